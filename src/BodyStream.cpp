@@ -0,0 +1,211 @@
+//
+// Created by Nevermore on 2026/10/17.
+// http-request BodyStream
+// Copyright (c) 2024 Nevermore All rights reserved.
+//
+#include "BodyStream.h"
+#include <cstdio>
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace http {
+
+namespace {
+
+constexpr std::string_view kCRLF = "\r\n";
+constexpr std::string_view kLastChunk = "0\r\n\r\n";
+
+SocketResult makeResult(ResultCode code) noexcept {
+    SocketResult result;
+    result.resultCode = code;
+    return result;
+}
+
+} //end of namespace
+
+BodyStream::BodyStream(const RequestInfo& info) noexcept
+    : reader_(info.bodyReader)
+    , isChunked_(!info.isBodyFile() && info.bodyLength < 0)
+    , remainLength_(std::max<int64_t>(info.bodyLength, 0))
+    , isFile_(info.isBodyFile()) {
+    if (!isFile_) {
+        buffer_ = Data::makePooled(BufferPool::kMaxSize);
+        return;
+    }
+#if !defined(_WIN32)
+    const auto& file = info.bodyFile;
+    fd_ = file.fd;
+    if (fd_ < 0) {
+        fd_ = ::open(file.path.data(), O_RDONLY | O_CLOEXEC);
+        isOwnedFd_ = fd_ >= 0;
+    }
+    fileOffset_ = file.offset;
+    BodyFile opened;
+    opened.fd = fd_;
+    opened.offset = file.offset;
+    opened.length = file.length;
+    remainLength_ = fileLength(opened);
+#else
+    ///file bodies are not supported on windows, the request fails with BodyReadFailed
+    remainLength_ = kInvalid;
+#endif
+    isFailed_ = remainLength_ < 0;
+}
+
+BodyStream::~BodyStream() {
+#if !defined(_WIN32)
+    if (isOwnedFd_) {
+        ::close(fd_);
+    }
+#endif
+}
+
+int64_t BodyStream::fileLength(const BodyFile& file) noexcept {
+#if defined(_WIN32)
+    (void)file;
+    return kInvalid;
+#else
+    struct stat fileStat{};
+    auto res = file.fd >= 0 ? ::fstat(file.fd, &fileStat) : ::stat(file.path.data(), &fileStat);
+    if (res != 0 || !S_ISREG(fileStat.st_mode) || static_cast<uint64_t>(fileStat.st_size) < file.offset) {
+        return kInvalid;
+    }
+    auto available = static_cast<int64_t>(static_cast<uint64_t>(fileStat.st_size) - file.offset);
+    if (file.length < 0) {
+        return available;
+    }
+    return file.length <= available ? file.length : kInvalid;
+#endif
+}
+
+std::tuple<SocketResult, int64_t> BodyStream::send(const ISocket& socket) noexcept {
+    if (isFailed_) {
+        return {makeResult(ResultCode::BodyReadFailed), 0};
+    }
+    return isFile_ ? sendFile(socket) : sendPart(socket);
+}
+
+std::tuple<SocketResult, int64_t> BodyStream::sendFile(const ISocket& socket) noexcept {
+    if (socket.isSendFileSupported()) {
+        if (remainLength_ == 0) {
+            return {makeResult(ResultCode::Completed), 0};
+        }
+        auto [result, sendSize] = socket.sendFile(fd_, fileOffset_, static_cast<uint64_t>(remainLength_));
+        if (result.isSuccess() && sendSize == 0) {
+            ///the file was truncated while it was sent
+            isFailed_ = true;
+            return {makeResult(ResultCode::BodyReadFailed), 0};
+        }
+        if (result.isSuccess()) {
+            fileOffset_ += static_cast<uint64_t>(sendSize);
+            remainLength_ -= sendSize;
+        }
+        return {result, sendSize};
+    }
+    ///tls encrypts in user space, the file is read into the buffer instead of being mapped, a mapping of a file
+    ///truncated meanwhile raises SIGBUS while a short read is just an error
+    if (sentSize_ >= partSize_ && !readFile()) {
+        return {makeResult(isFailed_ ? ResultCode::BodyReadFailed : ResultCode::Completed), 0};
+    }
+    auto [result, sendSize] = socket.send(buffer_->view().substr(static_cast<size_t>(sentSize_)));
+    if (result.isSuccess()) {
+        sentSize_ += static_cast<uint64_t>(sendSize);
+    }
+    return {result, sendSize};
+}
+
+bool BodyStream::readFile() noexcept {
+    if (remainLength_ == 0) {
+        return false;
+    }
+#if defined(_WIN32)
+    isFailed_ = true;
+    return false;
+#else
+    if (buffer_ == nullptr) {
+        buffer_ = Data::makePooled(BufferPool::kMaxSize);
+    }
+    auto size = std::min(buffer_->capacity, static_cast<uint64_t>(remainLength_));
+    ssize_t readSize = 0;
+    do {
+        readSize = ::pread(fd_, buffer_->rawData, size, static_cast<off_t>(fileOffset_));
+    } while (readSize < 0 && errno == EINTR);
+    if (readSize <= 0) {
+        ///an error, or the file was truncated while it was sent
+        isFailed_ = true;
+        return false;
+    }
+    buffer_->length = static_cast<uint64_t>(readSize);
+    partSize_ = buffer_->length;
+    sentSize_ = 0;
+    fileOffset_ += partSize_;
+    remainLength_ -= readSize;
+    return true;
+#endif
+}
+
+std::tuple<SocketResult, int64_t> BodyStream::sendPart(const ISocket& socket) noexcept {
+    if (sentSize_ >= partSize_ && !pull()) {
+        return {makeResult(isFailed_ ? ResultCode::BodyReadFailed : ResultCode::Completed), 0};
+    }
+    auto [result, sendSize] = socket.sendBuffers(skipBuffers(part(), sentSize_));
+    if (result.isSuccess()) {
+        sentSize_ += static_cast<uint64_t>(sendSize);
+    }
+    return {result, sendSize};
+}
+
+bool BodyStream::pull() noexcept {
+    if (isFinished_ || isFailed_) {
+        return false;
+    }
+    sentSize_ = 0;
+    partSize_ = 0;
+    if (isLastPart_ || (!isChunked_ && remainLength_ == 0)) {
+        isFinished_ = true;
+        return false;
+    }
+    if (isEnded_) {
+        isLastPart_ = true;
+        partSize_ = kLastChunk.size();
+        return true;
+    }
+    isStarted_ = true;
+    auto size = isChunked_ ? buffer_->capacity : std::min(buffer_->capacity, static_cast<uint64_t>(remainLength_));
+    auto readSize = reader_ ? reader_(buffer_->rawData, size) : -1;
+    if (readSize < 0 || static_cast<uint64_t>(readSize) > size || (readSize == 0 && !isChunked_)) {
+        isFailed_ = true;
+        return false;
+    }
+    if (readSize == 0) {
+        isEnded_ = true;
+        return pull();
+    }
+    buffer_->length = static_cast<uint64_t>(readSize);
+    partSize_ = buffer_->length;
+    if (isChunked_) {
+        ///https://www.rfc-editor.org/rfc/rfc7230#section-4.1
+        char sizeText[32];
+        auto length = std::snprintf(sizeText, sizeof(sizeText), "%llx\r\n", static_cast<unsigned long long>(readSize));
+        chunkHeader_.assign(sizeText, static_cast<size_t>(length));
+        partSize_ += chunkHeader_.size() + kCRLF.size();
+    } else {
+        remainLength_ -= readSize;
+    }
+    return true;
+}
+
+std::vector<DataView> BodyStream::part() const noexcept {
+    if (isLastPart_) {
+        return {kLastChunk};
+    }
+    if (isChunked_) {
+        return {chunkHeader_, buffer_->view(), kCRLF};
+    }
+    return {buffer_->view()};
+}
+
+} //end of namespace http
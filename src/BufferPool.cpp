@@ -0,0 +1,147 @@
+//
+// Created by Nevermore on 2026/10/17.
+// http-request BufferPool
+// Copyright (c) 2024 Nevermore All rights reserved.
+//
+#include "BufferPool.h"
+#include <array>
+#include <mutex>
+#include <vector>
+
+namespace http {
+
+namespace {
+
+constexpr int32_t kInvalidIndex = -1;
+///4kb, 8kb, 16kb, 32kb and 64kb
+constexpr size_t kClassCount = 5;
+///buffers of one size a thread keeps, half of them move to or from the depot at once
+constexpr size_t kLocalCount = 32;
+constexpr size_t kBatchCount = kLocalCount / 2;
+///the depot keeps up to 4mb of every size, the surplus is freed
+constexpr uint64_t kDepotBytes = 4 * 1024 * 1024;
+
+constexpr uint64_t classSize(size_t index) noexcept {
+    return BufferPool::kMinSize << index;
+}
+
+int32_t classIndex(uint64_t size) noexcept {
+    if (size == 0 || size > BufferPool::kMaxSize) {
+        return kInvalidIndex;
+    }
+    int32_t index = 0;
+    while (classSize(static_cast<size_t>(index)) < size) {
+        index++;
+    }
+    return index;
+}
+
+struct Depot {
+    std::mutex mutex;
+    std::array<std::vector<uint8_t*>, kClassCount> buffers;
+};
+
+///never destroyed, the caches of the threads exiting after main still flush into it
+Depot& depot() noexcept {
+    static auto depot = new Depot();
+    return *depot;
+}
+
+///trivially destructible, still readable while the thread locals are destroyed
+thread_local bool isCacheDestroyed = false;
+
+struct LocalCache {
+    std::array<std::vector<uint8_t*>, kClassCount> buffers;
+
+    ~LocalCache() {
+        isCacheDestroyed = true;
+        for (size_t i = 0; i < kClassCount; i++) {
+            flush(i, buffers[i].size());
+        }
+    }
+
+    ///move count buffers of the size into the depot, the ones over its limit are freed
+    void flush(size_t index, size_t count) noexcept {
+        auto& local = buffers[index];
+        auto& depotInstance = depot();
+        std::vector<uint8_t*> dropped;
+        {
+            std::lock_guard lock(depotInstance.mutex);
+            auto& shared = depotInstance.buffers[index];
+            auto maxCount = kDepotBytes / classSize(index);
+            for (size_t i = 0; i < count && !local.empty(); i++) {
+                (shared.size() < maxCount ? shared : dropped).push_back(local.back());
+                local.pop_back();
+            }
+        }
+        for (auto buffer : dropped) {
+            delete[] buffer;
+        }
+    }
+
+    ///take a batch from the depot, false if it has none of the size
+    bool refill(size_t index) noexcept {
+        auto& local = buffers[index];
+        auto& depotInstance = depot();
+        std::lock_guard lock(depotInstance.mutex);
+        auto& shared = depotInstance.buffers[index];
+        for (size_t i = 0; i < kBatchCount && !shared.empty(); i++) {
+            local.push_back(shared.back());
+            shared.pop_back();
+        }
+        return !local.empty();
+    }
+};
+
+thread_local LocalCache localCache;
+
+} //end of namespace
+
+uint8_t* BufferPool::allocate(uint64_t size, uint64_t& capacity) noexcept {
+    auto index = classIndex(size);
+    if (index == kInvalidIndex) {
+        capacity = 0;
+        return nullptr;
+    }
+    auto slot = static_cast<size_t>(index);
+    capacity = classSize(slot);
+    if (isCacheDestroyed) {
+        return new uint8_t[capacity];
+    }
+    auto& local = localCache.buffers[slot];
+    if (local.empty() && !localCache.refill(slot)) {
+        return new uint8_t[capacity];
+    }
+    auto buffer = local.back();
+    local.pop_back();
+    return buffer;
+}
+
+void BufferPool::release(uint8_t* data, uint64_t capacity) noexcept {
+    if (data == nullptr) {
+        return;
+    }
+    auto index = classIndex(capacity);
+    if (index == kInvalidIndex || classSize(static_cast<size_t>(index)) != capacity || isCacheDestroyed) {
+        delete[] data;
+        return;
+    }
+    auto slot = static_cast<size_t>(index);
+    auto& local = localCache.buffers[slot];
+    if (local.size() >= kLocalCount) {
+        localCache.flush(slot, kBatchCount);
+    }
+    local.push_back(data);
+}
+
+uint64_t BufferPool::depotCount() noexcept {
+    auto& depotInstance = depot();
+    std::lock_guard lock(depotInstance.mutex);
+    uint64_t count = 0;
+    for (const auto& buffers : depotInstance.buffers) {
+        count += buffers.size();
+    }
+    return count;
+}
+
+} //end of namespace http
@@ -0,0 +1,577 @@
+//
+// Created by Nevermore on 2026/10/17.
+// http-request Client
+// Copyright (c) 2024 Nevermore All rights reserved.
+//
+#include "Client.h"
+#include <algorithm>
+#include "ConnectionLimiter.h"
+#include "ConnectionPool.h"
+#include "EventLoop.h"
+#include "Http2Connection.h"
+#include "Pipeline.h"
+#include "Session.h"
+#include "Url.h"
+
+namespace http {
+
+using namespace http::util;
+
+///One event loop and the sessions it owns, the sessions are only touched on the loop thread.
+///Aligned so the counters of different shards never share a cache line.
+struct alignas(64) Shard {
+    explicit Shard(const ConnectionPoolConfig& poolConfig)
+        : pool(poolConfig) {
+
+    }
+
+    int32_t cpu = kInvalid;
+    std::atomic<uint64_t> activeCount = 0;
+    std::atomic<uint64_t> totalCount = 0;
+    SessionCounter counter;
+    std::unique_ptr<EventLoop> loop = std::make_unique<EventLoop>();
+    ///the idle connections opened by this loop, only its sessions take them so no socket changes loops.
+    ///declared before the sessions, they return their connections to it until they are destroyed
+    ConnectionPool pool;
+    std::unordered_map<std::string, std::unique_ptr<Session>> sessions;
+    ///keyed by origin, alive while it has requests
+    std::unordered_map<std::string, std::unique_ptr<Pipeline>> pipelines;
+    ///keyed by origin, alive while it has requests or an idle connection
+    std::unordered_map<std::string, std::unique_ptr<Http2Connection>> http2s;
+    ///the origins that answered ALPN with http/1.1, their http/2 requests go straight to sessions
+    Http2Connection::OriginSet http1Origins;
+};
+
+///A request of a coalesced GET, it shares the response of the one that went out
+struct FlightMember {
+    std::string reqId;
+    ResponseHandler handler;
+    ///cleared once it is canceled
+    std::atomic<bool> isValid = true;
+    ///onConnected was reported, only touched on the loop thread
+    bool isConnected = false;
+};
+
+///Identical coalesced GETs in flight together, one request goes out and its callbacks fan out to every member.
+///Members join until the response header arrives, the list is fixed once the flight is closed.
+struct Flight {
+    std::string key;
+    ///the request that went out
+    std::string reqId;
+    ///guarded by the mutex of the client
+    bool isOpen = true;
+    std::vector<std::shared_ptr<FlightMember>> members;
+};
+using FlightPtr = std::shared_ptr<Flight>;
+
+namespace {
+
+bool isCoalescable(const RequestInfo& info) noexcept {
+    return info.isCoalescing && info.methodType == HttpMethodType::Get && info.bodyEmpty() && !info.isBodyStreamed();
+}
+
+///method, url, the headers that may vary the response, the header names in lowercase and sorted, and every setting
+///that changes how the request goes out or fails: a member never gets the outcome of a request it would not have sent
+std::string makeFlightKey(const RequestInfo& info) {
+    std::vector<std::string> headers;
+    headers.reserve(info.headers.size());
+    for (const auto& [name, value] : info.headers) {
+        auto header = name;
+        StringUtil::toLower(header);
+        headers.push_back(header.append(":").append(value));
+    }
+    std::sort(headers.begin(), headers.end());
+    auto key = std::to_string(static_cast<int32_t>(info.methodType)) + (info.isAllowRedirect ? " R " : " ") + info.url;
+    key.append(" ").append(std::to_string(static_cast<int32_t>(info.httpVersion)));
+    key.append(info.isKeepAlive ? " K" : "").append(info.isPipelining ? " P" : "").append(info.isEarlyData ? " E" : "");
+    for (auto timeout : {info.timeout, info.connectTimeout, info.readTimeout, info.connectionAttemptDelay}) {
+        key.append(" ").append(std::to_string(timeout.count()));
+    }
+    ///the ip version and the socket options as the pool tells connections apart, plus fast open
+    key.append(" ").append(ConnectionPool::makeKey(Url(info.url), info.ipVersion, info.socketOptions));
+    key.append(info.socketOptions.isFastOpen ? " F" : "");
+    for (const auto& header : headers) {
+        key.append("\r\n").append(header);
+    }
+    return key;
+}
+
+} //end of namespace
+
+class ClientImpl {
+public:
+    explicit ClientImpl(const ClientConfig& config)
+        : policy_(config.shardPolicy)
+        , maxPipelineDepth_(config.maxPipelineDepth)
+        , idleTimeout_(config.poolConfig.idleTimeout) {
+        if (config.maxConnectionsPerOrigin > 0 || config.maxConnections > 0) {
+            limiter_ = std::make_unique<ConnectionLimiter>(config.maxConnectionsPerOrigin, config.maxConnections);
+        }
+        auto loopCount = config.loopCount;
+        if (loopCount == 0) {
+            loopCount = std::max<uint32_t>(std::thread::hardware_concurrency(), 1);
+        }
+        for (uint32_t i = 0; i < loopCount; i++) {
+            auto shard = std::make_unique<Shard>(config.poolConfig);
+            if (!config.cpuAffinity.empty()) {
+                shard->cpu = config.cpuAffinity[i % config.cpuAffinity.size()];
+            }
+            shard->loop->start(shard->cpu);
+            shards_.push_back(std::move(shard));
+        }
+    }
+
+    ~ClientImpl() {
+        for (auto& shard : shards_) {
+            shard->loop->stop();
+        }
+        shards_.clear();
+    }
+
+    std::string request(RequestInfo&& info, ResponseHandler&& handler) {
+        auto reqId = StringUtil::randomString(20);
+        if (isCoalescable(info) && coalesce(info, handler, reqId)) {
+            return reqId;
+        }
+        auto index = selectShard(info);
+        {
+            std::lock_guard lock(mutex_);
+            reqShards_[reqId] = index;
+        }
+        auto shard = shards_[index].get();
+        shard->activeCount.fetch_add(1, std::memory_order_relaxed);
+        shard->totalCount.fetch_add(1, std::memory_order_relaxed);
+        if (limiter_ && !Http2Connection::isHttp2(info) && !(maxPipelineDepth_ > 1 && Pipeline::isPipelinable(info))) {
+            limit(shard, std::move(info), std::move(handler), reqId);
+            return reqId;
+        }
+        shard->loop->post([this, shard, reqId, info = std::move(info), handler = std::move(handler)]() mutable {
+            if (Http2Connection::isHttp2(info)) {
+                http2(shard, std::move(info), std::move(handler), reqId);
+            } else if (maxPipelineDepth_ > 1 && Pipeline::isPipelinable(info)) {
+                pipeline(shard, std::move(info), std::move(handler), reqId);
+            } else {
+                startSession(shard, std::move(info), std::move(handler), reqId);
+            }
+        });
+        return reqId;
+    }
+
+    void cancel(const std::string& id) noexcept {
+        size_t index = 0;
+        auto reqId = id;
+        {
+            std::lock_guard lock(mutex_);
+            if (!leaveFlight(reqId)) {
+                return;
+            }
+            auto it = reqShards_.find(reqId);
+            if (it == reqShards_.end()) {
+                return;
+            }
+            index = it->second;
+            reqShards_.erase(it);
+        }
+        auto shard = shards_[index].get();
+        if (limiter_ && limiter_->cancel(reqId)) {
+            shard->activeCount.fetch_sub(1, std::memory_order_relaxed);
+            return;
+        }
+        shard->loop->post([this, shard, reqId] {
+            if (auto it = shard->sessions.find(reqId); it != shard->sessions.end()) {
+                it->second->cancel();
+                shard->sessions.erase(it);
+                shard->activeCount.fetch_sub(1, std::memory_order_relaxed);
+                if (limiter_) {
+                    limiter_->release(reqId);
+                }
+                return;
+            }
+            for (auto& [key, pipeline] : shard->pipelines) {
+                if (pipeline->cancel(reqId)) {
+                    shard->activeCount.fetch_sub(1, std::memory_order_relaxed);
+                    return;
+                }
+            }
+            for (auto& [key, connection] : shard->http2s) {
+                if (connection->cancel(reqId)) {
+                    shard->activeCount.fetch_sub(1, std::memory_order_relaxed);
+                    return;
+                }
+            }
+        });
+    }
+
+    void preconnect(const std::string& origin, uint32_t count, std::function<void(uint32_t)>&& onFinish,
+                    IPVersion ipVersion) {
+        if (count == 0) {
+            if (onFinish) {
+                onFinish(0);
+            }
+            return;
+        }
+        Request::warmUp();
+        struct Progress {
+            std::atomic<uint32_t> remainCount = 0;
+            std::atomic<uint32_t> readyCount = 0;
+            std::function<void(uint32_t)> onFinish;
+        };
+        auto progress = std::make_shared<Progress>();
+        progress->remainCount = count;
+        progress->onFinish = std::move(onFinish);
+        for (uint32_t i = 0; i < count; i++) {
+            RequestInfo info;
+            info.url = origin;
+            info.methodType = HttpMethodType::Get;
+            info.ipVersion = ipVersion;
+            ResponseHandler handler;
+            handler.onConnected = [progress](std::string_view) {
+                progress->readyCount.fetch_add(1, std::memory_order_relaxed);
+            };
+            handler.onDisconnected = [progress](std::string_view) {
+                if (progress->remainCount.fetch_sub(1) == 1 && progress->onFinish) {
+                    progress->onFinish(progress->readyCount.load());
+                }
+            };
+            ///every loop has its own pool, the connection goes to the loop the shard policy picks for the origin
+            auto shard = shards_[selectShard(info)].get();
+            auto reqId = StringUtil::randomString(20);
+            shard->activeCount.fetch_add(1, std::memory_order_relaxed);
+            shard->loop->post([this, shard, reqId, info = std::move(info), handler = std::move(handler)]() mutable {
+                startSession(shard, std::move(info), std::move(handler), reqId, true);
+            });
+        }
+    }
+
+    std::vector<ShardStats> shardStats() const noexcept {
+        std::vector<ShardStats> stats;
+        for (size_t i = 0; i < shards_.size(); i++) {
+            auto& shard = shards_[i];
+            ShardStats stat;
+            stat.index = static_cast<uint32_t>(i);
+            stat.cpu = shard->cpu;
+            stat.activeCount = shard->activeCount.load(std::memory_order_relaxed);
+            stat.totalCount = shard->totalCount.load(std::memory_order_relaxed);
+            stat.sentBytes = shard->counter.sentBytes.load(std::memory_order_relaxed);
+            stat.receivedBytes = shard->counter.receivedBytes.load(std::memory_order_relaxed);
+            stats.push_back(stat);
+        }
+        return stats;
+    }
+
+private:
+    ///join the flight of an identical request, or start one the request leads. True if it joined
+    bool coalesce(const RequestInfo& info, ResponseHandler& handler, const std::string& reqId) {
+        auto member = std::make_shared<FlightMember>();
+        member->reqId = reqId;
+        auto key = makeFlightKey(info);
+        std::lock_guard lock(mutex_);
+        if (auto it = flights_.find(key); it != flights_.end()) {
+            member->handler = std::move(handler);
+            it->second->members.push_back(std::move(member));
+            memberFlights_[reqId] = it->second;
+            return true;
+        }
+        auto flight = std::make_shared<Flight>();
+        flight->key = std::move(key);
+        flight->reqId = reqId;
+        member->handler = std::move(handler);
+        flight->members.push_back(std::move(member));
+        flights_[flight->key] = flight;
+        memberFlights_[reqId] = flight;
+        handler = makeFlightHandler(flight);
+        return false;
+    }
+
+    ///the callbacks of the request that went out, they run on its loop thread.
+    ///the members are snapshotted under the mutex, a member canceled meanwhile is skipped by its isValid flag
+    ResponseHandler makeFlightHandler(const FlightPtr& flight) {
+        ResponseHandler handler;
+        handler.onConnected = [this, flight](std::string_view) {
+            for (auto& member : flightMembers(*flight)) {
+                reportConnected(*member);
+            }
+        };
+        handler.onParseHeaderDone = [this, flight](std::string_view, ResponseHeader&& header) {
+            for (auto& member : closeFlight(*flight)) {
+                reportConnected(*member);
+                if (member->isValid.load(std::memory_order_acquire) && member->handler.onParseHeaderDone) {
+                    member->handler.onParseHeaderDone(member->reqId, ResponseHeader(header));
+                }
+            }
+        };
+        handler.onData = [flight](std::string_view, DataPtr data) {
+            ///every member gets a slice of the same bytes, the flight was closed by onParseHeaderDone so the members are fixed
+            DataRefPtr shared = std::move(data);
+            for (auto& member : flight->members) {
+                if (member->isValid.load(std::memory_order_acquire) && member->handler.onData) {
+                    member->handler.onData(member->reqId, Data::slice(shared, 0, shared->length));
+                }
+            }
+        };
+        handler.onError = [this, flight](std::string_view, ErrorInfo error) {
+            for (auto& member : closeFlight(*flight)) {
+                if (member->isValid.load(std::memory_order_acquire) && member->handler.onError) {
+                    member->handler.onError(member->reqId, error);
+                }
+            }
+        };
+        handler.onStats = [this, flight](std::string_view, const RequestStats& stats) {
+            for (auto& member : closeFlight(*flight)) {
+                if (member->isValid.load(std::memory_order_acquire) && member->handler.onStats) {
+                    member->handler.onStats(member->reqId, stats);
+                }
+            }
+        };
+        handler.onDisconnected = [this, flight](std::string_view) {
+            auto members = closeFlight(*flight);
+            {
+                std::lock_guard lock(mutex_);
+                for (auto& member : members) {
+                    memberFlights_.erase(member->reqId);
+                }
+            }
+            for (auto& member : members) {
+                if (member->isValid.load(std::memory_order_acquire) && member->handler.onDisconnected) {
+                    member->handler.onDisconnected(member->reqId);
+                }
+            }
+        };
+        return handler;
+    }
+
+    static void reportConnected(FlightMember& member) noexcept {
+        if (!member.isConnected && member.isValid.load(std::memory_order_acquire) && member.handler.onConnected) {
+            member.isConnected = true;
+            member.handler.onConnected(member.reqId);
+        }
+    }
+
+    std::vector<std::shared_ptr<FlightMember>> flightMembers(const Flight& flight) {
+        std::lock_guard lock(mutex_);
+        return flight.members;
+    }
+
+    ///no member joins anymore, an identical request starts a new flight. Returns the members it ends with
+    std::vector<std::shared_ptr<FlightMember>> closeFlight(Flight& flight) {
+        std::lock_guard lock(mutex_);
+        if (flight.isOpen) {
+            flight.isOpen = false;
+            if (auto it = flights_.find(flight.key); it != flights_.end() && it->second.get() == &flight) {
+                flights_.erase(it);
+            }
+        }
+        return flight.members;
+    }
+
+    ///called with the mutex held, a canceled member stops getting callbacks. False while other members still wait
+    ///for the response, otherwise reqId becomes the request that went out and it is canceled as well
+    bool leaveFlight(std::string& reqId) noexcept {
+        auto it = memberFlights_.find(reqId);
+        if (it == memberFlights_.end()) {
+            return true;
+        }
+        auto flight = it->second;
+        memberFlights_.erase(it);
+        auto isAbandoned = true;
+        for (auto& member : flight->members) {
+            if (member->reqId == reqId) {
+                member->isValid.store(false, std::memory_order_release);
+            }
+            isAbandoned = isAbandoned && !member->isValid.load(std::memory_order_relaxed);
+        }
+        if (!isAbandoned) {
+            return false;
+        }
+        if (flight->isOpen) {
+            flight->isOpen = false;
+            if (auto flightIt = flights_.find(flight->key); flightIt != flights_.end() && flightIt->second == flight) {
+                flights_.erase(flightIt);
+            }
+        }
+        reqId = flight->reqId;
+        return true;
+    }
+
+    ///run on the loop thread of the shard
+    void startSession(Shard* shard, RequestInfo&& info, ResponseHandler&& handler, const std::string& reqId,
+                      bool isPreconnect = false) {
+        auto session = std::make_unique<Session>(*shard->loop, std::move(info), std::move(handler), reqId,
+                                                 [this, shard](const std::string& id) {
+            if (shard->sessions.erase(id) > 0) {
+                shard->activeCount.fetch_sub(1, std::memory_order_relaxed);
+            }
+            if (limiter_) {
+                limiter_->release(id);
+            }
+            finish(id);
+        }, &shard->counter, &shard->pool);
+        auto sessionPtr = session.get();
+        shard->sessions[reqId] = std::move(session);
+        if (isPreconnect) {
+            sessionPtr->preconnect();
+        } else {
+            sessionPtr->start();
+        }
+    }
+
+    ///start the session once the origin has a free connection slot
+    void limit(Shard* shard, RequestInfo&& info, ResponseHandler&& handler, const std::string& reqId) {
+        ///the limits count the connections of the origin whatever socket options they were opened with
+        auto origin = ConnectionPool::makeKey(Url(info.url), info.ipVersion, SocketOptions());
+        limiter_->acquire(origin, reqId, [this, shard, reqId, info = std::move(info), handler = std::move(handler)]
+            (std::chrono::milliseconds queueTime) mutable {
+            if (queueTime.count() > 0 && handler.onStats) {
+                handler.onStats = [onStats = std::move(handler.onStats), queueTime](std::string_view id,
+                                                                                    const RequestStats& stats) {
+                    auto queuedStats = stats;
+                    queuedStats.queueTime = queueTime;
+                    onStats(id, queuedStats);
+                };
+            }
+            shard->loop->post([this, shard, reqId, info = std::move(info), handler = std::move(handler)]() mutable {
+                startSession(shard, std::move(info), std::move(handler), reqId);
+            });
+        });
+    }
+
+    ///run on the loop thread of the shard
+    void pipeline(Shard* shard, RequestInfo&& info, ResponseHandler&& handler, const std::string& reqId) {
+        auto key = ConnectionPool::makeKey(Url(info.url), info.ipVersion, info.socketOptions);
+        auto& pipeline = shard->pipelines[key];
+        if (pipeline == nullptr) {
+            pipeline = std::make_unique<Pipeline>(*shard->loop, key, maxPipelineDepth_, [this, shard](const std::string& id) {
+                shard->activeCount.fetch_sub(1, std::memory_order_relaxed);
+                finish(id);
+            }, [this, shard](RequestInfo&& redirectInfo, ResponseHandler&& redirectHandler, const std::string& id) {
+                startSession(shard, std::move(redirectInfo), std::move(redirectHandler), id);
+            }, [shard, key] {
+                if (auto it = shard->pipelines.find(key); it != shard->pipelines.end() && it->second->isIdle()) {
+                    shard->pipelines.erase(it);
+                }
+            }, &shard->counter, &shard->pool);
+        }
+        pipeline->add(std::move(info), std::move(handler), reqId);
+    }
+
+    ///run on the loop thread of the shard
+    void http2(Shard* shard, RequestInfo&& info, ResponseHandler&& handler, const std::string& reqId) {
+        auto key = ConnectionPool::makeKey(Url(info.url), info.ipVersion, info.socketOptions);
+        auto& connection = shard->http2s[key];
+        if (connection == nullptr) {
+            connection = std::make_unique<Http2Connection>(*shard->loop, key, idleTimeout_, [this, shard](const std::string& id) {
+                shard->activeCount.fetch_sub(1, std::memory_order_relaxed);
+                finish(id);
+            }, [this, shard](RequestInfo&& fallbackInfo, ResponseHandler&& fallbackHandler, const std::string& id) {
+                startSession(shard, std::move(fallbackInfo), std::move(fallbackHandler), id);
+            }, [shard, key] {
+                if (auto it = shard->http2s.find(key); it != shard->http2s.end() && it->second->isIdle()) {
+                    shard->http2s.erase(it);
+                }
+            }, &shard->counter, &shard->pool, &shard->http1Origins);
+        }
+        connection->add(std::move(info), std::move(handler), reqId);
+    }
+
+    void finish(const std::string& reqId) noexcept {
+        std::lock_guard lock(mutex_);
+        reqShards_.erase(reqId);
+    }
+
+    size_t selectShard(const RequestInfo& info) noexcept {
+        auto shardCount = shards_.size();
+        if (shardCount == 1) {
+            return 0;
+        }
+        switch (policy_) {
+            case ShardPolicy::HostHash: {
+                Url url(info.url);
+                if (!url.isValid()) {
+                    break;
+                }
+                return std::hash<std::string>{}(url.host + ":" + url.port) % shardCount;
+            }
+            case ShardPolicy::LeastLoaded: {
+                ///start from a rotating shard so ties do not always pick the first one
+                auto start = next_.fetch_add(1, std::memory_order_relaxed) % shardCount;
+                auto index = start;
+                auto minCount = UINT64_MAX;
+                for (size_t i = 0; i < shardCount; i++) {
+                    auto current = (start + i) % shardCount;
+                    auto count = shards_[current]->activeCount.load(std::memory_order_relaxed);
+                    if (count < minCount) {
+                        minCount = count;
+                        index = current;
+                    }
+                }
+                return index;
+            }
+            default:
+                break;
+        }
+        return next_.fetch_add(1, std::memory_order_relaxed) % shardCount;
+    }
+
+    ShardPolicy policy_ = ShardPolicy::RoundRobin;
+    uint32_t maxPipelineDepth_ = 8;
+    ///an idle http/2 connection is closed after it, the same as a pooled one
+    std::chrono::milliseconds idleTimeout_;
+    ///nullptr without limits, outlives the shards whose sessions release their slots
+    std::unique_ptr<ConnectionLimiter> limiter_;
+    std::vector<std::unique_ptr<Shard>> shards_;
+    std::atomic<uint32_t> next_ = 0;
+    std::mutex mutex_;
+    std::unordered_map<std::string, size_t> reqShards_;
+    ///the open flights of the coalesced requests by key, and the flight of every member
+    std::unordered_map<std::string, FlightPtr> flights_;
+    std::unordered_map<std::string, FlightPtr> memberFlights_;
+};
+
+void freeClientImpl(ClientImpl* impl) noexcept {
+    delete impl;
+}
+
+Client::Client(ClientConfig config)
+    : impl_(new ClientImpl(config), freeClientImpl) {
+
+}
+
+Client::~Client() = default;
+
+std::string Client::request(const RequestInfo& info, const ResponseHandler& handler) {
+    return impl_->request(RequestInfo(info), ResponseHandler(handler));
+}
+
+std::string Client::request(RequestInfo&& info, ResponseHandler&& handler) {
+    return impl_->request(std::move(info), std::move(handler));
+}
+
+void Client::cancel(const std::string& reqId) noexcept {
+    impl_->cancel(reqId);
+}
+
+void Client::preconnect(const std::string& origin, uint32_t count, std::function<void(uint32_t)> onFinish,
+                        IPVersion ipVersion) {
+    impl_->preconnect(origin, count, std::move(onFinish), ipVersion);
+}
+
+std::vector<ShardStats> Client::shardStats() const noexcept {
+    return impl_->shardStats();
+}
+
+#if ENABLE_COROUTINE
+ResponseAwaiter Client::get(const std::string& url) {
+    RequestInfo info;
+    info.url = url;
+    info.methodType = HttpMethodType::Get;
+    return send(std::move(info));
+}
+
+ResponseAwaiter Client::send(RequestInfo&& info) {
+    auto state = std::make_shared<ResponseState>();
+    auto reqId = impl_->request(std::move(info), ResponseState::makeHandler(state));
+    return ResponseAwaiter{std::move(state), std::move(reqId)};
+}
+#endif
+
+} //end of namespace http
@@ -0,0 +1,125 @@
+//
+// Created by Nevermore on 2026/10/17.
+// http-request ConnectionLimiter
+// Copyright (c) 2024 Nevermore All rights reserved.
+//
+#include "ConnectionLimiter.h"
+#include <algorithm>
+#include "Utility.h"
+
+namespace http {
+
+using namespace http::util;
+
+ConnectionLimiter::ConnectionLimiter(uint32_t maxPerOrigin, uint32_t maxTotal) noexcept
+    : maxPerOrigin_(maxPerOrigin)
+    , maxTotal_(maxTotal) {
+
+}
+
+bool ConnectionLimiter::canStart(const Origin& origin) const noexcept {
+    return (maxTotal_ == 0 || activeCount_ < maxTotal_) &&
+           (maxPerOrigin_ == 0 || origin.activeCount < maxPerOrigin_);
+}
+
+void ConnectionLimiter::start(const std::string& key, Origin& origin, const std::string& id) noexcept {
+    origin.activeCount++;
+    activeCount_++;
+    holders_[id] = key;
+}
+
+void ConnectionLimiter::acquire(const std::string& origin, const std::string& id, StartFunc&& onStart) noexcept {
+    std::lock_guard lock(mutex_);
+    auto& entry = origins_[origin];
+    if (entry.waiters.empty() && canStart(entry)) {
+        start(origin, entry, id);
+        onStart(std::chrono::milliseconds(0));
+        return;
+    }
+    if (entry.waiters.empty()) {
+        turns_.push_back(origin);
+    }
+    entry.waiters.push_back({id, Time::steadyTime(), std::move(onStart)});
+    waitingCount_++;
+}
+
+void ConnectionLimiter::release(const std::string& id) noexcept {
+    std::lock_guard lock(mutex_);
+    auto it = holders_.find(id);
+    if (it == holders_.end()) {
+        return;
+    }
+    auto originIt = origins_.find(it->second);
+    holders_.erase(it);
+    activeCount_--;
+    if (originIt != origins_.end()) {
+        auto& origin = originIt->second;
+        origin.activeCount--;
+        if (origin.activeCount == 0 && origin.waiters.empty()) {
+            origins_.erase(originIt);
+        }
+    }
+    dispatch();
+}
+
+void ConnectionLimiter::dispatch() noexcept {
+    ///stop after a whole round without a start, every waiting origin is at its own limit
+    size_t skipCount = 0;
+    while (!turns_.empty() && skipCount < turns_.size() && (maxTotal_ == 0 || activeCount_ < maxTotal_)) {
+        auto key = std::move(turns_.front());
+        turns_.pop_front();
+        auto& origin = origins_[key];
+        if (canStart(origin)) {
+            auto waiter = std::move(origin.waiters.front());
+            origin.waiters.pop_front();
+            waitingCount_--;
+            start(key, origin, waiter.id);
+            waiter.onStart(Time::steadyTime() - waiter.enqueueTime);
+            skipCount = 0;
+        } else {
+            skipCount++;
+        }
+        if (!origin.waiters.empty()) {
+            turns_.push_back(std::move(key));
+        }
+    }
+}
+
+bool ConnectionLimiter::cancel(const std::string& id) noexcept {
+    std::lock_guard lock(mutex_);
+    for (auto it = turns_.begin(); it != turns_.end(); ++it) {
+        auto originIt = origins_.find(*it);
+        if (originIt == origins_.end()) {
+            continue;
+        }
+        auto& origin = originIt->second;
+        auto waiterIt = std::find_if(origin.waiters.begin(), origin.waiters.end(), [&id](const Waiter& waiter) {
+            return waiter.id == id;
+        });
+        if (waiterIt == origin.waiters.end()) {
+            continue;
+        }
+        origin.waiters.erase(waiterIt);
+        waitingCount_--;
+        if (origin.waiters.empty()) {
+            if (origin.activeCount == 0) {
+                origins_.erase(originIt);
+            }
+            turns_.erase(it);
+        }
+        return true;
+    }
+    return false;
+}
+
+size_t ConnectionLimiter::waitingCount() const noexcept {
+    std::lock_guard lock(mutex_);
+    return waitingCount_;
+}
+
+size_t ConnectionLimiter::activeCount() const noexcept {
+    std::lock_guard lock(mutex_);
+    return activeCount_;
+}
+
+} //end of namespace http
@@ -0,0 +1,155 @@
+//
+// Created by Nevermore on 2026/10/17.
+// http-request ConnectionPool
+// Copyright (c) 2024 Nevermore All rights reserved.
+//
+#include "ConnectionPool.h"
+
+namespace http {
+
+using namespace http::util;
+
+ConnectionPool::ConnectionPool(const ConnectionPoolConfig& config) noexcept
+    : config_(config) {
+
+}
+
+ConnectionPool::~ConnectionPool() {
+    clear();
+}
+
+void ConnectionPool::setConfig(const ConnectionPoolConfig& config) noexcept {
+    std::vector<SocketPtr> dropped;
+    std::lock_guard lock(mutex_);
+    config_ = config;
+    purge(Time::steadyTime(), dropped);
+}
+
+std::string ConnectionPool::makeKey(const Url& url, IPVersion ipVersion, const SocketOptions& options) noexcept {
+    auto key = url.scheme + "://" + url.host + ":" + url.port;
+    if (ipVersion == IPVersion::V4) {
+        key += "#v4";
+    } else if (ipVersion == IPVersion::V6) {
+        key += "#v6";
+    }
+    ///fast open only changes how the connection opens, the others stay with it
+    const SocketOptions defaults;
+    if (options.interface != defaults.interface) {
+        key += "#if=" + options.interface;
+    }
+    if (options.sourceAddress != defaults.sourceAddress) {
+        key += "#src=" + options.sourceAddress;
+    }
+    if (options.tos != defaults.tos) {
+        key += "#tos=" + std::to_string(options.tos);
+    }
+    if (options.keepAliveIdle != defaults.keepAliveIdle || options.keepAliveInterval != defaults.keepAliveInterval ||
+        options.keepAliveCount != defaults.keepAliveCount) {
+        key += "#ka=" + std::to_string(options.keepAliveIdle.count()) + "," +
+               std::to_string(options.keepAliveInterval.count()) + "," + std::to_string(options.keepAliveCount);
+    }
+    if (options.userTimeout != defaults.userTimeout) {
+        key += "#uto=" + std::to_string(options.userTimeout.count());
+    }
+    if (options.sendBufferSize != defaults.sendBufferSize || options.receiveBufferSize != defaults.receiveBufferSize) {
+        key += "#buf=" + std::to_string(options.sendBufferSize) + "," + std::to_string(options.receiveBufferSize);
+    }
+    if (options.isNoDelay != defaults.isNoDelay) {
+        key += "#nagle";
+    }
+    return key;
+}
+
+SocketPtr ConnectionPool::checkout(const std::string& key) noexcept {
+    while (true) {
+        SocketPtr socket(nullptr, freeSocket);
+        {
+            std::lock_guard lock(mutex_);
+            auto it = idles_.find(key);
+            if (it == idles_.end()) {
+                return socket;
+            }
+            auto now = Time::steadyTime();
+            auto& entries = it->second;
+            while (!entries.empty() && socket == nullptr) {
+                auto entry = std::move(entries.back());
+                entries.pop_back();
+                if (!isExpired(entry, now)) {
+                    socket = std::move(entry.socket);
+                }
+            }
+            if (entries.empty()) {
+                idles_.erase(it);
+            }
+        }
+        if (socket == nullptr) {
+            return socket;
+        }
+        ///probe outside the lock, a tls socket may have to process the records the server sent meanwhile
+        if (socket->isAlive()) {
+            return socket;
+        }
+    }
+}
+
+void ConnectionPool::checkin(const std::string& key, SocketPtr socket) noexcept {
+    if (socket == nullptr) {
+        return;
+    }
+    std::vector<SocketPtr> dropped;
+    std::lock_guard lock(mutex_);
+    auto now = Time::steadyTime();
+    if (config_.maxIdlePerHost == 0 || now - socket->createTime() >= config_.maxLifetime) {
+        dropped.push_back(std::move(socket));
+        return;
+    }
+    idles_[key].push_back(Entry{std::move(socket), now});
+    purge(now, dropped);
+}
+
+size_t ConnectionPool::idleCount() const noexcept {
+    std::lock_guard lock(mutex_);
+    size_t count = 0;
+    for (const auto& [key, entries] : idles_) {
+        count += entries.size();
+    }
+    return count;
+}
+
+size_t ConnectionPool::idleCount(const std::string& key) const noexcept {
+    std::lock_guard lock(mutex_);
+    auto it = idles_.find(key);
+    return it == idles_.end() ? 0 : it->second.size();
+}
+
+void ConnectionPool::clear() noexcept {
+    decltype(idles_) idles;
+    std::lock_guard lock(mutex_);
+    idles.swap(idles_);
+}
+
+bool ConnectionPool::isExpired(const Entry& entry, std::chrono::milliseconds now) const noexcept {
+    return now - entry.idleTime >= config_.idleTimeout || now - entry.socket->createTime() >= config_.maxLifetime;
+}
+
+void ConnectionPool::purge(std::chrono::milliseconds now, std::vector<SocketPtr>& dropped) noexcept {
+    for (auto it = idles_.begin(); it != idles_.end();) {
+        auto& entries = it->second;
+        while (entries.size() > config_.maxIdlePerHost) {
+            dropped.push_back(std::move(entries.front().socket));
+            entries.pop_front();
+        }
+        ///the oldest ones expire first
+        while (!entries.empty() && isExpired(entries.front(), now)) {
+            dropped.push_back(std::move(entries.front().socket));
+            entries.pop_front();
+        }
+        if (entries.empty()) {
+            it = idles_.erase(it);
+        } else {
+            it++;
+        }
+    }
+}
+
+} //end of namespace http
@@ -0,0 +1,227 @@
+//
+// Created by Nevermore on 2026/10/17.
+// http-request Connector
+// Copyright (c) 2024 Nevermore All rights reserved.
+//
+#include "Connector.h"
+#include <algorithm>
+
+namespace http {
+
+using namespace http::util;
+
+namespace {
+
+SocketResult startConnect(const Connector::SocketFactory& factory, const addrinfo* address, bool isRacing,
+                          Connector::SocketPtr& socket) noexcept {
+    auto ipVersion = address->ai_family == AF_INET6 ? IPVersion::V6 : IPVersion::V4;
+    socket.reset(factory(ipVersion));
+    if (socket == nullptr) {
+        return {ResultCode::CreateSocketFailed};
+    }
+    if (isRacing) {
+        ///a fast open connect succeeds before any syn is sent, it would win the race even against a dead address
+        socket->disableFastOpen();
+    }
+    auto result = socket->connectAsync(address);
+    if (!result.isSuccess() && result.resultCode != ResultCode::Retry) {
+        socket.reset();
+    }
+    return result;
+}
+
+} //end of namespace
+
+Connector::Connector(EventLoop& loop, AddressInfoPtr address, std::chrono::milliseconds attemptDelay,
+                     SocketFactory&& factory, ConnectFunc&& onConnect)
+    : loop_(loop)
+    , address_(std::move(address))
+    , attemptDelay_(attemptDelay)
+    , factory_(std::move(factory))
+    , onConnect_(std::move(onConnect)) {
+    addresses_ = sortAddresses(address_.get());
+}
+
+Connector::~Connector() {
+    stop();
+}
+
+std::vector<const addrinfo*> Connector::sortAddresses(const addrinfo* address) noexcept {
+    std::vector<const addrinfo*> preferred;
+    std::vector<const addrinfo*> others;
+    for (auto current = address; current != nullptr; current = current->ai_next) {
+        if (current->ai_family != AF_INET && current->ai_family != AF_INET6) {
+            continue;
+        }
+        (current->ai_family == address->ai_family ? preferred : others).push_back(current);
+    }
+    std::vector<const addrinfo*> addresses;
+    for (size_t i = 0; i < std::max(preferred.size(), others.size()); i++) {
+        if (i < preferred.size()) {
+            addresses.push_back(preferred[i]);
+        }
+        if (i < others.size()) {
+            addresses.push_back(others[i]);
+        }
+    }
+    return addresses;
+}
+
+void Connector::start() noexcept {
+    next();
+}
+
+void Connector::next() noexcept {
+    if (timerId_ != 0) {
+        loop_.cancelTimer(timerId_);
+        timerId_ = 0;
+    }
+    while (nextIndex_ < addresses_.size()) {
+        SocketPtr socket(nullptr, freeSocket);
+        auto result = startConnect(factory_, addresses_[nextIndex_++], addresses_.size() > 1, socket);
+        if (result.isSuccess()) {
+            finish(std::move(socket));
+            return;
+        } else if (result.resultCode != ResultCode::Retry) {
+            lastResult_ = result;
+            continue;
+        }
+        auto fd = socket->fd();
+        if (!loop_.addEvent(fd, kEventWrite, [this, fd](uint32_t) { onEvent(fd); })) {
+            lastResult_ = {ResultCode::Failed, GetLastError()};
+            continue;
+        }
+        attempts_.push_back(std::move(socket));
+        if (nextIndex_ < addresses_.size()) {
+            timerId_ = loop_.runAfter(attemptDelay_, [this] {
+                timerId_ = 0;
+                next();
+            });
+        }
+        return;
+    }
+    if (attempts_.empty()) {
+        finish(SocketPtr(nullptr, freeSocket));
+    }
+}
+
+void Connector::onEvent(Socket socket) noexcept {
+    auto it = std::find_if(attempts_.begin(), attempts_.end(), [socket](const SocketPtr& attempt) {
+        return attempt->fd() == socket;
+    });
+    if (it == attempts_.end()) {
+        return;
+    }
+    auto result = (*it)->connectResult();
+    auto attempt = std::move(*it);
+    attempts_.erase(it);
+    loop_.removeEvent(socket);
+    if (result.isSuccess()) {
+        finish(std::move(attempt));
+        return;
+    }
+    lastResult_ = result;
+    attempt->close();
+    ///a failed attempt does not wait for the delay
+    next();
+}
+
+void Connector::finish(SocketPtr socket) noexcept {
+    stop();
+    auto result = socket ? SocketResult{} : lastResult_;
+    ///the owner may destroy the connector in the callback
+    auto onConnect = std::move(onConnect_);
+    if (onConnect) {
+        onConnect(std::move(socket), result);
+    }
+}
+
+void Connector::stop() noexcept {
+    nextIndex_ = addresses_.size();
+    if (timerId_ != 0) {
+        loop_.cancelTimer(timerId_);
+        timerId_ = 0;
+    }
+    for (auto& attempt : attempts_) {
+        loop_.removeEvent(attempt->fd());
+        attempt->close();
+    }
+    attempts_.clear();
+}
+
+std::tuple<Connector::SocketPtr, SocketResult> Connector::connect(const AddressInfoPtr& address,
+                                                                  std::chrono::milliseconds attemptDelay,
+                                                                  const SocketFactory& factory,
+                                                                  int64_t timeout) noexcept {
+    auto addresses = sortAddresses(address.get());
+    auto expiredTime = Time::steadyTime() + std::chrono::milliseconds(timeout);
+    auto nextAttemptTime = Time::steadyTime();
+    SocketResult lastResult{ResultCode::ConnectAddressError};
+    std::vector<SocketPtr> attempts;
+    size_t nextIndex = 0;
+    while (true) {
+        auto now = Time::steadyTime();
+        while (nextIndex < addresses.size() && (attempts.empty() || now >= nextAttemptTime)) {
+            SocketPtr socket(nullptr, freeSocket);
+            auto result = startConnect(factory, addresses[nextIndex++], addresses.size() > 1, socket);
+            if (result.isSuccess()) {
+                return {std::move(socket), result};
+            } else if (result.resultCode == ResultCode::Retry) {
+                attempts.push_back(std::move(socket));
+                nextAttemptTime = now + attemptDelay;
+                break;
+            }
+            lastResult = result;
+        }
+        if (attempts.empty()) {
+            return {SocketPtr(nullptr, freeSocket), lastResult};
+        }
+        auto waitTime = expiredTime - now;
+        if (waitTime.count() <= 0) {
+            return {SocketPtr(nullptr, freeSocket), SocketResult{ResultCode::Timeout}};
+        }
+        if (nextIndex < addresses.size()) {
+            waitTime = std::min(waitTime, std::max(nextAttemptTime - now, std::chrono::milliseconds(0)));
+        }
+        fd_set writeSet;
+        fd_set errorSet;
+        FD_ZERO(&writeSet);
+        FD_ZERO(&errorSet);
+        Socket maxFd = 0;
+        for (auto& attempt : attempts) {
+            FD_SET(attempt->fd(), &writeSet);
+            FD_SET(attempt->fd(), &errorSet);
+            maxFd = std::max(maxFd, attempt->fd());
+        }
+        timeval selectTimeout {
+            static_cast<int32_t>(waitTime.count() / 1000),
+            static_cast<int32_t>((waitTime.count() % 1000) * 1000)
+        };
+        ///windows reports a failed connect in the error set
+        auto ret = ::select(static_cast<int>(maxFd) + 1, nullptr, &writeSet, &errorSet, &selectTimeout);
+        if (ret == SocketError) {
+            auto errorCode = GetLastError();
+            if (errorCode == RetryCode) {
+                continue;
+            }
+            return {SocketPtr(nullptr, freeSocket), SocketResult{ResultCode::Failed, errorCode}};
+        }
+        for (auto it = attempts.begin(); it != attempts.end();) {
+            auto fd = (*it)->fd();
+            if (!FD_ISSET(fd, &writeSet) && !FD_ISSET(fd, &errorSet)) {
+                ++it;
+                continue;
+            }
+            auto result = (*it)->connectResult();
+            if (result.isSuccess()) {
+                return {std::move(*it), result};
+            }
+            lastResult = result;
+            it = attempts.erase(it);
+            ///a failed attempt does not wait for the delay
+            nextAttemptTime = now;
+        }
+    }
+}
+
+} //end of namespace http
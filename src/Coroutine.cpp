@@ -0,0 +1,99 @@
+//
+// Created by Nevermore on 2026/10/17.
+// http-request Coroutine
+// Copyright (c) 2024 Nevermore All rights reserved.
+//
+#if ENABLE_COROUTINE
+#include <utility>
+#include "Coroutine.h"
+
+namespace http {
+
+ResponseHandler ResponseState::makeHandler(const std::shared_ptr<ResponseState>& state) noexcept {
+    ResponseHandler handler;
+    handler.onParseHeaderDone = [state](std::string_view, ResponseHeader&& header) {
+        state->onHeader(std::move(header));
+    };
+    handler.onData = [state](std::string_view, DataPtr data) {
+        state->onData(std::move(data));
+    };
+    handler.onError = [state](std::string_view, ErrorInfo error) {
+        state->onError(error);
+    };
+    handler.onDisconnected = [state](std::string_view) {
+        state->onFinished();
+    };
+    return handler;
+}
+
+bool ResponseState::suspendForHeader(std::coroutine_handle<> handle) noexcept {
+    std::lock_guard lock(mutex_);
+    if (header_.has_value() || isFinished_) {
+        return false;
+    }
+    waiter_ = handle;
+    return true;
+}
+
+bool ResponseState::suspendForChunk(std::coroutine_handle<> handle) noexcept {
+    std::lock_guard lock(mutex_);
+    if (!chunks_.empty() || isFinished_) {
+        return false;
+    }
+    waiter_ = handle;
+    return true;
+}
+
+std::optional<ResponseHeader> ResponseState::takeHeader() noexcept {
+    std::lock_guard lock(mutex_);
+    if (isHeaderTaken_) {
+        return std::nullopt;
+    }
+    isHeaderTaken_ = true;
+    return std::move(header_);
+}
+
+DataPtr ResponseState::takeChunk() noexcept {
+    std::lock_guard lock(mutex_);
+    if (chunks_.empty()) {
+        return nullptr;
+    }
+    auto data = std::move(chunks_.front());
+    chunks_.pop_front();
+    return data;
+}
+
+void ResponseState::onHeader(ResponseHeader&& header) noexcept {
+    std::unique_lock lock(mutex_);
+    header_ = std::move(header);
+    resume(lock);
+}
+
+void ResponseState::onData(DataPtr data) noexcept {
+    std::unique_lock lock(mutex_);
+    chunks_.push_back(std::move(data));
+    resume(lock);
+}
+
+void ResponseState::onError(ErrorInfo error) noexcept {
+    std::lock_guard lock(mutex_);
+    error_ = error;
+}
+
+void ResponseState::onFinished() noexcept {
+    std::unique_lock lock(mutex_);
+    isFinished_ = true;
+    resume(lock);
+}
+
+void ResponseState::resume(std::unique_lock<std::mutex>& lock) noexcept {
+    auto handle = std::exchange(waiter_, nullptr);
+    lock.unlock();
+    if (handle) {
+        handle.resume();
+    }
+}
+
+} //end of namespace http
+
+#endif //end if ENABLE_COROUTINE
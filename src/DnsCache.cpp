@@ -0,0 +1,266 @@
+//
+// Created by Nevermore on 2026/10/17.
+// http-request DnsCache
+// Copyright (c) 2024 Nevermore All rights reserved.
+//
+#include "DnsCache.h"
+#include <algorithm>
+#include <cstring>
+#include "DnsResolver.h"
+
+namespace http {
+
+using namespace http::util;
+
+namespace {
+
+struct AddressNode {
+    addrinfo info;
+    sockaddr_storage address;
+};
+
+void freeAddressNodes(addrinfo* info) noexcept {
+    delete[] reinterpret_cast<AddressNode*>(info);
+}
+
+std::string makeKey(const std::string& host, const std::string& port, int family) noexcept {
+    return host + ":" + port + "#" + std::to_string(family);
+}
+
+} //end of namespace
+
+DnsCache::DnsCache(const DnsCacheConfig& config) noexcept
+    : config_(config) {
+
+}
+
+DnsCache::~DnsCache() {
+    {
+        std::lock_guard lock(mutex_);
+        isRunning_ = false;
+    }
+    cond_.notify_all();
+    if (refresher_.joinable()) {
+        refresher_.join();
+    }
+}
+
+DnsCache& DnsCache::shared() noexcept {
+    static DnsCache cache;
+    return cache;
+}
+
+void DnsCache::setConfig(const DnsCacheConfig& config) noexcept {
+    std::lock_guard lock(mutex_);
+    config_ = config;
+    trim();
+}
+
+std::tuple<AddressInfoPtr, int32_t> DnsCache::resolve(const std::string& host, const std::string& port,
+                                                      IPVersion ipVersion, int64_t timeout) noexcept {
+    if (auto [address, errorCode, isFound] = find(host, port, ipVersion); isFound) {
+        return {std::move(address), errorCode};
+    }
+    ///the lookup blocks, concurrent lookups of other hosts are not serialized behind it
+    auto result = lookup(host, port, ipVersion, timeout);
+    auto address = makeAddressInfo(result.addresses, AF_UNSPEC);
+    store(host, port, ipVersion, result.addresses, result.errorCode, result.ttl);
+    return {std::move(address), result.errorCode};
+}
+
+std::tuple<AddressInfoPtr, int32_t, bool> DnsCache::find(const std::string& host, const std::string& port,
+                                                         IPVersion ipVersion) noexcept {
+    auto family = GetAddressFamily(ipVersion);
+    auto key = makeKey(host, port, family);
+    std::lock_guard lock(mutex_);
+    if (auto it = overrides_.find(host + ":" + port); it != overrides_.end()) {
+        if (auto address = makeAddressInfo(it->second, family)) {
+            return {std::move(address), 0, true};
+        }
+    }
+    if (auto it = entries_.find(key); it != entries_.end()) {
+        auto& entry = it->second;
+        lru_.splice(lru_.begin(), lru_, entry.position);
+        if (Time::steadyTime() < entry.expireTime) {
+            return {makeAddressInfo(entry.addresses, AF_UNSPEC), entry.errorCode, true};
+        } else if (entry.errorCode == 0 && config_.isStaleWhileRefresh) {
+            if (!entry.isRefreshing) {
+                entry.isRefreshing = true;
+                refreshes_.push_back({key, host, port, ipVersion});
+                if (!refresher_.joinable()) {
+                    refresher_ = std::thread([this] {
+                        refreshLoop();
+                    });
+                }
+                cond_.notify_one();
+            }
+            return {makeAddressInfo(entry.addresses, AF_UNSPEC), 0, true};
+        }
+    }
+    return {AddressInfoPtr(nullptr, freeAddressNodes), 0, false};
+}
+
+void DnsCache::setOverride(const std::string& host, const std::string& port,
+                           const std::vector<std::string>& addresses) noexcept {
+    AddressList list;
+    auto portNumber = htons(static_cast<uint16_t>(std::strtoul(port.data(), nullptr, 10)));
+    for (const auto& address : addresses) {
+        Address item;
+        auto ipv4 = reinterpret_cast<sockaddr_in*>(&item.storage);
+        auto ipv6 = reinterpret_cast<sockaddr_in6*>(&item.storage);
+        if (inet_pton(AF_INET, address.data(), &ipv4->sin_addr) == 1) {
+            ipv4->sin_family = AF_INET;
+            ipv4->sin_port = portNumber;
+            item.length = sizeof(sockaddr_in);
+        } else if (inet_pton(AF_INET6, address.data(), &ipv6->sin6_addr) == 1) {
+            ipv6->sin6_family = AF_INET6;
+            ipv6->sin6_port = portNumber;
+            item.length = sizeof(sockaddr_in6);
+        } else {
+            continue;
+        }
+        list.push_back(item);
+    }
+    std::lock_guard lock(mutex_);
+    if (list.empty()) {
+        overrides_.erase(host + ":" + port);
+    } else {
+        overrides_[host + ":" + port] = std::move(list);
+    }
+}
+
+void DnsCache::clear() noexcept {
+    std::lock_guard lock(mutex_);
+    entries_.clear();
+    lru_.clear();
+}
+
+size_t DnsCache::size() const noexcept {
+    std::lock_guard lock(mutex_);
+    return entries_.size();
+}
+
+DnsCache::LookupResult DnsCache::lookup(const std::string& host, const std::string& port, IPVersion ipVersion,
+                                       int64_t timeout) noexcept {
+    if (auto& resolver = DnsResolver::shared(); resolver.isEnabled()) {
+        return resolver.resolve(host, port, ipVersion, timeout);
+    }
+    addrinfo hints{};
+    hints.ai_family = GetAddressFamily(ipVersion);
+    hints.ai_socktype = SOCK_STREAM; //tcp
+    addrinfo* addressInfo = nullptr;
+    LookupResult result;
+    result.errorCode = getaddrinfo(host.data(), port.data(), &hints, &addressInfo);
+    for (auto current = addressInfo; current != nullptr; current = current->ai_next) {
+        if (current->ai_addrlen > sizeof(sockaddr_storage)) {
+            continue;
+        }
+        Address address;
+        std::memcpy(&address.storage, current->ai_addr, current->ai_addrlen);
+        address.length = static_cast<socklen_t>(current->ai_addrlen);
+        result.addresses.push_back(address);
+    }
+    if (addressInfo) {
+        freeaddrinfo(addressInfo);
+    }
+    if (result.errorCode == 0 && result.addresses.empty()) {
+        result.errorCode = EAI_NONAME;
+    }
+    return result;
+}
+
+AddressInfoPtr DnsCache::makeAddressInfo(const AddressList& addresses, int family) noexcept {
+    std::vector<const Address*> matched;
+    for (const auto& address : addresses) {
+        if (family == AF_UNSPEC || address.storage.ss_family == family) {
+            matched.push_back(&address);
+        }
+    }
+    if (matched.empty()) {
+        return AddressInfoPtr(nullptr, freeAddressNodes);
+    }
+    auto nodes = new AddressNode[matched.size()]();
+    for (size_t i = 0; i < matched.size(); i++) {
+        auto& node = nodes[i];
+        std::memcpy(&node.address, &matched[i]->storage, matched[i]->length);
+        node.info.ai_family = matched[i]->storage.ss_family;
+        node.info.ai_socktype = SOCK_STREAM;
+        node.info.ai_protocol = IPPROTO_TCP;
+        node.info.ai_addrlen = matched[i]->length;
+        node.info.ai_addr = reinterpret_cast<sockaddr*>(&node.address);
+        node.info.ai_next = i + 1 < matched.size() ? &nodes[i + 1].info : nullptr;
+    }
+    return AddressInfoPtr(&nodes[0].info, freeAddressNodes);
+}
+
+void DnsCache::store(const std::string& host, const std::string& port, IPVersion ipVersion,
+                     const AddressList& addresses, int32_t errorCode, std::chrono::milliseconds ttl) noexcept {
+    auto key = makeKey(host, port, GetAddressFamily(ipVersion));
+    std::lock_guard lock(mutex_);
+    ttl = entryTtl(errorCode, ttl);
+    if (config_.maxEntries == 0 || ttl.count() <= 0) {
+        if (auto it = entries_.find(key); it != entries_.end()) {
+            lru_.erase(it->second.position);
+            entries_.erase(it);
+        }
+        return;
+    }
+    auto [it, isInserted] = entries_.try_emplace(key);
+    auto& entry = it->second;
+    if (isInserted) {
+        lru_.push_front(key);
+        entry.position = lru_.begin();
+    } else {
+        lru_.splice(lru_.begin(), lru_, entry.position);
+    }
+    entry.addresses = addresses;
+    entry.errorCode = errorCode;
+    entry.expireTime = Time::steadyTime() + ttl;
+    entry.isRefreshing = false;
+    trim();
+}
+
+std::chrono::milliseconds DnsCache::entryTtl(int32_t errorCode, std::chrono::milliseconds ttl) const noexcept {
+    auto configTtl = errorCode == 0 ? config_.ttl : config_.negativeTtl;
+    ///the records of the built-in resolver carry their own ttl
+    return ttl.count() >= 0 ? std::min(ttl, configTtl) : configTtl;
+}
+
+void DnsCache::trim() noexcept {
+    while (entries_.size() > config_.maxEntries) {
+        entries_.erase(lru_.back());
+        lru_.pop_back();
+    }
+}
+
+void DnsCache::refreshLoop() noexcept {
+    std::unique_lock lock(mutex_);
+    while (true) {
+        cond_.wait(lock, [this] {
+            return !isRunning_ || !refreshes_.empty();
+        });
+        if (!isRunning_) {
+            return;
+        }
+        auto refresh = std::move(refreshes_.front());
+        refreshes_.pop_front();
+        lock.unlock();
+        auto result = lookup(refresh.host, refresh.port, refresh.ipVersion, kInvalid);
+        lock.lock();
+        auto it = entries_.find(refresh.key);
+        if (it == entries_.end()) {
+            continue; //evicted or cleared meanwhile
+        }
+        auto& entry = it->second;
+        entry.isRefreshing = false;
+        if (result.errorCode != 0) {
+            ///a failed refresh keeps serving the stale addresses, it is tried again after the negative ttl
+            entry.expireTime = Time::steadyTime() + config_.negativeTtl;
+            continue;
+        }
+        entry.addresses = std::move(result.addresses);
+        entry.expireTime = Time::steadyTime() + entryTtl(0, result.ttl);
+    }
+}
+
+} //end of namespace http
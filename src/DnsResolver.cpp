@@ -0,0 +1,631 @@
+//
+// Created by Nevermore on 2026/10/17.
+// http-request DnsResolver
+// Copyright (c) 2024 Nevermore All rights reserved.
+//
+#include "DnsResolver.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <sstream>
+
+namespace http {
+
+using namespace http::util;
+
+namespace {
+
+constexpr uint16_t kDnsPort = 53;
+constexpr uint16_t kTypeA = 1;
+constexpr uint16_t kTypeAAAA = 28;
+constexpr uint16_t kClassIn = 1;
+constexpr size_t kHeaderSize = 12;
+constexpr uint16_t kFlagResponse = 0x8000;
+constexpr uint16_t kFlagTruncated = 0x0200;
+constexpr uint16_t kFlagRecursionDesired = 0x0100;
+constexpr uint16_t kRcodeNameError = 3;
+///no edns is sent, a udp answer is at most 512 bytes
+constexpr size_t kMaxMessageSize = 512;
+constexpr size_t kMaxNameLength = 253;
+constexpr size_t kMaxLabelLength = 63;
+
+uint16_t read16(std::string_view data, size_t pos) noexcept {
+    return static_cast<uint16_t>(static_cast<uint8_t>(data[pos]) << 8 | static_cast<uint8_t>(data[pos + 1]));
+}
+
+uint32_t read32(std::string_view data, size_t pos) noexcept {
+    return static_cast<uint32_t>(read16(data, pos)) << 16 | read16(data, pos + 2);
+}
+
+void append16(std::string& data, uint16_t value) noexcept {
+    data.push_back(static_cast<char>(value >> 8));
+    data.push_back(static_cast<char>(value & 0xFF));
+}
+
+///a query with one question, empty if the name cannot be encoded
+std::string encodeQuery(std::string_view name, uint16_t id, uint16_t type) noexcept {
+    if (!name.empty() && name.back() == '.') {
+        name.remove_suffix(1);
+    }
+    if (name.empty() || name.size() > kMaxNameLength) {
+        return {};
+    }
+    std::string query;
+    append16(query, id);
+    append16(query, kFlagRecursionDesired);
+    append16(query, 1); //question
+    append16(query, 0);
+    append16(query, 0);
+    append16(query, 0);
+    size_t start = 0;
+    while (start <= name.size()) {
+        auto end = std::min(name.find('.', start), name.size());
+        auto length = end - start;
+        if (length == 0 || length > kMaxLabelLength) {
+            return {};
+        }
+        query.push_back(static_cast<char>(length));
+        query.append(name.substr(start, length));
+        start = end + 1;
+    }
+    query.push_back('\0');
+    append16(query, type);
+    append16(query, kClassIn);
+    return query;
+}
+
+///the offset behind a possibly compressed name, 0 if it is malformed
+size_t skipName(std::string_view data, size_t pos) noexcept {
+    while (pos < data.size()) {
+        auto length = static_cast<uint8_t>(data[pos]);
+        if (length == 0) {
+            return pos + 1;
+        } else if ((length & 0xC0) == 0xC0) {
+            return pos + 2 <= data.size() ? pos + 2 : 0;
+        } else if (length & 0xC0) {
+            return 0;
+        }
+        pos += 1 + static_cast<size_t>(length);
+    }
+    return 0;
+}
+
+bool parseAddress(const std::string& text, uint16_t port, DnsCache::Address& address) noexcept {
+    auto ipv4 = reinterpret_cast<sockaddr_in*>(&address.storage);
+    auto ipv6 = reinterpret_cast<sockaddr_in6*>(&address.storage);
+    if (inet_pton(AF_INET, text.data(), &ipv4->sin_addr) == 1) {
+        ipv4->sin_family = AF_INET;
+        ipv4->sin_port = htons(port);
+        address.length = sizeof(sockaddr_in);
+        return true;
+    } else if (inet_pton(AF_INET6, text.data(), &ipv6->sin6_addr) == 1) {
+        ipv6->sin6_family = AF_INET6;
+        ipv6->sin6_port = htons(port);
+        address.length = sizeof(sockaddr_in6);
+        return true;
+    }
+    return false;
+}
+
+void setPort(DnsCache::Address& address, uint16_t port) noexcept {
+    if (address.storage.ss_family == AF_INET) {
+        reinterpret_cast<sockaddr_in*>(&address.storage)->sin_port = htons(port);
+    } else {
+        reinterpret_cast<sockaddr_in6*>(&address.storage)->sin6_port = htons(port);
+    }
+}
+
+///"ip", "ip:port" or "[ipv6]:port"
+bool parseServer(const std::string& text, DnsCache::Address& address) noexcept {
+    auto host = text;
+    auto port = std::string();
+    if (!text.empty() && text.front() == '[') {
+        auto end = text.find(']');
+        if (end == std::string::npos || (end + 1 < text.size() && text[end + 1] != ':')) {
+            return false;
+        }
+        host = text.substr(1, end - 1);
+        port = end + 1 < text.size() ? text.substr(end + 2) : std::string();
+    } else if (std::count(text.begin(), text.end(), ':') == 1) {
+        auto pos = text.find(':');
+        host = text.substr(0, pos);
+        port = text.substr(pos + 1);
+    }
+    auto portNumber = port.empty() ? kDnsPort : static_cast<uint16_t>(std::strtoul(port.data(), nullptr, 10));
+    return portNumber != 0 && parseAddress(host, portNumber, address);
+}
+
+std::unordered_map<std::string, DnsCache::AddressList> loadHosts(const std::string& path) noexcept {
+    std::unordered_map<std::string, DnsCache::AddressList> hosts;
+    std::ifstream file(path);
+    std::string line;
+    while (std::getline(file, line)) {
+        line = line.substr(0, line.find('#'));
+        std::istringstream stream(line);
+        std::string ip;
+        DnsCache::Address address;
+        if (!(stream >> ip) || !parseAddress(ip, 0, address)) {
+            continue;
+        }
+        std::string name;
+        while (stream >> name) {
+            StringUtil::toLower(name);
+            hosts[name].push_back(address);
+        }
+    }
+    return hosts;
+}
+
+uint16_t randomId() noexcept {
+    thread_local std::mt19937 engine{std::random_device{}()};
+    return static_cast<uint16_t>(engine());
+}
+
+bool setNonBlocking(Socket socket) noexcept {
+#if defined(_WIN32) || defined(__CYGWIN__)
+    u_long mode = 1;
+    return ioctlsocket(socket, FIONBIO, &mode) != SocketError;
+#else
+    auto flags = fcntl(socket, F_GETFL);
+    return flags != kInvalid && fcntl(socket, F_SETFL, flags | O_NONBLOCK) != kInvalid;
+#endif
+}
+
+} //end of namespace
+
+///The queries of one host, the caller waits for the socket to become readable and for the attempt timeout.
+class DnsExchange {
+public:
+    enum class Status : uint8_t {
+        Pending,
+        Done,
+        ///the nameserver failed every unanswered query, the next one is asked without waiting
+        NextServer,
+    };
+
+    DnsExchange(std::shared_ptr<const DnsResolver::Settings> settings, const std::string& host, const std::string& port,
+                IPVersion ipVersion) noexcept;
+    ~DnsExchange();
+    DnsExchange(const DnsExchange&) = delete;
+    DnsExchange& operator=(const DnsExchange&) = delete;
+
+    ///answered without a query
+    [[nodiscard]] bool isDone() const noexcept {
+        return isDone_;
+    }
+
+    ///send the unanswered queries to the next nameserver, false once the attempts are used up
+    bool next() noexcept;
+
+    ///read the answers that arrived
+    Status receive() noexcept;
+
+    [[nodiscard]] Socket fd() const noexcept {
+        return socket_;
+    }
+
+    [[nodiscard]] std::chrono::milliseconds attemptTimeout() const noexcept {
+        return settings_->config.attemptTimeout;
+    }
+
+    [[nodiscard]] DnsCache::LookupResult result() const noexcept;
+
+private:
+    struct Question {
+        uint16_t type = kTypeA;
+        std::string query;
+        bool isAnswered = false;
+        bool isFailed = false;
+        int32_t errorCode = EAI_AGAIN;
+        DnsCache::AddressList addresses;
+        std::chrono::milliseconds ttl{kInvalid};
+    };
+
+    void parse(std::string_view data) noexcept;
+    void closeSocket() noexcept;
+
+private:
+    std::shared_ptr<const DnsResolver::Settings> settings_;
+    uint16_t port_ = 0;
+    std::vector<Question> questions_;
+    size_t attempt_ = 0;
+    Socket socket_ = kInvalidSocket;
+    bool isDone_ = false;
+    ///the result of a host answered without a query
+    DnsCache::LookupResult result_;
+};
+
+DnsExchange::DnsExchange(std::shared_ptr<const DnsResolver::Settings> settings, const std::string& host,
+                         const std::string& port, IPVersion ipVersion) noexcept
+    : settings_(std::move(settings)) {
+    isDone_ = true;
+    char* end = nullptr;
+    auto portNumber = std::strtoul(port.data(), &end, 10);
+    if (port.empty() || *end != '\0' || portNumber > UINT16_MAX) {
+        result_.errorCode = EAI_SERVICE;
+        return;
+    }
+    port_ = static_cast<uint16_t>(portNumber);
+    auto family = GetAddressFamily(ipVersion);
+    auto isMatched = [family](const DnsCache::Address& address) {
+        return family == AF_UNSPEC || address.storage.ss_family == family;
+    };
+    if (DnsCache::Address address; parseAddress(host, port_, address)) {
+        if (isMatched(address)) {
+            result_.addresses.push_back(address);
+        } else {
+            result_.errorCode = EAI_NONAME;
+        }
+        return;
+    }
+    auto name = StringUtil::toLower(host);
+    if (!name.empty() && name.back() == '.') {
+        name.pop_back();
+    }
+    if (auto it = settings_->hosts.find(name); it != settings_->hosts.end()) {
+        for (auto address : it->second) {
+            if (isMatched(address)) {
+                setPort(address, port_);
+                result_.addresses.push_back(address);
+            }
+        }
+        if (!result_.addresses.empty()) {
+            return;
+        }
+    }
+    ///the AAAA answers go first like the default address selection of getaddrinfo
+    for (auto type : {kTypeAAAA, kTypeA}) {
+        if ((type == kTypeA && family == AF_INET6) || (type == kTypeAAAA && family == AF_INET)) {
+            continue;
+        }
+        Question question;
+        question.type = type;
+        question.query = encodeQuery(host, randomId(), type);
+        if (question.query.empty()) {
+            result_.errorCode = EAI_NONAME;
+            return;
+        }
+        questions_.push_back(std::move(question));
+    }
+    isDone_ = false;
+}
+
+DnsExchange::~DnsExchange() {
+    closeSocket();
+}
+
+bool DnsExchange::next() noexcept {
+    closeSocket();
+    const auto& servers = settings_->servers;
+    auto attemptCount = servers.size() * std::max<size_t>(settings_->config.attempts, 1);
+    while (attempt_ < attemptCount) {
+        const auto& server = servers[attempt_++ % servers.size()];
+        socket_ = ::socket(server.storage.ss_family, SOCK_DGRAM, IPPROTO_UDP);
+        if (socket_ == kInvalidSocket) {
+            continue;
+        }
+        ///a connected socket only receives the datagrams of the nameserver
+        if (!setNonBlocking(socket_) ||
+            ::connect(socket_, reinterpret_cast<const sockaddr*>(&server.storage), server.length) == SocketError) {
+            closeSocket();
+            continue;
+        }
+        auto isSent = false;
+        for (auto& question : questions_) {
+            if (question.isAnswered) {
+                continue;
+            }
+            question.isFailed = false;
+            auto size = ::send(socket_, question.query.data(), question.query.size(), kNoSignal);
+            isSent |= size == static_cast<decltype(size)>(question.query.size());
+        }
+        if (isSent) {
+            return true;
+        }
+        closeSocket();
+    }
+    return false;
+}
+
+DnsExchange::Status DnsExchange::receive() noexcept {
+    char buffer[kMaxMessageSize];
+    while (true) {
+        auto size = ::recv(socket_, buffer, sizeof(buffer), 0);
+        if (size == SocketError) {
+            auto errorCode = GetLastError();
+            if (errorCode == RetryCode) {
+                continue;
+            } else if (errorCode != AgainCode) {
+                ///the nameserver is unreachable, the icmp error is reported on the connected socket
+                for (auto& question : questions_) {
+                    question.isFailed = true;
+                }
+            }
+            break;
+        }
+        parse(std::string_view(buffer, static_cast<size_t>(size)));
+    }
+    auto isDone = true;
+    auto isFailed = true;
+    for (const auto& question : questions_) {
+        if (!question.isAnswered) {
+            isDone = false;
+            isFailed &= question.isFailed;
+        }
+    }
+    if (isDone) {
+        return Status::Done;
+    }
+    return isFailed ? Status::NextServer : Status::Pending;
+}
+
+void DnsExchange::parse(std::string_view data) noexcept {
+    if (data.size() < kHeaderSize) {
+        return;
+    }
+    auto id = read16(data, 0);
+    auto it = std::find_if(questions_.begin(), questions_.end(), [id](const Question& question) {
+        return !question.isAnswered && read16(question.query, 0) == id;
+    });
+    auto flags = read16(data, 2);
+    if (it == questions_.end() || !(flags & kFlagResponse) || read16(data, 4) != 1) {
+        return;
+    }
+    auto& question = *it;
+    ///the question is echoed, an answer to another name is dropped
+    auto questionView = std::string_view(question.query).substr(kHeaderSize);
+    if (data.substr(kHeaderSize, questionView.size()) != questionView) {
+        return;
+    }
+    auto rcode = flags & 0x0F;
+    if (rcode == kRcodeNameError) {
+        question.isAnswered = true;
+        question.errorCode = EAI_NONAME;
+        return;
+    } else if (rcode != 0) {
+        question.isFailed = true;
+        return;
+    }
+    auto addressLength = question.type == kTypeA ? sizeof(in_addr) : sizeof(in6_addr);
+    auto pos = question.query.size();
+    DnsCache::AddressList addresses;
+    auto ttl = std::chrono::milliseconds(kInvalid);
+    auto answerCount = read16(data, 6);
+    for (uint16_t i = 0; i < answerCount; i++) {
+        pos = skipName(data, pos);
+        if (pos == 0 || pos + 10 > data.size()) {
+            break;
+        }
+        auto type = read16(data, pos);
+        auto recordClass = read16(data, pos + 2);
+        auto recordTtl = std::chrono::milliseconds(static_cast<int64_t>(read32(data, pos + 4)) * 1000);
+        auto length = read16(data, pos + 8);
+        pos += 10;
+        if (pos + length > data.size()) {
+            break;
+        }
+        ///the cname records of the chain are skipped, the addresses follow them
+        if (type == question.type && recordClass == kClassIn && length == addressLength) {
+            DnsCache::Address address;
+            address.storage.ss_family = question.type == kTypeA ? AF_INET : AF_INET6;
+            if (question.type == kTypeA) {
+                std::memcpy(&reinterpret_cast<sockaddr_in*>(&address.storage)->sin_addr, data.data() + pos, length);
+                address.length = sizeof(sockaddr_in);
+            } else {
+                std::memcpy(&reinterpret_cast<sockaddr_in6*>(&address.storage)->sin6_addr, data.data() + pos, length);
+                address.length = sizeof(sockaddr_in6);
+            }
+            setPort(address, port_);
+            addresses.push_back(address);
+            ttl = ttl.count() < 0 ? recordTtl : std::min(ttl, recordTtl);
+        }
+        pos += length;
+    }
+    if (addresses.empty() && (flags & kFlagTruncated)) {
+        ///the answer needs tcp, which is not supported
+        question.isFailed = true;
+        return;
+    }
+    question.isAnswered = true;
+    question.errorCode = addresses.empty() ? EAI_NONAME : 0;
+    question.addresses = std::move(addresses);
+    question.ttl = ttl;
+}
+
+DnsCache::LookupResult DnsExchange::result() const noexcept {
+    if (isDone_) {
+        return result_;
+    }
+    DnsCache::LookupResult result;
+    auto isNoName = false;
+    for (const auto& question : questions_) {
+        result.addresses.insert(result.addresses.end(), question.addresses.begin(), question.addresses.end());
+        isNoName |= question.errorCode == EAI_NONAME;
+        if (question.ttl.count() >= 0) {
+            result.ttl = result.ttl.count() < 0 ? question.ttl : std::min(result.ttl, question.ttl);
+        }
+    }
+    if (result.addresses.empty()) {
+        ///a name without addresses is not retried before the negative ttl, a server that did not answer is
+        result.errorCode = isNoName ? EAI_NONAME : EAI_AGAIN;
+    }
+    return result;
+}
+
+void DnsExchange::closeSocket() noexcept {
+    if (socket_ == kInvalidSocket) {
+        return;
+    }
+#if defined(_WIN32) || defined(__CYGWIN__)
+    closesocket(socket_);
+#else
+    ::close(socket_);
+#endif
+    socket_ = kInvalidSocket;
+}
+
+DnsResolver& DnsResolver::shared() noexcept {
+    static DnsResolver resolver;
+    return resolver;
+}
+
+void DnsResolver::setConfig(const DnsResolverConfig& config) noexcept {
+    auto settings = std::make_shared<Settings>();
+    settings->config = config;
+    if (config.isEnabled) {
+        auto nameservers = config.nameservers.empty() ? loadNameservers("/etc/resolv.conf") : config.nameservers;
+        for (const auto& nameserver : nameservers) {
+            if (DnsCache::Address address; parseServer(nameserver, address)) {
+                settings->servers.push_back(address);
+            }
+        }
+        settings->hosts = loadHosts("/etc/hosts");
+    }
+    std::lock_guard lock(mutex_);
+    settings_ = std::move(settings);
+}
+
+bool DnsResolver::isEnabled() const noexcept {
+    std::lock_guard lock(mutex_);
+    return settings_->config.isEnabled && !settings_->servers.empty();
+}
+
+std::shared_ptr<const DnsResolver::Settings> DnsResolver::settings() const noexcept {
+    std::lock_guard lock(mutex_);
+    return settings_;
+}
+
+DnsCache::LookupResult DnsResolver::resolve(const std::string& host, const std::string& port, IPVersion ipVersion,
+                                            int64_t timeout) const noexcept {
+    DnsExchange exchange(settings(), host, port, ipVersion);
+    auto isLimited = timeout >= 0;
+    auto expiredTime = Time::steadyTime() + std::chrono::milliseconds(std::max<int64_t>(timeout, 0));
+    while (!exchange.isDone() && exchange.next()) {
+        auto attemptExpiredTime = Time::steadyTime() + exchange.attemptTimeout();
+        if (isLimited) {
+            attemptExpiredTime = std::min(attemptExpiredTime, expiredTime);
+        }
+        auto status = DnsExchange::Status::Pending;
+        while (status == DnsExchange::Status::Pending) {
+            auto waitTime = attemptExpiredTime - Time::steadyTime();
+            if (waitTime.count() <= 0) {
+                break;
+            }
+            auto result = select(SelectType::Read, exchange.fd(), waitTime.count());
+            if (result.resultCode == ResultCode::Retry) {
+                continue;
+            } else if (!result.isSuccess()) {
+                break;
+            }
+            status = exchange.receive();
+        }
+        if (status == DnsExchange::Status::Done || (isLimited && Time::steadyTime() >= expiredTime)) {
+            break;
+        }
+    }
+    return exchange.result();
+}
+
+std::vector<std::string> DnsResolver::loadNameservers(const std::string& path) noexcept {
+    std::vector<std::string> nameservers;
+    std::ifstream file(path);
+    std::string line;
+    while (std::getline(file, line)) {
+        std::istringstream stream(line.substr(0, line.find_first_of("#;")));
+        std::string keyword;
+        std::string address;
+        if (stream >> keyword >> address && keyword == "nameserver") {
+            nameservers.push_back(address);
+        }
+    }
+    return nameservers;
+}
+
+DnsQuery::DnsQuery(EventLoop& loop, std::string host, std::string port, IPVersion ipVersion, ResolveFunc&& onResolve)
+    : loop_(loop)
+    , host_(std::move(host))
+    , port_(std::move(port))
+    , ipVersion_(ipVersion)
+    , onResolve_(std::move(onResolve)) {
+
+}
+
+DnsQuery::~DnsQuery() {
+    stop();
+}
+
+void DnsQuery::start() noexcept {
+    if (auto [address, errorCode, isFound] = DnsCache::shared().find(host_, port_, ipVersion_); isFound) {
+        finish(std::move(address), errorCode);
+        return;
+    }
+    auto& resolver = DnsResolver::shared();
+    if (!resolver.isEnabled()) {
+        ///getaddrinfo blocks the loop thread
+        auto [address, errorCode] = DnsCache::shared().resolve(host_, port_, ipVersion_);
+        finish(std::move(address), errorCode);
+        return;
+    }
+    exchange_ = std::make_unique<DnsExchange>(resolver.settings(), host_, port_, ipVersion_);
+    if (exchange_->isDone()) {
+        complete();
+        return;
+    }
+    next();
+}
+
+void DnsQuery::next() noexcept {
+    stop();
+    if (!exchange_->next()) {
+        complete();
+        return;
+    }
+    socket_ = exchange_->fd();
+    if (!loop_.addEvent(socket_, kEventRead, [this](uint32_t) { onEvent(); })) {
+        socket_ = kInvalidSocket;
+        next();
+        return;
+    }
+    timerId_ = loop_.runAfter(exchange_->attemptTimeout(), [this] {
+        timerId_ = 0;
+        next();
+    });
+}
+
+void DnsQuery::onEvent() noexcept {
+    auto status = exchange_->receive();
+    if (status == DnsExchange::Status::Done) {
+        complete();
+    } else if (status == DnsExchange::Status::NextServer) {
+        next();
+    }
+}
+
+void DnsQuery::complete() noexcept {
+    stop();
+    auto result = exchange_->result();
+    DnsCache::shared().store(host_, port_, ipVersion_, result.addresses, result.errorCode, result.ttl);
+    finish(DnsCache::makeAddressInfo(result.addresses, AF_UNSPEC), result.errorCode);
+}
+
+void DnsQuery::finish(AddressInfoPtr address, int32_t errorCode) noexcept {
+    ///the owner may destroy the query in the callback
+    auto onResolve = std::move(onResolve_);
+    if (onResolve) {
+        onResolve(std::move(address), errorCode);
+    }
+}
+
+void DnsQuery::stop() noexcept {
+    if (socket_ != kInvalidSocket) {
+        loop_.removeEvent(socket_);
+        socket_ = kInvalidSocket;
+    }
+    if (timerId_ != 0) {
+        loop_.cancelTimer(timerId_);
+        timerId_ = 0;
+    }
+}
+
+} //end of namespace http
@@ -0,0 +1,289 @@
+//
+// Created by Nevermore on 2026/10/17.
+// http-request EventLoop
+// Copyright (c) 2024 Nevermore All rights reserved.
+//
+#include "EventLoop.h"
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#elif !defined(_WIN32) && !defined(__CYGWIN__)
+#include <poll.h>
+#endif
+
+namespace http {
+
+constexpr int32_t kMaxEventCount = 128;
+#if defined(_WIN32) || defined(__CYGWIN__)
+///there is no wakeup pipe on windows, bound the poll timeout instead
+constexpr int64_t kMaxPollTimeout = 10;
+#else
+constexpr int64_t kMaxPollTimeout = 1000;
+#endif
+
+using namespace http::util;
+
+EventLoop::EventLoop()
+    : timerWheel_(Time::steadyTime().count()) {
+#if defined(__linux__)
+    pollFd_ = epoll_create1(EPOLL_CLOEXEC);
+    wakeupFd_[0] = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    wakeupFd_[1] = wakeupFd_[0];
+    if (pollFd_ != kInvalid && wakeupFd_[0] != kInvalid) {
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.fd = wakeupFd_[0];
+        epoll_ctl(pollFd_, EPOLL_CTL_ADD, wakeupFd_[0], &event);
+    }
+#elif !defined(_WIN32) && !defined(__CYGWIN__)
+    if (pipe(wakeupFd_) == 0) {
+        fcntl(wakeupFd_[0], F_SETFL, fcntl(wakeupFd_[0], F_GETFL) | O_NONBLOCK);
+        fcntl(wakeupFd_[1], F_SETFL, fcntl(wakeupFd_[1], F_GETFL) | O_NONBLOCK);
+    }
+#endif
+}
+
+EventLoop::~EventLoop() {
+    stop();
+#if defined(__linux__)
+    if (pollFd_ != kInvalid) {
+        ::close(pollFd_);
+    }
+    if (wakeupFd_[0] != kInvalid) {
+        ::close(wakeupFd_[0]);
+    }
+#elif !defined(_WIN32) && !defined(__CYGWIN__)
+    for (auto fd : wakeupFd_) {
+        if (fd != kInvalid) {
+            ::close(fd);
+        }
+    }
+#endif
+}
+
+static void setThreadAffinity(int32_t cpu) noexcept {
+    if (cpu < 0) {
+        return;
+    }
+#if defined(__linux__)
+    cpu_set_t cpuSet;
+    CPU_ZERO(&cpuSet);
+    CPU_SET(cpu, &cpuSet);
+    pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet);
+#elif defined(_WIN32) || defined(__CYGWIN__)
+    SetThreadAffinityMask(GetCurrentThread(), static_cast<DWORD_PTR>(1) << cpu);
+#endif
+}
+
+bool EventLoop::start(int32_t cpu) noexcept {
+#if defined(__linux__)
+    if (pollFd_ == kInvalid) {
+        return false;
+    }
+#endif
+    if (isRunning_.exchange(true)) {
+        return true;
+    }
+    worker_ = std::make_unique<std::thread>(&EventLoop::loop, this, cpu);
+    threadId_ = worker_->get_id();
+    return true;
+}
+
+void EventLoop::stop() noexcept {
+    if (!isRunning_.exchange(false)) {
+        return;
+    }
+    wakeup();
+    if (worker_ && worker_->joinable()) {
+        worker_->join();
+    }
+    worker_.reset();
+}
+
+void EventLoop::post(Task&& task) noexcept {
+    {
+        std::lock_guard lock(taskMutex_);
+        tasks_.push_back(std::move(task));
+    }
+    if (!isInLoopThread()) {
+        wakeup();
+    }
+}
+
+void EventLoop::wakeup() noexcept {
+#if defined(__linux__)
+    uint64_t value = 1;
+    [[maybe_unused]] auto res = ::write(wakeupFd_[1], &value, sizeof(value));
+#elif !defined(_WIN32) && !defined(__CYGWIN__)
+    char value = 1;
+    [[maybe_unused]] auto res = ::write(wakeupFd_[1], &value, sizeof(value));
+#endif
+}
+
+bool EventLoop::addEvent(Socket socket, uint32_t events, EventFunc&& func) noexcept {
+    if (socket == kInvalidSocket || handlers_.count(socket) > 0) {
+        return false;
+    }
+#if defined(__linux__)
+    epoll_event event{};
+    event.events = ((events & kEventRead) ? EPOLLIN : 0u) | ((events & kEventWrite) ? EPOLLOUT : 0u);
+    event.data.fd = socket;
+    if (epoll_ctl(pollFd_, EPOLL_CTL_ADD, socket, &event) == kInvalid) {
+        return false;
+    }
+#endif
+    handlers_[socket] = std::make_shared<EventFunc>(std::move(func));
+    events_[socket] = events;
+    return true;
+}
+
+bool EventLoop::updateEvent(Socket socket, uint32_t events) noexcept {
+    auto it = events_.find(socket);
+    if (it == events_.end()) {
+        return false;
+    }
+    if (it->second == events) {
+        return true;
+    }
+#if defined(__linux__)
+    epoll_event event{};
+    event.events = ((events & kEventRead) ? EPOLLIN : 0u) | ((events & kEventWrite) ? EPOLLOUT : 0u);
+    event.data.fd = socket;
+    if (epoll_ctl(pollFd_, EPOLL_CTL_MOD, socket, &event) == kInvalid) {
+        return false;
+    }
+#endif
+    it->second = events;
+    return true;
+}
+
+void EventLoop::removeEvent(Socket socket) noexcept {
+    if (handlers_.erase(socket) == 0) {
+        return;
+    }
+    events_.erase(socket);
+#if defined(__linux__)
+    epoll_ctl(pollFd_, EPOLL_CTL_DEL, socket, nullptr);
+#endif
+}
+
+uint64_t EventLoop::runAfter(std::chrono::milliseconds delay, Task&& task) noexcept {
+    return timerWheel_.add((Time::steadyTime() + delay).count(), std::move(task));
+}
+
+void EventLoop::cancelTimer(uint64_t timerId) noexcept {
+    timerWheel_.cancel(timerId);
+}
+
+int64_t EventLoop::runTimers() noexcept {
+    auto timeout = timerWheel_.advance(Time::steadyTime().count());
+    if (timeout == kInvalid) {
+        return kMaxPollTimeout;
+    }
+    return std::min<int64_t>(timeout, kMaxPollTimeout);
+}
+
+void EventLoop::runTasks() noexcept {
+    std::vector<Task> tasks;
+    {
+        std::lock_guard lock(taskMutex_);
+        tasks.swap(tasks_);
+    }
+    for (auto& task : tasks) {
+        task();
+    }
+}
+
+void EventLoop::dispatch(Socket socket, uint32_t events) noexcept {
+    auto it = handlers_.find(socket);
+    if (it == handlers_.end()) {
+        return; //removed by a previous handler
+    }
+    auto handler = it->second; //the handler may remove itself
+    (*handler)(events);
+}
+
+void EventLoop::poll(int64_t timeout) noexcept {
+#if defined(__linux__)
+    epoll_event events[kMaxEventCount];
+    auto count = epoll_wait(pollFd_, events, kMaxEventCount, static_cast<int>(timeout));
+    for (int i = 0; i < count; i++) {
+        auto fd = events[i].data.fd;
+        if (fd == wakeupFd_[0]) {
+            uint64_t value = 0;
+            [[maybe_unused]] auto res = ::read(fd, &value, sizeof(value));
+            continue;
+        }
+        uint32_t flags = 0;
+        flags |= (events[i].events & EPOLLIN) ? kEventRead : 0;
+        flags |= (events[i].events & EPOLLOUT) ? kEventWrite : 0;
+        flags |= (events[i].events & (EPOLLERR | EPOLLHUP)) ? kEventError : 0;
+        dispatch(fd, flags);
+    }
+#else
+#if defined(_WIN32) || defined(__CYGWIN__)
+    using pollfd = WSAPOLLFD;
+    auto pollFunc = [](pollfd* fds, size_t count, int timeout) {
+        return WSAPoll(fds, static_cast<ULONG>(count), timeout);
+    };
+#else
+    auto pollFunc = [](pollfd* fds, size_t count, int timeout) {
+        return ::poll(fds, static_cast<nfds_t>(count), timeout);
+    };
+#endif
+    std::vector<pollfd> fds;
+    fds.reserve(events_.size() + 1);
+    if (wakeupFd_[0] != kInvalid) {
+        fds.push_back({static_cast<Socket>(wakeupFd_[0]), POLLIN, 0});
+    }
+    for (auto& [socket, events] : events_) {
+        short pollEvents = ((events & kEventRead) ? POLLIN : 0) | ((events & kEventWrite) ? POLLOUT : 0);
+        fds.push_back({socket, pollEvents, 0});
+    }
+    if (pollFunc(fds.data(), fds.size(), static_cast<int>(timeout)) <= 0) {
+        return;
+    }
+    for (auto& fd : fds) {
+        if (fd.revents == 0) {
+            continue;
+        }
+#if !defined(_WIN32) && !defined(__CYGWIN__)
+        if (fd.fd == wakeupFd_[0]) {
+            char buffer[64];
+            while (::read(wakeupFd_[0], buffer, sizeof(buffer)) > 0) {}
+            continue;
+        }
+#endif
+        uint32_t flags = 0;
+        flags |= (fd.revents & POLLIN) ? kEventRead : 0;
+        flags |= (fd.revents & POLLOUT) ? kEventWrite : 0;
+        flags |= (fd.revents & (POLLERR | POLLHUP)) ? kEventError : 0;
+        dispatch(fd.fd, flags);
+    }
+#endif
+}
+
+void EventLoop::loop(int32_t cpu) noexcept {
+    threadId_ = std::this_thread::get_id();
+    setThreadAffinity(cpu);
+    while (isRunning_) {
+        runTasks();
+        auto timeout = runTimers();
+        {
+            std::lock_guard lock(taskMutex_);
+            if (!tasks_.empty()) {
+                timeout = 0;
+            }
+        }
+        poll(timeout);
+    }
+    handlers_.clear();
+    events_.clear();
+    timerWheel_.clear();
+    std::lock_guard lock(taskMutex_);
+    tasks_.clear();
+}
+
+} //end of namespace http
@@ -0,0 +1,421 @@
+//
+// Created by Nevermore on 2026/10/17.
+// http-request Hpack
+// Copyright (c) 2024 Nevermore All rights reserved.
+//
+#include "Hpack.h"
+#include <array>
+
+namespace http::hpack {
+
+namespace {
+
+struct HuffmanCode {
+    uint32_t code;
+    uint8_t length;
+};
+
+///https://www.rfc-editor.org/rfc/rfc7541#appendix-B, the last one is EOS
+constexpr std::array<HuffmanCode, 257> kHuffmanCodes = {{
+    {0x1ff8, 13}, {0x7fffd8, 23}, {0xfffffe2, 28}, {0xfffffe3, 28}, {0xfffffe4, 28}, {0xfffffe5, 28}, {0xfffffe6, 28}, {0xfffffe7, 28},
+    {0xfffffe8, 28}, {0xffffea, 24}, {0x3ffffffc, 30}, {0xfffffe9, 28}, {0xfffffea, 28}, {0x3ffffffd, 30}, {0xfffffeb, 28}, {0xfffffec, 28},
+    {0xfffffed, 28}, {0xfffffee, 28}, {0xfffffef, 28}, {0xffffff0, 28}, {0xffffff1, 28}, {0xffffff2, 28}, {0x3ffffffe, 30}, {0xffffff3, 28},
+    {0xffffff4, 28}, {0xffffff5, 28}, {0xffffff6, 28}, {0xffffff7, 28}, {0xffffff8, 28}, {0xffffff9, 28}, {0xffffffa, 28}, {0xffffffb, 28},
+    {0x14, 6}, {0x3f8, 10}, {0x3f9, 10}, {0xffa, 12}, {0x1ff9, 13}, {0x15, 6}, {0xf8, 8}, {0x7fa, 11},
+    {0x3fa, 10}, {0x3fb, 10}, {0xf9, 8}, {0x7fb, 11}, {0xfa, 8}, {0x16, 6}, {0x17, 6}, {0x18, 6},
+    {0x0, 5}, {0x1, 5}, {0x2, 5}, {0x19, 6}, {0x1a, 6}, {0x1b, 6}, {0x1c, 6}, {0x1d, 6},
+    {0x1e, 6}, {0x1f, 6}, {0x5c, 7}, {0xfb, 8}, {0x7ffc, 15}, {0x20, 6}, {0xffb, 12}, {0x3fc, 10},
+    {0x1ffa, 13}, {0x21, 6}, {0x5d, 7}, {0x5e, 7}, {0x5f, 7}, {0x60, 7}, {0x61, 7}, {0x62, 7},
+    {0x63, 7}, {0x64, 7}, {0x65, 7}, {0x66, 7}, {0x67, 7}, {0x68, 7}, {0x69, 7}, {0x6a, 7},
+    {0x6b, 7}, {0x6c, 7}, {0x6d, 7}, {0x6e, 7}, {0x6f, 7}, {0x70, 7}, {0x71, 7}, {0x72, 7},
+    {0xfc, 8}, {0x73, 7}, {0xfd, 8}, {0x1ffb, 13}, {0x7fff0, 19}, {0x1ffc, 13}, {0x3ffc, 14}, {0x22, 6},
+    {0x7ffd, 15}, {0x3, 5}, {0x23, 6}, {0x4, 5}, {0x24, 6}, {0x5, 5}, {0x25, 6}, {0x26, 6},
+    {0x27, 6}, {0x6, 5}, {0x74, 7}, {0x75, 7}, {0x28, 6}, {0x29, 6}, {0x2a, 6}, {0x7, 5},
+    {0x2b, 6}, {0x76, 7}, {0x2c, 6}, {0x8, 5}, {0x9, 5}, {0x2d, 6}, {0x77, 7}, {0x78, 7},
+    {0x79, 7}, {0x7a, 7}, {0x7b, 7}, {0x7ffe, 15}, {0x7fc, 11}, {0x3ffd, 14}, {0x1ffd, 13}, {0xffffffc, 28},
+    {0xfffe6, 20}, {0x3fffd2, 22}, {0xfffe7, 20}, {0xfffe8, 20}, {0x3fffd3, 22}, {0x3fffd4, 22}, {0x3fffd5, 22}, {0x7fffd9, 23},
+    {0x3fffd6, 22}, {0x7fffda, 23}, {0x7fffdb, 23}, {0x7fffdc, 23}, {0x7fffdd, 23}, {0x7fffde, 23}, {0xffffeb, 24}, {0x7fffdf, 23},
+    {0xffffec, 24}, {0xffffed, 24}, {0x3fffd7, 22}, {0x7fffe0, 23}, {0xffffee, 24}, {0x7fffe1, 23}, {0x7fffe2, 23}, {0x7fffe3, 23},
+    {0x7fffe4, 23}, {0x1fffdc, 21}, {0x3fffd8, 22}, {0x7fffe5, 23}, {0x3fffd9, 22}, {0x7fffe6, 23}, {0x7fffe7, 23}, {0xffffef, 24},
+    {0x3fffda, 22}, {0x1fffdd, 21}, {0xfffe9, 20}, {0x3fffdb, 22}, {0x3fffdc, 22}, {0x7fffe8, 23}, {0x7fffe9, 23}, {0x1fffde, 21},
+    {0x7fffea, 23}, {0x3fffdd, 22}, {0x3fffde, 22}, {0xfffff0, 24}, {0x1fffdf, 21}, {0x3fffdf, 22}, {0x7fffeb, 23}, {0x7fffec, 23},
+    {0x1fffe0, 21}, {0x1fffe1, 21}, {0x3fffe0, 22}, {0x1fffe2, 21}, {0x7fffed, 23}, {0x3fffe1, 22}, {0x7fffee, 23}, {0x7fffef, 23},
+    {0xfffea, 20}, {0x3fffe2, 22}, {0x3fffe3, 22}, {0x3fffe4, 22}, {0x7ffff0, 23}, {0x3fffe5, 22}, {0x3fffe6, 22}, {0x7ffff1, 23},
+    {0x3ffffe0, 26}, {0x3ffffe1, 26}, {0xfffeb, 20}, {0x7fff1, 19}, {0x3fffe7, 22}, {0x7ffff2, 23}, {0x3fffe8, 22}, {0x1ffffec, 25},
+    {0x3ffffe2, 26}, {0x3ffffe3, 26}, {0x3ffffe4, 26}, {0x7ffffde, 27}, {0x7ffffdf, 27}, {0x3ffffe5, 26}, {0xfffff1, 24}, {0x1ffffed, 25},
+    {0x7fff2, 19}, {0x1fffe3, 21}, {0x3ffffe6, 26}, {0x7ffffe0, 27}, {0x7ffffe1, 27}, {0x3ffffe7, 26}, {0x7ffffe2, 27}, {0xfffff2, 24},
+    {0x1fffe4, 21}, {0x1fffe5, 21}, {0x3ffffe8, 26}, {0x3ffffe9, 26}, {0xffffffd, 28}, {0x7ffffe3, 27}, {0x7ffffe4, 27}, {0x7ffffe5, 27},
+    {0xfffec, 20}, {0xfffff3, 24}, {0xfffed, 20}, {0x1fffe6, 21}, {0x3fffe9, 22}, {0x1fffe7, 21}, {0x1fffe8, 21}, {0x7ffff3, 23},
+    {0x3fffea, 22}, {0x3fffeb, 22}, {0x1ffffee, 25}, {0x1ffffef, 25}, {0xfffff4, 24}, {0xfffff5, 24}, {0x3ffffea, 26}, {0x7ffff4, 23},
+    {0x3ffffeb, 26}, {0x7ffffe6, 27}, {0x3ffffec, 26}, {0x3ffffed, 26}, {0x7ffffe7, 27}, {0x7ffffe8, 27}, {0x7ffffe9, 27}, {0x7ffffea, 27},
+    {0x7ffffeb, 27}, {0xffffffe, 28}, {0x7ffffec, 27}, {0x7ffffed, 27}, {0x7ffffee, 27}, {0x7ffffef, 27}, {0x7fffff0, 27}, {0x3ffffee, 26},
+    {0x3fffffff, 30},
+}};
+
+constexpr uint16_t kEndOfString = 256;
+
+using StaticField = std::pair<std::string_view, std::string_view>;
+
+///https://www.rfc-editor.org/rfc/rfc7541#appendix-A, index 1 is the first one
+constexpr std::array<StaticField, 61> kStaticTable = {{
+    {":authority", ""},
+    {":method", "GET"},
+    {":method", "POST"},
+    {":path", "/"},
+    {":path", "/index.html"},
+    {":scheme", "http"},
+    {":scheme", "https"},
+    {":status", "200"},
+    {":status", "204"},
+    {":status", "206"},
+    {":status", "304"},
+    {":status", "400"},
+    {":status", "404"},
+    {":status", "500"},
+    {"accept-charset", ""},
+    {"accept-encoding", "gzip, deflate"},
+    {"accept-language", ""},
+    {"accept-ranges", ""},
+    {"accept", ""},
+    {"access-control-allow-origin", ""},
+    {"age", ""},
+    {"allow", ""},
+    {"authorization", ""},
+    {"cache-control", ""},
+    {"content-disposition", ""},
+    {"content-encoding", ""},
+    {"content-language", ""},
+    {"content-length", ""},
+    {"content-location", ""},
+    {"content-range", ""},
+    {"content-type", ""},
+    {"cookie", ""},
+    {"date", ""},
+    {"etag", ""},
+    {"expect", ""},
+    {"expires", ""},
+    {"from", ""},
+    {"host", ""},
+    {"if-match", ""},
+    {"if-modified-since", ""},
+    {"if-none-match", ""},
+    {"if-range", ""},
+    {"if-unmodified-since", ""},
+    {"last-modified", ""},
+    {"link", ""},
+    {"location", ""},
+    {"max-forwards", ""},
+    {"proxy-authenticate", ""},
+    {"proxy-authorization", ""},
+    {"range", ""},
+    {"referer", ""},
+    {"refresh", ""},
+    {"retry-after", ""},
+    {"server", ""},
+    {"set-cookie", ""},
+    {"strict-transport-security", ""},
+    {"transfer-encoding", ""},
+    {"user-agent", ""},
+    {"vary", ""},
+    {"via", ""},
+    {"www-authenticate", ""},
+}};
+
+///https://www.rfc-editor.org/rfc/rfc7541#section-4.1
+constexpr size_t kEntryOverhead = 32;
+
+///binary tree of the huffman codes, a leaf holds the symbol
+class HuffmanTree {
+public:
+    struct Node {
+        int16_t children[2] = {-1, -1};
+        int16_t symbol = -1;
+    };
+
+    static const HuffmanTree& shared() noexcept {
+        static HuffmanTree tree;
+        return tree;
+    }
+
+    [[nodiscard]] const Node& node(int16_t index) const noexcept {
+        return nodes_[static_cast<size_t>(index)];
+    }
+
+private:
+    HuffmanTree() noexcept {
+        nodes_.reserve(kHuffmanCodes.size() * 2);
+        nodes_.emplace_back();
+        for (size_t symbol = 0; symbol < kHuffmanCodes.size(); symbol++) {
+            auto [code, length] = kHuffmanCodes[symbol];
+            int16_t current = 0;
+            for (int32_t bit = length - 1; bit >= 0; bit--) {
+                auto branch = (code >> bit) & 1;
+                if (nodes_[static_cast<size_t>(current)].children[branch] < 0) {
+                    nodes_[static_cast<size_t>(current)].children[branch] = static_cast<int16_t>(nodes_.size());
+                    nodes_.emplace_back();
+                }
+                current = nodes_[static_cast<size_t>(current)].children[branch];
+            }
+            nodes_[static_cast<size_t>(current)].symbol = static_cast<int16_t>(symbol);
+        }
+    }
+
+private:
+    std::vector<Node> nodes_;
+};
+
+void encodeInteger(uint64_t value, uint8_t prefixBits, uint8_t flags, std::string& out) noexcept {
+    auto maxPrefix = static_cast<uint64_t>((1u << prefixBits) - 1);
+    if (value < maxPrefix) {
+        out.push_back(static_cast<char>(flags | value));
+        return;
+    }
+    out.push_back(static_cast<char>(flags | maxPrefix));
+    value -= maxPrefix;
+    while (value >= 128) {
+        out.push_back(static_cast<char>((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+bool decodeInteger(std::string_view data, size_t& pos, uint8_t prefixBits, uint64_t& value) noexcept {
+    if (pos >= data.size()) {
+        return false;
+    }
+    auto maxPrefix = static_cast<uint64_t>((1u << prefixBits) - 1);
+    value = static_cast<uint8_t>(data[pos++]) & maxPrefix;
+    if (value < maxPrefix) {
+        return true;
+    }
+    uint32_t shift = 0;
+    while (pos < data.size()) {
+        auto byte = static_cast<uint8_t>(data[pos++]);
+        value += static_cast<uint64_t>(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0) {
+            return true;
+        }
+        shift += 7;
+        ///no sane header is that long, stop before the value overflows
+        if (shift > 28) {
+            return false;
+        }
+    }
+    return false;
+}
+
+void encodeString(std::string_view data, std::string& out) noexcept {
+    auto huffmanSize = huffmanEncodedSize(data);
+    if (huffmanSize < data.size()) {
+        encodeInteger(huffmanSize, 7, 0x80, out);
+        huffmanEncode(data, out);
+    } else {
+        encodeInteger(data.size(), 7, 0, out);
+        out.append(data);
+    }
+}
+
+bool decodeString(std::string_view data, size_t& pos, std::string& out) noexcept {
+    if (pos >= data.size()) {
+        return false;
+    }
+    auto isHuffman = (static_cast<uint8_t>(data[pos]) & 0x80) != 0;
+    uint64_t length = 0;
+    if (!decodeInteger(data, pos, 7, length) || length > data.size() - pos) {
+        return false;
+    }
+    auto view = data.substr(pos, length);
+    pos += length;
+    if (isHuffman) {
+        out.clear();
+        return huffmanDecode(view, out);
+    }
+    out.assign(view);
+    return true;
+}
+
+} //end of namespace
+
+bool huffmanDecode(std::string_view data, std::string& out) noexcept {
+    const auto& tree = HuffmanTree::shared();
+    int16_t current = 0;
+    ///bits read since the last symbol, and whether they were all ones
+    uint32_t depth = 0;
+    bool isAllOnes = true;
+    for (auto ch : data) {
+        auto byte = static_cast<uint8_t>(ch);
+        for (int32_t bit = 7; bit >= 0; bit--) {
+            auto branch = (byte >> bit) & 1;
+            current = tree.node(current).children[branch];
+            if (current < 0) {
+                return false;
+            }
+            depth++;
+            isAllOnes = isAllOnes && branch == 1;
+            auto symbol = tree.node(current).symbol;
+            if (symbol < 0) {
+                continue;
+            }
+            if (symbol == kEndOfString) {
+                return false;
+            }
+            out.push_back(static_cast<char>(symbol));
+            current = 0;
+            depth = 0;
+            isAllOnes = true;
+        }
+    }
+    ///https://www.rfc-editor.org/rfc/rfc7541#section-5.2, the padding is the most significant bits of EOS
+    return depth < 8 && isAllOnes;
+}
+
+void huffmanEncode(std::string_view data, std::string& out) noexcept {
+    uint64_t bits = 0;
+    uint32_t bitCount = 0;
+    for (auto ch : data) {
+        auto [code, length] = kHuffmanCodes[static_cast<uint8_t>(ch)];
+        bits = (bits << length) | code;
+        bitCount += length;
+        while (bitCount >= 8) {
+            bitCount -= 8;
+            out.push_back(static_cast<char>(bits >> bitCount));
+        }
+    }
+    if (bitCount > 0) {
+        auto padding = 8 - bitCount;
+        out.push_back(static_cast<char>((bits << padding) | ((1u << padding) - 1)));
+    }
+}
+
+size_t huffmanEncodedSize(std::string_view data) noexcept {
+    size_t bitCount = 0;
+    for (auto ch : data) {
+        bitCount += kHuffmanCodes[static_cast<uint8_t>(ch)].length;
+    }
+    return (bitCount + 7) / 8;
+}
+
+void Encoder::encode(const HeaderList& headers, std::string& out) const noexcept {
+    for (const auto& [name, value] : headers) {
+        size_t nameIndex = 0;
+        size_t fieldIndex = 0;
+        for (size_t i = 0; i < kStaticTable.size() && fieldIndex == 0; i++) {
+            if (kStaticTable[i].first != name) {
+                continue;
+            }
+            if (nameIndex == 0) {
+                nameIndex = i + 1;
+            }
+            if (kStaticTable[i].second == value) {
+                fieldIndex = i + 1;
+            }
+        }
+        if (fieldIndex != 0) {
+            encodeInteger(fieldIndex, 7, 0x80, out);
+            continue;
+        }
+        ///literal header field without indexing
+        encodeInteger(nameIndex, 4, 0, out);
+        if (nameIndex == 0) {
+            encodeString(name, out);
+        }
+        encodeString(value, out);
+    }
+}
+
+Decoder::Decoder(uint32_t maxTableSize) noexcept
+    : maxTableSize_(maxTableSize)
+    , tableLimit_(maxTableSize) {
+
+}
+
+bool Decoder::decode(std::string_view block, HeaderList& headers) noexcept {
+    size_t pos = 0;
+    while (pos < block.size()) {
+        auto byte = static_cast<uint8_t>(block[pos]);
+        uint64_t index = 0;
+        if (byte & 0x80) {
+            ///indexed header field
+            if (!decodeInteger(block, pos, 7, index)) {
+                return false;
+            }
+            auto entry = field(index);
+            if (entry == nullptr) {
+                return false;
+            }
+            headers.push_back(*entry);
+            continue;
+        }
+        if ((byte & 0xe0) == 0x20) {
+            ///dynamic table size update
+            if (!decodeInteger(block, pos, 5, index) || index > maxTableSize_) {
+                return false;
+            }
+            tableLimit_ = static_cast<size_t>(index);
+            evict(tableLimit_);
+            continue;
+        }
+        auto isIndexing = (byte & 0xc0) == 0x40;
+        if (!decodeInteger(block, pos, isIndexing ? 6 : 4, index)) {
+            return false;
+        }
+        HeaderField header;
+        if (index != 0) {
+            auto entry = field(index);
+            if (entry == nullptr) {
+                return false;
+            }
+            header.first = entry->first;
+        } else if (!decodeString(block, pos, header.first)) {
+            return false;
+        }
+        if (!decodeString(block, pos, header.second)) {
+            return false;
+        }
+        if (isIndexing) {
+            insert(header);
+        }
+        headers.push_back(std::move(header));
+    }
+    return true;
+}
+
+const HeaderField* Decoder::field(uint64_t index) const noexcept {
+    static const auto staticFields = [] {
+        std::vector<HeaderField> fields;
+        for (const auto& [name, value] : kStaticTable) {
+            fields.emplace_back(name, value);
+        }
+        return fields;
+    }();
+    if (index == 0) {
+        return nullptr;
+    }
+    if (index <= staticFields.size()) {
+        return &staticFields[index - 1];
+    }
+    index -= staticFields.size() + 1;
+    return index < table_.size() ? &table_[index] : nullptr;
+}
+
+void Decoder::insert(HeaderField field) noexcept {
+    auto size = field.first.size() + field.second.size() + kEntryOverhead;
+    if (size > tableLimit_) {
+        ///https://www.rfc-editor.org/rfc/rfc7541#section-4.4, an entry larger than the table empties it
+        evict(0);
+        return;
+    }
+    evict(tableLimit_ - size);
+    tableSize_ += size;
+    table_.push_front(std::move(field));
+}
+
+void Decoder::evict(size_t maxSize) noexcept {
+    while (tableSize_ > maxSize && !table_.empty()) {
+        const auto& [name, value] = table_.back();
+        tableSize_ -= name.size() + value.size() + kEntryOverhead;
+        table_.pop_back();
+    }
+}
+
+} //end of namespace http::hpack
@@ -0,0 +1,1008 @@
+//
+// Created by Nevermore on 2026/10/17.
+// http-request Http2Connection
+// Copyright (c) 2024 Nevermore All rights reserved.
+//
+#include "Http2Connection.h"
+#include <algorithm>
+#include "DnsResolver.h"
+#include "Encode.h"
+#include "PlainSocket.h"
+#include "TSLSocket.h"
+
+namespace http {
+
+using namespace http::util;
+
+namespace {
+
+constexpr std::string_view kClientPreface = "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n";
+constexpr size_t kFrameHeaderSize = 9;
+
+///https://www.rfc-editor.org/rfc/rfc9113#section-6
+constexpr uint8_t kFrameData = 0x0;
+constexpr uint8_t kFrameHeaders = 0x1;
+constexpr uint8_t kFrameRstStream = 0x3;
+constexpr uint8_t kFrameSettings = 0x4;
+constexpr uint8_t kFramePushPromise = 0x5;
+constexpr uint8_t kFramePing = 0x6;
+constexpr uint8_t kFrameGoAway = 0x7;
+constexpr uint8_t kFrameWindowUpdate = 0x8;
+constexpr uint8_t kFrameContinuation = 0x9;
+
+constexpr uint8_t kFlagEndStream = 0x1;
+constexpr uint8_t kFlagAck = 0x1;
+constexpr uint8_t kFlagEndHeaders = 0x4;
+constexpr uint8_t kFlagPadded = 0x8;
+constexpr uint8_t kFlagPriority = 0x20;
+
+constexpr uint16_t kSettingsEnablePush = 0x2;
+constexpr uint16_t kSettingsMaxConcurrentStreams = 0x3;
+constexpr uint16_t kSettingsInitialWindowSize = 0x4;
+constexpr uint16_t kSettingsMaxFrameSize = 0x5;
+
+///https://www.rfc-editor.org/rfc/rfc9113#section-7
+constexpr uint32_t kNoError = 0x0;
+constexpr uint32_t kProtocolError = 0x1;
+constexpr uint32_t kFlowControlError = 0x3;
+constexpr uint32_t kFrameSizeError = 0x6;
+constexpr uint32_t kRefusedStream = 0x7;
+constexpr uint32_t kCancel = 0x8;
+constexpr uint32_t kCompressionError = 0x9;
+
+///the frame size and the window both sides start with
+constexpr uint32_t kDefaultFrameSize = 16384;
+constexpr uint32_t kMaxFrameSize = (1 << 24) - 1;
+constexpr int64_t kDefaultWindowSize = 65535;
+constexpr int64_t kMaxWindowSize = INT32_MAX;
+constexpr uint32_t kMaxStreamId = INT32_MAX;
+///assumed until the settings of the server arrive, the same as most servers announce
+constexpr uint32_t kInitialMaxConcurrentStreams = 100;
+///the windows we announce, a WINDOW_UPDATE is sent once half of one is consumed
+constexpr uint32_t kStreamWindowSize = 1 << 20;
+constexpr uint32_t kConnectionWindowSize = 4 << 20;
+///body bytes queued ahead of the socket, the windows are not drained into memory
+constexpr size_t kMaxBufferedSize = 256 * 1024;
+
+void appendUint32(std::string& out, uint32_t value) noexcept {
+    out.push_back(static_cast<char>(value >> 24));
+    out.push_back(static_cast<char>(value >> 16));
+    out.push_back(static_cast<char>(value >> 8));
+    out.push_back(static_cast<char>(value));
+}
+
+uint32_t readUint32(std::string_view data, size_t pos) noexcept {
+    return static_cast<uint32_t>(static_cast<uint8_t>(data[pos])) << 24 |
+           static_cast<uint32_t>(static_cast<uint8_t>(data[pos + 1])) << 16 |
+           static_cast<uint32_t>(static_cast<uint8_t>(data[pos + 2])) << 8 |
+           static_cast<uint32_t>(static_cast<uint8_t>(data[pos + 3]));
+}
+
+void appendSetting(std::string& out, uint16_t id, uint32_t value) noexcept {
+    out.push_back(static_cast<char>(id >> 8));
+    out.push_back(static_cast<char>(id));
+    appendUint32(out, value);
+}
+
+///https://www.rfc-editor.org/rfc/rfc9113#section-8.3.1, the connection specific fields are not allowed
+hpack::HeaderList requestHeaders(const RequestInfo& info, const Url& url) noexcept {
+    auto authority = url.host;
+    auto defaultPort = url.isHttps() ? kHttpsDefaultPort : kHttpDefaultPort;
+    if (url.port != defaultPort) {
+        authority += ":" + url.port;
+    }
+    hpack::HeaderList headers;
+    headers.emplace_back(":method", getMethodName(info.methodType));
+    headers.emplace_back(":scheme", url.scheme);
+    headers.emplace_back(":authority", authority);
+    headers.emplace_back(":path", url.path + (url.query.empty() ? "" : "?" + url.query));
+    auto hasLength = false;
+    auto hasAuthorization = false;
+    for (const auto& [key, value] : info.headers) {
+        auto name = StringUtil::toLower(key);
+        if (name == "connection" || name == "keep-alive" || name == "proxy-connection" || name == "transfer-encoding" ||
+            name == "upgrade" || name == "host" || (name == "te" && value != "trailers")) {
+            continue;
+        }
+        hasLength = hasLength || name == "content-length";
+        hasAuthorization = hasAuthorization || name == "authorization";
+        headers.emplace_back(std::move(name), value);
+    }
+    if (!hasLength && !info.bodyEmpty()) {
+        headers.emplace_back("content-length", std::to_string(info.bodySize()));
+    }
+    if (!hasAuthorization && !url.userInfo.empty()) {
+        headers.emplace_back("authorization", std::string("Basic ") + encode::base64Encode(url.userInfo));
+    }
+    return headers;
+}
+
+} //end of namespace
+
+Http2Connection::Http2Connection(EventLoop& loop, std::string key, std::chrono::milliseconds idleTimeout,
+                                 FinishFunc&& onFinish, FallbackFunc&& onFallback, IdleFunc&& onIdle,
+                                 SessionCounter* counter, ConnectionPool* pool, OriginSet* http1Origins)
+    : loop_(loop)
+    , key_(std::move(key))
+    , idleTimeout_(idleTimeout)
+    , onFinish_(std::move(onFinish))
+    , onFallback_(std::move(onFallback))
+    , onIdle_(std::move(onIdle))
+    , counter_(counter)
+    , pool_(pool)
+    , http1Origins_(http1Origins)
+    , socket_(nullptr, freeSocket) {
+
+}
+
+Http2Connection::~Http2Connection() {
+    for (auto& stream : queue_) {
+        if (stream->timerId != 0) {
+            loop_.cancelTimer(stream->timerId);
+        }
+    }
+    for (auto& [id, stream] : streams_) {
+        if (stream->timerId != 0) {
+            loop_.cancelTimer(stream->timerId);
+        }
+    }
+    if (idleTimerId_ != 0) {
+        loop_.cancelTimer(idleTimerId_);
+    }
+    closeSocket();
+}
+
+bool Http2Connection::isHttp2(const RequestInfo& info) noexcept {
+    if (info.httpVersion != HttpVersion::Http2 || info.isBodyStreamed()) {
+        return false;
+    }
+    Url url(info.url);
+    return url.isValid() && url.isHttpScheme();
+}
+
+void Http2Connection::add(RequestInfo&& info, ResponseHandler&& handler, std::string reqId) noexcept {
+    auto stream = std::make_unique<Stream>();
+    stream->url = std::make_unique<Url>(info.url);
+    stream->info = std::move(info);
+    stream->handler = std::move(handler);
+    stream->reqId = std::move(reqId);
+    stream->startTime = Time::steadyTime();
+    stream->timerId = loop_.runAfter(stream->info.timeout, [this, reqId = stream->reqId] {
+        expire(reqId);
+    });
+    queue_.push_back(std::move(stream));
+    if (idleTimerId_ != 0) {
+        loop_.cancelTimer(idleTimerId_);
+        idleTimerId_ = 0;
+    }
+    if (state_ == State::Idle) {
+        open();
+    } else if (state_ == State::Open) {
+        startStreams();
+        send();
+        checkIdle();
+    }
+}
+
+bool Http2Connection::cancel(const std::string& reqId) noexcept {
+    auto isMatch = [&reqId](const StreamPtr& stream) {
+        return stream->reqId == reqId;
+    };
+    if (auto it = std::find_if(queue_.begin(), queue_.end(), isMatch); it != queue_.end()) {
+        loop_.cancelTimer((*it)->timerId);
+        queue_.erase(it);
+        checkIdle();
+        return true;
+    }
+    auto it = std::find_if(streams_.begin(), streams_.end(), [&isMatch](const auto& pair) {
+        return isMatch(pair.second);
+    });
+    if (it == streams_.end() || it->second->isFinished) {
+        return false;
+    }
+    loop_.cancelTimer(it->second->timerId);
+    std::string payload;
+    appendUint32(payload, kCancel);
+    writeFrame(kFrameRstStream, 0, it->first, payload);
+    streams_.erase(it);
+    startStreams();
+    send();
+    checkIdle();
+    return true;
+}
+
+void Http2Connection::open() noexcept {
+    if (queue_.empty()) {
+        checkIdle();
+        return;
+    }
+    decoder_ = std::make_unique<hpack::Decoder>();
+    sendData_.clear();
+    sendPos_ = 0;
+    recvData_.clear();
+    nextStreamId_ = 1;
+    maxConcurrentStreams_ = kInitialMaxConcurrentStreams;
+    maxFrameSize_ = kDefaultFrameSize;
+    initialWindowSize_ = kDefaultWindowSize;
+    sendWindow_ = kDefaultWindowSize;
+    unackedSize_ = 0;
+    headerStreamId_ = 0;
+    headerBlock_.clear();
+    isGoingAway_ = false;
+    isTls_ = false;
+
+    const auto& front = *queue_.front();
+    if (front.url->isHttps() && http1Origins_ && http1Origins_->count(key_) > 0) {
+        ///the server did not select h2 last time, the sessions take a pooled connection if there is one
+        fallback();
+        return;
+    }
+#if !ENABLE_HTTPS
+    if (front.url->isHttps()) {
+        failAll(ResultCode::SchemeNotSupported, 0);
+        return;
+    }
+#endif
+    isTls_ = front.url->isHttps();
+    state_ = State::Connect;
+    query_ = std::make_unique<DnsQuery>(loop_, front.url->host, front.url->port, front.info.ipVersion,
+                                        [this](AddressInfoPtr address, int32_t errorCode) {
+        resolved(std::move(address), errorCode);
+    });
+    query_->start();
+}
+
+void Http2Connection::resolved(AddressInfoPtr address, int32_t errorCode) noexcept {
+    if (address == nullptr) {
+        failAll(ResultCode::GetAddressFailed, errorCode);
+        return;
+    }
+    const auto& front = *queue_.front();
+    connector_ = std::make_unique<Connector>(loop_, std::move(address), front.info.connectionAttemptDelay,
+                                             [url = *front.url, options = front.info.socketOptions](IPVersion ipVersion) -> ISocket* {
+#if ENABLE_HTTPS
+        if (url.isHttps()) {
+            auto socket = std::make_unique<TSLSocket>(ipVersion, url.host, url.port);
+            socket->setOptions(options);
+            return socket->setAlpn({"h2", "http/1.1"}) ? socket.release() : nullptr;
+        }
+#endif
+        auto socket = new PlainSocket(ipVersion);
+        socket->setOptions(options);
+        return socket;
+    }, [this](Connector::SocketPtr socket, SocketResult result) {
+        connected(std::move(socket), result);
+    });
+    connector_->start();
+}
+
+void Http2Connection::onEvent(uint32_t events) noexcept {
+    switch (state_) {
+        case State::Handshake:
+            handshake();
+            break;
+        case State::Open:
+            if (events & (kEventRead | kEventError)) {
+                receive();
+            }
+            if (state_ == State::Open && sendPos_ < sendData_.size()) {
+                send();
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+void Http2Connection::connected(Connector::SocketPtr socket, SocketResult result) noexcept {
+    if (!result.isSuccess()) {
+        failAll(result.resultCode, result.errorCode);
+        return;
+    }
+    socket_ = std::move(socket);
+    state_ = State::Handshake;
+    handshake();
+}
+
+void Http2Connection::handshake() noexcept {
+    auto result = socket_->handshake();
+    if (result.resultCode == ResultCode::Retry) {
+        wait(result.waitType == SelectType::Read ? kEventRead : kEventWrite);
+        return;
+    } else if (!result.isSuccess()) {
+        failAll(result.resultCode, result.errorCode);
+        return;
+    }
+#if ENABLE_HTTPS
+    if (isTls_ && static_cast<TSLSocket*>(socket_.get())->alpn() != "h2") {
+        if (http1Origins_) {
+            http1Origins_->insert(key_);
+        }
+        fallback();
+        return;
+    }
+#endif
+    state_ = State::Open;
+    ///https://www.rfc-editor.org/rfc/rfc9113#section-3.4, the preface is followed by our settings
+    sendData_.assign(kClientPreface);
+    std::string settings;
+    appendSetting(settings, kSettingsEnablePush, 0);
+    appendSetting(settings, kSettingsInitialWindowSize, kStreamWindowSize);
+    writeFrame(kFrameSettings, 0, 0, settings);
+    writeWindowUpdate(0, kConnectionWindowSize - kDefaultWindowSize);
+    startStreams();
+    send();
+}
+
+void Http2Connection::fallback() noexcept {
+    if (socket_ && pool_ && socket_->prepareIdle()) {
+        ///the first session takes it from the pool, the handshake is not wasted
+        loop_.removeEvent(socket_->fd());
+        pool_->checkin(key_, std::move(socket_));
+    }
+    closeSocket();
+    state_ = State::Idle;
+    while (!queue_.empty()) {
+        auto stream = std::move(queue_.front());
+        queue_.pop_front();
+        loop_.cancelTimer(stream->timerId);
+        stream->timerId = 0;
+        stream->isFinished = true;
+        if (onFallback_) {
+            onFallback_(std::move(stream->info), std::move(stream->handler), stream->reqId);
+        }
+    }
+    checkIdle();
+}
+
+void Http2Connection::startStreams() noexcept {
+    if (state_ != State::Open) {
+        return;
+    }
+    while (!queue_.empty() && !isGoingAway_ && streams_.size() < maxConcurrentStreams_) {
+        if (nextStreamId_ > kMaxStreamId) {
+            ///the ids are used up, the queued requests go to a new connection once this one is drained
+            isGoingAway_ = true;
+            break;
+        }
+        auto stream = std::move(queue_.front());
+        queue_.pop_front();
+        stream->id = nextStreamId_;
+        nextStreamId_ += 2;
+        if (!stream->isSent && stream->isValid && stream->handler.onConnected) {
+            stream->handler.onConnected(stream->reqId);
+        }
+        stream->isSent = true;
+        stream->isHeaderDone = false;
+        stream->isEndStream = stream->info.bodyEmpty();
+        stream->sendWindow = initialWindowSize_;
+        stream->bodyOffset = 0;
+        stream->unackedSize = 0;
+        std::string block;
+        encoder_.encode(requestHeaders(stream->info, *stream->url), block);
+        auto view = std::string_view(block);
+        auto flags = static_cast<uint8_t>(stream->isEndStream ? kFlagEndStream : 0);
+        auto type = kFrameHeaders;
+        ///a block larger than a frame continues in CONTINUATION frames
+        do {
+            auto fragment = view.substr(0, maxFrameSize_);
+            view.remove_prefix(fragment.size());
+            writeFrame(type, static_cast<uint8_t>(view.empty() ? (flags | kFlagEndHeaders) : flags), stream->id, fragment);
+            type = kFrameContinuation;
+            flags = 0;
+        } while (!view.empty());
+        streams_[stream->id] = std::move(stream);
+    }
+}
+
+bool Http2Connection::fillBodies() noexcept {
+    auto isAdded = false;
+    for (auto& [id, stream] : streams_) {
+        while (!stream->isEndStream && sendWindow_ > 0 && stream->sendWindow > 0 &&
+               sendData_.size() - sendPos_ < kMaxBufferedSize) {
+            auto body = stream->info.body->view();
+            auto remain = body.size() - stream->bodyOffset;
+            auto size = std::min<uint64_t>({remain, maxFrameSize_, static_cast<uint64_t>(stream->sendWindow),
+                                            static_cast<uint64_t>(sendWindow_)});
+            stream->isEndStream = size == remain;
+            writeFrame(kFrameData, stream->isEndStream ? kFlagEndStream : 0, id, body.substr(stream->bodyOffset, size));
+            stream->bodyOffset += size;
+            stream->sendWindow -= static_cast<int64_t>(size);
+            sendWindow_ -= static_cast<int64_t>(size);
+            isAdded = true;
+        }
+    }
+    return isAdded;
+}
+
+void Http2Connection::send() noexcept {
+    if (state_ != State::Open) {
+        return;
+    }
+    fillBodies();
+    while (true) {
+        auto dataView = std::string_view(sendData_);
+        while (sendPos_ < dataView.size()) {
+            auto [sendResult, sendSize] = socket_->send(dataView.substr(sendPos_));
+            if (sendResult.resultCode == ResultCode::Retry) {
+                ///the responses keep being read while the frames wait for the socket
+                wait(sendResult.waitType == SelectType::Read ? kEventRead : (kEventRead | kEventWrite));
+                return;
+            } else if (!sendResult.isSuccess()) {
+                restart(sendResult.resultCode, sendResult.errorCode);
+                return;
+            }
+            sendPos_ += static_cast<size_t>(sendSize);
+            if (counter_) {
+                counter_->sentBytes.fetch_add(static_cast<uint64_t>(sendSize), std::memory_order_relaxed);
+            }
+        }
+        sendData_.clear();
+        sendPos_ = 0;
+        if (!fillBodies()) {
+            break;
+        }
+    }
+    wait(kEventRead);
+}
+
+void Http2Connection::receive() noexcept {
+    int32_t readCount = 0;
+    do {
+        auto [recvResult, dataPtr] = socket_->receive();
+        if (!recvResult.isSuccess()) {
+            if (recvResult.resultCode == ResultCode::Retry) {
+                if (recvResult.waitType == SelectType::Write) {
+                    wait(kEventRead | kEventWrite);
+                    return;
+                }
+                break;
+            }
+            restart(recvResult.resultCode, recvResult.errorCode);
+            return;
+        }
+        if (counter_) {
+            counter_->receivedBytes.fetch_add(dataPtr->length, std::memory_order_relaxed);
+        }
+        recvData_.append(dataPtr->view());
+        if (!processFrames()) {
+            return;
+        }
+    } while (++readCount < kMaxReadCountPerEvent);
+    ///the finished streams made room for the queued ones
+    startStreams();
+    send();
+    checkIdle();
+}
+
+bool Http2Connection::processFrames() noexcept {
+    size_t pos = 0;
+    while (recvData_.size() - pos >= kFrameHeaderSize) {
+        auto view = std::string_view(recvData_).substr(pos);
+        auto length = readUint32(view, 0) >> 8;
+        auto type = static_cast<uint8_t>(view[3]);
+        auto flags = static_cast<uint8_t>(view[4]);
+        auto streamId = readUint32(view, 5) & kMaxStreamId;
+        ///we never announce a larger SETTINGS_MAX_FRAME_SIZE
+        if (length > kDefaultFrameSize) {
+            return goAway(kFrameSizeError);
+        }
+        if (view.size() < kFrameHeaderSize + length) {
+            break;
+        }
+        pos += kFrameHeaderSize + length;
+        ///the payload points into the receive buffer, a handler that drops the connection returns false at once
+        if (!onFrame(type, flags, streamId, view.substr(kFrameHeaderSize, length))) {
+            return false;
+        }
+    }
+    recvData_.erase(0, pos);
+    return true;
+}
+
+bool Http2Connection::onFrame(uint8_t type, uint8_t flags, uint32_t streamId, std::string_view payload) noexcept {
+    if (headerStreamId_ != 0) {
+        ///https://www.rfc-editor.org/rfc/rfc9113#section-6.10, nothing may come between a header block and its continuation
+        if (type != kFrameContinuation || streamId != headerStreamId_) {
+            return goAway(kProtocolError);
+        }
+        headerBlock_.append(payload);
+        return (flags & kFlagEndHeaders) == 0 || onHeaderBlock(streamId, isHeaderEndStream_);
+    }
+    switch (type) {
+        case kFrameData:
+            return onData(flags, streamId, payload);
+        case kFrameHeaders:
+            return onHeaders(flags, streamId, payload);
+        case kFrameRstStream:
+            if (streamId == 0) {
+                return goAway(kProtocolError);
+            } else if (payload.size() != 4) {
+                return goAway(kFrameSizeError);
+            }
+            onReset(streamId, readUint32(payload, 0));
+            return true;
+        case kFrameSettings:
+            if (streamId != 0) {
+                return goAway(kProtocolError);
+            }
+            return onSettings(flags, payload);
+        case kFramePing:
+            if (streamId != 0) {
+                return goAway(kProtocolError);
+            } else if (payload.size() != 8) {
+                return goAway(kFrameSizeError);
+            }
+            if ((flags & kFlagAck) == 0) {
+                writeFrame(kFramePing, kFlagAck, 0, payload);
+            }
+            return true;
+        case kFrameGoAway:
+            if (streamId != 0) {
+                return goAway(kProtocolError);
+            } else if (payload.size() < 8) {
+                return goAway(kFrameSizeError);
+            }
+            onGoAway(readUint32(payload, 0) & kMaxStreamId);
+            return true;
+        case kFrameWindowUpdate:
+            return onWindowUpdate(streamId, payload);
+        case kFramePushPromise:
+            ///push was disabled in our settings
+        case kFrameContinuation:
+            return goAway(kProtocolError);
+        default:
+            ///PRIORITY and the unknown types are ignored
+            return true;
+    }
+}
+
+bool Http2Connection::onData(uint8_t flags, uint32_t streamId, std::string_view payload) noexcept {
+    if (streamId == 0) {
+        return goAway(kProtocolError);
+    }
+    auto data = payload;
+    if (flags & kFlagPadded) {
+        if (data.empty() || static_cast<uint8_t>(data[0]) >= data.size()) {
+            return goAway(kProtocolError);
+        }
+        data = data.substr(1, data.size() - 1 - static_cast<uint8_t>(data[0]));
+    }
+    ///the padding counts against the windows too, the frames of a reset stream only against the connection
+    auto length = static_cast<uint32_t>(payload.size());
+    unackedSize_ += length;
+    if (unackedSize_ >= kConnectionWindowSize / 2) {
+        writeWindowUpdate(0, unackedSize_);
+        unackedSize_ = 0;
+    }
+    auto it = streams_.find(streamId);
+    if (it == streams_.end()) {
+        return true;
+    }
+    auto& stream = *it->second;
+    if (!stream.isHeaderDone) {
+        ///the body can not come before the response header
+        resetStream(streamId, kProtocolError);
+        return true;
+    }
+    if (!data.empty() && stream.location.empty() && stream.isValid && stream.handler.onData) {
+        stream.handler.onData(stream.reqId, std::make_unique<Data>(data.size(), reinterpret_cast<const uint8_t*>(data.data())));
+    }
+    if (flags & kFlagEndStream) {
+        complete(streamId);
+        return true;
+    }
+    stream.unackedSize += length;
+    if (stream.unackedSize >= kStreamWindowSize / 2) {
+        writeWindowUpdate(streamId, stream.unackedSize);
+        stream.unackedSize = 0;
+    }
+    return true;
+}
+
+bool Http2Connection::onHeaders(uint8_t flags, uint32_t streamId, std::string_view payload) noexcept {
+    if (streamId == 0) {
+        return goAway(kProtocolError);
+    }
+    size_t padding = 0;
+    if (flags & kFlagPadded) {
+        if (payload.empty()) {
+            return goAway(kProtocolError);
+        }
+        padding = static_cast<uint8_t>(payload[0]);
+        payload.remove_prefix(1);
+    }
+    if (flags & kFlagPriority) {
+        ///the stream dependency and the weight
+        if (payload.size() < 5) {
+            return goAway(kProtocolError);
+        }
+        payload.remove_prefix(5);
+    }
+    if (padding > payload.size()) {
+        return goAway(kProtocolError);
+    }
+    headerBlock_.assign(payload.substr(0, payload.size() - padding));
+    headerStreamId_ = streamId;
+    isHeaderEndStream_ = (flags & kFlagEndStream) != 0;
+    return (flags & kFlagEndHeaders) == 0 || onHeaderBlock(streamId, isHeaderEndStream_);
+}
+
+bool Http2Connection::onHeaderBlock(uint32_t streamId, bool isEndStream) noexcept {
+    auto block = std::move(headerBlock_);
+    headerBlock_.clear();
+    headerStreamId_ = 0;
+    hpack::HeaderList fields;
+    ///every block is decoded even if its stream is gone, the dynamic table must stay in sync
+    if (!decoder_->decode(block, fields)) {
+        return goAway(kCompressionError);
+    }
+    auto it = streams_.find(streamId);
+    if (it == streams_.end()) {
+        return true;
+    }
+    auto& stream = *it->second;
+    if (!stream.isHeaderDone) {
+        ResponseHeader header;
+        uint32_t status = 0;
+        for (auto& [name, value] : fields) {
+            if (name == ":status") {
+                for (auto ch : value) {
+                    status = (ch >= '0' && ch <= '9' && status < 1000) ? status * 10 + static_cast<uint32_t>(ch - '0') : 1000;
+                }
+            } else if (name.empty() || name[0] != ':') {
+                auto& field = header.headers[name];
+                field = field.empty() ? std::move(value) : field + ", " + value;
+            }
+        }
+        if (status < 100 || status > 999 || (status < 200 && isEndStream)) {
+            resetStream(streamId, kProtocolError);
+            return true;
+        }
+        if (status < 200) {
+            ///an interim response, the final one follows on the same stream
+            return true;
+        }
+        stream.isHeaderDone = true;
+        stream.isReceived = true;
+        header.httpStatusCode = static_cast<HttpStatusCode>(status);
+        if (header.isNeedRedirect() && stream.info.isAllowRedirect && header.headers.count("location")) {
+            stream.location = header.headers["location"];
+        } else if (stream.isValid && stream.handler.onParseHeaderDone) {
+            stream.handler.onParseHeaderDone(stream.reqId, std::move(header));
+        }
+    }
+    ///the fields of a trailer are dropped, ResponseHandler has no place for them
+    if (isEndStream) {
+        complete(streamId);
+    }
+    return true;
+}
+
+bool Http2Connection::onSettings(uint8_t flags, std::string_view payload) noexcept {
+    if (flags & kFlagAck) {
+        return payload.empty() || goAway(kFrameSizeError);
+    }
+    if (payload.size() % 6 != 0) {
+        return goAway(kFrameSizeError);
+    }
+    for (size_t pos = 0; pos < payload.size(); pos += 6) {
+        auto id = static_cast<uint16_t>(static_cast<uint8_t>(payload[pos]) << 8 | static_cast<uint8_t>(payload[pos + 1]));
+        auto value = readUint32(payload, pos + 2);
+        switch (id) {
+            case kSettingsMaxConcurrentStreams:
+                maxConcurrentStreams_ = value;
+                break;
+            case kSettingsInitialWindowSize: {
+                if (value > kMaxWindowSize) {
+                    return goAway(kFlowControlError);
+                }
+                ///https://www.rfc-editor.org/rfc/rfc9113#section-6.9.2, the open streams take the difference
+                auto delta = static_cast<int64_t>(value) - initialWindowSize_;
+                for (auto& [streamId, stream] : streams_) {
+                    stream->sendWindow += delta;
+                    if (stream->sendWindow > kMaxWindowSize) {
+                        return goAway(kFlowControlError);
+                    }
+                }
+                initialWindowSize_ = value;
+                break;
+            }
+            case kSettingsMaxFrameSize:
+                if (value < kDefaultFrameSize || value > kMaxFrameSize) {
+                    return goAway(kProtocolError);
+                }
+                maxFrameSize_ = value;
+                break;
+            default:
+                ///our encoder never uses the dynamic table, the table size does not matter
+                break;
+        }
+    }
+    writeFrame(kFrameSettings, kFlagAck, 0, {});
+    return true;
+}
+
+bool Http2Connection::onWindowUpdate(uint32_t streamId, std::string_view payload) noexcept {
+    if (payload.size() != 4) {
+        return goAway(kFrameSizeError);
+    }
+    auto increment = readUint32(payload, 0) & kMaxStreamId;
+    if (streamId == 0) {
+        if (increment == 0) {
+            return goAway(kProtocolError);
+        }
+        sendWindow_ += increment;
+        return sendWindow_ <= kMaxWindowSize || goAway(kFlowControlError);
+    }
+    auto it = streams_.find(streamId);
+    if (it == streams_.end()) {
+        return true;
+    }
+    it->second->sendWindow += increment;
+    if (increment == 0) {
+        resetStream(streamId, kProtocolError);
+    } else if (it->second->sendWindow > kMaxWindowSize) {
+        resetStream(streamId, kFlowControlError);
+    }
+    return true;
+}
+
+void Http2Connection::resetStream(uint32_t streamId, uint32_t errorCode) noexcept {
+    auto it = streams_.find(streamId);
+    if (it == streams_.end()) {
+        return;
+    }
+    auto stream = std::move(it->second);
+    streams_.erase(it);
+    std::string payload;
+    appendUint32(payload, errorCode);
+    writeFrame(kFrameRstStream, 0, streamId, payload);
+    fail(*stream, ResultCode::ProtocolError, static_cast<int32_t>(errorCode));
+}
+
+void Http2Connection::onReset(uint32_t streamId, uint32_t errorCode) noexcept {
+    auto it = streams_.find(streamId);
+    if (it == streams_.end()) {
+        return;
+    }
+    auto stream = std::move(it->second);
+    streams_.erase(it);
+    ///a refused stream was not processed at all, it is safe to send again
+    if (errorCode == kRefusedStream && !stream->isReceived && stream->resendCount < kMaxResendCount) {
+        stream->resendCount++;
+        queue_.push_front(std::move(stream));
+        return;
+    }
+    fail(*stream, ResultCode::StreamReset, static_cast<int32_t>(errorCode));
+}
+
+void Http2Connection::onGoAway(uint32_t lastStreamId) noexcept {
+    isGoingAway_ = true;
+    ///the streams above the last one were not processed, they go to the next connection
+    while (!streams_.empty() && streams_.rbegin()->first > lastStreamId) {
+        auto it = std::prev(streams_.end());
+        queue_.push_front(std::move(it->second));
+        streams_.erase(it);
+    }
+}
+
+void Http2Connection::writeFrame(uint8_t type, uint8_t flags, uint32_t streamId, std::string_view payload) noexcept {
+    auto length = static_cast<uint32_t>(payload.size());
+    sendData_.push_back(static_cast<char>(length >> 16));
+    sendData_.push_back(static_cast<char>(length >> 8));
+    sendData_.push_back(static_cast<char>(length));
+    sendData_.push_back(static_cast<char>(type));
+    sendData_.push_back(static_cast<char>(flags));
+    appendUint32(sendData_, streamId & kMaxStreamId);
+    sendData_.append(payload);
+}
+
+void Http2Connection::writeWindowUpdate(uint32_t streamId, uint32_t increment) noexcept {
+    std::string payload;
+    appendUint32(payload, increment);
+    writeFrame(kFrameWindowUpdate, 0, streamId, payload);
+}
+
+void Http2Connection::complete(uint32_t streamId) noexcept {
+    auto it = streams_.find(streamId);
+    if (it == streams_.end()) {
+        return;
+    }
+    auto stream = std::move(it->second);
+    streams_.erase(it);
+    if (!stream->isEndStream) {
+        ///the server answered before it read the whole body, stop sending it
+        std::string payload;
+        appendUint32(payload, kNoError);
+        writeFrame(kFrameRstStream, 0, streamId, payload);
+    }
+    if (!stream->location.empty() && stream->isValid && onFallback_) {
+        loop_.cancelTimer(stream->timerId);
+        stream->timerId = 0;
+        stream->isFinished = true;
+        stream->info.url = stream->location;
+        onFallback_(std::move(stream->info), std::move(stream->handler), stream->reqId);
+        return;
+    }
+    finish(*stream);
+}
+
+void Http2Connection::expire(const std::string& reqId) noexcept {
+    auto isMatch = [&reqId](const StreamPtr& stream) {
+        return stream->reqId == reqId;
+    };
+    if (auto it = std::find_if(queue_.begin(), queue_.end(), isMatch); it != queue_.end()) {
+        auto stream = std::move(*it);
+        queue_.erase(it);
+        stream->timerId = 0;
+        fail(*stream, ResultCode::Timeout, 0);
+        checkIdle();
+        return;
+    }
+    auto it = std::find_if(streams_.begin(), streams_.end(), [&isMatch](const auto& pair) {
+        return isMatch(pair.second);
+    });
+    if (it == streams_.end()) {
+        return;
+    }
+    auto stream = std::move(it->second);
+    streams_.erase(it);
+    stream->timerId = 0;
+    std::string payload;
+    appendUint32(payload, kCancel);
+    writeFrame(kFrameRstStream, 0, stream->id, payload);
+    fail(*stream, ResultCode::Timeout, 0);
+    startStreams();
+    send();
+    checkIdle();
+}
+
+bool Http2Connection::goAway(uint32_t errorCode) noexcept {
+    sendGoAway(errorCode);
+    failAll(ResultCode::ProtocolError, static_cast<int32_t>(errorCode));
+    return false;
+}
+
+void Http2Connection::sendGoAway(uint32_t errorCode) noexcept {
+    if (socket_ == nullptr || state_ != State::Open) {
+        return;
+    }
+    std::string payload;
+    ///the last stream the server opened, push is disabled so there is none
+    appendUint32(payload, 0);
+    appendUint32(payload, errorCode);
+    writeFrame(kFrameGoAway, 0, 0, payload);
+    ///best effort, the connection is closed right after
+    [[maybe_unused]] auto result = socket_->send(std::string_view(sendData_).substr(sendPos_));
+}
+
+void Http2Connection::restart(ResultCode code, int32_t errorCode) noexcept {
+    closeSocket();
+    state_ = State::Idle;
+    for (auto it = streams_.rbegin(); it != streams_.rend(); it++) {
+        auto stream = std::move(it->second);
+        if (stream->isFinished) {
+            continue;
+        }
+        if (stream->isReceived || stream->resendCount >= kMaxResendCount || !isIdempotent(stream->info.methodType)) {
+            fail(*stream, code, errorCode);
+            continue;
+        }
+        stream->resendCount++;
+        queue_.push_front(std::move(stream));
+    }
+    streams_.clear();
+    open();
+}
+
+void Http2Connection::failAll(ResultCode code, int32_t errorCode) noexcept {
+    closeSocket();
+    state_ = State::Idle;
+    for (auto& [id, stream] : streams_) {
+        if (!stream->isFinished) {
+            fail(*stream, code, errorCode);
+        }
+    }
+    streams_.clear();
+    while (!queue_.empty()) {
+        auto stream = std::move(queue_.front());
+        queue_.pop_front();
+        fail(*stream, code, errorCode);
+    }
+    checkIdle();
+}
+
+void Http2Connection::fail(Stream& stream, ResultCode code, int32_t errorCode) noexcept {
+    if (stream.isValid && stream.handler.onError) {
+        stream.handler.onError(stream.reqId, {code, errorCode});
+    }
+    finish(stream);
+}
+
+void Http2Connection::finish(Stream& stream) noexcept {
+    if (stream.timerId != 0) {
+        loop_.cancelTimer(stream.timerId);
+        stream.timerId = 0;
+    }
+    if (stream.isValid && stream.handler.onStats) {
+        RequestStats stats;
+        stats.isFastOpen = socket_ && socket_->isFastOpen();
+        stats.networkTime = Time::steadyTime() - stream.startTime;
+        stream.handler.onStats(stream.reqId, stats);
+    }
+    if (stream.isValid && stream.handler.onDisconnected) {
+        stream.handler.onDisconnected(stream.reqId);
+    }
+    stream.isValid = false;
+    if (!stream.isFinished) {
+        stream.isFinished = true;
+        if (onFinish_) {
+            loop_.post([onFinish = onFinish_, reqId = stream.reqId] {
+                onFinish(reqId);
+            });
+        }
+    }
+}
+
+void Http2Connection::checkIdle() noexcept {
+    if (!queue_.empty() || !streams_.empty()) {
+        if (state_ == State::Open && isGoingAway_ && streams_.empty()) {
+            ///the last stream of a connection going away is done, the queued ones need a new connection
+            closeSocket();
+            state_ = State::Idle;
+            open();
+        }
+        return;
+    }
+    if (state_ == State::Open && !isGoingAway_) {
+        if (idleTimerId_ == 0) {
+            idleTimerId_ = loop_.runAfter(idleTimeout_, [this] {
+                idleTimerId_ = 0;
+                idle();
+            });
+        }
+        return;
+    }
+    idle();
+}
+
+void Http2Connection::idle() noexcept {
+    if (idleTimerId_ != 0) {
+        loop_.cancelTimer(idleTimerId_);
+        idleTimerId_ = 0;
+    }
+    sendGoAway(kNoError);
+    closeSocket();
+    state_ = State::Idle;
+    sendData_.clear();
+    sendPos_ = 0;
+    recvData_.clear();
+    if (onIdle_) {
+        ///the owner destroys the connection, never do it inside its own callback
+        loop_.post([onIdle = onIdle_] {
+            onIdle();
+        });
+    }
+}
+
+void Http2Connection::wait(uint32_t events) noexcept {
+    if (loop_.updateEvent(socket_->fd(), events)) {
+        return;
+    }
+    if (!loop_.addEvent(socket_->fd(), events, [this](uint32_t flags) { onEvent(flags); })) {
+        failAll(ResultCode::Failed, GetLastError());
+    }
+}
+
+void Http2Connection::closeSocket() noexcept {
+    query_.reset();
+    connector_.reset();
+    if (socket_) {
+        loop_.removeEvent(socket_->fd());
+        socket_->close();
+        socket_.reset();
+    }
+}
+
+} //end of namespace http
@@ -0,0 +1,456 @@
+//
+// Created by Nevermore on 2026/10/17.
+// http-request Pipeline
+// Copyright (c) 2024 Nevermore All rights reserved.
+//
+#include "Pipeline.h"
+#include <algorithm>
+#include "DnsResolver.h"
+#include "Encode.h"
+#include "PlainSocket.h"
+#include "TSLSocket.h"
+
+namespace http {
+
+Pipeline::Pipeline(EventLoop& loop, std::string key, uint32_t maxDepth, FinishFunc&& onFinish, RedirectFunc&& onRedirect,
+                   IdleFunc&& onIdle, SessionCounter* counter, ConnectionPool* pool)
+    : loop_(loop)
+    , key_(std::move(key))
+    , maxDepth_(std::max<uint32_t>(maxDepth, 1))
+    , onFinish_(std::move(onFinish))
+    , onRedirect_(std::move(onRedirect))
+    , onIdle_(std::move(onIdle))
+    , counter_(counter)
+    , pool_(pool)
+    , socket_(nullptr, freeSocket) {
+
+}
+
+Pipeline::~Pipeline() {
+    for (auto exchanges : {&queue_, &inflight_}) {
+        for (auto& exchange : *exchanges) {
+            if (exchange->timerId != 0) {
+                loop_.cancelTimer(exchange->timerId);
+            }
+        }
+    }
+    closeSocket();
+}
+
+bool Pipeline::isPipelinable(const RequestInfo& info) noexcept {
+    if (!info.isPipelining || !info.isKeepAlive || info.isBodyStreamed() || !isIdempotent(info.methodType)) {
+        return false;
+    }
+    Url url(info.url);
+    return url.isValid() && url.isHttpScheme();
+}
+
+void Pipeline::add(RequestInfo&& info, ResponseHandler&& handler, std::string reqId) noexcept {
+    auto exchange = std::make_unique<Exchange>();
+    exchange->url = std::make_unique<Url>(info.url);
+    exchange->info = std::move(info);
+    exchange->handler = std::move(handler);
+    exchange->reqId = std::move(reqId);
+    exchange->startTime = util::Time::steadyTime();
+    exchange->timerId = loop_.runAfter(exchange->info.timeout, [this, reqId = exchange->reqId] {
+        expire(reqId);
+    });
+    queue_.push_back(std::move(exchange));
+    if (state_ == State::Idle) {
+        open();
+    } else if (state_ == State::Ready) {
+        flush();
+    }
+}
+
+bool Pipeline::cancel(const std::string& reqId) noexcept {
+    auto isMatch = [&reqId](const ExchangePtr& exchange) {
+        return exchange->reqId == reqId && !exchange->isFinished;
+    };
+    if (auto it = std::find_if(queue_.begin(), queue_.end(), isMatch); it != queue_.end()) {
+        loop_.cancelTimer((*it)->timerId);
+        queue_.erase(it);
+        if (isIdle()) {
+            idle();
+        }
+        return true;
+    }
+    if (auto it = std::find_if(inflight_.begin(), inflight_.end(), isMatch); it != inflight_.end()) {
+        ///the response is still read and dropped, the ones behind it depend on that
+        auto& exchange = **it;
+        loop_.cancelTimer(exchange.timerId);
+        exchange.timerId = 0;
+        exchange.isValid = false;
+        exchange.isFinished = true;
+        return true;
+    }
+    return false;
+}
+
+void Pipeline::open() noexcept {
+    if (queue_.empty()) {
+        idle();
+        return;
+    }
+    if (pool_) {
+        socket_ = pool_->checkout(key_);
+    }
+    if (socket_) {
+        state_ = State::Ready;
+        flush();
+        return;
+    }
+    const auto& front = *queue_.front();
+#if !ENABLE_HTTPS
+    if (front.url->isHttps()) {
+        failAll(ResultCode::SchemeNotSupported, 0);
+        return;
+    }
+#endif
+    state_ = State::Connect;
+    query_ = std::make_unique<DnsQuery>(loop_, front.url->host, front.url->port, front.info.ipVersion,
+                                        [this](AddressInfoPtr address, int32_t errorCode) {
+        resolved(std::move(address), errorCode);
+    });
+    query_->start();
+}
+
+void Pipeline::resolved(AddressInfoPtr address, int32_t errorCode) noexcept {
+    if (address == nullptr) {
+        failAll(ResultCode::GetAddressFailed, errorCode);
+        return;
+    }
+    const auto& front = *queue_.front();
+    connector_ = std::make_unique<Connector>(loop_, std::move(address), front.info.connectionAttemptDelay,
+                                             [url = *front.url, options = front.info.socketOptions](IPVersion ipVersion) -> ISocket* {
+        ISocket* socket = nullptr;
+#if ENABLE_HTTPS
+        if (url.isHttps()) {
+            socket = new TSLSocket(ipVersion, url.host, url.port);
+        }
+#endif
+        if (socket == nullptr) {
+            socket = new PlainSocket(ipVersion);
+        }
+        socket->setOptions(options);
+        return socket;
+    }, [this](Connector::SocketPtr socket, SocketResult result) {
+        connected(std::move(socket), result);
+    });
+    connector_->start();
+}
+
+void Pipeline::onEvent(uint32_t events) noexcept {
+    switch (state_) {
+        case State::Handshake:
+            handshake();
+            break;
+        case State::Ready:
+            if (events & (kEventRead | kEventError)) {
+                receive();
+            }
+            if (state_ == State::Ready && sendPos_ < sendData_.size()) {
+                send();
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+void Pipeline::connected(Connector::SocketPtr socket, SocketResult result) noexcept {
+    if (!result.isSuccess()) {
+        failAll(result.resultCode, result.errorCode);
+        return;
+    }
+    socket_ = std::move(socket);
+    state_ = State::Handshake;
+    handshake();
+}
+
+void Pipeline::handshake() noexcept {
+    auto result = socket_->handshake();
+    if (result.resultCode == ResultCode::Retry) {
+        wait(result.waitType == SelectType::Read ? kEventRead : kEventWrite);
+        return;
+    } else if (!result.isSuccess()) {
+        failAll(result.resultCode, result.errorCode);
+        return;
+    }
+    state_ = State::Ready;
+    flush();
+}
+
+void Pipeline::flush() noexcept {
+    while (!queue_.empty() && inflight_.size() < maxDepth_) {
+        auto exchange = std::move(queue_.front());
+        queue_.pop_front();
+        if (!exchange->isSent && exchange->isValid && exchange->handler.onConnected) {
+            exchange->handler.onConnected(exchange->reqId);
+        }
+        exchange->isSent = true;
+        sendData_ += encode::htmlEncode(exchange->info, *exchange->url);
+        inflight_.push_back(std::move(exchange));
+        if (inflight_.size() == 1) {
+            startParser();
+        }
+    }
+    send();
+}
+
+void Pipeline::send() noexcept {
+    auto dataView = std::string_view(sendData_);
+    while (sendPos_ < dataView.size()) {
+        auto [sendResult, sendSize] = socket_->send(dataView.substr(sendPos_));
+        if (sendResult.resultCode == ResultCode::Retry) {
+            ///the responses keep being read while the requests wait for the socket
+            wait(sendResult.waitType == SelectType::Read ? kEventRead : (kEventRead | kEventWrite));
+            return;
+        } else if (!sendResult.isSuccess()) {
+            restart(sendResult.resultCode, sendResult.errorCode, false);
+            return;
+        }
+        sendPos_ += static_cast<size_t>(sendSize);
+        if (counter_) {
+            counter_->sentBytes.fetch_add(static_cast<uint64_t>(sendSize), std::memory_order_relaxed);
+        }
+    }
+    sendData_.clear();
+    sendPos_ = 0;
+    wait(kEventRead);
+}
+
+void Pipeline::receive() noexcept {
+    int32_t readCount = 0;
+    do {
+        auto [recvResult, dataPtr] = socket_->receive();
+        if (!recvResult.isSuccess()) {
+            if (recvResult.resultCode == ResultCode::Retry) {
+                if (recvResult.waitType == SelectType::Write) {
+                    wait(kEventRead | kEventWrite);
+                    return;
+                }
+                break;
+            }
+            auto isGraceful = false;
+            if (parser_ && recvResult.resultCode == ResultCode::Disconnected &&
+                parser_->finish() == ParseState::Completed) {
+                ///the response without a length ends with the connection
+                complete();
+                isGraceful = true;
+            }
+            restart(recvResult.resultCode, recvResult.errorCode, isGraceful);
+            return;
+        }
+        if (counter_) {
+            counter_->receivedBytes.fetch_add(dataPtr->length, std::memory_order_relaxed);
+        }
+        if (!consume(std::move(dataPtr))) {
+            return;
+        }
+    } while (++readCount < kMaxReadCountPerEvent);
+    ///the completed responses made room for more requests
+    flush();
+}
+
+bool Pipeline::consume(DataPtr data) noexcept {
+    while (data && !data->empty()) {
+        if (inflight_.empty()) {
+            ///bytes nobody asked for, the connection is out of sync
+            restart(ResultCode::Failed, 0, false);
+            return false;
+        }
+        inflight_.front()->isReceived = true;
+        auto state = parser_->parse(std::move(data));
+        if (state == ParseState::Error) {
+            auto errorCode = parser_->errorCode();
+            fail(*inflight_.front(), errorCode, 0);
+            restart(errorCode, 0, false);
+            return false;
+        } else if (state != ParseState::Completed) {
+            return true;
+        }
+        data = parser_->takeRemain();
+        auto isKeepAlive = parser_->isKeepAlive();
+        complete();
+        if (!isKeepAlive) {
+            ///the server closes after this response, the rest goes to a new connection
+            restart(ResultCode::Disconnected, 0, true);
+            return false;
+        }
+    }
+    if (isIdle()) {
+        idle();
+        return false;
+    }
+    return true;
+}
+
+void Pipeline::startParser() noexcept {
+    auto exchange = inflight_.front().get();
+    ///redirects are followed by a session once the response is read, the pipeline stays in order
+    parser_ = std::make_unique<ResponseParser>(false);
+    parser_->setHeaderCallback([exchange](ResponseHeader&& header) {
+        if (header.isNeedRedirect() && exchange->info.isAllowRedirect && header.headers.count("Location")) {
+            exchange->location = header.headers["Location"];
+            return;
+        }
+        if (exchange->isValid && exchange->handler.onParseHeaderDone) {
+            exchange->handler.onParseHeaderDone(exchange->reqId, std::move(header));
+        }
+    });
+    parser_->setDataCallback([exchange](DataPtr data) {
+        if (exchange->location.empty() && exchange->isValid && exchange->handler.onData) {
+            exchange->handler.onData(exchange->reqId, std::move(data));
+        }
+    });
+}
+
+void Pipeline::complete() noexcept {
+    auto exchange = std::move(inflight_.front());
+    inflight_.pop_front();
+    if (!exchange->location.empty() && exchange->isValid && onRedirect_) {
+        loop_.cancelTimer(exchange->timerId);
+        exchange->timerId = 0;
+        exchange->isFinished = true;
+        exchange->info.url = exchange->location;
+        onRedirect_(std::move(exchange->info), std::move(exchange->handler), exchange->reqId);
+    } else {
+        finish(*exchange);
+    }
+    if (inflight_.empty()) {
+        parser_.reset();
+    } else {
+        startParser();
+    }
+}
+
+void Pipeline::expire(const std::string& reqId) noexcept {
+    auto isMatch = [&reqId](const ExchangePtr& exchange) {
+        return exchange->reqId == reqId;
+    };
+    if (auto it = std::find_if(queue_.begin(), queue_.end(), isMatch); it != queue_.end()) {
+        auto exchange = std::move(*it);
+        queue_.erase(it);
+        exchange->timerId = 0;
+        fail(*exchange, ResultCode::Timeout, 0);
+        if (isIdle()) {
+            idle();
+        }
+        return;
+    }
+    if (auto it = std::find_if(inflight_.begin(), inflight_.end(), isMatch); it != inflight_.end()) {
+        (*it)->timerId = 0;
+        fail(**it, ResultCode::Timeout, 0);
+        ///the responses behind it would keep waiting for it, send them again on a new connection
+        restart(ResultCode::Timeout, 0, true);
+    }
+}
+
+void Pipeline::restart(ResultCode code, int32_t errorCode, bool isGraceful) noexcept {
+    closeSocket();
+    parser_.reset();
+    sendData_.clear();
+    sendPos_ = 0;
+    state_ = State::Idle;
+    while (!inflight_.empty()) {
+        auto exchange = std::move(inflight_.back());
+        inflight_.pop_back();
+        if (exchange->isFinished) {
+            continue;
+        }
+        if (exchange->isReceived || (!isGraceful && exchange->resendCount >= kMaxResendCount)) {
+            fail(*exchange, code, errorCode);
+            continue;
+        }
+        if (!isGraceful) {
+            exchange->resendCount++;
+        }
+        queue_.push_front(std::move(exchange));
+    }
+    open();
+}
+
+void Pipeline::failAll(ResultCode code, int32_t errorCode) noexcept {
+    closeSocket();
+    state_ = State::Idle;
+    for (auto exchanges : {&inflight_, &queue_}) {
+        while (!exchanges->empty()) {
+            auto exchange = std::move(exchanges->front());
+            exchanges->pop_front();
+            if (!exchange->isFinished) {
+                fail(*exchange, code, errorCode);
+            }
+        }
+    }
+    idle();
+}
+
+void Pipeline::fail(Exchange& exchange, ResultCode code, int32_t errorCode) noexcept {
+    if (exchange.isValid && exchange.handler.onError) {
+        exchange.handler.onError(exchange.reqId, {code, errorCode});
+    }
+    finish(exchange);
+}
+
+void Pipeline::finish(Exchange& exchange) noexcept {
+    if (exchange.timerId != 0) {
+        loop_.cancelTimer(exchange.timerId);
+        exchange.timerId = 0;
+    }
+    if (exchange.isValid && exchange.handler.onStats) {
+        RequestStats stats;
+        stats.isFastOpen = socket_ && socket_->isFastOpen();
+        stats.networkTime = util::Time::steadyTime() - exchange.startTime;
+        exchange.handler.onStats(exchange.reqId, stats);
+    }
+    if (exchange.isValid && exchange.handler.onDisconnected) {
+        exchange.handler.onDisconnected(exchange.reqId);
+    }
+    exchange.isValid = false;
+    if (!exchange.isFinished) {
+        exchange.isFinished = true;
+        if (onFinish_) {
+            loop_.post([onFinish = onFinish_, reqId = exchange.reqId] {
+                onFinish(reqId);
+            });
+        }
+    }
+}
+
+void Pipeline::idle() noexcept {
+    if (socket_ && state_ == State::Ready && sendData_.empty() && pool_ && socket_->prepareIdle()) {
+        loop_.removeEvent(socket_->fd());
+        pool_->checkin(key_, std::move(socket_));
+    }
+    closeSocket();
+    parser_.reset();
+    state_ = State::Idle;
+    if (onIdle_) {
+        ///the owner destroys the pipeline, never do it inside its own callback
+        loop_.post([onIdle = onIdle_] {
+            onIdle();
+        });
+    }
+}
+
+void Pipeline::wait(uint32_t events) noexcept {
+    if (loop_.updateEvent(socket_->fd(), events)) {
+        return;
+    }
+    if (!loop_.addEvent(socket_->fd(), events, [this](uint32_t flags) { onEvent(flags); })) {
+        failAll(ResultCode::Failed, GetLastError());
+    }
+}
+
+void Pipeline::closeSocket() noexcept {
+    query_.reset();
+    connector_.reset();
+    if (socket_) {
+        loop_.removeEvent(socket_->fd());
+        socket_->close();
+        socket_.reset();
+    }
+}
+
+} //end of namespace http
@@ -6,9 +6,40 @@
 #include "PlainSocket.h"
 #include "Socket.h"
 #include "Type.h"
+#if !defined(_WIN32) && !defined(__CYGWIN__)
+#include <climits>
+#include <sys/uio.h>
+#endif
+#if defined(__linux__)
+#include <sys/sendfile.h>
+#endif
 
 namespace http {
 
+namespace {
+
+///map the return value of a send to its result, sendSize is 0 after a failure
+SocketResult checkSendResult(int64_t& sendSize, int32_t errorCode) noexcept {
+    SocketResult result;
+    result.errorCode = errorCode;
+    if (sendSize == kInvalid) {
+        sendSize = 0;
+        if (result.errorCode == RetryCode) {
+            result.resultCode = ResultCode::RetryReachMaxCount;
+        } else if (result.errorCode == AgainCode) {
+            result.resultCode = ResultCode::Retry;
+            result.waitType = SelectType::Write;
+        } else {
+            result.resultCode = ResultCode::Failed;
+        }
+    } else if (sendSize == 0) {
+        result.resultCode = ResultCode::Disconnected;
+    }
+    return result;
+}
+
+} //end of namespace
+
 PlainSocket::PlainSocket(IPVersion ipVersion)
     : ISocket(ipVersion) {
 
@@ -31,31 +62,83 @@ SocketResult PlainSocket::connect(const AddressInfoPtr& address, int64_t timeout
 }
 
 std::tuple<SocketResult, int64_t> PlainSocket::send(const std::string_view& dataView) const noexcept {
-    int32_t sendSize = 0;
-    SocketResult result;
+    int64_t sendSize = 0;
+    int32_t errorCode = 0;
     int32_t retryCount = 0;
     do {
         retryCount++;
-        sendSize = static_cast<int32_t>(::send(socket_, dataView.data(), dataView.length(), kNoSignal));
-        if (sendSize == SocketError) {
-            result.errorCode = GetLastError();
-        } else {
-            result.errorCode = 0;
+        sendSize = static_cast<int64_t>(::send(socket_, dataView.data(), dataView.length(), kNoSignal));
+        errorCode = sendSize == SocketError ? GetLastError() : 0;
+    } while (retryCount < kMaxRetryCount && errorCode == RetryCode);
+    auto result = checkSendResult(sendSize, errorCode);
+    return {result, sendSize};
+}
+
+std::tuple<SocketResult, int64_t> PlainSocket::sendBuffers(const std::vector<DataView>& buffers) const noexcept {
+#if defined(_WIN32) || defined(__CYGWIN__)
+    return ISocket::sendBuffers(buffers);
+#else
+    std::vector<iovec> vectors;
+    vectors.reserve(buffers.size());
+    for (const auto& buffer : buffers) {
+        if (!buffer.empty()) {
+            vectors.push_back({const_cast<char*>(buffer.data()), buffer.size()});
         }
-    } while (retryCount < kMaxRetryCount && result.errorCode == RetryCode);
+    }
+    if (vectors.empty()) {
+        return {SocketResult(), 0};
+    }
+    msghdr message{};
+    message.msg_iov = vectors.data();
+    message.msg_iovlen = std::min(vectors.size(), static_cast<size_t>(IOV_MAX));
+    int64_t sendSize = 0;
+    int32_t errorCode = 0;
+    int32_t retryCount = 0;
+    do {
+        retryCount++;
+        sendSize = static_cast<int64_t>(::sendmsg(socket_, &message, kNoSignal));
+        errorCode = sendSize == SocketError ? GetLastError() : 0;
+    } while (retryCount < kMaxRetryCount && errorCode == RetryCode);
+    auto result = checkSendResult(sendSize, errorCode);
+    return {result, sendSize};
+#endif
+}
 
-    if (sendSize == kInvalid) {
-        sendSize = 0;
-        result.resultCode = result.errorCode == RetryCode ? ResultCode::RetryReachMaxCount : ResultCode::Failed;
-    } else if (sendSize == 0) {
-        result.resultCode = ResultCode::Disconnected;
+bool PlainSocket::isSendFileSupported() const noexcept {
+#if defined(__linux__)
+    return true;
+#else
+    return false;
+#endif
+}
+
+std::tuple<SocketResult, int64_t> PlainSocket::sendFile(int32_t fd, uint64_t offset, uint64_t size) const noexcept {
+#if defined(__linux__)
+    ///sendfile moves at most 0x7ffff000 bytes at once
+    constexpr uint64_t kMaxSendFileSize = 0x7ffff000;
+    int64_t sendSize = 0;
+    int32_t errorCode = 0;
+    int32_t retryCount = 0;
+    do {
+        retryCount++;
+        auto position = static_cast<off_t>(offset);
+        sendSize = static_cast<int64_t>(::sendfile(socket_, fd, &position, std::min(size, kMaxSendFileSize)));
+        errorCode = sendSize == SocketError ? GetLastError() : 0;
+    } while (retryCount < kMaxRetryCount && errorCode == RetryCode);
+    auto result = checkSendResult(sendSize, errorCode);
+    if (result.resultCode == ResultCode::Disconnected) {
+        ///0 means the file ended before offset, a closed connection fails with EPIPE
+        result.resultCode = ResultCode::Success;
     }
     return {result, sendSize};
+#else
+    return ISocket::sendFile(fd, offset, size);
+#endif
 }
 
 std::tuple<SocketResult, DataPtr> PlainSocket::receive() const noexcept {
     SocketResult result;
-    auto data = std::make_unique<Data>(kDefaultReadSize);
+    auto data = Data::makePooled(kDefaultReadSize);
     int32_t receiveSize = 0;
     int32_t retryCount = 0;
     do {
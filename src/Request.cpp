@@ -4,11 +4,19 @@
 // Copyright (c) 2024 Nevermore All rights reserved.
 //
 #include "Request.h"
+#include "BodyStream.h"
+#include "ConnectionPool.h"
+#include "Connector.h"
 #include "Data.hpp"
+#include "DnsCache.h"
+#include "DnsResolver.h"
 #include "TSLSocket.h"
 #include "Type.h"
 #include "PlainSocket.h"
+#include "UringSocket.h"
 #include "Url.h"
+#include "ResponseParser.h"
+#include "Encode.h"
 #include <cstdint>
 #include <utility>
 #include <sstream>
@@ -24,37 +32,6 @@ std::string getMethodName(HttpMethodType type) {
     return kMethodNameArray[static_cast<int>(type)];
 }
 
-template <typename T>
-bool parseFieldValue(const std::unordered_map<std::string, std::string>& headers, const std::string& key, T& value) {
-    if (headers.count(key) == 0) {
-        return false;
-    }
-    if constexpr (std::is_same_v<double, T>) {
-        value = std::stod(headers.at(key));
-    } else if constexpr (std::is_same_v<float, T>) {
-        value = std::stof(headers.at(key));
-    } else if constexpr (std::is_same_v<uint32_t, T>) {
-        value = std::stoul(headers.at(key));
-    } else if constexpr (std::is_same_v<int32_t, T>) {
-        value = std::stoi(headers.at(key));
-    } else if constexpr (std::is_same_v<uint64_t, T>) {
-        value = std::stoull(headers.at(key));
-    } else if constexpr (std::is_same_v<int64_t, T>) {
-        value = std::stoll(headers.at(key));
-    } else if constexpr (std::is_same_v<std::string, T> || std::is_same_v<std::string_view, T>) {
-        value = headers.at(key);
-    } else if constexpr (std::is_same_v<bool, T>) {
-        std::istringstream(headers.at(key)) >> std::boolalpha >> value;
-    } else if constexpr (std::is_same_v<char, T>) {
-        value = static_cast<char>(std::stoi(headers.at(key)));
-    } else if constexpr (std::is_same_v<unsigned char, T>) {
-        value = static_cast<unsigned char>(std::stoi(headers.at(key)));
-    } else {
-        return false;
-    }
-    return true;
-}
-
 namespace encode {
 ///https://stackoverflow.com/questions/180947/base64-decode-snippet-in-c
 constexpr std::string_view kBase64Content = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/"sv;
@@ -76,12 +53,21 @@ std::string base64Encode(const std::string& str) {
     return res;
 }
 
-std::string htmlEncode(RequestInfo& info, const Url& url) noexcept {
+std::string encodeHeader(RequestInfo& info, const Url& url) noexcept {
     auto& headers = info.headers;
     if (!info.bodyEmpty()) {
         headers["Content-Length"] = std::to_string(info.bodySize());
+    } else if (info.isBodyFile()) {
+        headers["Content-Length"] = std::to_string(std::max<int64_t>(BodyStream::fileLength(info.bodyFile), 0));
+    } else if (info.isBodyStreamed() && info.bodyLength >= 0) {
+        headers["Content-Length"] = std::to_string(info.bodyLength);
+    } else if (info.isBodyStreamed()) {
+        headers["Transfer-Encoding"] = "chunked";
     }
     headers["Host"] = url.host;
+    if (!info.isKeepAlive && headers.count("Connection") == 0) {
+        headers["Connection"] = "close";
+    }
     if (headers.count("Authorization") == 0 && !url.userInfo.empty()) {
         headers["Authorization"] = std::string("Basic ") + base64Encode(url.userInfo);
     }
@@ -91,34 +77,170 @@ std::string htmlEncode(RequestInfo& info, const Url& url) noexcept {
     std::for_each(headers.begin(), headers.end(), [&](const auto& pair) {
         oss << pair.first << ": " << pair.second << "\r\n";
     });
-    if (!info.bodyEmpty()) {
-        oss << "\r\n";
-        oss << info.body->view();
-    }
     oss << "\r\n";
     return oss.str();
 }
 
+std::string htmlEncode(RequestInfo& info, const Url& url) noexcept {
+    auto res = encodeHeader(info, url);
+    if (!info.bodyEmpty()) {
+        res.append(info.body->view());
+    }
+    return res;
+}
+
 }
 
 using namespace std::chrono_literals;
 
+namespace {
+std::mutex gExecutorMutex;
+std::shared_ptr<RequestExecutor> gDefaultExecutor;
+
+std::shared_ptr<RequestExecutor> defaultExecutor() noexcept {
+    std::lock_guard lock(gExecutorMutex);
+    return gDefaultExecutor;
+}
+
+ConnectionPool& sharedPool() noexcept {
+    static ConnectionPool pool;
+    return pool;
+}
+
+///the pool key of the io_uring connections, they need a ring and only go to the requests that use one
+constexpr std::string_view kUringKeySuffix = "#uring";
+
+///plain http on a worker of an executor goes through io_uring. The ring is per thread, its setup costs more syscalls
+///than a short request saves, so a thread per request keeps the socket path
+bool useUring(const Url& url) noexcept {
+#if ENABLE_IO_URING
+    return !url.isHttps() && RequestExecutor::isWorkerThread() && UringSocket::isSupported();
+#else
+    (void)url;
+    return false;
+#endif
+}
+
+ISocket* makeSocket(const Url& url, IPVersion ipVersion, const SocketOptions& options, bool isUring = false) noexcept {
+    ISocket* socket = nullptr;
+#if ENABLE_HTTPS
+    if (url.isHttps()) {
+        socket = new TSLSocket(ipVersion, url.host, url.port);
+    }
+#endif
+#if ENABLE_IO_URING
+    if (socket == nullptr && isUring) {
+        socket = new UringSocket(ipVersion);
+    }
+#else
+    (void)isUring;
+#endif
+    if (socket == nullptr) {
+        socket = new PlainSocket(ipVersion);
+    }
+    socket->setOptions(options);
+    return socket;
+}
+}
+
+void Request::setDefaultExecutor(std::shared_ptr<RequestExecutor> executor) noexcept {
+    std::lock_guard lock(gExecutorMutex);
+    gDefaultExecutor = std::move(executor);
+}
+
+void Request::setConnectionPoolConfig(const ConnectionPoolConfig& config) noexcept {
+    sharedPool().setConfig(config);
+}
+
+void Request::setDnsCacheConfig(const DnsCacheConfig& config) noexcept {
+    DnsCache::shared().setConfig(config);
+}
+
+void Request::setHostOverride(const std::string& host, const std::string& port,
+                              const std::vector<std::string>& addresses) noexcept {
+    DnsCache::shared().setOverride(host, port, addresses);
+}
+
+void Request::clearDnsCache() noexcept {
+    DnsCache::shared().clear();
+}
+
+void Request::setDnsResolverConfig(const DnsResolverConfig& config) noexcept {
+    DnsResolver::shared().setConfig(config);
+}
+
+void Request::warmUp() noexcept {
+#if ENABLE_HTTPS
+    SSLManager::shareContext();
+#endif
+}
+
+uint32_t Request::preconnect(const std::string& origin, uint32_t count, IPVersion ipVersion) noexcept {
+    Url url(origin);
+    if (!url.isValid() || !url.isHttpScheme()) {
+        return 0;
+    }
+#if !ENABLE_HTTPS
+    if (url.isHttps()) {
+        return 0;
+    }
+#endif
+    warmUp();
+    RequestInfo info;
+    auto timeout = info.connectTimeout.count() > 0 ? info.connectTimeout.count() : info.timeout.count();
+    auto [addressInfoPtr, errorCode] = DnsCache::shared().resolve(url.host, url.port, ipVersion, timeout);
+    if (addressInfoPtr == nullptr) {
+        return 0;
+    }
+    auto key = ConnectionPool::makeKey(url, ipVersion, info.socketOptions);
+    uint32_t readyCount = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        auto [socket, result] = Connector::connect(addressInfoPtr, info.connectionAttemptDelay,
+                                                   [&url, &info](IPVersion version) {
+            return makeSocket(url, version, info.socketOptions);
+        }, timeout);
+        if (result.isSuccess()) {
+            result = socket->finishHandshake(timeout);
+        }
+        if (!result.isSuccess() || !socket->prepareIdle()) {
+            continue;
+        }
+        sharedPool().checkin(key, std::move(socket));
+        readyCount++;
+    }
+    return readyCount;
+}
+
 Request::Request(const RequestInfo& info, const ResponseHandler& responseHandler)
+    : Request(info, responseHandler, defaultExecutor()) {
+
+}
+
+Request::Request(RequestInfo&& info, ResponseHandler&& responseHandler)
+    : Request(std::move(info), std::move(responseHandler), defaultExecutor()) {
+
+}
+
+Request::Request(const RequestInfo& info, const ResponseHandler& responseHandler, std::shared_ptr<RequestExecutor> executor)
     : info_(info)
     , handler_(responseHandler)
-    , startStamp_(Time::nowTimeStamp())
+    , startTime_(Time::steadyTime())
     , reqId_(StringUtil::randomString(20))
     , socket_(nullptr, freeSocket)
-    , url_(nullptr, freeUrl) {
+    , url_(nullptr, freeUrl)
+    , bodyStream_(nullptr, freeBodyStream)
+    , executor_(std::move(executor)) {
     config();
 }
 
-Request::Request(RequestInfo&& info, ResponseHandler&& responseHandler)
+Request::Request(RequestInfo&& info, ResponseHandler&& responseHandler, std::shared_ptr<RequestExecutor> executor)
     : info_(std::move(info))
     , handler_(std::move(responseHandler))
-    , startStamp_(Time::nowTimeStamp())
+    , startTime_(Time::steadyTime())
     , reqId_(StringUtil::randomString(20)), socket_(nullptr,freeSocket)
-    , url_(nullptr, freeUrl) {
+    , url_(nullptr, freeUrl)
+    , bodyStream_(nullptr, freeBodyStream)
+    , executor_(std::move(executor)) {
     config();
 }
 
@@ -126,6 +248,9 @@ Request::~Request() {
     if (worker_ && worker_->joinable()) {
         worker_->join();
     }
+    if (task_) {
+        RequestExecutor::wait(task_);
+    }
 }
 
 bool Request::init() {
@@ -145,8 +270,18 @@ void Request::clear() {
 }
 
 void Request::config() noexcept {
-
-    worker_ = std::make_unique<std::thread>(&Request::process, this);
+    if (executor_ == nullptr) {
+        worker_ = std::make_unique<std::thread>(&Request::process, this);
+        return;
+    }
+    task_ = std::make_shared<ExecutorTask>();
+    task_->run = [this] {
+        process();
+    };
+    task_->reject = [this] {
+        handleErrorResponse(ResultCode::Rejected, 0);
+    };
+    executor_->submit(task_);
 }
 
 #ifdef __clang__
@@ -157,45 +292,62 @@ void Request::config() noexcept {
 #pragma comment(lib, "Ws2_32.lib")
 #endif //end _WIN32
 
-void Request::sendRequest() noexcept {
+void Request::sendRequest(bool isReuse) noexcept {
     auto errorHandler = [&](ResultCode code, int32_t errorCode) {
         this->handleErrorResponse(code, errorCode);
     };
-    addrinfo hints{};
-    hints.ai_family = GetAddressFamily(info_.ipVersion);
-    hints.ai_socktype = SOCK_STREAM; //tcp
-    addrinfo* addressInfo = nullptr;
-    ResponseHeader responseData;
-    if (getaddrinfo(url_->host.data(), url_->port.data(), &hints, &addressInfo) != 0 || addressInfo == nullptr) {
-        errorHandler(ResultCode::GetAddressFailed, GetLastError());
+    isUring_ = useUring(*url_);
+    auto key = ConnectionPool::makeKey(*url_, info_.ipVersion, info_.socketOptions);
+    poolKey_ = isUring_ ? key + std::string(kUringKeySuffix) : key;
+    if (isReuse && info_.isKeepAlive) {
+        socket_ = sharedPool().checkout(poolKey_);
+        if (socket_ == nullptr && isUring_) {
+            ///a socket path connection, e.g. one of preconnect, works on any thread
+            socket_ = sharedPool().checkout(key);
+            if (socket_ != nullptr) {
+                poolKey_ = key;
+            }
+        }
+    }
+    isReusedSocket_ = socket_ != nullptr;
+    if (isReusedSocket_) {
+        if (handler_.onConnected) {
+            handler_.onConnected(reqId_);
+        }
+        if (send()) {
+            receive();
+        }
         return;
     }
-    auto ipVersion = info_.ipVersion;
-    if (ipVersion == IPVersion::Auto) {
-        ipVersion = addressInfo->ai_family == AF_INET ? IPVersion::V4 : IPVersion::V6;
+    ///the built-in resolver gives up with the connect phase, getaddrinfo has no timeout
+    auto [addressInfoPtr, errorCode] = DnsCache::shared().resolve(url_->host, url_->port, info_.ipVersion,
+                                                                  getRemainTime(info_.connectTimeout));
+    if (addressInfoPtr == nullptr) {
+        errorHandler(ResultCode::GetAddressFailed, errorCode);
+        return;
     }
-    ISocket* socketPtr = nullptr;
+#if !ENABLE_HTTPS
     if (url_->isHttps()) {
-#if ENABLE_HTTPS
-        socketPtr = new TSLSocket(ipVersion);
-#else
         errorHandler(ResultCode::SchemeNotSupported, 0);
-#endif
-    } else {
-        socketPtr = new PlainSocket(ipVersion);
+        return;
     }
-    socket_ = std::unique_ptr<ISocket, decltype(&freeSocket)>(socketPtr, freeSocket);
-    auto addressInfoPtr = MakeAddressInfoPtr(addressInfo);
-    auto timeout = getRemainTime();
+#endif
+    auto timeout = getRemainTime(info_.connectTimeout);
     if (timeout <= 0) {
         errorHandler(ResultCode::Timeout, GetLastError());
         return;
     }
-    auto result = socket_->connect(addressInfoPtr, timeout);
+    auto [socket, result] = Connector::connect(addressInfoPtr, info_.connectionAttemptDelay, [this](IPVersion ipVersion) {
+        return createSocket(ipVersion);
+    }, timeout);
+    if (result.isSuccess()) {
+        socket_ = std::move(socket);
+        result = socket_->finishHandshake(getRemainTime(info_.connectTimeout));
+    }
     if (!result.isSuccess()) {
-        errorHandler(result.resultCode, GetLastError());
+        errorHandler(result.resultCode, result.errorCode);
         return;
-    } else if (handler_.onConnected) {
+    } else if (isReuse && handler_.onConnected) {
         handler_.onConnected(reqId_);
     }
     if (!send()) {
@@ -204,6 +356,17 @@ void Request::sendRequest() noexcept {
     receive();
 }
 
+ISocket* Request::createSocket(IPVersion ipVersion) noexcept {
+    auto socket = makeSocket(*url_, ipVersion, info_.socketOptions, isUring_);
+#if ENABLE_HTTPS
+    if (url_->isHttps() && info_.isEarlyData && !info_.isBodyStreamed() &&
+        (info_.methodType == HttpMethodType::Get || info_.methodType == HttpMethodType::Options)) {
+        static_cast<TSLSocket*>(socket)->setEarlyData(encode::htmlEncode(info_, *url_));
+    }
+#endif
+    return socket;
+}
+
 void Request::redirect(const std::string& url) noexcept {
     auto errorHandler = [this](ResultCode code) {
         handleErrorResponse(code, 0);
@@ -228,6 +391,10 @@ void Request::process() noexcept {
     auto handler = [&](ResultCode code) {
         this->handleErrorResponse(code, 0);
     };
+    if (!isValid_) {
+        return; //canceled while it was queued
+    }
+    stats_.queueTime = Time::steadyTime() - startTime_;
     if (info_.methodType == HttpMethodType::Unknown) {
         handler(ResultCode::MethodError);
         return;
@@ -243,64 +410,61 @@ void Request::process() noexcept {
         return;
     }
     sendRequest();
+    socket_.reset(); //release it on the thread that used it
 }
 
 bool Request::send() noexcept {
+    if (socket_->isEarlyDataAccepted()) {
+        return true; //the request went out with the handshake
+    }
     auto canSend = socket_->canSend(getRemainTime());
     if (!canSend.isSuccess()) {
         this->handleErrorResponse(canSend.resultCode, canSend.errorCode);
         return false;
     }
-    std::this_thread::sleep_for(1ms);
-    auto sendData = encode::htmlEncode(info_, *url_);
-    auto dataView = std::string_view(sendData);
-    do {
-        auto [sendResult, sendSize] = socket_->send(dataView);
-        if (!sendResult.isSuccess()) {
-            this->handleErrorResponse(sendResult.resultCode, sendResult.errorCode);
+    if (info_.isBodyStreamed()) {
+        bodyStream_.reset(new BodyStream(info_));
+        if (bodyStream_->isFailed()) {
+            this->handleErrorResponse(ResultCode::BodyReadFailed, 0);
             return false;
-        } else if (sendSize < dataView.size()) {
-            dataView = dataView.substr(sendSize);
-        } else {
+        }
+    }
+    ///the header and the body go out as separate buffers, the body is never copied into the header
+    auto header = encode::encodeHeader(info_, *url_);
+    std::vector<DataView> buffers{header};
+    if (!info_.bodyEmpty()) {
+        buffers.push_back(info_.body->view());
+    }
+    while (true) {
+        ///a streamed body follows the header
+        auto isStream = buffers.empty() && bodyStream_ != nullptr;
+        if (buffers.empty() && !isStream) {
             break;
         }
-    } while (!dataView.empty());
-    return true;
-}
-
-std::tuple<bool, int64_t> parseResponseHeader(std::string_view data, ResponseHeader& response) {
-    constexpr std::string_view kCRLF = "\r\n"sv;
-    constexpr std::string_view kHeaderEnd = "\r\n\r\n"sv;
-    ///https://www.rfc-editor.org/rfc/rfc7230#section-3.1.2:~:text=header%2Dfield%20CRLF%20)-,CRLF,-%5B%20message%2Dbody%20%5D
-    auto headerEndPos = data.find(kHeaderEnd);
-    if (headerEndPos == std::string_view::npos) {
-        return {false, 0};
-    }
-    auto headerView = data.substr(0, headerEndPos);
-
-    auto headerViews = StringUtil::split(headerView, std::string(kCRLF));
-    ///parse version and status
-    auto statusView = headerViews[0];
-    constexpr std::string_view kHTTPFlag = "HTTP/"sv;
-    if (auto versionPos = statusView.find(kHTTPFlag); versionPos != std::string_view::npos) {
-        ///HTTP-version SP status-code SP reason-phrase CRLF
-        response.headers["Version"] = statusView.substr(versionPos, kHTTPFlag.size() + 3);
-        response.httpStatusCode = static_cast<HttpStatusCode>(std::stoi(std::string(statusView.substr(kHTTPFlag.size() + 4, 3))));
-        response.reasonPhrase = statusView.substr(versionPos + kHTTPFlag.size() + 3 + 1 + 3 + 1);
-    }
-    for (auto& view : headerViews) {
-        if (view.empty() || view.find(':') == std::string_view::npos) {
-            continue;
+        auto [sendResult, sendSize] = isStream ? bodyStream_->send(*socket_) : socket_->sendBuffers(buffers);
+        if (sendResult.resultCode == ResultCode::Completed) {
+            break;
         }
-        auto fieldValue = StringUtil::split(view, ": ");
-        if (fieldValue.size() == 2) {
-            auto name = std::string(fieldValue[0]);
-            auto value = std::string(fieldValue[1]);
-            response.headers[std::move(StringUtil::removePrefix(name, ' '))] = std::move(
-            StringUtil::removePrefix(value, ' '));
+        if (sendResult.resultCode == ResultCode::Retry) {
+            ///tls may need to read before it can write
+            auto waitResult = sendResult.waitType == SelectType::Write ? socket_->canSend(getRemainTime()) :
+                                                                          socket_->canReceive(getRemainTime());
+            if (waitResult.isSuccess() || waitResult.resultCode == ResultCode::Retry) {
+                continue;
+            }
+            sendResult = waitResult;
+        }
+        if (!sendResult.isSuccess()) {
+            if (sendResult.resultCode == ResultCode::BodyReadFailed || !retryStaleSocket()) {
+                this->handleErrorResponse(sendResult.resultCode, sendResult.errorCode);
+            }
+            return false;
+        }
+        if (!isStream) {
+            buffers = skipBuffers(buffers, static_cast<uint64_t>(sendSize));
         }
     }
-    return {true, headerEndPos + kHeaderEnd.size()};
+    return true;
 }
 
 bool Request::isReceivable() noexcept {
@@ -309,12 +473,11 @@ bool Request::isReceivable() noexcept {
             disconnected();
             return false;
         }
-        auto timeout = getRemainTime();
-        auto canReceive = socket_->canReceive(timeout);
+        auto canReceive = socket_->canReceive(getRemainTime(info_.readTimeout));
         if (canReceive.isSuccess()) {
             return true;
         }
-        timeout = getRemainTime();
+        auto timeout = getRemainTime();
         if (timeout > 0 && canReceive.resultCode == ResultCode::Retry) {
             continue;
         }
@@ -323,65 +486,37 @@ bool Request::isReceivable() noexcept {
     }
 }
 
-bool Request::parseChunk(DataPtr& data, int64_t& chunkSize, bool& isCompleted) noexcept {
-    constexpr std::string_view kCRLF = "\r\n"sv;
-    bool res = true;
-    auto dataView = data->view();
-    while (!dataView.empty()) {
-        if (chunkSize <= 0) {
-            auto pos = dataView.find(kCRLF);
-            if (pos == std::string_view::npos) {
-                this->handleErrorResponse(ResultCode::ChunkSizeError, 0);
-                res = false;
-                break;
-            }
-            chunkSize = std::stol(std::string(dataView.substr(0, pos)), nullptr, 16);
-            if (chunkSize == 0) {
-                isCompleted = true;
-                break;
-            }
-            dataView = dataView.substr(pos + kCRLF.size());
-        } else {
-            auto size = std::min(static_cast<size_t>(chunkSize), dataView.size());
-            responseData(std::make_unique<Data>(std::string(dataView.substr(0, size))));
-            dataView = dataView.substr(size);
-            chunkSize -= static_cast<int64_t>(size);
-        }
-
-        if (dataView.find(kCRLF) == 0) {
-            dataView = dataView.substr(kCRLF.size());
-        }
-    }
-
-    if (dataView.empty()) {
-        data->destroy();
-    } else {
-        data = std::make_unique<Data>(std::string(dataView));
-    }
-    return res;
-}
-
 void Request::receive() noexcept {
-    ResponseHeader response;
-    auto recvDataPtr = std::make_unique<Data>();
-    bool parseHeaderSuccess = false;
-    int64_t contentLength = INT64_MAX;
-    int64_t recvLength = 0;
-    std::string transferCoding;
-    int64_t chunkSize = kInvalid;
+    ResponseParser parser(info_.isAllowRedirect && !info_.isBodyStreamed());
+    parser.setHeaderCallback([this](ResponseHeader&& header) {
+        responseHeader(std::move(header));
+    });
+    parser.setDataCallback([this](DataPtr data) {
+        responseData(std::move(data));
+    });
     while (true) {
         if (!isReceivable()) {
             return;
         }
-        std::this_thread::sleep_for(1ms);
         auto [recvResult, dataPtr] = std::move(socket_->receive());
-        bool isCompleted = (recvResult.resultCode == ResultCode::Completed ||
-                            recvResult.resultCode == ResultCode::Disconnected);
         if (!recvResult.isSuccess()) {
-            if (recvResult.resultCode == ResultCode::Retry) {
+            if (recvResult.resultCode == ResultCode::Retry && recvResult.waitType == SelectType::Write) {
+                ///tls renegotiation has to write before it can read again
+                auto waitResult = socket_->canSend(getRemainTime());
+                if (waitResult.isSuccess() || waitResult.resultCode == ResultCode::Retry) {
+                    continue;
+                }
+                recvResult = waitResult;
+            } else if (recvResult.resultCode == ResultCode::Retry) {
                 continue;
             }
-            if (isCompleted) {
+            if ((recvResult.resultCode == ResultCode::Disconnected || recvResult.resultCode == ResultCode::Failed) &&
+                retryStaleSocket()) {
+                return;
+            }
+            if (recvResult.resultCode == ResultCode::Completed ||
+                recvResult.resultCode == ResultCode::Disconnected) {
+                parser.finish();
                 disconnected();
             } else {
                 this->handleErrorResponse(recvResult.resultCode, recvResult.errorCode);
@@ -389,52 +524,56 @@ void Request::receive() noexcept {
             return;
         }
 
-        if (!parseHeaderSuccess) {
-            recvDataPtr->append(std::move(dataPtr));
-            auto [isSuccess, headerSize] = parseResponseHeader(recvDataPtr->view(), response);
-            parseHeaderSuccess = isSuccess;
-            if (!isSuccess) {
-                continue;
-            }
-            if (response.isNeedRedirect() && info_.isAllowRedirect) {
-                redirect(response.headers["Location"]);
-                return;
-            }
-            parseFieldValue(response.headers, "Content-Length", contentLength);
-            parseFieldValue(response.headers, "Transfer-Encoding", transferCoding);
-            responseHeader(std::move(response));
-            dataPtr = recvDataPtr->copy(headerSize);
-            recvDataPtr->destroy();
-        }
-
-        recvLength += static_cast<int64_t>(dataPtr->length);
-        if (transferCoding == "chunked") {
-            recvDataPtr->append(std::move(dataPtr));
-            if (!parseChunk(recvDataPtr, chunkSize, isCompleted)) {
-                return; //disconnect
-            }
-        } else {
-            isCompleted = isCompleted || recvLength >= contentLength;
-            if (parseHeaderSuccess && !dataPtr->empty()){
-                responseData(std::move(dataPtr));
-            }
-        }
-
-        if (isCompleted) {
+        isReusedSocket_ = false;
+        auto state = parser.parse(std::move(dataPtr));
+        if (state == ParseState::Redirect) {
+            redirect(parser.location());
+            return;
+        } else if (state == ParseState::Error) {
+            this->handleErrorResponse(parser.errorCode(), 0);
+            return; //disconnect
+        } else if (state == ParseState::Completed) {
+            recycleSocket(parser);
             disconnected();
             return; //disconnect
         }
     }
 }
+
+bool Request::retryStaleSocket() noexcept {
+    if (!isReusedSocket_ || !isValid_ || (bodyStream_ && bodyStream_->isStarted())) {
+        return false;
+    }
+    isReusedSocket_ = false;
+    socket_.reset();
+    sendRequest(false);
+    return true;
+}
+
+void Request::recycleSocket(const ResponseParser& parser) noexcept {
+    stats_.isFastOpen = socket_->isFastOpen();
+    if (!isValid_ || !info_.isKeepAlive || !parser.isReusable() || !socket_->prepareIdle()) {
+        return;
+    }
+    sharedPool().checkin(poolKey_, std::move(socket_));
+}
 #ifdef __clang__
 #pragma clang diagnostic pop
 #endif
 
 int64_t Request::getRemainTime() const noexcept {
-    auto t = static_cast<int64_t>((info_.timeout - (Time::nowTimeStamp().diff(startStamp_))).count());
+    auto t = static_cast<int64_t>((info_.timeout - (Time::steadyTime() - startTime_)).count());
     return std::max<int64_t>(t, 0ll);
 }
 
+int64_t Request::getRemainTime(std::chrono::milliseconds phaseTimeout) const noexcept {
+    auto remainTime = getRemainTime();
+    if (phaseTimeout.count() <= 0) {
+        return remainTime;
+    }
+    return std::min<int64_t>(remainTime, phaseTimeout.count());
+}
+
 void Request::handleErrorResponse(ResultCode code, int32_t errorCode) noexcept {
     if (handler_.onError) {
         handler_.onError(reqId_ , {code, errorCode});
@@ -456,6 +595,13 @@ void Request::responseData(DataPtr dataPtr) noexcept {
 
 
 void Request::disconnected() noexcept {
+    if (socket_) {
+        stats_.isFastOpen = socket_->isFastOpen();
+    }
+    if (isValid_ && handler_.onStats) {
+        stats_.networkTime = Time::steadyTime() - startTime_ - stats_.queueTime;
+        handler_.onStats(reqId_, stats_);
+    }
     if (isValid_ && handler_.onDisconnected) {
         handler_.onDisconnected(reqId_);
         socket_.reset(); //release resource
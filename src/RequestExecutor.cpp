@@ -0,0 +1,147 @@
+//
+// Created by Nevermore on 2026/10/17.
+// http-request RequestExecutor
+// Copyright (c) 2024 Nevermore All rights reserved.
+//
+#include "RequestExecutor.h"
+#include <algorithm>
+
+namespace http {
+
+namespace {
+thread_local bool isWorker = false;
+}
+
+RequestExecutor::RequestExecutor(ExecutorConfig config)
+    : config_(config) {
+    config_.maxThreads = std::max<uint32_t>(config_.maxThreads, 1);
+    config_.queueDepth = std::max<uint32_t>(config_.queueDepth, 1);
+}
+
+RequestExecutor::~RequestExecutor() {
+    std::vector<std::thread> workers;
+    std::deque<ExecutorTaskPtr> tasks;
+    {
+        std::lock_guard lock(mutex_);
+        isRunning_ = false;
+        workers.swap(workers_);
+        tasks.swap(tasks_);
+    }
+    taskCond_.notify_all();
+    spaceCond_.notify_all();
+    for (auto& worker : workers) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+    for (auto& task : tasks) {
+        execute(task, true);
+    }
+}
+
+void RequestExecutor::execute(const ExecutorTaskPtr& task, bool isReject) noexcept {
+    {
+        std::lock_guard lock(task->mutex);
+        if (task->state != ExecutorTask::State::Queued) {
+            return;
+        }
+        task->state = ExecutorTask::State::Running;
+    }
+    auto& func = isReject ? task->reject : task->run;
+    if (func) {
+        func();
+    }
+    std::lock_guard lock(task->mutex);
+    task->state = ExecutorTask::State::Done;
+    task->cond.notify_all();
+}
+
+void RequestExecutor::submit(const ExecutorTaskPtr& task) noexcept {
+    ExecutorTaskPtr discardTask;
+    std::unique_lock lock(mutex_);
+    if (!isRunning_) {
+        lock.unlock();
+        execute(task, true);
+        return;
+    }
+    if (tasks_.size() >= config_.queueDepth) {
+        switch (config_.rejectPolicy) {
+            case RejectPolicy::Reject:
+                lock.unlock();
+                execute(task, true);
+                return;
+            case RejectPolicy::CallerRuns:
+                lock.unlock();
+                execute(task, false);
+                return;
+            case RejectPolicy::Block:
+                spaceCond_.wait(lock, [this] {
+                    return !isRunning_ || tasks_.size() < config_.queueDepth;
+                });
+                if (!isRunning_) {
+                    lock.unlock();
+                    execute(task, true);
+                    return;
+                }
+                break;
+            case RejectPolicy::DiscardOldest:
+                discardTask = std::move(tasks_.front());
+                tasks_.pop_front();
+                break;
+        }
+    }
+    tasks_.push_back(task);
+    if (tasks_.size() > idleCount_ && workers_.size() < config_.maxThreads) {
+        workers_.emplace_back(&RequestExecutor::work, this);
+    }
+    lock.unlock();
+    taskCond_.notify_one();
+    if (discardTask) {
+        execute(discardTask, true);
+    }
+}
+
+void RequestExecutor::wait(const ExecutorTaskPtr& task) noexcept {
+    std::unique_lock lock(task->mutex);
+    task->cond.wait(lock, [&task] {
+        return task->state == ExecutorTask::State::Done;
+    });
+}
+
+size_t RequestExecutor::queueSize() noexcept {
+    std::lock_guard lock(mutex_);
+    return tasks_.size();
+}
+
+size_t RequestExecutor::threadCount() noexcept {
+    std::lock_guard lock(mutex_);
+    return workers_.size();
+}
+
+bool RequestExecutor::isWorkerThread() noexcept {
+    return isWorker;
+}
+
+void RequestExecutor::work() noexcept {
+    isWorker = true;
+    while (true) {
+        ExecutorTaskPtr task;
+        {
+            std::unique_lock lock(mutex_);
+            idleCount_++;
+            taskCond_.wait(lock, [this] {
+                return !isRunning_ || !tasks_.empty();
+            });
+            idleCount_--;
+            if (!isRunning_) {
+                return;
+            }
+            task = std::move(tasks_.front());
+            tasks_.pop_front();
+        }
+        spaceCond_.notify_one();
+        execute(task, false);
+    }
+}
+
+} //end of namespace http
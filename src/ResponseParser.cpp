@@ -0,0 +1,315 @@
+//
+// Created by Nevermore on 2026/10/17.
+// http-request ResponseParser
+// Copyright (c) 2024 Nevermore All rights reserved.
+//
+#include "ResponseParser.h"
+#include "Utility.h"
+#include <sstream>
+
+namespace http {
+
+using namespace http::util;
+using namespace std::string_view_literals;
+
+template <typename T>
+bool parseFieldValue(const std::unordered_map<std::string, std::string>& headers, const std::string& key, T& value) {
+    if (headers.count(key) == 0) {
+        return false;
+    }
+    if constexpr (std::is_same_v<double, T>) {
+        value = std::stod(headers.at(key));
+    } else if constexpr (std::is_same_v<float, T>) {
+        value = std::stof(headers.at(key));
+    } else if constexpr (std::is_same_v<uint32_t, T>) {
+        value = std::stoul(headers.at(key));
+    } else if constexpr (std::is_same_v<int32_t, T>) {
+        value = std::stoi(headers.at(key));
+    } else if constexpr (std::is_same_v<uint64_t, T>) {
+        value = std::stoull(headers.at(key));
+    } else if constexpr (std::is_same_v<int64_t, T>) {
+        value = std::stoll(headers.at(key));
+    } else if constexpr (std::is_same_v<std::string, T> || std::is_same_v<std::string_view, T>) {
+        value = headers.at(key);
+    } else if constexpr (std::is_same_v<bool, T>) {
+        std::istringstream(headers.at(key)) >> std::boolalpha >> value;
+    } else if constexpr (std::is_same_v<char, T>) {
+        value = static_cast<char>(std::stoi(headers.at(key)));
+    } else if constexpr (std::is_same_v<unsigned char, T>) {
+        value = static_cast<unsigned char>(std::stoi(headers.at(key)));
+    } else {
+        return false;
+    }
+    return true;
+}
+
+std::tuple<bool, int64_t> parseResponseHeader(std::string_view data, ResponseHeader& response) {
+    constexpr std::string_view kCRLF = "\r\n"sv;
+    constexpr std::string_view kHeaderEnd = "\r\n\r\n"sv;
+    ///https://www.rfc-editor.org/rfc/rfc7230#section-3.1.2:~:text=header%2Dfield%20CRLF%20)-,CRLF,-%5B%20message%2Dbody%20%5D
+    auto headerEndPos = data.find(kHeaderEnd);
+    if (headerEndPos == std::string_view::npos) {
+        return {false, 0};
+    }
+    auto headerView = data.substr(0, headerEndPos);
+
+    auto headerViews = StringUtil::split(headerView, std::string(kCRLF));
+    ///parse version and status
+    auto statusView = headerViews[0];
+    constexpr std::string_view kHTTPFlag = "HTTP/"sv;
+    if (auto versionPos = statusView.find(kHTTPFlag); versionPos != std::string_view::npos) {
+        ///HTTP-version SP status-code SP reason-phrase CRLF
+        response.headers["Version"] = statusView.substr(versionPos, kHTTPFlag.size() + 3);
+        response.httpStatusCode = static_cast<HttpStatusCode>(std::stoi(std::string(statusView.substr(kHTTPFlag.size() + 4, 3))));
+        response.reasonPhrase = statusView.substr(versionPos + kHTTPFlag.size() + 3 + 1 + 3 + 1);
+    }
+    for (auto& view : headerViews) {
+        if (view.empty() || view.find(':') == std::string_view::npos) {
+            continue;
+        }
+        auto fieldValue = StringUtil::split(view, ": ");
+        if (fieldValue.size() == 2) {
+            auto name = std::string(fieldValue[0]);
+            auto value = std::string(fieldValue[1]);
+            response.headers[std::move(StringUtil::removePrefix(name, ' '))] = std::move(
+            StringUtil::removePrefix(value, ' '));
+        }
+    }
+    return {true, headerEndPos + kHeaderEnd.size()};
+}
+
+ResponseParser::ResponseParser(bool isAllowRedirect) noexcept
+    : isAllowRedirect_(isAllowRedirect) {
+
+}
+
+ParseState ResponseParser::parse(DataPtr data) noexcept {
+    if (state_ != ParseState::Header && state_ != ParseState::Body) {
+        return state_;
+    }
+    if (data == nullptr || data->empty()) {
+        return state_;
+    }
+    if (state_ == ParseState::Body && !isChunked_ && static_cast<int64_t>(data->length) <= contentLength_ - recvLength_) {
+        ///the whole buffer is body, it is handed over as it is
+        recvLength_ += static_cast<int64_t>(data->length);
+        if (onData_) {
+            onData_(std::move(data));
+        }
+        if (recvLength_ >= contentLength_) {
+            state_ = ParseState::Completed;
+        }
+        return state_;
+    }
+    received_ = std::move(data);
+    auto view = received_->view();
+    if (state_ != ParseState::Header || parseHeader(view)) {
+        if (isChunked_) {
+            parseChunked(view);
+        } else {
+            parseBody(view);
+        }
+    }
+    received_.reset();
+    return state_;
+}
+
+ParseState ResponseParser::finish() noexcept {
+    if (state_ == ParseState::Body && !isChunked_ && contentLength_ == INT64_MAX) {
+        state_ = ParseState::Completed;
+    }
+    return state_;
+}
+
+///parse the header received so far, on success view is left holding the body bytes that followed it
+bool ResponseParser::parseHeader(DataView& view) noexcept {
+    uint64_t bufferedLength = 0;
+    if (buffer_) {
+        bufferedLength = buffer_->length;
+        buffer_->append(*received_);
+        view = buffer_->view();
+    }
+    ResponseHeader response;
+    auto [isSuccess, headerSize] = parseResponseHeader(view, response);
+    if (!isSuccess) {
+        if (buffer_ == nullptr) {
+            buffer_ = Data::slice(received_, 0, received_->length);
+        }
+        return false;
+    }
+    ///the header ends in the bytes just received, the body is taken from them rather than from buffer_
+    buffer_.reset();
+    view = received_->view().substr(static_cast<size_t>(headerSize) - bufferedLength);
+    if (response.isNeedRedirect() && isAllowRedirect_) {
+        location_ = response.headers["Location"];
+        state_ = ParseState::Redirect;
+        return false;
+    }
+    parseFieldValue(response.headers, "Content-Length", contentLength_);
+    std::string transferCoding;
+    parseFieldValue(response.headers, "Transfer-Encoding", transferCoding);
+    isChunked_ = transferCoding == "chunked";
+    ///https://www.rfc-editor.org/rfc/rfc7230#section-6.3
+    std::string connection;
+    parseFieldValue(response.headers, "Connection", connection);
+    StringUtil::toLower(connection);
+    if (response.headers["Version"] == "HTTP/1.1") {
+        isKeepAlive_ = connection.find("close") == std::string::npos;
+    } else {
+        isKeepAlive_ = connection.find("keep-alive") != std::string::npos;
+    }
+    auto statusCode = response.httpStatusCode;
+    state_ = ParseState::Body;
+    if (onHeader_) {
+        onHeader_(std::move(response));
+    }
+    ///https://www.rfc-editor.org/rfc/rfc7230#section-3.3.3
+    auto isEmptyBody = statusCode == HttpStatusCode::NoContent || statusCode == HttpStatusCode::NotModified;
+    ///without a length the body ends when the server closes
+    isKeepAlive_ = isKeepAlive_ && (isEmptyBody || isChunked_ || contentLength_ != INT64_MAX);
+    if (isEmptyBody || (!isChunked_ && contentLength_ == 0)) {
+        state_ = ParseState::Completed;
+        keepRemain(view);
+        return false;
+    }
+    return true;
+}
+
+void ResponseParser::parseBody(DataView view) noexcept {
+    auto remainLength = contentLength_ - recvLength_;
+    if (static_cast<int64_t>(view.size()) <= remainLength) {
+        recvLength_ += static_cast<int64_t>(view.size());
+        deliver(view);
+    } else {
+        deliver(view.substr(0, static_cast<size_t>(remainLength)));
+        keepRemain(view.substr(static_cast<size_t>(remainLength)));
+        recvLength_ = contentLength_;
+    }
+    if (recvLength_ >= contentLength_) {
+        state_ = ParseState::Completed;
+    }
+}
+
+void ResponseParser::parseChunked(DataView view) noexcept {
+    ///the line split by the previous read is completed with the start of this one, the chunk data after it is not copied
+    while (buffer_ && !view.empty() && state_ == ParseState::Body) {
+        auto lineEnd = view.find('\n');
+        auto size = lineEnd == std::string_view::npos ? view.size() : lineEnd + 1;
+        buffer_->append(*slice(view.substr(0, size)));
+        view.remove_prefix(size);
+        auto line = std::move(buffer_);
+        auto lineView = line->view();
+        if (!parseChunk(lineView)) {
+            return;
+        }
+        if (!lineView.empty() && state_ == ParseState::Body) {
+            buffer_ = slice(lineView);
+        }
+    }
+    if (state_ == ParseState::Body && !parseChunk(view)) {
+        return;
+    }
+    if (view.empty()) {
+        return;
+    }
+    if (state_ == ParseState::Body) {
+        buffer_ = std::make_unique<Data>(static_cast<uint64_t>(view.size()), reinterpret_cast<const uint8_t*>(view.data()));
+    } else if (state_ == ParseState::Completed) {
+        keepRemain(view);
+    }
+}
+
+bool ResponseParser::parseChunk(DataView& view) noexcept {
+    constexpr std::string_view kCRLF = "\r\n"sv;
+    while (!view.empty() && state_ == ParseState::Body) {
+        switch (chunkState_) {
+            case ChunkState::Size: {
+                auto pos = view.find(kCRLF);
+                if (pos == std::string_view::npos) {
+                    return true;
+                }
+                int64_t size = 0;
+                size_t digitCount = 0;
+                for (auto c : view.substr(0, pos)) {
+                    if (!std::isxdigit(static_cast<unsigned char>(c))) {
+                        break; //chunk extension
+                    }
+                    auto value = std::isdigit(static_cast<unsigned char>(c)) ? c - '0' : (std::tolower(c) - 'a' + 10);
+                    size = (size << 4) | value;
+                    digitCount++;
+                }
+                if (digitCount == 0) {
+                    setError(ResultCode::ChunkSizeError);
+                    return false;
+                }
+                view.remove_prefix(pos + kCRLF.size());
+                chunkSize_ = size;
+                chunkState_ = size == 0 ? ChunkState::Trailer : ChunkState::Data;
+                break;
+            }
+            case ChunkState::Data: {
+                auto size = std::min(static_cast<size_t>(chunkSize_), view.size());
+                deliver(view.substr(0, size));
+                view.remove_prefix(size);
+                chunkSize_ -= static_cast<int64_t>(size);
+                if (chunkSize_ == 0) {
+                    chunkState_ = ChunkState::DataEnd;
+                }
+                break;
+            }
+            case ChunkState::DataEnd: {
+                if (view.size() < kCRLF.size()) {
+                    return true;
+                }
+                if (view.substr(0, kCRLF.size()) != kCRLF) {
+                    setError(ResultCode::ChunkSizeError);
+                    return false;
+                }
+                view.remove_prefix(kCRLF.size());
+                chunkState_ = ChunkState::Size;
+                break;
+            }
+            case ChunkState::Trailer: {
+                auto pos = view.find(kCRLF);
+                if (pos == std::string_view::npos) {
+                    return true;
+                }
+                view.remove_prefix(pos + kCRLF.size());
+                if (pos == 0) {
+                    state_ = ParseState::Completed;
+                }
+                break;
+            }
+        }
+    }
+    return true;
+}
+
+DataPtr ResponseParser::slice(DataView view) const noexcept {
+    auto begin = reinterpret_cast<const uint8_t*>(view.data());
+    if (received_ && begin >= received_->rawData && begin + view.size() <= received_->rawData + received_->length) {
+        return Data::slice(received_, static_cast<uint64_t>(begin - received_->rawData), static_cast<uint64_t>(view.size()));
+    }
+    return std::make_unique<Data>(static_cast<uint64_t>(view.size()), begin);
+}
+
+void ResponseParser::deliver(DataView view) noexcept {
+    if (view.empty() || !onData_) {
+        return;
+    }
+    onData_(slice(view));
+}
+
+void ResponseParser::keepRemain(DataView view) noexcept {
+    if (view.empty()) {
+        return;
+    }
+    remain_ = slice(view);
+}
+
+void ResponseParser::setError(ResultCode code) noexcept {
+    state_ = ParseState::Error;
+    errorCode_ = code;
+}
+
+} //end of namespace http
@@ -7,7 +7,11 @@
 #include "SSLManager.h"
 #include "Socket.h"
 #include "Type.h"
-#include <thread>
+#include <algorithm>
+#include <atomic>
+#include <ctime>
+#include <deque>
+#include <unordered_map>
 #ifdef _WIN32
 #ifdef __cplusplus
 extern "C" {
@@ -21,6 +25,112 @@ extern "C" {
 
 namespace http {
 
+namespace {
+
+///the newest sessions kept per origin, a tls 1.3 ticket is used once
+constexpr size_t kMaxSessionsPerOrigin = 4;
+///the least recently used origin is dropped beyond this
+constexpr size_t kMaxSessionOrigins = 256;
+
+///Resumable client sessions keyed by host:port, thread-safe.
+class SessionCache {
+public:
+    static SessionCache& shared() noexcept {
+        static SessionCache cache;
+        return cache;
+    }
+
+    ~SessionCache() {
+        clear();
+    }
+
+    ///take over the reference of the session
+    void put(const std::string& key, SSL_SESSION* session) noexcept {
+        std::vector<SSL_SESSION*> dropped;
+        {
+            std::lock_guard lock(mutex_);
+            auto& entry = origins_[key];
+            entry.lastUsed = ++tick_;
+            entry.sessions.push_back(session);
+            while (entry.sessions.size() > kMaxSessionsPerOrigin) {
+                dropped.push_back(entry.sessions.front());
+                entry.sessions.pop_front();
+            }
+            if (origins_.size() > kMaxSessionOrigins) {
+                auto oldest = std::min_element(origins_.begin(), origins_.end(), [](const auto& lhs, const auto& rhs) {
+                    return lhs.second.lastUsed < rhs.second.lastUsed;
+                });
+                dropped.insert(dropped.end(), oldest->second.sessions.begin(), oldest->second.sessions.end());
+                origins_.erase(oldest);
+            }
+        }
+        std::for_each(dropped.begin(), dropped.end(), SSL_SESSION_free);
+    }
+
+    ///the newest usable session with a reference for the caller, nullptr if there is none
+    SSL_SESSION* take(const std::string& key) noexcept {
+        std::vector<SSL_SESSION*> dropped;
+        SSL_SESSION* session = nullptr;
+        {
+            std::lock_guard lock(mutex_);
+            auto it = origins_.find(key);
+            if (it == origins_.end()) {
+                return nullptr;
+            }
+            auto& entry = it->second;
+            entry.lastUsed = ++tick_;
+            auto now = static_cast<int64_t>(time(nullptr));
+            while (!entry.sessions.empty() && session == nullptr) {
+                auto newest = entry.sessions.back();
+                auto expireTime = static_cast<int64_t>(SSL_SESSION_get_time(newest)) + SSL_SESSION_get_timeout(newest);
+                if (!SSL_SESSION_is_resumable(newest) || expireTime <= now) {
+                    dropped.push_back(newest);
+                    entry.sessions.pop_back();
+                } else if (SSL_SESSION_get_protocol_version(newest) == TLS1_3_VERSION) {
+                    ///https://www.rfc-editor.org/rfc/rfc8446#appendix-C.4, a ticket is not reused to avoid correlation
+                    session = newest;
+                    entry.sessions.pop_back();
+                } else {
+                    session = newest;
+                    SSL_SESSION_up_ref(session);
+                }
+            }
+            if (entry.sessions.empty()) {
+                origins_.erase(it);
+            }
+        }
+        std::for_each(dropped.begin(), dropped.end(), SSL_SESSION_free);
+        return session;
+    }
+
+    void clear() noexcept {
+        decltype(origins_) origins;
+        {
+            std::lock_guard lock(mutex_);
+            origins.swap(origins_);
+        }
+        for (auto& [key, entry] : origins) {
+            std::for_each(entry.sessions.begin(), entry.sessions.end(), SSL_SESSION_free);
+        }
+    }
+
+    std::atomic<uint64_t> hitCount = 0;
+    std::atomic<uint64_t> missCount = 0;
+
+private:
+    struct Entry {
+        ///oldest first
+        std::deque<SSL_SESSION*> sessions;
+        uint64_t lastUsed = 0;
+    };
+
+    std::mutex mutex_;
+    uint64_t tick_ = 0;
+    std::unordered_map<std::string, Entry> origins_;
+};
+
+} //end of namespace
+
 #ifdef __clang__
 #pragma clang diagnostic push
 #pragma ide diagnostic ignored "modernize-use-equals-default"
@@ -47,6 +157,18 @@ SSLManager::~SSLManager() {
 
 std::function<void(SSLContextPtr&)> HttpsHelper::configContext = nullptr;
 
+TlsSessionStats HttpsHelper::sessionStats() noexcept {
+    auto& cache = SessionCache::shared();
+    TlsSessionStats stats;
+    stats.hitCount = cache.hitCount.load(std::memory_order_relaxed);
+    stats.missCount = cache.missCount.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void HttpsHelper::clearSessionCache() noexcept {
+    SessionCache::shared().clear();
+}
+
 SSLContextPtr& SSLManager::shareContext() {
     static std::once_flag flag;
     static SSLManager instance; //Initialize OpenSSL library
@@ -56,6 +178,9 @@ SSLContextPtr& SSLManager::shareContext() {
         SSL_CTX* context = SSL_CTX_new(sslMethod);
         if (context) {
             contextPtr.reset(context);
+            ///the sessions are kept by origin in our own cache, filled from the new session callback
+            SSL_CTX_set_session_cache_mode(context, SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+            SSL_CTX_sess_set_new_cb(context, SSLManager::onNewSession);
             if (HttpsHelper::configContext) {
                 HttpsHelper::configContext(contextPtr);
             }
@@ -66,111 +191,227 @@ SSLContextPtr& SSLManager::shareContext() {
     return contextPtr;
 }
 
-SSLPtr SSLManager::create(Socket socket) noexcept {
+SSLPtr SSLManager::create(Socket socket, const std::string& host, const std::string& port) noexcept {
     SSLPtr res(nullptr, SSL_free);
     SSL* ssl = SSL_new(SSLManager::shareContext().get());
     if (!ssl) {
         return res;
     }
     SSL_set_fd(ssl, socket);
+    ///a write retried after WANT_WRITE may come from another buffer holding the same bytes
+    SSL_set_mode(ssl, SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER);
     res.reset(ssl);
+    if (host.empty()) {
+        return res;
+    }
+    ///https://www.rfc-editor.org/rfc/rfc6066#section-3, literal ip addresses are not sent as the server name
+    in6_addr address{};
+    auto name = host.front() == '[' ? host.substr(1, host.size() - 2) : host;
+    if (inet_pton(AF_INET, name.data(), &address) != 1 && inet_pton(AF_INET6, name.data(), &address) != 1) {
+        SSL_set_tlsext_host_name(ssl, name.data());
+    }
+    SSL_set_ex_data(ssl, sessionKeyIndex(), new std::string(host + ":" + port));
     return res;
 }
 
-SocketResult SSLManager::connect(SSLPtr& sslPtr) noexcept {
-    SocketResult res;
-    auto result = SSL_connect(sslPtr.get());
-    if (result == 0) {
-        res.resultCode = ResultCode::Disconnected;
-    } else if (result < 0) {
-        res.resultCode = ResultCode::Failed;
-        res.errorCode = SSL_get_error(sslPtr.get(), 0);
-        ERR_print_errors_fp(stdout);
+int SSLManager::sessionKeyIndex() noexcept {
+    static int index = SSL_get_ex_new_index(0, nullptr, nullptr, nullptr,
+                                            [](void*, void* data, CRYPTO_EX_DATA*, int, long, void*) {
+        delete static_cast<std::string*>(data);
+    });
+    return index;
+}
+
+int SSLManager::onNewSession(SSL* ssl, SSL_SESSION* session) noexcept {
+    auto key = static_cast<std::string*>(SSL_get_ex_data(ssl, sessionKeyIndex()));
+    if (key == nullptr) {
+        return 0;
     }
-    return res;
+    ///returning 1 keeps the reference
+    SessionCache::shared().put(*key, session);
+    return 1;
 }
 
-std::tuple<SocketResult, int64_t> SSLManager::write(const SSLPtr& sslPtr, const std::string_view& data) noexcept {
-    using namespace std::chrono_literals;
-    SocketResult res;
+void SSLManager::resume(const SSLPtr& sslPtr) noexcept {
     if (sslPtr == nullptr) {
-        res.resultCode = ResultCode::Failed;
-        return {res, 0};
+        return;
     }
-    int64_t sendLength = 0;
-    bool isNeedRetry = false;
-    int32_t retryCount = 0;
-    do {
-        retryCount++;
-        sendLength = SSL_write(sslPtr.get(), data.data(), static_cast<int>(data.size()));
-        if (sendLength == 0) {
+    auto key = static_cast<std::string*>(SSL_get_ex_data(sslPtr.get(), sessionKeyIndex()));
+    if (key == nullptr) {
+        return;
+    }
+    if (auto session = SessionCache::shared().take(*key)) {
+        SSL_set_session(sslPtr.get(), session);
+        SSL_SESSION_free(session);
+    }
+}
+
+bool SSLManager::setAlpn(const SSLPtr& sslPtr, const std::vector<std::string>& protocols) noexcept {
+    if (sslPtr == nullptr) {
+        return false;
+    }
+    ///https://www.rfc-editor.org/rfc/rfc7301#section-3.1, every name is prefixed with its length
+    std::string wire;
+    for (const auto& protocol : protocols) {
+        if (protocol.empty() || protocol.size() > UINT8_MAX) {
+            return false;
+        }
+        wire.push_back(static_cast<char>(protocol.size()));
+        wire.append(protocol);
+    }
+    return SSL_set_alpn_protos(sslPtr.get(), reinterpret_cast<const unsigned char*>(wire.data()),
+                               static_cast<unsigned int>(wire.size())) == 0;
+}
+
+std::string SSLManager::alpn(const SSLPtr& sslPtr) noexcept {
+    if (sslPtr == nullptr) {
+        return {};
+    }
+    const unsigned char* data = nullptr;
+    unsigned int length = 0;
+    SSL_get0_alpn_selected(sslPtr.get(), &data, &length);
+    return data ? std::string(reinterpret_cast<const char*>(data), length) : std::string();
+}
+
+SocketResult SSLManager::checkResult(const SSLPtr& sslPtr, int ret) noexcept {
+    SocketResult res;
+    if (ret > 0) {
+        return res;
+    }
+    auto error = SSL_get_error(sslPtr.get(), ret);
+    res.errorCode = error;
+    switch (error) {
+        case SSL_ERROR_WANT_READ:
+            res.resultCode = ResultCode::Retry;
+            res.waitType = SelectType::Read;
+            break;
+        case SSL_ERROR_WANT_WRITE:
+            res.resultCode = ResultCode::Retry;
+            res.waitType = SelectType::Write;
+            break;
+        case SSL_ERROR_ZERO_RETURN:
             res.resultCode = ResultCode::Disconnected;
             break;
-        } else if (sendLength < 0) {
-            res.resultCode = ResultCode::Failed;
-            res.errorCode = SSL_get_error(sslPtr.get(), 0);
-            if (retryCount >= kMaxRetryCount) {
-                res.resultCode = ResultCode::RetryReachMaxCount;
+        case SSL_ERROR_SYSCALL:
+            if (ret == 0) {
+                res.resultCode = ResultCode::Disconnected; //eof without close_notify
                 break;
             }
-            if (SSL_ERROR_WANT_WRITE == res.errorCode || SSL_ERROR_WANT_READ == res.errorCode) {
-                isNeedRetry = true;
+            res.errorCode = GetLastError();
+            if (res.errorCode == RetryCode || res.errorCode == AgainCode) {
+                res.resultCode = ResultCode::Retry;
             }
 #if defined(_WIN32) || defined(__CYGWIN__)
-            else if (res.errorCode == SSL_ERROR_SYSCALL && GetLastError() == WSAETIMEDOUT) {
-                isNeedRetry = true;
+            else if (res.errorCode == WSAETIMEDOUT) {
+                res.resultCode = ResultCode::Retry;
             }
 #endif
-            std::this_thread::sleep_for(1ms);
-        } else {
-            res.reset();
+            else {
+                res.resultCode = ResultCode::Failed;
+            }
             break;
-        }
-    } while (isNeedRetry);
-    return {res, sendLength};
+        default:
+            res.resultCode = ResultCode::Failed;
+            ERR_print_errors_fp(stdout);
+            break;
+    }
+    return res;
+}
+
+uint32_t SSLManager::maxEarlyDataSize(const SSLPtr& sslPtr) noexcept {
+    if (sslPtr == nullptr) {
+        return 0;
+    }
+    auto session = SSL_get_session(sslPtr.get());
+    if (session == nullptr || SSL_SESSION_get_protocol_version(session) != TLS1_3_VERSION) {
+        return 0;
+    }
+    return SSL_SESSION_get_max_early_data(session);
+}
+
+SocketResult SSLManager::writeEarlyData(const SSLPtr& sslPtr, const std::string_view& data) noexcept {
+    if (sslPtr == nullptr) {
+        return {ResultCode::Failed};
+    }
+    SocketResult res;
+    size_t written = 0;
+    do {
+        ///a retry has to offer the same data again
+        auto ret = SSL_write_early_data(sslPtr.get(), data.data(), data.size(), &written);
+        res = checkResult(sslPtr, ret);
+    } while (res.resultCode == ResultCode::Retry && res.errorCode == RetryCode);
+    if (res.resultCode == ResultCode::Disconnected) {
+        res.resultCode = ResultCode::Failed;
+    }
+    return res;
+}
+
+bool SSLManager::isEarlyDataAccepted(const SSLPtr& sslPtr) noexcept {
+    return sslPtr && SSL_get_early_data_status(sslPtr.get()) == SSL_EARLY_DATA_ACCEPTED;
+}
+
+SocketResult SSLManager::connect(SSLPtr& sslPtr) noexcept {
+    if (sslPtr == nullptr) {
+        return {ResultCode::Failed};
+    }
+    auto res = checkResult(sslPtr, SSL_connect(sslPtr.get()));
+    if (res.resultCode == ResultCode::Disconnected) {
+        res.resultCode = ResultCode::Failed; //the peer closed during the handshake
+    } else if (res.isSuccess()) {
+        auto& cache = SessionCache::shared();
+        (SSL_session_reused(sslPtr.get()) ? cache.hitCount : cache.missCount).fetch_add(1, std::memory_order_relaxed);
+    }
+    return res;
+}
+
+std::tuple<SocketResult, int64_t> SSLManager::write(const SSLPtr& sslPtr, const std::string_view& data) noexcept {
+    SocketResult res;
+    if (sslPtr == nullptr) {
+        res.resultCode = ResultCode::Failed;
+        return {res, 0};
+    }
+    int sendLength = 0;
+    do {
+        sendLength = SSL_write(sslPtr.get(), data.data(), static_cast<int>(data.size()));
+        res = checkResult(sslPtr, sendLength);
+        ///an interrupted call is retried at once, waiting for readiness is up to the caller
+    } while (res.resultCode == ResultCode::Retry && res.errorCode == RetryCode);
+    return {res, std::max(sendLength, 0)};
 }
 
 std::tuple<SocketResult, DataPtr> SSLManager::read(const SSLPtr& sslPtr) noexcept {
-    using namespace std::chrono_literals;
     SocketResult res;
     if (sslPtr == nullptr) {
         res.resultCode = ResultCode::Failed;
         return {res, nullptr};
     }
-    bool isNeedRetry = false;
-    auto data = std::make_unique<Data>(kDefaultReadSize);
-    int32_t retryCount = 0;
+    auto data = Data::makePooled(kDefaultReadSize);
+    int recvLength = 0;
     do {
-        retryCount++;
-        auto recvLength = SSL_read(sslPtr.get(), data->rawData, kDefaultReadSize);
-        if (recvLength == 0) {
-            res.resultCode = ResultCode::Disconnected;
-            break;
-        } else if (recvLength < 0) {
-            res.resultCode = ResultCode::Failed;
-            res.errorCode = SSL_get_error(sslPtr.get(), 0);
-            if (retryCount >= kMaxRetryCount) {
-                res.resultCode = ResultCode::RetryReachMaxCount;
-                break;
-            }
-            if ((SSL_ERROR_WANT_WRITE == res.errorCode || SSL_ERROR_WANT_READ == res.errorCode)) {
-                isNeedRetry = true;
-            }
-#if defined(_WIN32) || defined(__CYGWIN__)
-            else if (res.errorCode == SSL_ERROR_SYSCALL && GetLastError() == WSAETIMEDOUT) {
-                isNeedRetry = true;
-            }
-#endif
-            std::this_thread::sleep_for(1ms);
-        } else {
-            res.reset();
-            data->length = recvLength;
-            break;
-        }
-    } while (isNeedRetry);
+        recvLength = SSL_read(sslPtr.get(), data->rawData, kDefaultReadSize);
+        res = checkResult(sslPtr, recvLength);
+    } while (res.resultCode == ResultCode::Retry && res.errorCode == RetryCode);
+    if (res.isSuccess()) {
+        data->length = static_cast<uint64_t>(recvLength);
+    }
     return {res, std::move(data)};
 }
 
+bool SSLManager::isAlive(const SSLPtr& sslPtr) noexcept {
+    if (sslPtr == nullptr || SSL_pending(sslPtr.get()) > 0) {
+        return false;
+    }
+    ///tls 1.3 servers may send session tickets after the response, only those are allowed to be unread
+    char byte = 0;
+    auto ret = SSL_peek(sslPtr.get(), &byte, 1);
+    if (ret > 0) {
+        return false;
+    }
+    auto error = SSL_get_error(sslPtr.get(), ret);
+    ERR_clear_error(); //a dead connection is expected here, keep the error queue quiet
+    return error == SSL_ERROR_WANT_READ;
+}
+
 void SSLManager::close(SSLPtr& sslPtr) noexcept {
     if (sslPtr) {
         SSL_shutdown(sslPtr.get());
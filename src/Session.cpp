@@ -0,0 +1,427 @@
+//
+// Created by Nevermore on 2026/10/17.
+// http-request Session
+// Copyright (c) 2024 Nevermore All rights reserved.
+//
+#include "Session.h"
+#include "DnsResolver.h"
+#include "Encode.h"
+#include "PlainSocket.h"
+#include "TSLSocket.h"
+
+namespace http {
+
+constexpr uint8_t kRedirectMaxCount = 7;
+
+Session::Session(EventLoop& loop, RequestInfo&& info, ResponseHandler&& handler, std::string reqId, FinishFunc&& onFinish,
+                 SessionCounter* counter, ConnectionPool* pool)
+    : loop_(loop)
+    , info_(std::move(info))
+    , handler_(std::move(handler))
+    , reqId_(std::move(reqId))
+    , onFinish_(std::move(onFinish))
+    , counter_(counter)
+    , pool_(pool)
+    , socket_(nullptr, freeSocket) {
+
+}
+
+Session::~Session() {
+    release();
+}
+
+void Session::start() noexcept {
+    if (info_.methodType == HttpMethodType::Unknown) {
+        handleErrorResponse(ResultCode::MethodError, 0);
+        return;
+    }
+    url_ = std::make_unique<Url>(info_.url);
+    if (!url_->isValid()) {
+        handleErrorResponse(ResultCode::UrlInvalid, 0);
+        return;
+    }
+    if (!url_->isHttpScheme()) {
+        handleErrorResponse(ResultCode::SchemeNotSupported, 0);
+        return;
+    }
+    startTime_ = util::Time::steadyTime();
+    timerId_ = loop_.runAfter(info_.timeout, [this] {
+        timerId_ = 0;
+        handleErrorResponse(ResultCode::Timeout, 0);
+    });
+    sendRequest(!isPreconnect_);
+}
+
+void Session::preconnect() noexcept {
+    isPreconnect_ = true;
+    if (pool_ == nullptr) {
+        handleErrorResponse(ResultCode::Failed, 0);
+        return;
+    }
+    start();
+}
+
+void Session::cancel() noexcept {
+    isValid_ = false;
+    state_ = State::Done;
+    release();
+}
+
+void Session::sendRequest(bool isReuse) noexcept {
+    poolKey_ = ConnectionPool::makeKey(*url_, info_.ipVersion, info_.socketOptions);
+    if (pool_ && isReuse && info_.isKeepAlive) {
+        socket_ = pool_->checkout(poolKey_);
+    }
+    isReusedSocket_ = socket_ != nullptr;
+    if (isReusedSocket_) {
+        startSend();
+        return;
+    }
+#if !ENABLE_HTTPS
+    if (url_->isHttps()) {
+        handleErrorResponse(ResultCode::SchemeNotSupported, 0);
+        return;
+    }
+#endif
+    ///the lookup counts towards the connect timeout
+    state_ = State::Connect;
+    startPhaseTimer(info_.connectTimeout);
+    query_ = std::make_unique<DnsQuery>(loop_, url_->host, url_->port, info_.ipVersion,
+                                        [this](AddressInfoPtr address, int32_t errorCode) {
+        resolved(std::move(address), errorCode);
+    });
+    query_->start();
+}
+
+void Session::resolved(AddressInfoPtr address, int32_t errorCode) noexcept {
+    if (address == nullptr) {
+        handleErrorResponse(ResultCode::GetAddressFailed, errorCode);
+        return;
+    }
+    connector_ = std::make_unique<Connector>(loop_, std::move(address), info_.connectionAttemptDelay,
+                                             [this](IPVersion ipVersion) {
+        return createSocket(ipVersion);
+    }, [this](Connector::SocketPtr socket, SocketResult result) {
+        connected(std::move(socket), result);
+    });
+    connector_->start();
+}
+
+ISocket* Session::createSocket(IPVersion ipVersion) noexcept {
+    ISocket* socket = nullptr;
+#if ENABLE_HTTPS
+    if (url_->isHttps()) {
+        auto tlsSocket = new TSLSocket(ipVersion, url_->host, url_->port);
+        if (info_.isEarlyData && !info_.isBodyStreamed() &&
+            (info_.methodType == HttpMethodType::Get || info_.methodType == HttpMethodType::Options)) {
+            tlsSocket->setEarlyData(encode::htmlEncode(info_, *url_));
+        }
+        socket = tlsSocket;
+    }
+#endif
+    if (socket == nullptr) {
+        socket = new PlainSocket(ipVersion);
+    }
+    socket->setOptions(info_.socketOptions);
+    return socket;
+}
+
+void Session::redirect(const std::string& url) noexcept {
+    if (url.empty()) {
+        handleErrorResponse(ResultCode::RedirectError, 0);
+        return;
+    }
+    if (redirectCount_ >= kRedirectMaxCount) {
+        handleErrorResponse(ResultCode::RedirectReachMaxCount, 0);
+        return;
+    }
+    redirectCount_++;
+    url_ = std::make_unique<Url>(url);
+    if (!url_->isValid() || !url_->isHttpScheme()) {
+        handleErrorResponse(ResultCode::RedirectError, 0);
+        return;
+    }
+    closeSocket();
+    sendRequest();
+}
+
+void Session::onEvent([[maybe_unused]] uint32_t events) noexcept {
+    switch (state_) {
+        case State::Handshake:
+            handshake();
+            break;
+        case State::Send:
+            send();
+            break;
+        case State::Receive:
+            receive();
+            break;
+        default:
+            break;
+    }
+}
+
+void Session::connected(Connector::SocketPtr socket, SocketResult result) noexcept {
+    if (!result.isSuccess()) {
+        handleErrorResponse(result.resultCode, result.errorCode);
+        return;
+    }
+    socket_ = std::move(socket);
+    state_ = State::Handshake;
+    handshake();
+}
+
+void Session::handshake() noexcept {
+    auto result = socket_->handshake();
+    if (result.resultCode == ResultCode::Retry) {
+        wait(result.waitType);
+        return;
+    } else if (!result.isSuccess()) {
+        handleErrorResponse(result.resultCode, result.errorCode);
+        return;
+    }
+    stopPhaseTimer();
+    if (isPreconnect_) {
+        park();
+        return;
+    }
+    startSend();
+}
+
+void Session::startSend() noexcept {
+    ///the retry of a stale pooled connection was reported as connected already
+    if (isValid_ && handler_.onConnected && !isRetry_) {
+        handler_.onConnected(reqId_);
+    }
+    isRetry_ = false;
+    state_ = State::Send;
+    bodyStream_.reset();
+    if (info_.isBodyStreamed()) {
+        bodyStream_ = std::make_unique<BodyStream>(info_);
+        if (bodyStream_->isFailed()) {
+            handleErrorResponse(ResultCode::BodyReadFailed, 0);
+            return;
+        }
+    }
+    sendData_ = encode::encodeHeader(info_, *url_);
+    sendPos_ = 0;
+    if (socket_->isEarlyDataAccepted()) {
+        ///the request went out with the handshake, a rejected one is sent here again
+        sendPos_ = sendData_.size() + info_.bodySize();
+        if (counter_) {
+            counter_->sentBytes.fetch_add(sendPos_, std::memory_order_relaxed);
+        }
+    }
+    send();
+}
+
+void Session::send() noexcept {
+    ///the header and the body go out as separate buffers, sendPos_ counts the bytes of both.
+    ///A streamed body follows them, its next part is read once the previous one is sent
+    std::vector<DataView> buffers{sendData_};
+    if (!info_.bodyEmpty()) {
+        buffers.push_back(info_.body->view());
+    }
+    buffers = skipBuffers(buffers, sendPos_);
+    while (true) {
+        auto isStream = buffers.empty() && bodyStream_ != nullptr;
+        if (buffers.empty() && !isStream) {
+            break;
+        }
+        auto [sendResult, sendSize] = isStream ? bodyStream_->send(*socket_) : socket_->sendBuffers(buffers);
+        if (sendResult.resultCode == ResultCode::Completed) {
+            break;
+        } else if (sendResult.resultCode == ResultCode::Retry) {
+            wait(sendResult.waitType);
+            return;
+        } else if (!sendResult.isSuccess()) {
+            if (sendResult.resultCode == ResultCode::BodyReadFailed || !retryStaleSocket()) {
+                handleErrorResponse(sendResult.resultCode, sendResult.errorCode);
+            }
+            return;
+        }
+        if (!isStream) {
+            sendPos_ += static_cast<size_t>(sendSize);
+            buffers = skipBuffers(buffers, static_cast<uint64_t>(sendSize));
+        }
+        if (counter_) {
+            counter_->sentBytes.fetch_add(static_cast<uint64_t>(sendSize), std::memory_order_relaxed);
+        }
+    }
+    sendData_.clear();
+    state_ = State::Receive;
+    parser_ = std::make_unique<ResponseParser>(info_.isAllowRedirect && !info_.isBodyStreamed());
+    parser_->setHeaderCallback([this](ResponseHeader&& header) {
+        if (isValid_ && handler_.onParseHeaderDone) {
+            handler_.onParseHeaderDone(reqId_, std::move(header));
+        }
+    });
+    parser_->setDataCallback([this](DataPtr data) {
+        if (isValid_ && handler_.onData) {
+            handler_.onData(reqId_, std::move(data));
+        }
+    });
+    startPhaseTimer(info_.readTimeout);
+    wait(SelectType::Read);
+}
+
+void Session::receive() noexcept {
+    int32_t readCount = 0;
+    do {
+        auto [recvResult, dataPtr] = socket_->receive();
+        if (!recvResult.isSuccess()) {
+            if (recvResult.resultCode == ResultCode::Retry) {
+                wait(recvResult.waitType);
+            } else if ((recvResult.resultCode == ResultCode::Disconnected ||
+                        recvResult.resultCode == ResultCode::Failed) && retryStaleSocket()) {
+                return;
+            } else if (recvResult.resultCode == ResultCode::Completed ||
+                       recvResult.resultCode == ResultCode::Disconnected) {
+                parser_->finish();
+                disconnected();
+            } else {
+                handleErrorResponse(recvResult.resultCode, recvResult.errorCode);
+            }
+            return;
+        }
+        isReusedSocket_ = false;
+        if (counter_) {
+            counter_->receivedBytes.fetch_add(dataPtr->length, std::memory_order_relaxed);
+        }
+        if (readCount == 0) {
+            startPhaseTimer(info_.readTimeout);
+        }
+        auto state = parser_->parse(std::move(dataPtr));
+        if (state == ParseState::Redirect) {
+            redirect(parser_->location());
+            return;
+        } else if (state == ParseState::Error) {
+            handleErrorResponse(parser_->errorCode(), 0);
+            return;
+        } else if (state == ParseState::Completed) {
+            recycleSocket();
+            disconnected();
+            return;
+        }
+    } while (++readCount < kMaxReadCountPerEvent);
+}
+
+void Session::wait(SelectType type) noexcept {
+    auto events = type == SelectType::Read ? kEventRead : kEventWrite;
+    if (loop_.updateEvent(socket_->fd(), events)) {
+        return;
+    }
+    if (!loop_.addEvent(socket_->fd(), events, [this](uint32_t flags) { onEvent(flags); })) {
+        handleErrorResponse(ResultCode::Failed, GetLastError());
+    }
+}
+
+void Session::startPhaseTimer(std::chrono::milliseconds timeout) noexcept {
+    stopPhaseTimer();
+    if (timeout.count() <= 0) {
+        return;
+    }
+    phaseTimerId_ = loop_.runAfter(timeout, [this] {
+        phaseTimerId_ = 0;
+        handleErrorResponse(ResultCode::Timeout, 0);
+    });
+}
+
+void Session::stopPhaseTimer() noexcept {
+    if (phaseTimerId_ != 0) {
+        loop_.cancelTimer(phaseTimerId_);
+        phaseTimerId_ = 0;
+    }
+}
+
+bool Session::retryStaleSocket() noexcept {
+    if (!isReusedSocket_ || state_ == State::Done || (bodyStream_ && bodyStream_->isStarted())) {
+        return false;
+    }
+    isReusedSocket_ = false;
+    isRetry_ = true;
+    stopPhaseTimer();
+    closeSocket();
+    sendRequest(false);
+    return true;
+}
+
+void Session::recycleSocket() noexcept {
+    stats_.isFastOpen = socket_->isFastOpen();
+    if (pool_ == nullptr || !info_.isKeepAlive || !parser_->isReusable() || !socket_->prepareIdle()) {
+        return;
+    }
+    loop_.removeEvent(socket_->fd());
+    pool_->checkin(poolKey_, std::move(socket_));
+}
+
+void Session::park() noexcept {
+    if (!socket_->prepareIdle()) {
+        handleErrorResponse(ResultCode::Failed, 0);
+        return;
+    }
+    loop_.removeEvent(socket_->fd());
+    pool_->checkin(poolKey_, std::move(socket_));
+    if (isValid_ && handler_.onConnected) {
+        handler_.onConnected(reqId_);
+    }
+    disconnected();
+}
+
+void Session::closeSocket() noexcept {
+    query_.reset();
+    connector_.reset();
+    if (socket_) {
+        loop_.removeEvent(socket_->fd());
+        socket_->close();
+        socket_.reset();
+    }
+}
+
+void Session::handleErrorResponse(ResultCode code, int32_t errorCode) noexcept {
+    if (state_ == State::Done) {
+        return;
+    }
+    if (isValid_ && handler_.onError) {
+        handler_.onError(reqId_, {code, errorCode});
+    }
+    disconnected();
+}
+
+void Session::disconnected() noexcept {
+    if (state_ == State::Done) {
+        return;
+    }
+    state_ = State::Done;
+    if (socket_) {
+        stats_.isFastOpen = socket_->isFastOpen();
+    }
+    if (isValid_ && handler_.onStats) {
+        if (startTime_.count() > 0) {
+            stats_.networkTime = util::Time::steadyTime() - startTime_;
+        }
+        handler_.onStats(reqId_, stats_);
+    }
+    if (isValid_ && handler_.onDisconnected) {
+        handler_.onDisconnected(reqId_);
+    }
+    isValid_ = false;
+    release();
+    if (onFinish_) {
+        ///the owner destroys the session, never do it inside its own callback
+        loop_.post([onFinish = onFinish_, reqId = reqId_] {
+            onFinish(reqId);
+        });
+    }
+}
+
+void Session::release() noexcept {
+    if (timerId_ != 0) {
+        loop_.cancelTimer(timerId_);
+        timerId_ = 0;
+    }
+    stopPhaseTimer();
+    closeSocket();
+}
+
+} //end of namespace http
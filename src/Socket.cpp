@@ -4,6 +4,9 @@
 // Copyright (c) 2024 Nevermore All rights reserved.
 //
 #include "Socket.h"
+#if !defined(_WIN32) && !defined(__CYGWIN__)
+#include <poll.h>
+#endif
 
 namespace http {
 
@@ -36,13 +39,18 @@ SocketResult select(SelectType type, Socket socket, int64_t timeout) {
 
 ISocket::ISocket(IPVersion ipVersion)
 : ipVersion_(ipVersion)
-, socket_(socket(GetAddressFamily(ipVersion), SOCK_STREAM, IPPROTO_TCP)){
+, socket_(socket(GetAddressFamily(ipVersion), SOCK_STREAM, IPPROTO_TCP))
+, createTime_(util::Time::steadyTime()) {
 
 }
 
 ISocket::ISocket(ISocket&& rhs) noexcept
 : ipVersion_(rhs.ipVersion_)
-, socket_(std::exchange(rhs.socket_, kInvalidSocket)) {
+, socket_(std::exchange(rhs.socket_, kInvalidSocket))
+, createTime_(rhs.createTime_)
+, options_(std::move(rhs.options_))
+, isFastOpenKnown_(rhs.isFastOpenKnown_)
+, isFastOpen_(rhs.isFastOpen_) {
 
 }
 
@@ -82,6 +90,112 @@ ResultCode ISocket::config() noexcept {
     return resultCode;
 }
 
+SocketResult ISocket::applyOptions() const noexcept {
+    SocketResult result;
+    auto setOption = [this, &result](int level, int name, int32_t value) {
+        if (result.isSuccess() &&
+            setsockopt(socket_, level, name, reinterpret_cast<const char*>(&value), sizeof(value)) == SocketError) {
+            result.resultCode = ResultCode::SetOptionFailed;
+            result.errorCode = GetLastError();
+        }
+    };
+    const auto& options = options_;
+    if (options.isNoDelay) {
+        setOption(IPPROTO_TCP, TCP_NODELAY, 1);
+    }
+    if (options.sendBufferSize > 0) {
+        setOption(SOL_SOCKET, SO_SNDBUF, options.sendBufferSize);
+    }
+    if (options.receiveBufferSize > 0) {
+        setOption(SOL_SOCKET, SO_RCVBUF, options.receiveBufferSize);
+    }
+    if (options.keepAliveIdle.count() > 0) {
+        setOption(SOL_SOCKET, SO_KEEPALIVE, 1);
+#if defined(TCP_KEEPIDLE)
+        setOption(IPPROTO_TCP, TCP_KEEPIDLE, static_cast<int32_t>(options.keepAliveIdle.count()));
+#elif defined(TCP_KEEPALIVE)
+        setOption(IPPROTO_TCP, TCP_KEEPALIVE, static_cast<int32_t>(options.keepAliveIdle.count()));
+#endif
+#if defined(TCP_KEEPINTVL)
+        if (options.keepAliveInterval.count() > 0) {
+            setOption(IPPROTO_TCP, TCP_KEEPINTVL, static_cast<int32_t>(options.keepAliveInterval.count()));
+        }
+#endif
+#if defined(TCP_KEEPCNT)
+        if (options.keepAliveCount > 0) {
+            setOption(IPPROTO_TCP, TCP_KEEPCNT, options.keepAliveCount);
+        }
+#endif
+    }
+#if defined(TCP_USER_TIMEOUT)
+    if (options.userTimeout.count() > 0) {
+        setOption(IPPROTO_TCP, TCP_USER_TIMEOUT, static_cast<int32_t>(options.userTimeout.count()));
+    }
+#endif
+    if (options.tos >= 0 && ipVersion_ != IPVersion::V6) {
+        setOption(IPPROTO_IP, IP_TOS, options.tos);
+    }
+#if defined(IPV6_TCLASS)
+    if (options.tos >= 0 && ipVersion_ == IPVersion::V6) {
+        setOption(IPPROTO_IPV6, IPV6_TCLASS, options.tos);
+    }
+#endif
+#if defined(SO_BINDTODEVICE)
+    if (!options.interface.empty() && result.isSuccess() &&
+        setsockopt(socket_, SOL_SOCKET, SO_BINDTODEVICE, options.interface.data(),
+                   static_cast<socklen_t>(options.interface.size())) == SocketError) {
+        result.resultCode = ResultCode::SetOptionFailed;
+        result.errorCode = GetLastError();
+    }
+#endif
+#if defined(TCP_FASTOPEN_CONNECT)
+    ///connect returns at once and the first send carries the syn, an unsupported kernel just connects as usual
+    if (options.isFastOpen && result.isSuccess()) {
+        int32_t value = 1;
+        setsockopt(socket_, IPPROTO_TCP, TCP_FASTOPEN_CONNECT, reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+#endif
+    if (!options.sourceAddress.empty() && result.isSuccess()) {
+        sockaddr_storage address{};
+        socklen_t length = 0;
+        auto ipv4 = reinterpret_cast<sockaddr_in*>(&address);
+        auto ipv6 = reinterpret_cast<sockaddr_in6*>(&address);
+        if (ipVersion_ == IPVersion::V6 && inet_pton(AF_INET6, options.sourceAddress.data(), &ipv6->sin6_addr) == 1) {
+            ipv6->sin6_family = AF_INET6;
+            length = sizeof(sockaddr_in6);
+        } else if (ipVersion_ != IPVersion::V6 && inet_pton(AF_INET, options.sourceAddress.data(), &ipv4->sin_addr) == 1) {
+            ipv4->sin_family = AF_INET;
+            length = sizeof(sockaddr_in);
+        }
+        if (length == 0) {
+            result.resultCode = ResultCode::SetOptionFailed;
+            result.errorCode = EAFNOSUPPORT;
+        } else if (::bind(socket_, reinterpret_cast<sockaddr*>(&address), length) == SocketError) {
+            result.resultCode = ResultCode::SetOptionFailed;
+            result.errorCode = GetLastError();
+        }
+    }
+    return result;
+}
+
+bool ISocket::isFastOpen() const noexcept {
+#if defined(TCP_INFO) && defined(TCPI_OPT_SYN_DATA)
+    if (isFastOpenKnown_ || !options_.isFastOpen || socket_ == kInvalidSocket) {
+        return isFastOpen_;
+    }
+    tcp_info info{};
+    socklen_t length = sizeof(info);
+    if (getsockopt(socket_, IPPROTO_TCP, TCP_INFO, &info, &length) == SocketError ||
+        info.tcpi_state == TCP_SYN_SENT || info.tcpi_state == TCP_CLOSE) {
+        ///the deferred syn has not been sent or answered yet
+        return false;
+    }
+    isFastOpenKnown_ = true;
+    isFastOpen_ = (info.tcpi_options & TCPI_OPT_SYN_DATA) != 0;
+#endif
+    return isFastOpen_;
+}
+
 ISocket& ISocket::operator=(ISocket&& rhs) noexcept {
     if (this == &rhs) {
         return *this;
@@ -89,6 +203,10 @@ ISocket& ISocket::operator=(ISocket&& rhs) noexcept {
     close();
     ipVersion_ = rhs.ipVersion_;
     socket_ = std::exchange(rhs.socket_, kInvalidSocket);
+    createTime_ = rhs.createTime_;
+    options_ = std::move(rhs.options_);
+    isFastOpenKnown_ = rhs.isFastOpenKnown_;
+    isFastOpen_ = rhs.isFastOpen_;
     return *this;
 }
 
@@ -104,6 +222,35 @@ void ISocket::close() noexcept {
     socket_ = kInvalidSocket;
 }
 
+std::tuple<SocketResult, int64_t> ISocket::sendBuffers(const std::vector<DataView>& buffers) const noexcept {
+    for (const auto& buffer : buffers) {
+        if (!buffer.empty()) {
+            return send(buffer);
+        }
+    }
+    return {SocketResult(), 0};
+}
+
+std::tuple<SocketResult, int64_t> ISocket::sendFile(int32_t, uint64_t, uint64_t) const noexcept {
+    SocketResult result;
+    result.resultCode = ResultCode::Failed;
+    return {result, 0};
+}
+
+std::vector<DataView> skipBuffers(const std::vector<DataView>& buffers, uint64_t offset) noexcept {
+    std::vector<DataView> res;
+    res.reserve(buffers.size());
+    for (auto buffer : buffers) {
+        auto skipSize = std::min(offset, static_cast<uint64_t>(buffer.size()));
+        offset -= skipSize;
+        buffer.remove_prefix(static_cast<size_t>(skipSize));
+        if (!buffer.empty()) {
+            res.push_back(buffer);
+        }
+    }
+    return res;
+}
+
 SocketResult ISocket::canSend(int64_t timeout) const noexcept {
     return select(SelectType::Write, socket_, timeout);
 }
@@ -112,38 +259,54 @@ SocketResult ISocket::canReceive(int64_t timeout) const noexcept {
     return select(SelectType::Read, socket_, timeout);
 }
 
-void ISocket::checkConnectResult(SocketResult& result, int64_t timeout) const noexcept {
-    using namespace http::util;
-    if (result.isSuccess()) {
-        return;
+bool ISocket::isAlive() const noexcept {
+    if (socket_ == kInvalidSocket) {
+        return false;
     }
+    ///poll has no FD_SETSIZE limit, an idle connection has nothing to read and no hang up
+#if defined(_WIN32) || defined(__CYGWIN__)
+    WSAPOLLFD fd{socket_, POLLRDNORM, 0};
+    return WSAPoll(&fd, 1, 0) == 0;
+#else
+    short events = POLLIN;
+#if defined(POLLRDHUP)
+    events |= POLLRDHUP;
+#endif
+    pollfd fd{socket_, events, 0};
+    return ::poll(&fd, 1, 0) == 0;
+#endif
+}
 
-    auto checkNeedRetry = [&result](){
-        return result.errorCode == RetryCode || result.errorCode == BusyCode;
-    };
-
-    if (!checkNeedRetry()) {
+void ISocket::checkConnectResult(SocketResult& result, int64_t timeout) const noexcept {
+    using namespace http::util;
+    if (result.resultCode != ResultCode::Retry) {
         return;
     }
 
-    auto expiredTime = Time::nowTime() + std::chrono::milliseconds(timeout);
+    auto expiredTime = Time::steadyTime() + std::chrono::milliseconds(timeout);
     bool isTimeout = false;
     do {
-        auto remainTime = static_cast<int64_t>((expiredTime - Time::nowTime()).count());
+        auto remainTime = static_cast<int64_t>((expiredTime - Time::steadyTime()).count());
         if (remainTime < 0) {
             isTimeout = true;
             break;
         }
-        auto selectResult = select(SelectType::Write, socket_, remainTime);
-        result = selectResult;
-    } while (!result.isSuccess() && checkNeedRetry());
+        result = select(SelectType::Write, socket_, remainTime);
+    } while (result.resultCode == ResultCode::Retry);
 
-    if (isTimeout) {
+    if (isTimeout || result.resultCode == ResultCode::Timeout) {
         result.resultCode = ResultCode::Timeout;
         result.errorCode = 0;
         return;
     }
+    if (!result.isSuccess()) {
+        return;
+    }
+    result = connectResult();
+}
 
+SocketResult ISocket::connectResult() const noexcept {
+    SocketResult result;
     int error = 0;
 #if defined(_WIN32) || defined(__CYGWIN__)
     char socketError[sizeof(int)];
@@ -155,7 +318,7 @@ void ISocket::checkConnectResult(SocketResult& result, int64_t timeout) const no
     if (getsockopt(socket_, SOL_SOCKET, SO_ERROR, socketError, &errorLength) == SocketError) {
         result.resultCode = ResultCode::ConnectGenericError;
         result.errorCode = GetLastError();
-        return;
+        return result;
     }
 
 #if defined(_WIN32) || defined(__CYGWIN__)
@@ -164,13 +327,11 @@ void ISocket::checkConnectResult(SocketResult& result, int64_t timeout) const no
     if (error != 0) {
         result.resultCode = ResultCode::ConnectGenericError;
         result.errorCode = error;
-    } else {
-        result.resultCode = ResultCode::Success;
-        result.errorCode = 0;
     }
+    return result;
 }
 
-SocketResult ISocket::connect(const AddressInfoPtr& address, int64_t timeout) noexcept {
+SocketResult ISocket::connectAsync(const addrinfo* address) noexcept {
     SocketResult result;
     if (address == nullptr) {
         result.resultCode = ResultCode::ConnectAddressError;
@@ -185,16 +346,47 @@ SocketResult ISocket::connect(const AddressInfoPtr& address, int64_t timeout) no
         result.errorCode = GetLastError();
         return result;
     }
+    result = applyOptions();
+    if (!result.isSuccess()) {
+        return result;
+    }
 
-    auto connectResult = ::connect(socket_, address->ai_addr, address->ai_addrlen);
-    if (connectResult == kInvalid) {
+    if (::connect(socket_, address->ai_addr, static_cast<socklen_t>(address->ai_addrlen)) == kInvalid) {
         result.errorCode = GetLastError();
-    } else {
-        result.errorCode = 0;
+        if (result.errorCode == RetryCode || result.errorCode == BusyCode) {
+            result.resultCode = ResultCode::Retry;
+            result.waitType = SelectType::Write;
+        } else {
+            result.resultCode = ResultCode::ConnectGenericError;
+        }
     }
-    result.resultCode = connectResult == kInvalid ? ResultCode::ConnectGenericError : ResultCode::Success;
+    return result;
+}
+
+SocketResult ISocket::finishHandshake(int64_t timeout) noexcept {
+    using namespace http::util;
+    auto expiredTime = Time::steadyTime() + std::chrono::milliseconds(timeout);
+    while (true) {
+        auto result = handshake();
+        if (result.resultCode != ResultCode::Retry) {
+            return result;
+        }
+        auto remainTime = static_cast<int64_t>((expiredTime - Time::steadyTime()).count());
+        if (remainTime <= 0) {
+            return {ResultCode::Timeout};
+        }
+        ///a select interrupted by a signal reports Retry as well, just take another step
+        result = http::select(result.waitType, socket_, remainTime);
+        if (!result.isSuccess() && result.resultCode != ResultCode::Retry) {
+            return result;
+        }
+    }
+}
+
+SocketResult ISocket::connect(const AddressInfoPtr& address, int64_t timeout) noexcept {
+    auto result = connectAsync(address.get());
     checkConnectResult(result, timeout);
     return result;
 }
 
-}//end of namespace http
\ No newline at end of file
+}//end of namespace http
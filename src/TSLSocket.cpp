@@ -11,20 +11,67 @@
 
 namespace http {
 
+namespace {
+
+///the largest plaintext of a tls record
+constexpr size_t kMaxRecordSize = 16 * 1024;
+
+} //end of namespace
+
 TSLSocket::TSLSocket(IPVersion ipVersion) : ISocket(ipVersion), sslPtr(SSLManager::create(socket_)) {
 
 }
 
+TSLSocket::TSLSocket(IPVersion ipVersion, const std::string& host, const std::string& port)
+    : ISocket(ipVersion)
+    , sslPtr(SSLManager::create(socket_, host, port)) {
+
+}
+
+TSLSocket::~TSLSocket() {
+    close();
+}
+
 SocketResult TSLSocket::connect(const AddressInfoPtr& address, int64_t timeout) noexcept {
+    using namespace http::util;
+    auto expiredTime = Time::steadyTime() + std::chrono::milliseconds(timeout);
     SocketResult result = ISocket::connect(address, timeout);
     if (!result.isSuccess()) {
         return result;
     }
-    result = SSLManager::connect(sslPtr);
-    if (!result.isSuccess() && (result.errorCode == SSL_ERROR_WANT_WRITE || result.errorCode == SSL_ERROR_WANT_READ)) {
-        result = http::select(result.errorCode == SSL_ERROR_WANT_WRITE ? SelectType::Write : SelectType::Read, socket_, timeout);
+    return finishHandshake(static_cast<int64_t>((expiredTime - Time::steadyTime()).count()));
+}
+
+SocketResult TSLSocket::handshake() noexcept {
+    if (!isHandshakeStarted_) {
+        isHandshakeStarted_ = true;
+        SSLManager::resume(sslPtr);
+        if (earlyData_.size() > SSLManager::maxEarlyDataSize(sslPtr)) {
+            earlyData_.clear();
+        }
+    }
+    if (!earlyData_.empty()) {
+        auto result = SSLManager::writeEarlyData(sslPtr, earlyData_);
+        if (!result.isSuccess()) {
+            return result;
+        }
+        earlyData_.clear();
+        isEarlyDataSent_ = true;
     }
-    return result;
+    return SSLManager::connect(sslPtr);
+}
+
+void TSLSocket::setEarlyData(std::string data) noexcept {
+    earlyData_ = std::move(data);
+}
+
+bool TSLSocket::isEarlyDataAccepted() const noexcept {
+    return isEarlyDataSent_ && SSLManager::isEarlyDataAccepted(sslPtr);
+}
+
+bool TSLSocket::prepareIdle() noexcept {
+    isEarlyDataSent_ = false;
+    return true;
 }
 
 std::tuple<SocketResult, int64_t> TSLSocket::send(const std::string_view& data) const noexcept {
@@ -36,6 +83,22 @@ std::tuple<SocketResult, int64_t> TSLSocket::send(const std::string_view& data)
     return SSLManager::write(sslPtr, data);
 }
 
+std::tuple<SocketResult, int64_t> TSLSocket::sendBuffers(const std::vector<DataView>& buffers) const noexcept {
+    if (buffers.size() < 2 || buffers.front().size() >= kMaxRecordSize) {
+        return ISocket::sendBuffers(buffers);
+    }
+    ///at most one record is joined, a retry joins the same bytes again from the same offset
+    std::string record;
+    record.reserve(kMaxRecordSize);
+    for (const auto& buffer : buffers) {
+        record.append(buffer.substr(0, kMaxRecordSize - record.size()));
+        if (record.size() == kMaxRecordSize) {
+            break;
+        }
+    }
+    return send(record);
+}
+
 std::tuple<SocketResult, DataPtr> TSLSocket::receive() const noexcept {
     SocketResult result;
     if (sslPtr == nullptr) {
@@ -46,7 +109,10 @@ std::tuple<SocketResult, DataPtr> TSLSocket::receive() const noexcept {
 }
 
 void TSLSocket::close() noexcept {
-    SSLManager::close(sslPtr);
+    ///the socket bio writes without MSG_NOSIGNAL, a close_notify to a peer that is gone raises SIGPIPE
+    if (isAlive()) {
+        SSLManager::close(sslPtr);
+    }
     ISocket::close();
     sslPtr.reset();
 }
@@ -62,6 +128,18 @@ SocketResult TSLSocket::canReceive(int64_t timeout) const noexcept {
     return ISocket::canReceive(timeout);
 }
 
+bool TSLSocket::setAlpn(const std::vector<std::string>& protocols) noexcept {
+    return SSLManager::setAlpn(sslPtr, protocols);
+}
+
+std::string TSLSocket::alpn() const noexcept {
+    return SSLManager::alpn(sslPtr);
+}
+
+bool TSLSocket::isAlive() const noexcept {
+    return socket_ != kInvalidSocket && SSLManager::isAlive(sslPtr);
+}
+
 } //end of namespace http
 
 #endif
\ No newline at end of file
@@ -0,0 +1,117 @@
+//
+// Created by Nevermore on 2026/10/17.
+// http-request TimerWheel
+// Copyright (c) 2024 Nevermore All rights reserved.
+//
+#include "TimerWheel.h"
+
+namespace http {
+
+TimerWheel::TimerWheel(int64_t now) noexcept
+    : current_(now) {
+
+}
+
+uint64_t TimerWheel::add(int64_t expireTime, Task&& task) noexcept {
+    auto timerId = ++timerId_;
+    Slot pending;
+    pending.push_back(Timer{timerId, expireTime, 0, 0, std::move(task)});
+    auto it = pending.begin();
+    timers_[timerId] = it;
+    place(pending, it);
+    return timerId;
+}
+
+bool TimerWheel::cancel(uint64_t timerId) noexcept {
+    auto it = timers_.find(timerId);
+    if (it == timers_.end()) {
+        return false;
+    }
+    auto timer = it->second;
+    wheels_[timer->level][timer->slot].erase(timer);
+    timers_.erase(it);
+    return true;
+}
+
+void TimerWheel::place(Slot& from, Slot::iterator it) noexcept {
+    ///an expired timer runs on the next tick
+    auto expireTime = std::max(it->expireTime, current_ + 1);
+    auto delta = static_cast<uint64_t>(expireTime - current_);
+    uint32_t level = 0;
+    while (level + 1 < kLevelCount && delta >= (1ull << (kSlotBits * (level + 1)))) {
+        level++;
+    }
+    constexpr uint64_t kMaxDelta = (1ull << (kSlotBits * kLevelCount)) - 1;
+    if (delta > kMaxDelta) {
+        expireTime = current_ + static_cast<int64_t>(kMaxDelta);
+    }
+    auto slot = static_cast<uint32_t>(static_cast<uint64_t>(expireTime) >> (kSlotBits * level)) & kSlotMask;
+    it->level = static_cast<uint8_t>(level);
+    it->slot = static_cast<uint8_t>(slot);
+    auto& to = wheels_[level][slot];
+    to.splice(to.end(), from, it);
+}
+
+void TimerWheel::cascade(uint32_t level) noexcept {
+    auto slot = static_cast<uint32_t>(static_cast<uint64_t>(current_) >> (kSlotBits * level)) & kSlotMask;
+    Slot timers;
+    timers.swap(wheels_[level][slot]);
+    while (!timers.empty()) {
+        place(timers, timers.begin());
+    }
+}
+
+int64_t TimerWheel::advance(int64_t now) noexcept {
+    if (timers_.empty()) {
+        current_ = std::max(current_, now);
+        return kInvalid;
+    }
+    while (current_ < now) {
+        current_++;
+        auto tick = static_cast<uint64_t>(current_);
+        ///cascade from the highest level whose slot index wrapped, so every timer moves down in one pass
+        uint32_t level = 0;
+        while (level + 1 < kLevelCount && ((tick >> (kSlotBits * level)) & kSlotMask) == 0) {
+            level++;
+        }
+        for (; level > 0; level--) {
+            cascade(level);
+        }
+        ///one by one, a task may cancel the timers next to it, the ones it adds land on a later tick
+        auto& expired = wheels_[0][tick & kSlotMask];
+        while (!expired.empty()) {
+            auto task = std::move(expired.front().task);
+            timers_.erase(expired.front().id);
+            expired.pop_front();
+            task();
+        }
+        if (timers_.empty()) {
+            current_ = now;
+            return kInvalid;
+        }
+    }
+    return nextTimeout();
+}
+
+int64_t TimerWheel::nextTimeout() const noexcept {
+    auto tick = static_cast<uint64_t>(current_);
+    auto remainCount = kSlotCount - static_cast<uint32_t>(tick & kSlotMask);
+    for (uint32_t i = 1; i < remainCount; i++) {
+        if (!wheels_[0][(tick + i) & kSlotMask].empty()) {
+            return i;
+        }
+    }
+    ///the next cascade may move timers into level 0
+    return remainCount;
+}
+
+void TimerWheel::clear() noexcept {
+    for (auto& wheel : wheels_) {
+        for (auto& slot : wheel) {
+            slot.clear();
+        }
+    }
+    timers_.clear();
+}
+
+} //end of namespace http
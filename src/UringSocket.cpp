@@ -0,0 +1,741 @@
+//
+// Created by Nevermore on 2026/10/17.
+// http-request UringSocket
+// Copyright (c) 2024 Nevermore All rights reserved.
+//
+#if ENABLE_IO_URING
+#include "UringSocket.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
+#include <sys/syscall.h>
+
+namespace http {
+
+namespace {
+
+constexpr uint32_t kRingEntries = 64;
+constexpr uint16_t kBufferCount = 64;
+constexpr uint16_t kBufferGroup = 0;
+///how long close waits for a canceled operation to complete
+constexpr int64_t kCancelTimeout = 1000;
+
+int ioUringSetup(uint32_t entries, io_uring_params* params) noexcept {
+    return static_cast<int>(::syscall(__NR_io_uring_setup, entries, params));
+}
+
+int ioUringEnter(int fd, uint32_t submitCount, uint32_t minComplete, uint32_t flags, void* arg, size_t argSize) noexcept {
+    return static_cast<int>(::syscall(__NR_io_uring_enter, fd, submitCount, minComplete, flags, arg, argSize));
+}
+
+int ioUringRegister(int fd, uint32_t opcode, void* arg, uint32_t argCount) noexcept {
+    return static_cast<int>(::syscall(__NR_io_uring_register, fd, opcode, arg, argCount));
+}
+
+int64_t nowTime() noexcept {
+    using namespace std::chrono;
+    return duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+}
+
+struct UringCompletion {
+    int32_t result = 0;
+    uint32_t flags = 0;
+
+    [[nodiscard]] bool hasMore() const noexcept {
+        return (flags & IORING_CQE_F_MORE) != 0;
+    }
+
+    [[nodiscard]] bool hasBuffer() const noexcept {
+        return (flags & IORING_CQE_F_BUFFER) != 0;
+    }
+
+    [[nodiscard]] uint16_t bufferId() const noexcept {
+        return static_cast<uint16_t>(flags >> IORING_CQE_BUFFER_SHIFT);
+    }
+};
+
+///The memory an operation hands to the kernel by address, it lives until the last completion of the operation
+struct UringOperation {
+    msghdr message{};
+    std::vector<iovec> vectors;
+    sockaddr_storage address{};
+    ///the recv buffer when the ring has no buffer ring
+    DataPtr buffer;
+};
+
+///io_uring instance of one thread, only touched by that thread.
+///Completions are queued per operation id until the owner asks for them, completions of released ids are dropped.
+class UringRing {
+public:
+    UringRing() = default;
+    ~UringRing();
+    UringRing(const UringRing&) = delete;
+    UringRing& operator=(const UringRing&) = delete;
+
+    ///the ring of the calling thread, nullptr if io_uring is not available
+    static std::shared_ptr<UringRing> local() noexcept;
+
+    [[nodiscard]] uint64_t makeId() noexcept {
+        auto id = ++lastId_;
+        completions_[id];
+        return id;
+    }
+
+    ///drop the completions and the state of id, only once its last completion arrived
+    void release(uint64_t id) noexcept;
+
+    ///the state of the operation of id, owned by the ring until release
+    UringOperation& operation(uint64_t id) noexcept;
+
+    ///a zeroed sqe bound to id, submitted by the next wait
+    io_uring_sqe* prepare(uint8_t opcode, int fd, uint64_t id) noexcept;
+
+    ///submit the prepared sqes and wait for a completion of id, timeout < 0 waits forever
+    bool wait(uint64_t id, int64_t timeout, UringCompletion& completion) noexcept;
+
+    ///cancel the operations of id and wait for the last completion, true once it arrived and id was released.
+    ///A valid fd is shut down when the cancel does not finish in time, which ends a socket operation at once, and the
+    ///wait goes on. Without the last completion the state of id is kept until it arrives, the kernel may still use it
+    bool cancel(uint64_t id, int fd = kInvalid) noexcept;
+
+    [[nodiscard]] bool hasBufferRing() const noexcept {
+        return bufferRing_ != nullptr;
+    }
+
+    [[nodiscard]] bool isMultishotReceive() const noexcept {
+        return isMultishotReceive_;
+    }
+
+    void disableMultishotReceive() noexcept {
+        isMultishotReceive_ = false;
+    }
+
+    ///hand out a selected buffer without copying it, the buffer goes back to the kernel once the data and
+    ///every slice of it are released, on any thread
+    static DataPtr takeBuffer(const std::shared_ptr<UringRing>& ring, uint16_t bufferId, size_t size) noexcept;
+
+    ///give a selected buffer back to the kernel
+    void recycle(uint16_t bufferId) noexcept;
+
+private:
+    bool init() noexcept;
+    void initBufferRing() noexcept;
+    ///recycle the buffers handed out by takeBuffer and released since
+    void recycleReturned() noexcept;
+    void submit() noexcept;
+    void reap() noexcept;
+    bool pop(uint64_t id, UringCompletion& completion) noexcept;
+
+private:
+    int fd_ = kInvalid;
+    io_uring_params params_{};
+    void* sqRing_ = MAP_FAILED;
+    size_t sqRingSize_ = 0;
+    void* cqRing_ = MAP_FAILED;
+    size_t cqRingSize_ = 0;
+    io_uring_sqe* sqes_ = nullptr;
+    size_t sqesSize_ = 0;
+    uint32_t* sqHead_ = nullptr;
+    uint32_t* sqTail_ = nullptr;
+    uint32_t sqMask_ = 0;
+    uint32_t* sqArray_ = nullptr;
+    uint32_t* cqHead_ = nullptr;
+    uint32_t* cqTail_ = nullptr;
+    uint32_t cqMask_ = 0;
+    io_uring_cqe* cqes_ = nullptr;
+    uint32_t sqeTail_ = 0;
+    uint32_t pendingCount_ = 0;
+    uint64_t lastId_ = 0;
+    std::unordered_map<uint64_t, std::deque<UringCompletion>> completions_;
+    std::unordered_map<uint64_t, std::unique_ptr<UringOperation>> operations_;
+    ///canceled without their last completion, released by reap once it arrives
+    std::unordered_set<uint64_t> orphans_;
+    ///io_uring_buf_ring is not usable from C++, its flexible array does not start at offset 0 there
+    io_uring_buf* bufferRing_ = nullptr;
+    ///not zeroed, the kernel writes a buffer before it is read
+    std::unique_ptr<uint8_t[]> buffers_;
+    bool isMultishotReceive_ = false;
+    std::atomic<bool> hasReturned_ = false;
+    std::mutex returnMutex_;
+    std::vector<uint16_t> returnedBuffers_;
+};
+
+UringRing::~UringRing() {
+    ///the kernel cancels the operations left when the ring closes, the memory they may still touch is not freed
+    for (auto id : orphans_) {
+        if (auto it = operations_.find(id); it != operations_.end()) {
+            [[maybe_unused]] auto leaked = it->second.release();
+        }
+    }
+    if (bufferRing_) {
+        io_uring_buf_reg reg{};
+        reg.bgid = kBufferGroup;
+        ioUringRegister(fd_, IORING_UNREGISTER_PBUF_RING, &reg, 1);
+        ::munmap(bufferRing_, kBufferCount * sizeof(io_uring_buf));
+    }
+    if (sqes_) {
+        ::munmap(sqes_, sqesSize_);
+    }
+    if (cqRing_ != MAP_FAILED && cqRing_ != sqRing_) {
+        ::munmap(cqRing_, cqRingSize_);
+    }
+    if (sqRing_ != MAP_FAILED) {
+        ::munmap(sqRing_, sqRingSize_);
+    }
+    if (fd_ != kInvalid) {
+        ::close(fd_);
+    }
+}
+
+std::shared_ptr<UringRing> UringRing::local() noexcept {
+    thread_local std::shared_ptr<UringRing> ring;
+    thread_local bool isInitialized = false;
+    if (!isInitialized) {
+        isInitialized = true;
+        auto newRing = std::make_shared<UringRing>();
+        if (newRing->init()) {
+            ring = std::move(newRing);
+        }
+    }
+    return ring;
+}
+
+bool UringRing::init() noexcept {
+    ///fewer interrupts, the completions are only reaped when this thread enters the kernel anyway
+    params_.flags = IORING_SETUP_SINGLE_ISSUER | IORING_SETUP_COOP_TASKRUN;
+    fd_ = ioUringSetup(kRingEntries, &params_);
+    if (fd_ < 0) {
+        params_ = {};
+        fd_ = ioUringSetup(kRingEntries, &params_);
+    }
+    if (fd_ < 0) {
+        fd_ = kInvalid;
+        return false;
+    }
+    if (!(params_.features & IORING_FEAT_SINGLE_MMAP) || !(params_.features & IORING_FEAT_EXT_ARG) ||
+        !(params_.features & IORING_FEAT_NODROP)) {
+        return false;
+    }
+
+    std::vector<uint8_t> probeData(sizeof(io_uring_probe) + 256 * sizeof(io_uring_probe_op));
+    auto probe = reinterpret_cast<io_uring_probe*>(probeData.data());
+    if (ioUringRegister(fd_, IORING_REGISTER_PROBE, probe, 256) < 0) {
+        return false;
+    }
+    for (auto opcode : {IORING_OP_CONNECT, IORING_OP_SEND, IORING_OP_SENDMSG, IORING_OP_RECV, IORING_OP_ASYNC_CANCEL}) {
+        if (opcode > probe->last_op || !(probe->ops[opcode].flags & IO_URING_OP_SUPPORTED)) {
+            return false;
+        }
+    }
+
+    sqRingSize_ = params_.sq_off.array + params_.sq_entries * sizeof(uint32_t);
+    cqRingSize_ = params_.cq_off.cqes + params_.cq_entries * sizeof(io_uring_cqe);
+    sqRingSize_ = cqRingSize_ = std::max(sqRingSize_, cqRingSize_);
+    sqRing_ = ::mmap(nullptr, sqRingSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_SQ_RING);
+    if (sqRing_ == MAP_FAILED) {
+        return false;
+    }
+    cqRing_ = sqRing_;
+    sqesSize_ = params_.sq_entries * sizeof(io_uring_sqe);
+    auto sqes = ::mmap(nullptr, sqesSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) {
+        return false;
+    }
+    sqes_ = static_cast<io_uring_sqe*>(sqes);
+
+    auto sqBase = static_cast<uint8_t*>(sqRing_);
+    sqHead_ = reinterpret_cast<uint32_t*>(sqBase + params_.sq_off.head);
+    sqTail_ = reinterpret_cast<uint32_t*>(sqBase + params_.sq_off.tail);
+    sqMask_ = *reinterpret_cast<uint32_t*>(sqBase + params_.sq_off.ring_mask);
+    sqArray_ = reinterpret_cast<uint32_t*>(sqBase + params_.sq_off.array);
+    auto cqBase = static_cast<uint8_t*>(cqRing_);
+    cqHead_ = reinterpret_cast<uint32_t*>(cqBase + params_.cq_off.head);
+    cqTail_ = reinterpret_cast<uint32_t*>(cqBase + params_.cq_off.tail);
+    cqMask_ = *reinterpret_cast<uint32_t*>(cqBase + params_.cq_off.ring_mask);
+    cqes_ = reinterpret_cast<io_uring_cqe*>(cqBase + params_.cq_off.cqes);
+    sqeTail_ = *sqTail_;
+
+    initBufferRing();
+    return true;
+}
+
+void UringRing::initBufferRing() noexcept {
+    ///the buffer ring needs 5.19, multishot recv on top of it needs 6.0, a recv into a per socket buffer is the fallback
+    auto ringMemory = ::mmap(nullptr, kBufferCount * sizeof(io_uring_buf), PROT_READ | PROT_WRITE,
+                             MAP_ANONYMOUS | MAP_PRIVATE, -1, 0);
+    if (ringMemory == MAP_FAILED) {
+        return;
+    }
+    io_uring_buf_reg reg{};
+    reg.ring_addr = reinterpret_cast<uint64_t>(ringMemory);
+    reg.ring_entries = kBufferCount;
+    reg.bgid = kBufferGroup;
+    if (ioUringRegister(fd_, IORING_REGISTER_PBUF_RING, &reg, 1) < 0) {
+        ::munmap(ringMemory, kBufferCount * sizeof(io_uring_buf));
+        return;
+    }
+    bufferRing_ = static_cast<io_uring_buf*>(ringMemory);
+    buffers_.reset(new uint8_t[static_cast<size_t>(kBufferCount) * kDefaultReadSize]);
+    for (uint16_t i = 0; i < kBufferCount; i++) {
+        recycle(i);
+    }
+    isMultishotReceive_ = true;
+}
+
+void UringRing::recycle(uint16_t bufferId) noexcept {
+    ///the ring tail overlays the resv field of the first entry
+    auto tail = bufferRing_[0].resv;
+    auto& buf = bufferRing_[tail & (kBufferCount - 1)];
+    buf.addr = reinterpret_cast<uint64_t>(buffers_.get() + static_cast<size_t>(bufferId) * kDefaultReadSize);
+    buf.len = kDefaultReadSize;
+    buf.bid = bufferId;
+    __atomic_store_n(&bufferRing_[0].resv, static_cast<uint16_t>(tail + 1), __ATOMIC_RELEASE);
+}
+
+DataPtr UringRing::takeBuffer(const std::shared_ptr<UringRing>& ring, uint16_t bufferId, size_t size) noexcept {
+    ///the buffer is not owned by the data, the deleter hands it back instead of freeing it
+    DataRefPtr buffer(new Data(), [ring, bufferId](Data* data) {
+        data->rawData = nullptr;
+        delete data;
+        {
+            std::lock_guard lock(ring->returnMutex_);
+            ring->returnedBuffers_.push_back(bufferId);
+        }
+        ring->hasReturned_.store(true, std::memory_order_release);
+    });
+    buffer->rawData = ring->buffers_.get() + static_cast<size_t>(bufferId) * kDefaultReadSize;
+    buffer->capacity = kDefaultReadSize;
+    buffer->length = size;
+    return Data::slice(buffer, 0, size);
+}
+
+void UringRing::recycleReturned() noexcept {
+    if (!hasReturned_.exchange(false, std::memory_order_acquire)) {
+        return;
+    }
+    std::vector<uint16_t> buffers;
+    {
+        std::lock_guard lock(returnMutex_);
+        buffers.swap(returnedBuffers_);
+    }
+    for (auto bufferId : buffers) {
+        recycle(bufferId);
+    }
+}
+
+void UringRing::release(uint64_t id) noexcept {
+    auto it = completions_.find(id);
+    if (it == completions_.end()) {
+        return;
+    }
+    for (auto& completion : it->second) {
+        if (completion.hasBuffer()) {
+            recycle(completion.bufferId());
+        }
+    }
+    completions_.erase(it);
+    operations_.erase(id);
+}
+
+UringOperation& UringRing::operation(uint64_t id) noexcept {
+    auto& operation = operations_[id];
+    if (operation == nullptr) {
+        operation = std::make_unique<UringOperation>();
+    }
+    return *operation;
+}
+
+io_uring_sqe* UringRing::prepare(uint8_t opcode, int fd, uint64_t id) noexcept {
+    if (sqeTail_ - __atomic_load_n(sqHead_, __ATOMIC_ACQUIRE) >= params_.sq_entries) {
+        submit();
+    }
+    auto index = sqeTail_ & sqMask_;
+    auto sqe = &sqes_[index];
+    std::memset(sqe, 0, sizeof(io_uring_sqe));
+    sqe->opcode = opcode;
+    sqe->fd = fd;
+    sqe->user_data = id;
+    sqArray_[index] = index;
+    sqeTail_++;
+    pendingCount_++;
+    __atomic_store_n(sqTail_, sqeTail_, __ATOMIC_RELEASE);
+    return sqe;
+}
+
+void UringRing::submit() noexcept {
+    while (pendingCount_ > 0) {
+        if (ioUringEnter(fd_, pendingCount_, 0, 0, nullptr, 0) < 0) {
+            if (errno == EINTR || errno == EAGAIN || errno == EBUSY) {
+                reap();
+                continue;
+            }
+            break;
+        }
+        pendingCount_ = sqeTail_ - __atomic_load_n(sqHead_, __ATOMIC_ACQUIRE);
+    }
+}
+
+void UringRing::reap() noexcept {
+    recycleReturned();
+    auto head = *cqHead_;
+    auto tail = __atomic_load_n(cqTail_, __ATOMIC_ACQUIRE);
+    for (; head != tail; head++) {
+        auto& cqe = cqes_[head & cqMask_];
+        UringCompletion completion{cqe.res, cqe.flags};
+        if (orphans_.count(cqe.user_data) > 0) {
+            if (completion.hasBuffer()) {
+                recycle(completion.bufferId());
+            }
+            if (!completion.hasMore()) {
+                orphans_.erase(cqe.user_data);
+                release(cqe.user_data);
+            }
+        } else if (auto it = completions_.find(cqe.user_data); it != completions_.end()) {
+            it->second.push_back(completion);
+        } else if (completion.hasBuffer()) {
+            recycle(completion.bufferId());
+        }
+    }
+    __atomic_store_n(cqHead_, head, __ATOMIC_RELEASE);
+}
+
+bool UringRing::pop(uint64_t id, UringCompletion& completion) noexcept {
+    auto it = completions_.find(id);
+    if (it == completions_.end() || it->second.empty()) {
+        return false;
+    }
+    completion = it->second.front();
+    it->second.pop_front();
+    return true;
+}
+
+bool UringRing::wait(uint64_t id, int64_t timeout, UringCompletion& completion) noexcept {
+    auto expiredTime = nowTime() + timeout;
+    while (true) {
+        reap();
+        if (pop(id, completion)) {
+            submit();
+            return true;
+        }
+        auto remainTime = timeout < 0 ? kInvalid : std::max<int64_t>(expiredTime - nowTime(), 0);
+        if (remainTime == 0 && pendingCount_ == 0) {
+            return false;
+        }
+        __kernel_timespec ts{remainTime / 1000, (remainTime % 1000) * 1000000};
+        io_uring_getevents_arg arg{};
+        arg.ts = timeout < 0 ? 0 : reinterpret_cast<uint64_t>(&ts);
+        auto ret = ioUringEnter(fd_, pendingCount_, 1, IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG, &arg, sizeof(arg));
+        pendingCount_ = sqeTail_ - __atomic_load_n(sqHead_, __ATOMIC_ACQUIRE);
+        if (ret < 0 && errno != ETIME && errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+            return false;
+        }
+        if (remainTime == 0) {
+            reap();
+            return pop(id, completion);
+        }
+    }
+}
+
+bool UringRing::cancel(uint64_t id, int fd) noexcept {
+    auto cancelId = makeId();
+    auto sqe = prepare(IORING_OP_ASYNC_CANCEL, -1, cancelId);
+    sqe->addr = id;
+    ///the target reports its last completion without IORING_CQE_F_MORE
+    auto waitLast = [this, id](int64_t timeout) {
+        auto expiredTime = nowTime() + timeout;
+        UringCompletion completion;
+        while (wait(id, timeout < 0 ? kInvalid : std::max<int64_t>(expiredTime - nowTime(), 0), completion)) {
+            if (completion.hasBuffer()) {
+                recycle(completion.bufferId());
+            }
+            if (!completion.hasMore()) {
+                return true;
+            }
+        }
+        return false;
+    };
+    auto isCompleted = waitLast(kCancelTimeout);
+    if (!isCompleted && fd != kInvalid) {
+        ::shutdown(fd, SHUT_RDWR);
+        isCompleted = waitLast(kInvalid);
+    }
+    release(cancelId);
+    if (!isCompleted) {
+        orphans_.insert(id);
+        return false;
+    }
+    release(id);
+    return true;
+}
+
+UringSocket::UringSocket(IPVersion ipVersion)
+    : ISocket(ipVersion)
+    , ring_(UringRing::local()) {
+
+}
+
+UringSocket::~UringSocket() {
+    close();
+}
+
+bool UringSocket::isSupported() noexcept {
+    return UringRing::local() != nullptr;
+}
+
+SocketResult UringSocket::connect(const AddressInfoPtr& address, int64_t timeout) noexcept {
+    SocketResult result;
+    if (address == nullptr) {
+        result.resultCode = ResultCode::ConnectAddressError;
+        return result;
+    }
+    if (address->ai_family != GetAddressFamily(ipVersion_)) {
+        result.resultCode = ResultCode::ConnectTypeInconsistent;
+        return result;
+    }
+    if (socket_ == kInvalidSocket || ring() == nullptr) {
+        result.resultCode = ResultCode::CreateSocketFailed;
+        return result;
+    }
+    ///the socket stays blocking, io_uring arms the readiness poll itself
+    auto id = ring()->makeId();
+    auto& operation = ring()->operation(id);
+    auto addressLength = std::min<size_t>(address->ai_addrlen, sizeof(operation.address));
+    std::memcpy(&operation.address, address->ai_addr, addressLength);
+    auto sqe = ring()->prepare(IORING_OP_CONNECT, socket_, id);
+    sqe->addr = reinterpret_cast<uint64_t>(&operation.address);
+    sqe->off = addressLength;
+    UringCompletion completion;
+    if (!ring()->wait(id, timeout, completion)) {
+        ring()->cancel(id, socket_);
+        result.resultCode = ResultCode::Timeout;
+        return result;
+    }
+    ring()->release(id);
+    if (completion.result < 0) {
+        result.resultCode = ResultCode::ConnectGenericError;
+        result.errorCode = -completion.result;
+    }
+    return result;
+}
+
+SocketResult UringSocket::connectAsync(const addrinfo* address) noexcept {
+    auto result = ISocket::connectAsync(address);
+    if (result.isSuccess()) {
+        setBlocking();
+    }
+    return result;
+}
+
+SocketResult UringSocket::connectResult() const noexcept {
+    auto result = ISocket::connectResult();
+    if (result.isSuccess()) {
+        setBlocking();
+    }
+    return result;
+}
+
+void UringSocket::setBlocking() const noexcept {
+    auto flags = fcntl(socket_, F_GETFL);
+    if (flags != -1) {
+        fcntl(socket_, F_SETFL, flags & ~O_NONBLOCK);
+    }
+}
+
+std::tuple<SocketResult, int64_t> UringSocket::send(const std::string_view& data) const noexcept {
+    auto id = ring()->makeId();
+    auto sqe = ring()->prepare(IORING_OP_SEND, socket_, id);
+    sqe->addr = reinterpret_cast<uint64_t>(data.data());
+    sqe->len = static_cast<uint32_t>(data.size());
+    sqe->msg_flags = kNoSignal;
+    return waitSend(id);
+}
+
+std::tuple<SocketResult, int64_t> UringSocket::sendBuffers(const std::vector<DataView>& buffers) const noexcept {
+    if (std::all_of(buffers.begin(), buffers.end(), [](const DataView& buffer) { return buffer.empty(); })) {
+        return {SocketResult(), 0};
+    }
+    auto id = ring()->makeId();
+    auto& operation = ring()->operation(id);
+    operation.vectors.reserve(buffers.size());
+    for (const auto& buffer : buffers) {
+        if (!buffer.empty()) {
+            operation.vectors.push_back({const_cast<char*>(buffer.data()), buffer.size()});
+        }
+    }
+    operation.message.msg_iov = operation.vectors.data();
+    operation.message.msg_iovlen = operation.vectors.size();
+    auto sqe = ring()->prepare(IORING_OP_SENDMSG, socket_, id);
+    sqe->addr = reinterpret_cast<uint64_t>(&operation.message);
+    sqe->len = 1;
+    sqe->msg_flags = kNoSignal;
+    return waitSend(id);
+}
+
+std::tuple<SocketResult, int64_t> UringSocket::waitSend(uint64_t id) const noexcept {
+    SocketResult result;
+    UringCompletion completion;
+    auto isCompleted = ring()->wait(id, sendTimeout_, completion);
+    sendTimeout_ = kInvalid;
+    if (!isCompleted) {
+        ///the data stays with the caller, a cancel that does not finish shuts the socket down and waits for the send
+        ring()->cancel(id, socket_);
+        result.resultCode = ResultCode::Timeout;
+        return {result, 0};
+    }
+    ring()->release(id);
+    if (completion.result < 0) {
+        result.errorCode = -completion.result;
+        if (result.errorCode == AgainCode || result.errorCode == RetryCode) {
+            result.resultCode = ResultCode::Retry;
+            result.waitType = SelectType::Write;
+        } else {
+            result.resultCode = ResultCode::Failed;
+        }
+        return {result, 0};
+    } else if (completion.result == 0) {
+        result.resultCode = ResultCode::Disconnected;
+    }
+    return {result, completion.result};
+}
+
+SocketResult UringSocket::canSend(int64_t timeout) const noexcept {
+    sendTimeout_ = timeout;
+    return {};
+}
+
+void UringSocket::armReceive() const noexcept {
+    receiveId_ = ring()->makeId();
+    auto sqe = ring()->prepare(IORING_OP_RECV, socket_, receiveId_);
+    if (ring()->hasBufferRing() && !isPooledReceive_) {
+        sqe->flags = IOSQE_BUFFER_SELECT;
+        sqe->buf_group = kBufferGroup;
+        if (ring()->isMultishotReceive()) {
+            sqe->ioprio = IORING_RECV_MULTISHOT;
+        } else {
+            sqe->len = kDefaultReadSize;
+        }
+    } else {
+        ///the buffer ring ran dry once, the buffers are held by the data handed out, recv into a pooled one
+        isPooledReceive_ = false;
+        auto& buffer = ring()->operation(receiveId_).buffer;
+        buffer = Data::makePooled(kDefaultReadSize);
+        sqe->addr = reinterpret_cast<uint64_t>(buffer->rawData);
+        sqe->len = static_cast<uint32_t>(buffer->capacity);
+    }
+    isReceiveArmed_ = true;
+}
+
+SocketResult UringSocket::canReceive(int64_t timeout) const noexcept {
+    SocketResult result;
+    if (isReady_) {
+        return result;
+    }
+    if (socket_ == kInvalidSocket) {
+        result.resultCode = ResultCode::Disconnected;
+        return result;
+    }
+    UringCompletion completion;
+    DataPtr received;
+    while (true) {
+        if (!isReceiveArmed_) {
+            armReceive();
+        }
+        if (!ring()->wait(receiveId_, timeout, completion)) {
+            result.resultCode = ResultCode::Timeout;
+            return result;
+        }
+        if (!completion.hasMore()) {
+            isReceiveArmed_ = false;
+            received = std::move(ring()->operation(receiveId_).buffer);
+            ring()->release(receiveId_);
+        }
+        if (completion.result == -ENOBUFS) {
+            isPooledReceive_ = true;
+            continue;
+        } else if (completion.result == -EINVAL && ring()->isMultishotReceive()) {
+            ring()->disableMultishotReceive();
+            continue;
+        }
+        break;
+    }
+    isReady_ = true;
+    readyResult_.reset();
+    if (completion.result > 0) {
+        if (completion.hasBuffer()) {
+            readyData_ = UringRing::takeBuffer(ring_, completion.bufferId(), static_cast<size_t>(completion.result));
+        } else {
+            received->length = static_cast<uint64_t>(completion.result);
+            readyData_ = std::move(received);
+        }
+    } else if (completion.result == 0) {
+        readyResult_.resultCode = ResultCode::Disconnected;
+    } else {
+        readyResult_.resultCode = ResultCode::Failed;
+        readyResult_.errorCode = -completion.result;
+    }
+    return result;
+}
+
+std::tuple<SocketResult, DataPtr> UringSocket::receive() const noexcept {
+    if (!isReady_) {
+        auto result = canReceive(0);
+        if (!result.isSuccess()) {
+            result.resultCode = result.resultCode == ResultCode::Timeout ? ResultCode::Retry : result.resultCode;
+            return {result, nullptr};
+        }
+    }
+    isReady_ = false;
+    auto data = std::move(readyData_);
+    if (data == nullptr) {
+        data = std::make_unique<Data>();
+    }
+    return {readyResult_, std::move(data)};
+}
+
+void UringSocket::close() noexcept {
+    if (isReceiveArmed_) {
+        ring()->cancel(receiveId_, socket_);
+        isReceiveArmed_ = false;
+    }
+    readyData_.reset();
+    isReady_ = false;
+    ISocket::close();
+}
+
+bool UringSocket::prepareIdle() noexcept {
+    if (isReady_) {
+        return false; //unexpected bytes after the response
+    }
+    if (isReceiveArmed_) {
+        isReceiveArmed_ = false;
+        if (!ring()->cancel(receiveId_)) {
+            ///the recv is still pending, end it so the ring drops it, the connection can not be handed over
+            ::shutdown(socket_, SHUT_RDWR);
+            return false;
+        }
+    }
+    ring_.reset();
+    return true;
+}
+
+UringRing* UringSocket::ring() const noexcept {
+    if (ring_ == nullptr) {
+        ring_ = UringRing::local();
+    }
+    return ring_.get();
+}
+
+} //end of namespace http
+
+#endif //end if ENABLE_IO_URING
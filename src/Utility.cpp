@@ -6,6 +6,9 @@
 #include "Utility.h"
 #include <random>
 #include <algorithm>
+#if defined(__linux__)
+#include <ctime>
+#endif
 
 namespace http::util {
 
@@ -96,6 +99,18 @@ std::chrono::milliseconds Time::nowTime() noexcept {
     return tp.time_since_epoch();
 }
 
+std::chrono::milliseconds Time::steadyTime() noexcept {
+#if defined(__linux__)
+    ///a few ms of resolution without the cost of reading the hardware clock
+    timespec ts{};
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+    return std::chrono::milliseconds(static_cast<int64_t>(ts.tv_sec) * 1000 + ts.tv_nsec / 1000000);
+#else
+    using namespace std::chrono;
+    return duration_cast<milliseconds>(steady_clock::now().time_since_epoch());
+#endif
+}
+
 std::chrono::milliseconds Time::TimeStamp::diff(Time::TimeStamp timeStamp) const noexcept {
     return std::chrono::milliseconds( (stamp - timeStamp) / 1000);
 }
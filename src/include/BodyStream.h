@@ -0,0 +1,79 @@
+//
+// Created by Nevermore on 2026/10/17.
+// http-request BodyStream
+// Copyright (c) 2024 Nevermore All rights reserved.
+//
+#pragma once
+
+#include <string>
+#include <vector>
+#include "Request.h"
+#include "Socket.h"
+
+namespace http {
+
+///Sends the body of RequestInfo::bodyFile or RequestInfo::bodyReader after the header, a part at a time.
+///The reader fills a single 64kb buffer, framed as chunks when its length is unknown, and is asked for the next part
+///only once the previous one is sent. A file goes through sendfile when the socket supports it, otherwise it is read
+///into the same buffer a part at a time. File bodies are not supported on windows.
+class BodyStream {
+public:
+    explicit BodyStream(const RequestInfo& info) noexcept;
+    ~BodyStream();
+    BodyStream(const BodyStream&) = delete;
+    BodyStream& operator=(const BodyStream&) = delete;
+
+    ///send the next bytes of the body, Completed once all of it is sent,
+    ///BodyReadFailed when the reader or the file failed or ended before the length of the body
+    [[nodiscard]] std::tuple<SocketResult, int64_t> send(const ISocket& socket) noexcept;
+
+    ///the file can not be opened or is shorter than its offset
+    [[nodiscard]] bool isFailed() const noexcept {
+        return isFailed_;
+    }
+
+    ///the reader was called and the body can not be sent again, a file body always can
+    [[nodiscard]] bool isStarted() const noexcept {
+        return isStarted_;
+    }
+
+    ///the bytes of the file to send, -1 if it can not be read
+    [[nodiscard]] static int64_t fileLength(const BodyFile& file) noexcept;
+
+private:
+    std::tuple<SocketResult, int64_t> sendFile(const ISocket& socket) noexcept;
+    std::tuple<SocketResult, int64_t> sendPart(const ISocket& socket) noexcept;
+    ///read the next part of the file into the buffer, false once it is sent or the read failed
+    bool readFile() noexcept;
+    bool pull() noexcept;
+    [[nodiscard]] std::vector<DataView> part() const noexcept;
+
+private:
+    std::function<int64_t(uint8_t*, uint64_t)> reader_;
+    bool isChunked_ = false;
+    ///the bytes of a known length, or of the file, still to read
+    int64_t remainLength_ = 0;
+    DataPtr buffer_;
+    std::string chunkHeader_;
+    ///the reader returned 0, only the last chunk is left
+    bool isEnded_ = false;
+    bool isLastPart_ = false;
+    bool isFinished_ = false;
+    bool isFailed_ = false;
+    bool isStarted_ = false;
+    uint64_t partSize_ = 0;
+    uint64_t sentSize_ = 0;
+
+    bool isFile_ = false;
+    int32_t fd_ = kInvalid;
+    ///fd_ was opened from the path and is closed with the stream
+    bool isOwnedFd_ = false;
+    ///the next byte of the file to send with sendfile or to read into the buffer
+    uint64_t fileOffset_ = 0;
+};
+
+inline void freeBodyStream(BodyStream* stream) noexcept {
+    delete stream;
+}
+
+} //end of namespace http
@@ -0,0 +1,75 @@
+//
+// Created by Nevermore on 2026/10/17.
+// http-request ConnectionLimiter
+// Copyright (c) 2024 Nevermore All rights reserved.
+//
+#pragma once
+
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace http {
+
+///Bounds the requests holding a connection per origin and in total, thread-safe.
+///The requests over a limit wait in a queue per origin, a freed slot goes to the origins in turn so a burst to one
+///origin cannot starve the others. The requests of one origin start in the order they arrived.
+class ConnectionLimiter {
+public:
+    ///the time the request waited for its slot
+    using StartFunc = std::function<void(std::chrono::milliseconds)>;
+
+    ///0 means no limit
+    ConnectionLimiter(uint32_t maxPerOrigin, uint32_t maxTotal) noexcept;
+    ConnectionLimiter(const ConnectionLimiter&) = delete;
+    ConnectionLimiter& operator=(const ConnectionLimiter&) = delete;
+
+    ///onStart runs once the request holds a slot, right away or on the thread releasing one.
+    ///It is called under the lock of the limiter and must only hand the request over, e.g. post it to a loop
+    void acquire(const std::string& origin, const std::string& id, StartFunc&& onStart) noexcept;
+
+    ///free the slot of a finished request and start the next waiting ones, an unknown id is ignored
+    void release(const std::string& id) noexcept;
+
+    ///drop a waiting request, false if it is not waiting
+    bool cancel(const std::string& id) noexcept;
+
+    [[nodiscard]] size_t waitingCount() const noexcept;
+
+    [[nodiscard]] size_t activeCount() const noexcept;
+
+private:
+    struct Waiter {
+        std::string id;
+        ///monotonic, ms
+        std::chrono::milliseconds enqueueTime;
+        StartFunc onStart;
+    };
+
+    struct Origin {
+        uint32_t activeCount = 0;
+        std::deque<Waiter> waiters;
+    };
+
+    [[nodiscard]] bool canStart(const Origin& origin) const noexcept;
+    void start(const std::string& key, Origin& origin, const std::string& id) noexcept;
+    ///hand the free slots to the waiting origins in turn
+    void dispatch() noexcept;
+
+private:
+    mutable std::mutex mutex_;
+    uint32_t maxPerOrigin_ = 0;
+    uint32_t maxTotal_ = 0;
+    uint32_t activeCount_ = 0;
+    size_t waitingCount_ = 0;
+    std::unordered_map<std::string, Origin> origins_;
+    ///the origins with waiting requests, the front one is served next
+    std::deque<std::string> turns_;
+    ///origin by the id of the requests holding a slot
+    std::unordered_map<std::string, std::string> holders_;
+};
+
+} //end of namespace http
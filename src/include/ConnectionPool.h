@@ -0,0 +1,67 @@
+//
+// Created by Nevermore on 2026/10/17.
+// http-request ConnectionPool
+// Copyright (c) 2024 Nevermore All rights reserved.
+//
+#pragma once
+
+#include <deque>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "Request.h"
+#include "Socket.h"
+#include "Url.h"
+
+namespace http {
+
+using SocketPtr = std::unique_ptr<ISocket, decltype(&freeSocket)>;
+
+///Idle keep-alive connections keyed by origin, thread-safe.
+///The most recently returned connection is handed out first, it is the least likely to be closed by the server.
+class ConnectionPool {
+public:
+    explicit ConnectionPool(const ConnectionPoolConfig& config = {}) noexcept;
+    ~ConnectionPool();
+    ConnectionPool(const ConnectionPool&) = delete;
+    ConnectionPool& operator=(const ConnectionPool&) = delete;
+
+    ///close the idle connections over the new limits
+    void setConfig(const ConnectionPoolConfig& config) noexcept;
+
+    ///scheme://host:port, a forced ip version and the socket options that differ from the defaults are part of the key,
+    ///a connection is only reused by requests that would have opened the same one
+    [[nodiscard]] static std::string makeKey(const Url& url, IPVersion ipVersion, const SocketOptions& options) noexcept;
+
+    ///a healthy idle connection of the origin, nullptr if there is none
+    [[nodiscard]] SocketPtr checkout(const std::string& key) noexcept;
+
+    ///keep a connection whose response was fully read, it is closed if the pool is full or it is too old
+    void checkin(const std::string& key, SocketPtr socket) noexcept;
+
+    [[nodiscard]] size_t idleCount() const noexcept;
+
+    [[nodiscard]] size_t idleCount(const std::string& key) const noexcept;
+
+    void clear() noexcept;
+
+private:
+    struct Entry {
+        SocketPtr socket;
+        ///monotonic, ms
+        std::chrono::milliseconds idleTime;
+    };
+
+    [[nodiscard]] bool isExpired(const Entry& entry, std::chrono::milliseconds now) const noexcept;
+    ///move the expired and the surplus connections into dropped, they are closed outside the lock
+    void purge(std::chrono::milliseconds now, std::vector<SocketPtr>& dropped) noexcept;
+
+private:
+    mutable std::mutex mutex_;
+    ConnectionPoolConfig config_;
+    ///oldest first
+    std::unordered_map<std::string, std::deque<Entry>> idles_;
+};
+
+} //end of namespace http
@@ -0,0 +1,66 @@
+//
+// Created by Nevermore on 2026/10/17.
+// http-request Connector
+// Copyright (c) 2024 Nevermore All rights reserved.
+//
+#pragma once
+
+#include <functional>
+#include <vector>
+#include "EventLoop.h"
+#include "Socket.h"
+
+namespace http {
+
+///Happy Eyeballs connection racing over the resolved addresses, https://www.rfc-editor.org/rfc/rfc8305.
+///The address families alternate and a new connect starts every attempt delay or as soon as the previous one fails,
+///the first socket to connect wins and the others are closed. Only the tcp connect is raced, the handshake is not.
+class Connector {
+public:
+    using SocketPtr = std::unique_ptr<ISocket, decltype(&freeSocket)>;
+    ///a socket of the family, nullptr if it cannot be created
+    using SocketFactory = std::function<ISocket*(IPVersion)>;
+    ///the connected socket, or nullptr with the error of the last attempt
+    using ConnectFunc = std::function<void(SocketPtr, SocketResult)>;
+
+    ///every method must be called on the loop thread, onConnect may destroy the connector
+    Connector(EventLoop& loop, AddressInfoPtr address, std::chrono::milliseconds attemptDelay, SocketFactory&& factory,
+              ConnectFunc&& onConnect);
+    ~Connector();
+    Connector(const Connector&) = delete;
+    Connector& operator=(const Connector&) = delete;
+
+    void start() noexcept;
+
+    ///blocking race, timeout in ms
+    [[nodiscard]] static std::tuple<SocketPtr, SocketResult> connect(const AddressInfoPtr& address,
+                                                                     std::chrono::milliseconds attemptDelay,
+                                                                     const SocketFactory& factory,
+                                                                     int64_t timeout) noexcept;
+
+    ///the first address keeps its family in front, the other family follows every address of it
+    [[nodiscard]] static std::vector<const addrinfo*> sortAddresses(const addrinfo* address) noexcept;
+
+private:
+    ///start connects until one is pending, report the failure when no address is left
+    void next() noexcept;
+    void onEvent(Socket socket) noexcept;
+    void finish(SocketPtr socket) noexcept;
+    ///cancel the pending connects and the delay
+    void stop() noexcept;
+
+private:
+    EventLoop& loop_;
+    AddressInfoPtr address_;
+    std::chrono::milliseconds attemptDelay_;
+    SocketFactory factory_;
+    ConnectFunc onConnect_;
+    std::vector<const addrinfo*> addresses_;
+    size_t nextIndex_ = 0;
+    ///the pending connects
+    std::vector<SocketPtr> attempts_;
+    SocketResult lastResult_{ResultCode::ConnectAddressError};
+    uint64_t timerId_ = 0;
+};
+
+} //end of namespace http
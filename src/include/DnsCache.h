@@ -0,0 +1,117 @@
+//
+// Created by Nevermore on 2026/10/17.
+// http-request DnsCache
+// Copyright (c) 2024 Nevermore All rights reserved.
+//
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <list>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "Request.h"
+#include "Socket.h"
+
+namespace http {
+
+///Resolved addresses keyed by host, port and ip version, thread-safe.
+///getaddrinfo reports no ttl, every host is kept for the configured one and a failed lookup for the negative ttl,
+///the records of the built-in resolver shorten it to their own ttl.
+///With stale-while-refresh an expired host is still handed out while a background thread resolves it again,
+///so only the first lookup of a host blocks. The overrides win over the cache and never expire.
+class DnsCache {
+public:
+    ///an address with the port of the request
+    struct Address {
+        sockaddr_storage storage{};
+        socklen_t length = 0;
+    };
+    using AddressList = std::vector<Address>;
+
+    struct LookupResult {
+        AddressList addresses;
+        ///a getaddrinfo error code
+        int32_t errorCode = 0;
+        ///the smallest ttl of the records, negative if it is unknown
+        std::chrono::milliseconds ttl{kInvalid};
+    };
+
+    explicit DnsCache(const DnsCacheConfig& config = {}) noexcept;
+    ~DnsCache();
+    DnsCache(const DnsCache&) = delete;
+    DnsCache& operator=(const DnsCache&) = delete;
+
+    ///shared by all the requests and clients of the process
+    static DnsCache& shared() noexcept;
+
+    void setConfig(const DnsCacheConfig& config) noexcept;
+
+    ///the addresses in the order they were resolved, nullptr and the getaddrinfo error if it failed,
+    ///a host missing from the cache is resolved before it returns, the built-in resolver gives up after timeout ms
+    [[nodiscard]] std::tuple<AddressInfoPtr, int32_t> resolve(const std::string& host, const std::string& port,
+                                                             IPVersion ipVersion, int64_t timeout = kInvalid) noexcept;
+
+    ///the same as resolve without a lookup, the last value is false if the host has to be resolved
+    [[nodiscard]] std::tuple<AddressInfoPtr, int32_t, bool> find(const std::string& host, const std::string& port,
+                                                                IPVersion ipVersion) noexcept;
+
+    ///keep a lookup result, a positive ttl shorter than the configured one is used instead
+    void store(const std::string& host, const std::string& port, IPVersion ipVersion, const AddressList& addresses,
+               int32_t errorCode, std::chrono::milliseconds ttl = std::chrono::milliseconds(kInvalid)) noexcept;
+
+    ///a list in one allocation with the addresses of the family, released by the deleter of the pointer
+    [[nodiscard]] static AddressInfoPtr makeAddressInfo(const AddressList& addresses, int family) noexcept;
+
+    ///the numeric addresses of host:port, empty addresses remove the override
+    void setOverride(const std::string& host, const std::string& port,
+                     const std::vector<std::string>& addresses) noexcept;
+
+    ///forget the resolved hosts, the overrides are kept
+    void clear() noexcept;
+
+    [[nodiscard]] size_t size() const noexcept;
+
+private:
+    struct Entry {
+        AddressList addresses;
+        int32_t errorCode = 0;
+        ///monotonic, ms
+        std::chrono::milliseconds expireTime{0};
+        bool isRefreshing = false;
+        std::list<std::string>::iterator position;
+    };
+
+    struct Refresh {
+        std::string key;
+        std::string host;
+        std::string port;
+        IPVersion ipVersion = IPVersion::Auto;
+    };
+
+    ///the built-in resolver when it is enabled, getaddrinfo otherwise
+    [[nodiscard]] static LookupResult lookup(const std::string& host, const std::string& port, IPVersion ipVersion,
+                                             int64_t timeout) noexcept;
+    [[nodiscard]] std::chrono::milliseconds entryTtl(int32_t errorCode, std::chrono::milliseconds ttl) const noexcept;
+    ///drop the least recently used hosts over the limit, the caller holds the lock
+    void trim() noexcept;
+    void refreshLoop() noexcept;
+
+private:
+    mutable std::mutex mutex_;
+    DnsCacheConfig config_;
+    std::unordered_map<std::string, Entry> entries_;
+    ///keys, most recently used first
+    std::list<std::string> lru_;
+    std::unordered_map<std::string, AddressList> overrides_;
+    std::deque<Refresh> refreshes_;
+    std::condition_variable cond_;
+    bool isRunning_ = true;
+    ///started with the first refresh
+    std::thread refresher_;
+};
+
+} //end of namespace http
@@ -0,0 +1,89 @@
+//
+// Created by Nevermore on 2026/10/17.
+// http-request DnsResolver
+// Copyright (c) 2024 Nevermore All rights reserved.
+//
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include "DnsCache.h"
+#include "EventLoop.h"
+
+namespace http {
+
+class DnsExchange;
+
+///A stub resolver asking the nameservers over udp instead of blocking in getaddrinfo, https://www.rfc-editor.org/rfc/rfc1035.
+///The A and AAAA queries of a host go out together on one socket, a nameserver that does not answer within the attempt
+///timeout or fails the queries hands them over to the next one. Numeric hosts and the names of /etc/hosts are answered
+///without a query, no search domain is appended to a name. Thread-safe.
+class DnsResolver {
+public:
+    struct Settings {
+        DnsResolverConfig config;
+        DnsCache::AddressList servers;
+        ///the addresses of /etc/hosts by lowercase name, port 0
+        std::unordered_map<std::string, DnsCache::AddressList> hosts;
+    };
+
+    static DnsResolver& shared() noexcept;
+
+    ///reads /etc/resolv.conf and /etc/hosts when it is enabled
+    void setConfig(const DnsResolverConfig& config) noexcept;
+
+    ///false while it is disabled or no nameserver is known
+    [[nodiscard]] bool isEnabled() const noexcept;
+
+    [[nodiscard]] std::shared_ptr<const Settings> settings() const noexcept;
+
+    ///blocking lookup, it gives up after timeout ms or once the attempts of the config are used up
+    [[nodiscard]] DnsCache::LookupResult resolve(const std::string& host, const std::string& port, IPVersion ipVersion,
+                                                 int64_t timeout) const noexcept;
+
+    ///the nameserver lines of a resolv.conf
+    [[nodiscard]] static std::vector<std::string> loadNameservers(const std::string& path) noexcept;
+
+private:
+    mutable std::mutex mutex_;
+    std::shared_ptr<const Settings> settings_ = std::make_shared<Settings>();
+};
+
+///Resolve a host through the dns cache on the loop thread. A miss is queried by the resolver without blocking the loop,
+///getaddrinfo blocks it while the resolver is disabled. The result is kept in the dns cache.
+class DnsQuery {
+public:
+    ///the addresses, or nullptr and the getaddrinfo error
+    using ResolveFunc = std::function<void(AddressInfoPtr, int32_t)>;
+
+    ///every method must be called on the loop thread, onResolve may destroy the query
+    DnsQuery(EventLoop& loop, std::string host, std::string port, IPVersion ipVersion, ResolveFunc&& onResolve);
+    ~DnsQuery();
+    DnsQuery(const DnsQuery&) = delete;
+    DnsQuery& operator=(const DnsQuery&) = delete;
+
+    ///onResolve runs before it returns when the host is cached
+    void start() noexcept;
+
+private:
+    ///ask the next nameserver, finish once the attempts are used up
+    void next() noexcept;
+    void onEvent() noexcept;
+    void complete() noexcept;
+    void finish(AddressInfoPtr address, int32_t errorCode) noexcept;
+    ///cancel the pending query and the attempt timer
+    void stop() noexcept;
+
+private:
+    EventLoop& loop_;
+    std::string host_;
+    std::string port_;
+    IPVersion ipVersion_;
+    ResolveFunc onResolve_;
+    std::unique_ptr<DnsExchange> exchange_;
+    Socket socket_ = kInvalidSocket;
+    uint64_t timerId_ = 0;
+};
+
+} //end of namespace http
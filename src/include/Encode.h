@@ -0,0 +1,28 @@
+//
+// Created by Nevermore on 2026/10/17.
+// http-request Encode
+// Copyright (c) 2024 Nevermore All rights reserved.
+//
+#pragma once
+
+#include <string>
+#include "Request.h"
+#include "Url.h"
+
+namespace http {
+
+std::string getMethodName(HttpMethodType type);
+
+namespace encode {
+
+std::string base64Encode(const std::string& str);
+
+///serialize the request line and headers, the body is sent from info.body as it is
+std::string encodeHeader(RequestInfo& info, const Url& url) noexcept;
+
+///serialize the request line, headers and body
+std::string htmlEncode(RequestInfo& info, const Url& url) noexcept;
+
+} //end of namespace encode
+
+} //end of namespace http
@@ -0,0 +1,88 @@
+//
+// Created by Nevermore on 2026/10/17.
+// http-request EventLoop
+// Copyright (c) 2024 Nevermore All rights reserved.
+//
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "Socket.h"
+#include "TimerWheel.h"
+
+namespace http {
+
+constexpr uint32_t kEventRead = 1;
+constexpr uint32_t kEventWrite = 1 << 1;
+constexpr uint32_t kEventError = 1 << 2;
+
+///Single threaded reactor, epoll on linux and poll everywhere else.
+///All the methods except post/stop must be called on the loop thread.
+class EventLoop {
+public:
+    using Task = std::function<void()>;
+    using EventFunc = std::function<void(uint32_t)>;
+
+    EventLoop();
+    ~EventLoop();
+    EventLoop(const EventLoop&) = delete;
+    EventLoop& operator=(const EventLoop&) = delete;
+
+    ///spawn the loop thread, pinned to the cpu unless it is kInvalid
+    bool start(int32_t cpu = kInvalid) noexcept;
+
+    ///stop the loop thread and wait for it, pending tasks are dropped
+    void stop() noexcept;
+
+    ///thread-safe, run the task on the loop thread
+    void post(Task&& task) noexcept;
+
+    [[nodiscard]] bool isInLoopThread() const noexcept {
+        return std::this_thread::get_id() == threadId_;
+    }
+
+    bool addEvent(Socket socket, uint32_t events, EventFunc&& func) noexcept;
+
+    bool updateEvent(Socket socket, uint32_t events) noexcept;
+
+    void removeEvent(Socket socket) noexcept;
+
+    ///return the timer id, never 0, the timers of all the sessions on the loop share one wheel
+    uint64_t runAfter(std::chrono::milliseconds delay, Task&& task) noexcept;
+
+    void cancelTimer(uint64_t timerId) noexcept;
+
+private:
+    void loop(int32_t cpu) noexcept;
+    void poll(int64_t timeout) noexcept;
+    void wakeup() noexcept;
+    void runTasks() noexcept;
+    int64_t runTimers() noexcept;
+    void dispatch(Socket socket, uint32_t events) noexcept;
+
+private:
+    std::atomic<bool> isRunning_ = false;
+    std::unique_ptr<std::thread> worker_ = nullptr;
+    std::atomic<std::thread::id> threadId_;
+    std::mutex taskMutex_;
+    std::vector<Task> tasks_;
+    std::unordered_map<Socket, std::shared_ptr<EventFunc>> handlers_;
+    std::unordered_map<Socket, uint32_t> events_;
+    TimerWheel timerWheel_;
+#if defined(__linux__)
+    int pollFd_ = kInvalid;
+#endif
+    ///wakeup pipe, unused on windows where the poll timeout is bounded instead
+    int wakeupFd_[2] = {kInvalid, kInvalid};
+};
+
+inline void freeEventLoop(EventLoop* loop) noexcept {
+    delete loop;
+}
+
+} //end of namespace http
@@ -0,0 +1,61 @@
+//
+// Created by Nevermore on 2026/10/17.
+// http-request Hpack
+// Copyright (c) 2024 Nevermore All rights reserved.
+//
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace http::hpack {
+
+///https://www.rfc-editor.org/rfc/rfc7541
+using HeaderField = std::pair<std::string, std::string>;
+using HeaderList = std::vector<HeaderField>;
+
+///the table size both sides start with
+constexpr uint32_t kDefaultTableSize = 4096;
+
+///false if the input is not a valid huffman string
+bool huffmanDecode(std::string_view data, std::string& out) noexcept;
+
+void huffmanEncode(std::string_view data, std::string& out) noexcept;
+
+[[nodiscard]] size_t huffmanEncodedSize(std::string_view data) noexcept;
+
+///The encoder never adds to the dynamic table, the peer never has to evict for it.
+///A field is sent as a static table index when possible, the strings are huffman coded when that is shorter.
+class Encoder {
+public:
+    ///the names must be lowercase already
+    void encode(const HeaderList& headers, std::string& out) const noexcept;
+};
+
+///Decodes the header blocks of one connection in the order they arrive, the dynamic table is shared by all the blocks.
+class Decoder {
+public:
+    explicit Decoder(uint32_t maxTableSize = kDefaultTableSize) noexcept;
+
+    ///false on a compression error, the connection can not continue after that
+    bool decode(std::string_view block, HeaderList& headers) noexcept;
+
+private:
+    [[nodiscard]] const HeaderField* field(uint64_t index) const noexcept;
+    void insert(HeaderField field) noexcept;
+    void evict(size_t maxSize) noexcept;
+
+private:
+    ///the limit we announced, the peer can only lower the table below it
+    uint32_t maxTableSize_ = kDefaultTableSize;
+    size_t tableSize_ = 0;
+    size_t tableLimit_ = kDefaultTableSize;
+    ///newest first
+    std::deque<HeaderField> table_;
+};
+
+} //end of namespace http::hpack
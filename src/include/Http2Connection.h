@@ -0,0 +1,178 @@
+//
+// Created by Nevermore on 2026/10/17.
+// http-request Http2Connection
+// Copyright (c) 2024 Nevermore All rights reserved.
+//
+#pragma once
+
+#include <deque>
+#include <map>
+#include <unordered_set>
+#include "Request.h"
+#include "ConnectionPool.h"
+#include "EventLoop.h"
+#include "Hpack.h"
+#include "Session.h"
+#include "Url.h"
+
+namespace http {
+
+///HTTP/2 client connection to one origin, driven by an EventLoop, https://www.rfc-editor.org/rfc/rfc9113.
+///Every request is a stream multiplexed on the connection, the responses are delivered to its ResponseHandler.
+///https negotiates h2 with ALPN, when the server picks http/1.1 the requests go on as sessions and the connection is pooled for them.
+///Plain http speaks h2c with prior knowledge.
+///Every method must be called on the loop thread.
+class Http2Connection {
+public:
+    using FinishFunc = std::function<void(const std::string&)>;
+    ///the request continues as a plain session, after a redirect or when the server has no h2
+    using FallbackFunc = std::function<void(RequestInfo&&, ResponseHandler&&, const std::string&)>;
+    using IdleFunc = std::function<void()>;
+    ///the origins whose server selected http/1.1 with ALPN, owned by the loop and shared by its connections
+    using OriginSet = std::unordered_set<std::string>;
+
+    Http2Connection(EventLoop& loop, std::string key, std::chrono::milliseconds idleTimeout, FinishFunc&& onFinish,
+                    FallbackFunc&& onFallback, IdleFunc&& onIdle, SessionCounter* counter = nullptr,
+                    ConnectionPool* pool = nullptr, OriginSet* http1Origins = nullptr);
+    ~Http2Connection();
+    Http2Connection(const Http2Connection&) = delete;
+    Http2Connection& operator=(const Http2Connection&) = delete;
+
+    ///opted in, a valid http url and no streamed body
+    [[nodiscard]] static bool isHttp2(const RequestInfo& info) noexcept;
+
+    void add(RequestInfo&& info, ResponseHandler&& handler, std::string reqId) noexcept;
+
+    ///reset the stream without any further callback, false if the request is not on this connection
+    bool cancel(const std::string& reqId) noexcept;
+
+    ///no request and no connection, the owner may destroy it
+    [[nodiscard]] bool isIdle() const noexcept {
+        return queue_.empty() && streams_.empty() && state_ == State::Idle;
+    }
+
+private:
+    struct Stream {
+        RequestInfo info;
+        ResponseHandler handler;
+        std::string reqId;
+        std::unique_ptr<Url> url;
+        ///monotonic, ms
+        std::chrono::milliseconds startTime{0};
+        uint64_t timerId = 0;
+        uint32_t id = 0;
+        uint8_t resendCount = 0;
+        ///callbacks are still delivered
+        bool isValid = true;
+        ///the owner was told the request finished
+        bool isFinished = false;
+        ///onConnected was reported
+        bool isSent = false;
+        ///part of the response was delivered, it can no longer be sent again
+        bool isReceived = false;
+        ///the final response header arrived, a later header block is the trailer
+        bool isHeaderDone = false;
+        ///the request went out with END_STREAM
+        bool isEndStream = false;
+        ///body bytes the server still accepts on this stream
+        int64_t sendWindow = 0;
+        uint64_t bodyOffset = 0;
+        ///received bytes not returned to the server with a WINDOW_UPDATE yet
+        uint32_t unackedSize = 0;
+        std::string location;
+    };
+    using StreamPtr = std::unique_ptr<Stream>;
+
+    enum class State : uint8_t {
+        Idle,
+        Connect,
+        Handshake,
+        Open,
+    };
+
+    void open() noexcept;
+    void onEvent(uint32_t events) noexcept;
+    void resolved(AddressInfoPtr address, int32_t errorCode) noexcept;
+    void connected(Connector::SocketPtr socket, SocketResult result) noexcept;
+    void handshake() noexcept;
+    ///the server selected http/1.1, hand the requests and the connection to sessions
+    void fallback() noexcept;
+    ///open the queued streams while the server allows more concurrent ones
+    void startStreams() noexcept;
+    ///append the DATA frames the flow control windows allow, false if nothing was added
+    bool fillBodies() noexcept;
+    void send() noexcept;
+    void receive() noexcept;
+    ///false if the connection was dropped
+    bool processFrames() noexcept;
+    bool onFrame(uint8_t type, uint8_t flags, uint32_t streamId, std::string_view payload) noexcept;
+    bool onData(uint8_t flags, uint32_t streamId, std::string_view payload) noexcept;
+    bool onHeaders(uint8_t flags, uint32_t streamId, std::string_view payload) noexcept;
+    bool onHeaderBlock(uint32_t streamId, bool isEndStream) noexcept;
+    bool onSettings(uint8_t flags, std::string_view payload) noexcept;
+    bool onWindowUpdate(uint32_t streamId, std::string_view payload) noexcept;
+    ///the stream broke the protocol, reset it and fail its request
+    void resetStream(uint32_t streamId, uint32_t errorCode) noexcept;
+    ///the server reset the stream
+    void onReset(uint32_t streamId, uint32_t errorCode) noexcept;
+    void onGoAway(uint32_t lastStreamId) noexcept;
+    void writeFrame(uint8_t type, uint8_t flags, uint32_t streamId, std::string_view payload) noexcept;
+    void writeWindowUpdate(uint32_t streamId, uint32_t increment) noexcept;
+    void complete(uint32_t streamId) noexcept;
+    void expire(const std::string& reqId) noexcept;
+    ///write a GOAWAY and try to send it once, the connection is closed right after
+    void sendGoAway(uint32_t errorCode) noexcept;
+    ///tell the server about a broken connection, every request fails with ProtocolError
+    bool goAway(uint32_t errorCode) noexcept;
+    ///drop the connection, the requests without a response go back to the queue
+    void restart(ResultCode code, int32_t errorCode) noexcept;
+    void failAll(ResultCode code, int32_t errorCode) noexcept;
+    void fail(Stream& stream, ResultCode code, int32_t errorCode) noexcept;
+    void finish(Stream& stream) noexcept;
+    ///keep an open connection for the idle timeout, otherwise let the owner destroy it
+    void checkIdle() noexcept;
+    void idle() noexcept;
+    void wait(uint32_t events) noexcept;
+    void closeSocket() noexcept;
+
+private:
+    EventLoop& loop_;
+    std::string key_;
+    std::chrono::milliseconds idleTimeout_;
+    FinishFunc onFinish_;
+    FallbackFunc onFallback_;
+    IdleFunc onIdle_;
+    SessionCounter* counter_ = nullptr;
+    ConnectionPool* pool_ = nullptr;
+    OriginSet* http1Origins_ = nullptr;
+    State state_ = State::Idle;
+    std::unique_ptr<DnsQuery> query_;
+    std::unique_ptr<Connector> connector_;
+    std::unique_ptr<ISocket, decltype(&freeSocket)> socket_;
+    hpack::Encoder encoder_;
+    std::unique_ptr<hpack::Decoder> decoder_;
+    ///waiting for the connection or for a free stream
+    std::deque<StreamPtr> queue_;
+    ///open streams by id, the bodies are sent in the order the streams were opened
+    std::map<uint32_t, StreamPtr> streams_;
+    std::string sendData_;
+    size_t sendPos_ = 0;
+    std::string recvData_;
+    uint32_t nextStreamId_ = 1;
+    uint32_t maxConcurrentStreams_ = 0;
+    uint32_t maxFrameSize_ = 0;
+    int64_t initialWindowSize_ = 0;
+    ///connection level flow control of the bodies we send
+    int64_t sendWindow_ = 0;
+    uint32_t unackedSize_ = 0;
+    ///the stream of the header block that waits for its CONTINUATION frames
+    uint32_t headerStreamId_ = 0;
+    bool isHeaderEndStream_ = false;
+    std::string headerBlock_;
+    ///the server sent GOAWAY or the stream ids ran out, no new stream is opened on this connection
+    bool isGoingAway_ = false;
+    bool isTls_ = false;
+    uint64_t idleTimerId_ = 0;
+};
+
+} //end of namespace http
@@ -0,0 +1,122 @@
+//
+// Created by Nevermore on 2026/10/17.
+// http-request Pipeline
+// Copyright (c) 2024 Nevermore All rights reserved.
+//
+#pragma once
+
+#include <deque>
+#include "Request.h"
+#include "ConnectionPool.h"
+#include "EventLoop.h"
+#include "ResponseParser.h"
+#include "Session.h"
+#include "Url.h"
+
+namespace http {
+
+///HTTP/1.1 pipelining of idempotent requests to one origin, driven by an EventLoop.
+///Up to maxDepth serialized requests are written back-to-back on one connection and the responses are matched in order.
+///When the server closes mid-pipeline the requests without a response are sent again on a new connection.
+///Every method must be called on the loop thread.
+class Pipeline {
+public:
+    using FinishFunc = std::function<void(const std::string&)>;
+    ///the request got a redirect, it continues as a plain session
+    using RedirectFunc = std::function<void(RequestInfo&&, ResponseHandler&&, const std::string&)>;
+    using IdleFunc = std::function<void()>;
+
+    Pipeline(EventLoop& loop, std::string key, uint32_t maxDepth, FinishFunc&& onFinish, RedirectFunc&& onRedirect,
+             IdleFunc&& onIdle, SessionCounter* counter = nullptr, ConnectionPool* pool = nullptr);
+    ~Pipeline();
+    Pipeline(const Pipeline&) = delete;
+    Pipeline& operator=(const Pipeline&) = delete;
+
+    ///opted in, idempotent, a valid http url and no streamed body
+    [[nodiscard]] static bool isPipelinable(const RequestInfo& info) noexcept;
+
+    void add(RequestInfo&& info, ResponseHandler&& handler, std::string reqId) noexcept;
+
+    ///stop the request without any further callback, false if it is not in the pipeline
+    bool cancel(const std::string& reqId) noexcept;
+
+    ///nothing queued or in flight, the owner may destroy it
+    [[nodiscard]] bool isIdle() const noexcept {
+        return queue_.empty() && inflight_.empty();
+    }
+
+private:
+    struct Exchange {
+        RequestInfo info;
+        ResponseHandler handler;
+        std::string reqId;
+        std::unique_ptr<Url> url;
+        ///monotonic, ms
+        std::chrono::milliseconds startTime{0};
+        uint64_t timerId = 0;
+        uint8_t resendCount = 0;
+        ///callbacks are still delivered
+        bool isValid = true;
+        ///the owner was told the request finished
+        bool isFinished = false;
+        ///onConnected was reported
+        bool isSent = false;
+        ///part of the response was delivered, it can no longer be sent again
+        bool isReceived = false;
+        std::string location;
+    };
+    using ExchangePtr = std::unique_ptr<Exchange>;
+
+    enum class State : uint8_t {
+        Idle,
+        Connect,
+        Handshake,
+        Ready,
+    };
+
+    void open() noexcept;
+    void onEvent(uint32_t events) noexcept;
+    void resolved(AddressInfoPtr address, int32_t errorCode) noexcept;
+    void connected(Connector::SocketPtr socket, SocketResult result) noexcept;
+    void handshake() noexcept;
+    ///move the queued requests into the send buffer while the depth allows
+    void flush() noexcept;
+    void send() noexcept;
+    void receive() noexcept;
+    ///false if the connection was reset
+    bool consume(DataPtr data) noexcept;
+    void startParser() noexcept;
+    void complete() noexcept;
+    void expire(const std::string& reqId) noexcept;
+    ///drop the connection, the requests in flight without a response go back to the queue
+    void restart(ResultCode code, int32_t errorCode, bool isGraceful) noexcept;
+    void failAll(ResultCode code, int32_t errorCode) noexcept;
+    void fail(Exchange& exchange, ResultCode code, int32_t errorCode) noexcept;
+    void finish(Exchange& exchange) noexcept;
+    void idle() noexcept;
+    void wait(uint32_t events) noexcept;
+    void closeSocket() noexcept;
+
+private:
+    EventLoop& loop_;
+    std::string key_;
+    uint32_t maxDepth_ = 1;
+    FinishFunc onFinish_;
+    RedirectFunc onRedirect_;
+    IdleFunc onIdle_;
+    SessionCounter* counter_ = nullptr;
+    ConnectionPool* pool_ = nullptr;
+    State state_ = State::Idle;
+    std::unique_ptr<DnsQuery> query_;
+    std::unique_ptr<Connector> connector_;
+    std::unique_ptr<ISocket, decltype(&freeSocket)> socket_;
+    std::unique_ptr<ResponseParser> parser_;
+    ///not written yet
+    std::deque<ExchangePtr> queue_;
+    ///written, waiting for the responses in order
+    std::deque<ExchangePtr> inflight_;
+    std::string sendData_;
+    size_t sendPos_ = 0;
+};
+
+} //end of namespace http
@@ -23,6 +23,15 @@ public:
 
     [[nodiscard]] std::tuple<SocketResult, int64_t> send(const std::string_view& data) const noexcept override;
 
+    ///one sendmsg with an iovec per buffer
+    [[nodiscard]] std::tuple<SocketResult, int64_t> sendBuffers(const std::vector<DataView>& buffers) const noexcept override;
+
+    ///true on linux
+    [[nodiscard]] bool isSendFileSupported() const noexcept override;
+
+    ///sendfile, the bytes never enter user space
+    [[nodiscard]] std::tuple<SocketResult, int64_t> sendFile(int32_t fd, uint64_t offset, uint64_t size) const noexcept override;
+
     [[nodiscard]] std::tuple<SocketResult, DataPtr> receive() const noexcept override;
 
     void close() noexcept override;
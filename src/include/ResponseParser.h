@@ -0,0 +1,114 @@
+//
+// Created by Nevermore on 2026/10/17.
+// http-request ResponseParser
+// Copyright (c) 2024 Nevermore All rights reserved.
+//
+#pragma once
+
+#include <functional>
+#include "Request.h"
+
+namespace http {
+
+enum class ParseState : uint8_t {
+    Header,
+    Body,
+    Completed,
+    Redirect,
+    Error,
+};
+
+///Incremental HTTP/1.1 response parser, shared by the threaded Request and the event loop sessions.
+///The body is handed out as slices of the received buffers, only the header and the chunk lines split
+///between two reads are copied.
+class ResponseParser {
+public:
+    using HeaderFunc = std::function<void(ResponseHeader&&)>;
+    using DataFunc = std::function<void(DataPtr)>;
+
+    explicit ResponseParser(bool isAllowRedirect = true) noexcept;
+
+    void setHeaderCallback(HeaderFunc&& func) noexcept {
+        onHeader_ = std::move(func);
+    }
+
+    void setDataCallback(DataFunc&& func) noexcept {
+        onData_ = std::move(func);
+    }
+
+    ///feed the received bytes, return the state after consuming them
+    ParseState parse(DataPtr data) noexcept;
+
+    ///the peer closed the connection
+    ParseState finish() noexcept;
+
+    [[nodiscard]] ParseState state() const noexcept {
+        return state_;
+    }
+
+    [[nodiscard]] ResultCode errorCode() const noexcept {
+        return errorCode_;
+    }
+
+    ///valid when the state is Redirect
+    [[nodiscard]] const std::string& location() const noexcept {
+        return location_;
+    }
+
+    ///the server keeps the connection open after this response, valid once the header is parsed
+    [[nodiscard]] bool isKeepAlive() const noexcept {
+        return isKeepAlive_;
+    }
+
+    ///the response is complete, the server keeps the connection open and sent nothing after it
+    [[nodiscard]] bool isReusable() const noexcept {
+        return state_ == ParseState::Completed && isKeepAlive_ && remain_ == nullptr;
+    }
+
+    ///the bytes received after the end of the response, the start of the next pipelined one
+    [[nodiscard]] DataPtr takeRemain() noexcept {
+        return std::move(remain_);
+    }
+
+private:
+    bool parseHeader(DataView& view) noexcept;
+    void parseBody(DataView view) noexcept;
+    void parseChunked(DataView view) noexcept;
+    bool parseChunk(DataView& view) noexcept;
+    ///a slice of received_ if the view lies in it, otherwise a copy
+    DataPtr slice(DataView view) const noexcept;
+    void deliver(DataView view) noexcept;
+    void keepRemain(DataView view) noexcept;
+    void setError(ResultCode code) noexcept;
+
+private:
+    enum class ChunkState : uint8_t {
+        Size,
+        Data,
+        DataEnd,
+        Trailer,
+    };
+
+    bool isAllowRedirect_ = true;
+    ParseState state_ = ParseState::Header;
+    ResultCode errorCode_ = ResultCode::Success;
+    ///the header or the chunk line not complete yet
+    DataPtr buffer_;
+    ///the buffer being parsed, the slices handed out share it
+    DataRefPtr received_;
+    std::string location_;
+    bool isChunked_ = false;
+    bool isKeepAlive_ = false;
+    ///the bytes received after the end of the response
+    DataPtr remain_;
+    ChunkState chunkState_ = ChunkState::Size;
+    int64_t chunkSize_ = 0;
+    int64_t contentLength_ = INT64_MAX;
+    int64_t recvLength_ = 0;
+    HeaderFunc onHeader_ = nullptr;
+    DataFunc onData_ = nullptr;
+};
+
+std::tuple<bool, int64_t> parseResponseHeader(std::string_view data, ResponseHeader& response);
+
+} //end of namespace http
@@ -7,6 +7,8 @@
 
 #if ENABLE_HTTPS
 #include <mutex>
+#include <string>
+#include <vector>
 #include <openssl/err.h>
 
 #include "PlainSocket.h"
@@ -18,12 +20,33 @@ class SSLManager {
 public:
     static SSLContextPtr& shareContext();
 
-    static SSLPtr create(Socket) noexcept;
+    ///host is sent as SNI unless it is an ip address, host:port is the key of the cached sessions
+    static SSLPtr create(Socket, const std::string& host = {}, const std::string& port = {}) noexcept;
+    ///apply the cached session of the origin, call it before the first SSL_connect
+    static void resume(const SSLPtr&) noexcept;
+    ///offer the protocols in the handshake, most preferred first
+    static bool setAlpn(const SSLPtr&, const std::vector<std::string>& protocols) noexcept;
+    ///the protocol the server selected, empty if it did not take part in ALPN
+    [[nodiscard]] static std::string alpn(const SSLPtr&) noexcept;
+    ///the early data the resumed session lets us send, 0 if it is not resumed or the server never allowed it
+    [[nodiscard]] static uint32_t maxEarlyDataSize(const SSLPtr&) noexcept;
+    ///start the handshake with the data as tls 1.3 early data, the whole data is written once it succeeds
+    static SocketResult writeEarlyData(const SSLPtr&, const std::string_view&) noexcept;
+    ///the handshake is done and the server processed the early data
+    [[nodiscard]] static bool isEarlyDataAccepted(const SSLPtr&) noexcept;
+    ///one handshake step, Retry carries the readiness direction to wait for
     static SocketResult connect(SSLPtr&) noexcept;
+    ///never block or sleep, Retry carries the readiness direction to wait for, which may differ from the operation
     [[nodiscard]] static std::tuple<SocketResult, int64_t> write(const SSLPtr&, const std::string_view&) noexcept;
     [[nodiscard]] static std::tuple<SocketResult, DataPtr> read(const SSLPtr&) noexcept;
+    ///false if application data, close_notify or eof arrived, the other records are processed on the way
+    [[nodiscard]] static bool isAlive(const SSLPtr&) noexcept;
     static void close(SSLPtr&) noexcept;
 private:
+    ///index of the session key in the ex data of an SSL
+    static int sessionKeyIndex() noexcept;
+    static int onNewSession(SSL*, SSL_SESSION*) noexcept;
+    static SocketResult checkResult(const SSLPtr&, int ret) noexcept;
     SSLManager();
     ~SSLManager();
 };
@@ -0,0 +1,137 @@
+//
+// Created by Nevermore on 2026/10/17.
+// http-request Session
+// Copyright (c) 2024 Nevermore All rights reserved.
+//
+#pragma once
+
+#include "Request.h"
+#include "BodyStream.h"
+#include "ConnectionPool.h"
+#include "Connector.h"
+#include "DnsResolver.h"
+#include "EventLoop.h"
+#include "ResponseParser.h"
+#include "Url.h"
+
+namespace http {
+
+///the maximum number of reads per readable event, keeps the loop fair between sessions.
+///the loop is level triggered, a socket read until Retry is polled again when more bytes arrive
+constexpr int32_t kMaxReadCountPerEvent = 16;
+///a request is sent at most this many times more when the connection drops before its response
+constexpr uint8_t kMaxResendCount = 2;
+
+///https://www.rfc-editor.org/rfc/rfc9110#section-9.2.2, only the idempotent methods are safe to send again
+inline bool isIdempotent(HttpMethodType type) noexcept {
+    switch (type) {
+        case HttpMethodType::Get:
+        case HttpMethodType::Put:
+        case HttpMethodType::Delete:
+        case HttpMethodType::Options:
+            return true;
+        default:
+            return false;
+    }
+}
+
+///Traffic counters of the sessions owned by one loop, only written on that loop thread.
+struct SessionCounter {
+    std::atomic<uint64_t> sentBytes = 0;
+    std::atomic<uint64_t> receivedBytes = 0;
+};
+
+///Non-blocking request state machine driven by an EventLoop: resolve, connect, handshake, send, receive.
+///Every method must be called on the loop thread.
+class Session {
+public:
+    using FinishFunc = std::function<void(const std::string&)>;
+
+    Session(EventLoop& loop, RequestInfo&& info, ResponseHandler&& handler, std::string reqId, FinishFunc&& onFinish,
+            SessionCounter* counter = nullptr, ConnectionPool* pool = nullptr);
+    ~Session();
+    Session(const Session&) = delete;
+    Session& operator=(const Session&) = delete;
+
+    void start() noexcept;
+
+    ///open a new connection and hand it to the pool instead of sending the request,
+    ///onConnected is reported once it is parked, onError if it could not be opened
+    void preconnect() noexcept;
+
+    ///stop the session without any further callback
+    void cancel() noexcept;
+
+    [[nodiscard]] const std::string& getReqId() const noexcept {
+        return reqId_;
+    }
+
+private:
+    enum class State : uint8_t {
+        Idle,
+        Connect,
+        Handshake,
+        Send,
+        Receive,
+        Done,
+    };
+
+    ///isReuse false always opens a new connection, it is the retry of a stale pooled one
+    void sendRequest(bool isReuse = true) noexcept;
+    void redirect(const std::string& url) noexcept;
+    void onEvent(uint32_t events) noexcept;
+    ///a socket for the family of a resolved address, the connector races them
+    ISocket* createSocket(IPVersion ipVersion) noexcept;
+    void resolved(AddressInfoPtr address, int32_t errorCode) noexcept;
+    void connected(Connector::SocketPtr socket, SocketResult result) noexcept;
+    void handshake() noexcept;
+    ///the connection is ready, encode and send the request
+    void startSend() noexcept;
+    void send() noexcept;
+    void receive() noexcept;
+    void wait(SelectType type) noexcept;
+    ///arm the connect or read deadline, replacing the previous one
+    void startPhaseTimer(std::chrono::milliseconds timeout) noexcept;
+    void stopPhaseTimer() noexcept;
+    ///the preconnected socket goes idle in the pool
+    void park() noexcept;
+    ///a pooled connection closed by the server fails before any response byte, retry once on a new one
+    bool retryStaleSocket() noexcept;
+    void recycleSocket() noexcept;
+    void closeSocket() noexcept;
+    void handleErrorResponse(ResultCode code, int32_t errorCode) noexcept;
+    void disconnected() noexcept;
+    void release() noexcept;
+
+private:
+    EventLoop& loop_;
+    State state_ = State::Idle;
+    bool isValid_ = true;
+    bool isReusedSocket_ = false;
+    bool isRetry_ = false;
+    bool isPreconnect_ = false;
+    uint8_t redirectCount_ = 0;
+    uint64_t timerId_ = 0;
+    uint64_t phaseTimerId_ = 0;
+    RequestInfo info_;
+    ResponseHandler handler_;
+    RequestStats stats_;
+    ///monotonic, ms
+    std::chrono::milliseconds startTime_{0};
+    std::string reqId_;
+    FinishFunc onFinish_;
+    SessionCounter* counter_ = nullptr;
+    ConnectionPool* pool_ = nullptr;
+    std::unique_ptr<Url> url_;
+    std::string poolKey_;
+    std::unique_ptr<DnsQuery> query_;
+    std::unique_ptr<Connector> connector_;
+    std::unique_ptr<ISocket, decltype(&freeSocket)> socket_;
+    std::unique_ptr<ResponseParser> parser_;
+    std::unique_ptr<BodyStream> bodyStream_;
+    ///the request line and the headers, the body is sent from info_.body
+    std::string sendData_;
+    size_t sendPos_ = 0;
+};
+
+} //end of namespace http
@@ -7,8 +7,11 @@
 
 #include "Type.h"
 #include "Data.hpp"
+#include "Request.h"
 #include "Utility.h"
 #include <tuple>
+#include <utility>
+#include <vector>
 
 #if defined(_WIN32) || defined(__CYGWIN__)
 #pragma push_macro("WIN32_LEAN_AND_MEAN")
@@ -36,9 +39,11 @@ extern "C" char *_strdup(const char *strSource);
 #define GetLastError() WSAGetLastError()
 
 #else
+#include <arpa/inet.h>
 #include <cerrno>
 #include <fcntl.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <netdb.h>
 #include <sys/select.h>
 #include <sys/socket.h>
@@ -85,6 +90,8 @@ enum class SelectType{
 struct SocketResult {
     ResultCode resultCode = ResultCode::Success;
     int32_t errorCode = 0;
+    ///the readiness to wait for when resultCode is Retry
+    SelectType waitType = SelectType::Read;
 
     [[nodiscard]] bool isSuccess() const {
         return resultCode == ResultCode::Success;
@@ -93,6 +100,7 @@ struct SocketResult {
     void reset() noexcept {
         resultCode = ResultCode::Success;
         errorCode = 0;
+        waitType = SelectType::Read;
     }
 };
 
@@ -114,9 +122,45 @@ public:
     ///return ResultCode and error code, error code is last error number
     virtual SocketResult connect(const AddressInfoPtr& address, int64_t timeout) noexcept;
 
+    ///applied by the next connect
+    void setOptions(const SocketOptions& options) noexcept {
+        options_ = options;
+    }
+
+    ///with fast open the connect returns at once and the syn waits for the first send, applied by the next connect
+    void disableFastOpen() noexcept {
+        options_.isFastOpen = false;
+    }
+
+    ///start a non-blocking connect, Retry means the connection is in progress and the socket has to become writable
+    virtual SocketResult connectAsync(const addrinfo* address) noexcept;
+
+    ///check the result of an in-progress connect once the socket is writable
+    [[nodiscard]] virtual SocketResult connectResult() const noexcept;
+
+    ///advance the protocol handshake one step, Retry carries the readiness to wait for
+    virtual SocketResult handshake() noexcept {
+        return {};
+    }
+
+    ///blocking handshake until it is done or the timeout in ms passes
+    SocketResult finishHandshake(int64_t timeout) noexcept;
     ///return ResultCode and the number of bytes sent successfully
     [[nodiscard]] virtual std::tuple<SocketResult, int64_t> send(const std::string_view& data) const noexcept = 0;
 
+    ///send the buffers in order without joining them, the bytes sent may end in any of them.
+    ///return ResultCode and the number of bytes sent successfully, the default sends the first one only
+    [[nodiscard]] virtual std::tuple<SocketResult, int64_t> sendBuffers(const std::vector<DataView>& buffers) const noexcept;
+
+    ///sendFile moves the bytes of a file to the socket inside the kernel
+    [[nodiscard]] virtual bool isSendFileSupported() const noexcept {
+        return false;
+    }
+
+    ///send up to size bytes of the file from offset, the position of fd is not changed.
+    ///return ResultCode and the number of bytes sent successfully, Failed unless isSendFileSupported
+    [[nodiscard]] virtual std::tuple<SocketResult, int64_t> sendFile(int32_t fd, uint64_t offset, uint64_t size) const noexcept;
+
     ///return ResultCode and the received data
     [[nodiscard]] virtual std::tuple<SocketResult, DataPtr> receive() const noexcept = 0;
 
@@ -126,15 +170,49 @@ public:
     [[nodiscard]] virtual SocketResult canSend(int64_t timeout) const noexcept;
 
     [[nodiscard]] virtual SocketResult canReceive(int64_t timeout) const noexcept;
+
+    ///an idle connection is alive while nothing is readable, data or eof means the server gave up on it
+    [[nodiscard]] virtual bool isAlive() const noexcept;
+
+    ///the syn carried data and the server acknowledged it, false until the syn-ack arrived
+    [[nodiscard]] bool isFastOpen() const noexcept;
+
+    ///the request went out as early data in the handshake and the server accepted it, it must not be sent again
+    [[nodiscard]] virtual bool isEarlyDataAccepted() const noexcept {
+        return false;
+    }
+    ///detach the socket from the thread that used it before it goes idle in the pool, false if it cannot be reused
+    virtual bool prepareIdle() noexcept {
+        return true;
+    }
+
+    [[nodiscard]] Socket fd() const noexcept {
+        return socket_;
+    }
+
+    ///monotonic, ms
+    [[nodiscard]] std::chrono::milliseconds createTime() const noexcept {
+        return createTime_;
+    }
 protected:
     ResultCode config() noexcept;
+    ///set the socket options before the connect, the errno of a refused one
+    [[nodiscard]] SocketResult applyOptions() const noexcept;
 private:
     void checkConnectResult(SocketResult& result, int64_t timeout) const noexcept;
 protected:
     IPVersion ipVersion_ = IPVersion::V4;
     Socket socket_ = kInvalidSocket;
+    std::chrono::milliseconds createTime_;
+    SocketOptions options_;
+    ///the syn-ack settled whether the connection was opened with fast open
+    mutable bool isFastOpenKnown_ = false;
+    mutable bool isFastOpen_ = false;
 };
 
+///the part of the buffers after their first offset bytes, the empty ones are left out
+std::vector<DataView> skipBuffers(const std::vector<DataView>& buffers, uint64_t offset) noexcept;
+
 inline void freeSocket(ISocket* socket) noexcept {
     delete socket;
 }
@@ -15,20 +15,46 @@ namespace http {
 class TSLSocket final : public ISocket {
 public:
     explicit TSLSocket(IPVersion ipVersion = IPVersion::V4);
+    ///host is the server name, a session cached for host:port is resumed
+    TSLSocket(IPVersion ipVersion, const std::string& host, const std::string& port);
+    ~TSLSocket() override;
 
     SocketResult connect(const AddressInfoPtr& address, int64_t timeout) noexcept override;
 
+    ///one handshake step, Retry carries the readiness to wait for
+    SocketResult handshake() noexcept override;
+
     [[nodiscard]] std::tuple<SocketResult, int64_t> send(const std::string_view& data) const noexcept override;
 
+    ///a short first buffer shares its record with the start of the next ones instead of going out in a record of its own
+    [[nodiscard]] std::tuple<SocketResult, int64_t> sendBuffers(const std::vector<DataView>& buffers) const noexcept override;
+
     [[nodiscard]] std::tuple<SocketResult, DataPtr> receive() const noexcept override;
 
     [[nodiscard]] SocketResult canSend(int64_t timeout) const noexcept override;
 
     [[nodiscard]] SocketResult canReceive(int64_t timeout) const noexcept override;
 
+    [[nodiscard]] bool isAlive() const noexcept override;
+
     void close() noexcept override;
+
+    ///offer the protocols with ALPN, call it before the handshake
+    bool setAlpn(const std::vector<std::string>& protocols) noexcept;
+
+    ///the protocol selected by the server once the handshake is done
+    [[nodiscard]] std::string alpn() const noexcept;
+    ///send the data in the first flight when the resumed session allows enough early data, call it before the handshake
+    void setEarlyData(std::string data) noexcept;
+    [[nodiscard]] bool isEarlyDataAccepted() const noexcept override;
+    ///the next request on the pooled connection is sent normally
+    bool prepareIdle() noexcept override;
 private:
     SSLPtr sslPtr;
+    bool isHandshakeStarted_ = false;
+    ///cleared once it is written or when it cannot be sent early
+    std::string earlyData_;
+    bool isEarlyDataSent_ = false;
 };
 
 } //end of namespace http
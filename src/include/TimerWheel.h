@@ -0,0 +1,67 @@
+//
+// Created by Nevermore on 2026/10/17.
+// http-request TimerWheel
+// Copyright (c) 2024 Nevermore All rights reserved.
+//
+#pragma once
+
+#include <array>
+#include <functional>
+#include <list>
+#include <unordered_map>
+#include "Type.h"
+
+namespace http {
+
+///Hierarchical timing wheel with a 1ms tick, 4 levels of 64 slots span about 4.6 hours,
+///timers further out wait in the last level and cascade again.
+///Adding and canceling are O(1), not thread-safe, the times are in ms of a monotonic clock.
+class TimerWheel {
+public:
+    using Task = std::function<void()>;
+
+    explicit TimerWheel(int64_t now) noexcept;
+
+    ///return the timer id, never 0
+    uint64_t add(int64_t expireTime, Task&& task) noexcept;
+
+    ///return false if the timer already ran or was canceled
+    bool cancel(uint64_t timerId) noexcept;
+
+    ///run the timers expired at now, return the ms until the wheel needs to advance again, kInvalid if it is empty
+    int64_t advance(int64_t now) noexcept;
+
+    [[nodiscard]] size_t size() const noexcept {
+        return timers_.size();
+    }
+
+    void clear() noexcept;
+
+private:
+    struct Timer {
+        uint64_t id = 0;
+        int64_t expireTime = 0;
+        uint8_t level = 0;
+        uint8_t slot = 0;
+        Task task;
+    };
+    using Slot = std::list<Timer>;
+
+    static constexpr uint32_t kLevelCount = 4;
+    static constexpr uint32_t kSlotBits = 6;
+    static constexpr uint32_t kSlotCount = 1 << kSlotBits;
+    static constexpr uint32_t kSlotMask = kSlotCount - 1;
+
+    ///move the timers from the front of slot list into the slot matching their expire time
+    void place(Slot& from, Slot::iterator it) noexcept;
+    void cascade(uint32_t level) noexcept;
+    [[nodiscard]] int64_t nextTimeout() const noexcept;
+
+private:
+    int64_t current_ = 0;
+    uint64_t timerId_ = 0;
+    std::array<std::array<Slot, kSlotCount>, kLevelCount> wheels_;
+    std::unordered_map<uint64_t, Slot::iterator> timers_;
+};
+
+} //end of namespace http
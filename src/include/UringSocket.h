@@ -0,0 +1,78 @@
+//
+// Created by Nevermore on 2026/10/17.
+// http-request UringSocket
+// Copyright (c) 2024 Nevermore All rights reserved.
+//
+#pragma once
+
+#if ENABLE_IO_URING
+#include <memory>
+#include "Socket.h"
+
+namespace http {
+
+class UringRing;
+
+///Plain socket whose connect, send and receive are submitted to a per thread io_uring.
+///Waiting and the transfer happen in a single io_uring_enter instead of select plus send/recv,
+///receives use a multishot recv on a registered buffer ring when the kernel supports it, the received buffer is handed
+///out as it is and goes back to the ring once released.
+///A socket must be used and closed on one thread at a time, prepareIdle hands it over to another one.
+class UringSocket final : public ISocket {
+public:
+    explicit UringSocket(IPVersion ipVersion = IPVersion::V4);
+    ~UringSocket() override;
+
+    UringSocket(const UringSocket&) = delete;
+    UringSocket& operator=(const UringSocket&) = delete;
+
+    ///false if io_uring is disabled or lacks connect/send/sendmsg/recv, use PlainSocket instead
+    [[nodiscard]] static bool isSupported() noexcept;
+
+    SocketResult connect(const AddressInfoPtr& address, int64_t timeout) noexcept override;
+
+    ///the raced connects are non-blocking, the socket goes back to blocking for io_uring once it is connected
+    SocketResult connectAsync(const addrinfo* address) noexcept override;
+
+    [[nodiscard]] SocketResult connectResult() const noexcept override;
+
+    [[nodiscard]] std::tuple<SocketResult, int64_t> send(const std::string_view& data) const noexcept override;
+
+    ///one sendmsg with an iovec per buffer
+    [[nodiscard]] std::tuple<SocketResult, int64_t> sendBuffers(const std::vector<DataView>& buffers) const noexcept override;
+
+    [[nodiscard]] std::tuple<SocketResult, DataPtr> receive() const noexcept override;
+
+    void close() noexcept override;
+
+    ///only records the timeout of the next send, the send itself waits for the socket
+    [[nodiscard]] SocketResult canSend(int64_t timeout) const noexcept override;
+
+    ///wait for the next receive completion, the data is handed out by receive
+    [[nodiscard]] SocketResult canReceive(int64_t timeout) const noexcept override;
+
+    ///cancel the armed receive and drop the ring, the next operation uses the ring of its own thread
+    bool prepareIdle() noexcept override;
+
+private:
+    void setBlocking() const noexcept;
+    ///wait for the submitted send, bounded by the timeout of canSend
+    std::tuple<SocketResult, int64_t> waitSend(uint64_t id) const noexcept;
+    void armReceive() const noexcept;
+    UringRing* ring() const noexcept;
+
+private:
+    mutable std::shared_ptr<UringRing> ring_;
+    mutable int64_t sendTimeout_ = kInvalid;
+    mutable uint64_t receiveId_ = 0;
+    mutable bool isReceiveArmed_ = false;
+    ///the next receive goes into a pooled buffer instead of the buffer ring
+    mutable bool isPooledReceive_ = false;
+    mutable bool isReady_ = false;
+    mutable SocketResult readyResult_;
+    mutable DataPtr readyData_;
+};
+
+} //end of namespace http
+
+#endif //end if ENABLE_IO_URING
@@ -0,0 +1,31 @@
+//
+// Created by Nevermore on 2026/10/17.
+// http-request BufferPool
+// Copyright (c) 2024 Nevermore All rights reserved.
+//
+#pragma once
+
+#include <cstdint>
+
+namespace http {
+
+///Free lists of the receive buffers, a buffer is reused instead of going through malloc and free for every read.
+///The sizes are rounded up to a power of two from 4kb to 64kb, larger ones are not pooled. Every thread keeps a small
+///cache of each size and trades batches of them with a shared depot, so a buffer allocated on a loop thread and
+///released on the thread of the callback goes back into circulation. Buffers are not zeroed. Thread-safe.
+class BufferPool {
+public:
+    static constexpr uint64_t kMinSize = 4 * 1024;
+    static constexpr uint64_t kMaxSize = 64 * 1024;
+
+    ///a buffer of at least size bytes, capacity is its actual size, nullptr if size is not pooled
+    [[nodiscard]] static uint8_t* allocate(uint64_t size, uint64_t& capacity) noexcept;
+
+    ///give back a buffer of allocate with its capacity
+    static void release(uint8_t* data, uint64_t capacity) noexcept;
+
+    ///the buffers idle in the depot, the caches of the threads are not counted
+    [[nodiscard]] static uint64_t depotCount() noexcept;
+};
+
+} //end of namespace http
@@ -0,0 +1,95 @@
+//
+// Created by Nevermore on 2026/10/17.
+// http-request Client
+// Copyright (c) 2024 Nevermore All rights reserved.
+//
+#pragma once
+
+#include <vector>
+#include "Request.h"
+#if ENABLE_COROUTINE
+#include "Coroutine.h"
+#endif
+
+namespace http {
+
+class ClientImpl;
+
+extern void freeClientImpl(ClientImpl*) noexcept;
+
+enum class ShardPolicy : uint8_t {
+    RoundRobin,
+    HostHash, //!< requests to the same host:port always land on the same loop.
+    LeastLoaded, //!< the loop with the fewest requests in flight.
+};
+
+struct ClientConfig {
+    ///number of event loops, each one runs on its own thread and owns a shard of the requests, 0 means one per core, default 1
+    uint32_t loopCount = 1;
+    ShardPolicy shardPolicy = ShardPolicy::RoundRobin;
+    ///loop i is pinned to cpuAffinity[i % size], empty disables pinning, only linux and windows
+    std::vector<int32_t> cpuAffinity;
+    ///the idle keep-alive connections, every loop keeps its own ones and the limits apply per loop
+    ConnectionPoolConfig poolConfig;
+    ///the most requests with isPipelining waiting for their responses on one connection, default 8
+    uint32_t maxPipelineDepth = 8;
+    ///the most requests holding a connection to one origin and to all of them, 0 means no limit. The requests over
+    ///it wait and the origins take turns once connections free up. Pipelined and http/2 requests share one connection
+    ///per loop and origin and do not wait
+    uint32_t maxConnectionsPerOrigin = 0;
+    uint32_t maxConnections = 0;
+};
+
+struct ShardStats {
+    uint32_t index = 0;
+    ///the pinned cpu, kInvalid if the loop is not pinned
+    int32_t cpu = kInvalid;
+    ///requests in flight
+    uint64_t activeCount = 0;
+    ///requests dispatched since the client started
+    uint64_t totalCount = 0;
+    uint64_t sentBytes = 0;
+    uint64_t receivedBytes = 0;
+};
+
+///Drives many requests as non-blocking state machines on a small fixed number of event loop threads.
+///The ResponseHandler callbacks are invoked on the loop threads and must not block.
+class Client {
+public:
+    explicit Client(ClientConfig config = {});
+    ///stop the loops, the requests still in flight are dropped without callbacks
+    ~Client();
+    Client(const Client&) = delete;
+    Client& operator=(const Client&) = delete;
+
+    ///return reqId, data copying may result in some performance degradation
+    [[maybe_unused]] std::string request(const RequestInfo&, const ResponseHandler&);
+
+    ///return reqId
+    [[maybe_unused]] std::string request(RequestInfo&&, ResponseHandler&&);
+
+    ///no callback is invoked for the request after it is canceled
+    [[maybe_unused]] void cancel(const std::string& reqId) noexcept;
+
+    ///resolve the origin and open count connections into the pools of the loops the shard policy picks for it ahead of
+    ///the traffic, onFinish gets the number of them that are ready, on a loop thread. At most poolConfig.maxIdlePerHost
+    ///are kept per loop, http/1.1 only
+    [[maybe_unused]] void preconnect(const std::string& origin, uint32_t count = 1,
+                                     std::function<void(uint32_t)> onFinish = nullptr,
+                                     IPVersion ipVersion = IPVersion::Auto);
+
+    ///per loop counters to observe the load skew across shards
+    [[maybe_unused]] [[nodiscard]] std::vector<ShardStats> shardStats() const noexcept;
+
+#if ENABLE_COROUTINE
+    ///co_await client.get(url), the request starts immediately
+    [[maybe_unused]] [[nodiscard]] ResponseAwaiter get(const std::string& url);
+
+    ///co_await client.send(info), the request starts immediately
+    [[maybe_unused]] [[nodiscard]] ResponseAwaiter send(RequestInfo&& info);
+#endif
+private:
+    std::unique_ptr<ClientImpl, decltype(&freeClientImpl)> impl_;
+};
+
+}//end of namespace http
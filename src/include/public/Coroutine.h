@@ -0,0 +1,159 @@
+//
+// Created by Nevermore on 2026/10/17.
+// http-request Coroutine
+// Copyright (c) 2024 Nevermore All rights reserved.
+//
+#pragma once
+
+#if ENABLE_COROUTINE
+#include <coroutine>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include "Request.h"
+
+namespace http {
+
+///Buffers the callbacks of one request until the coroutine awaiting it asks for them.
+///The coroutine is resumed on the loop thread that drives the request, so it must not block.
+class ResponseState {
+public:
+    ///ResponseHandler that feeds the state
+    [[nodiscard]] static ResponseHandler makeHandler(const std::shared_ptr<ResponseState>& state) noexcept;
+
+    ///return false if the header or the end of the response has already arrived
+    bool suspendForHeader(std::coroutine_handle<> handle) noexcept;
+
+    ///return false if a chunk or the end of the response has already arrived
+    bool suspendForChunk(std::coroutine_handle<> handle) noexcept;
+
+    [[nodiscard]] std::optional<ResponseHeader> takeHeader() noexcept;
+
+    ///nullptr once the response is finished
+    [[nodiscard]] DataPtr takeChunk() noexcept;
+
+    [[nodiscard]] ErrorInfo error() noexcept {
+        std::lock_guard lock(mutex_);
+        return error_;
+    }
+
+private:
+    void onHeader(ResponseHeader&& header) noexcept;
+    void onData(DataPtr data) noexcept;
+    void onError(ErrorInfo error) noexcept;
+    void onFinished() noexcept;
+    ///resume the waiting coroutine outside the lock
+    void resume(std::unique_lock<std::mutex>& lock) noexcept;
+
+private:
+    std::mutex mutex_;
+    std::optional<ResponseHeader> header_;
+    bool isHeaderTaken_ = false;
+    std::deque<DataPtr> chunks_;
+    bool isFinished_ = false;
+    ErrorInfo error_;
+    std::coroutine_handle<> waiter_ = nullptr;
+};
+
+using ResponseStatePtr = std::shared_ptr<ResponseState>;
+
+struct ChunkAwaiter {
+    ResponseStatePtr state;
+
+    [[nodiscard]] bool await_ready() const noexcept {
+        return false;
+    }
+
+    bool await_suspend(std::coroutine_handle<> handle) noexcept {
+        return state->suspendForChunk(handle);
+    }
+
+    ///nullptr once the response is finished
+    DataPtr await_resume() noexcept {
+        return state->takeChunk();
+    }
+};
+
+class Response {
+public:
+    Response(ResponseStatePtr state, std::string reqId) noexcept
+        : state_(std::move(state))
+        , reqId_(std::move(reqId)) {
+        header_ = state_->takeHeader();
+    }
+
+    ///pass it to Client::cancel, a canceled response never resumes the coroutine again
+    [[nodiscard]] const std::string& reqId() const noexcept {
+        return reqId_;
+    }
+
+    ///empty if the request failed before the header was parsed
+    [[nodiscard]] const std::optional<ResponseHeader>& header() const noexcept {
+        return header_;
+    }
+
+    [[nodiscard]] bool isSuccess() const noexcept {
+        return header_.has_value() && state_->error().retCode == ResultCode::Success;
+    }
+
+    [[nodiscard]] ErrorInfo error() const noexcept {
+        return state_->error();
+    }
+
+    ///co_await response.nextChunk(), yields nullptr at the end of the body
+    [[nodiscard]] ChunkAwaiter nextChunk() const noexcept {
+        return ChunkAwaiter{state_};
+    }
+
+private:
+    ResponseStatePtr state_;
+    std::string reqId_;
+    std::optional<ResponseHeader> header_;
+};
+
+///co_await client.get(url), resumes once the response header is parsed or the request fails
+struct ResponseAwaiter {
+    ResponseStatePtr state;
+    std::string reqId;
+
+    [[nodiscard]] bool await_ready() const noexcept {
+        return false;
+    }
+
+    bool await_suspend(std::coroutine_handle<> handle) noexcept {
+        return state->suspendForHeader(handle);
+    }
+
+    Response await_resume() noexcept {
+        return Response(state, reqId);
+    }
+};
+
+///Fire-and-forget coroutine type, the frame is destroyed when the coroutine finishes.
+struct DetachedTask {
+    struct promise_type {
+        DetachedTask get_return_object() noexcept {
+            return {};
+        }
+
+        std::suspend_never initial_suspend() noexcept {
+            return {};
+        }
+
+        std::suspend_never final_suspend() noexcept {
+            return {};
+        }
+
+        void return_void() noexcept {
+
+        }
+
+        void unhandled_exception() noexcept {
+            std::terminate();
+        }
+    };
+};
+
+} //end of namespace http
+
+#endif //end if ENABLE_COROUTINE
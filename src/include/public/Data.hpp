@@ -11,6 +11,7 @@
 #include <string_view>
 #include <string>
 #include <functional>
+#include "BufferPool.h"
 
 namespace http {
 
@@ -23,6 +24,10 @@ struct Data {
     uint64_t capacity = 0;
     uint64_t length = 0;
     uint8_t* rawData = nullptr;
+    ///rawData came from the BufferPool and goes back to it
+    bool isPooled = false;
+    ///set on a slice, the buffer rawData points into, the bytes are shared and not owned
+    DataRefPtr owner;
 
     Data()
         : capacity(0)
@@ -72,10 +77,13 @@ struct Data {
     Data(Data&& data) noexcept
         : capacity (data.capacity)
         , length (data.length)
-        , rawData(data.rawData) {
+        , rawData(data.rawData)
+        , isPooled(data.isPooled)
+        , owner(std::move(data.owner)) {
         data.rawData = nullptr;
         data.length = 0;
         data.capacity = 0;
+        data.isPooled = false;
     }
 
     Data& operator=(const Data& data) {
@@ -98,7 +106,10 @@ struct Data {
         capacity = data.capacity;
         length = data.length;
         rawData = data.rawData;
+        isPooled = data.isPooled;
+        owner = std::move(data.owner);
         data.rawData = nullptr;
+        data.isPooled = false;
         return *this;
     }
 
@@ -119,6 +130,38 @@ struct Data {
 #pragma clang diagnostic pop
 #endif
 
+    ///a receive buffer of at least size bytes from the BufferPool, the bytes are not zeroed
+    [[nodiscard]] static inline DataPtr makePooled(uint64_t size) noexcept {
+        auto res = std::make_unique<Data>();
+        res->rawData = BufferPool::allocate(size, res->capacity);
+        if (res->rawData) {
+            res->isPooled = true;
+        } else {
+            res->rawData = new uint8_t[size];
+            res->capacity = size;
+        }
+        return res;
+    }
+
+    ///a view of len bytes of buffer from pos without copying them, the slice keeps the buffer alive.
+    ///the bytes are shared with the buffer and its other slices, appending to or resizing a slice copies them first
+    [[nodiscard]] static inline DataPtr slice(const DataRefPtr& buffer, uint64_t pos, uint64_t len) noexcept {
+        auto res = std::make_unique<Data>();
+        if (buffer == nullptr || pos >= buffer->length || len == 0) {
+            return res;
+        }
+        res->rawData = buffer->rawData + pos;
+        res->length = std::min(len, buffer->length - pos);
+        res->capacity = res->length;
+        ///a slice of a slice refers to the buffer owning the bytes
+        res->owner = buffer->owner ? buffer->owner : buffer;
+        return res;
+    }
+
+    [[nodiscard]] inline bool isSlice() const noexcept {
+        return owner != nullptr;
+    }
+
     [[nodiscard]] inline DataPtr copy() const noexcept {
         return this->copy(0, static_cast<int64_t>(length));
     }
@@ -141,16 +184,44 @@ struct Data {
     }
 
     inline void destroy() noexcept {
-        if (rawData) {
-            delete [] rawData;
-            rawData = nullptr;
+        if (owner) {
+            owner.reset();
+        } else {
+            freeBuffer(rawData, capacity, isPooled);
         }
+        rawData = nullptr;
+        isPooled = false;
         length = 0;
         capacity = 0;
     }
 
+    static inline void freeBuffer(uint8_t* buffer, uint64_t bufferCapacity, bool isPooledBuffer) noexcept {
+        if (buffer == nullptr) {
+            return;
+        }
+        if (isPooledBuffer) {
+            BufferPool::release(buffer, bufferCapacity);
+        } else {
+            delete [] buffer;
+        }
+    }
+
+    ///rawData moved to a new buffer, let go of the old one
+    inline void releaseBuffer(uint8_t* buffer, uint64_t bufferCapacity) noexcept {
+        if (owner) {
+            owner.reset();
+        } else {
+            freeBuffer(buffer, bufferCapacity, isPooled);
+        }
+        isPooled = false;
+    }
+
     [[maybe_unused]]
     inline void resetData() noexcept {
+        if (owner) {
+            destroy();
+            return;
+        }
         if (rawData) {
             std::fill_n(rawData, capacity, 0);
         }
@@ -170,9 +241,9 @@ struct Data {
         rawData = new uint8_t [size];
         auto contentLength = std::min(size, length);
         std::copy(p, p + contentLength, rawData);
+        releaseBuffer(p, capacity);
         length = contentLength;
         capacity = size;
-        delete[] p;
     }
 
     inline DataPtr detachData() {
@@ -180,9 +251,12 @@ struct Data {
         res->length = length;
         res->capacity = capacity;
         res->rawData = rawData;
+        res->isPooled = isPooled;
+        res->owner = std::move(owner);
         length = 0;
         capacity = 0;
         rawData = nullptr;
+        isPooled = false;
         return res;
     }
 
@@ -194,13 +268,14 @@ struct Data {
         auto expectLength = length + d.length;
         if (capacity < expectLength) {
             auto p = rawData;
+            auto oldCapacity = capacity;
             auto len = static_cast<int64_t>(static_cast<float>(expectLength) * 1.5f);
             rawData = new uint8_t[static_cast<size_t>(len)];
             capacity = static_cast<uint64_t>(len);
             if (p) {
                 std::copy(p, p + length, rawData);
-                delete[] p;
             }
+            releaseBuffer(p, oldCapacity);
         }
         std::copy(d.rawData, d.rawData + d.length, rawData + length);
         length = expectLength;
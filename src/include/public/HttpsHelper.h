@@ -12,9 +12,22 @@ namespace http {
 using SSLPtr = std::unique_ptr<SSL, decltype(&SSL_free)>;
 using SSLContextPtr = std::unique_ptr<SSL_CTX, decltype(&SSL_CTX_free)>;
 
+struct TlsSessionStats {
+    ///handshakes that resumed a cached session
+    uint64_t hitCount = 0;
+    ///full handshakes
+    uint64_t missCount = 0;
+};
+
 class HttpsHelper {
 public:
     static std::function<void(SSLContextPtr&)> configContext;
+
+    ///resumed and full handshakes since the start, the sessions are cached per host:port
+    [[maybe_unused]] [[nodiscard]] static TlsSessionStats sessionStats() noexcept;
+
+    ///drop the cached sessions, the next connection to every origin makes a full handshake
+    [[maybe_unused]] static void clearSessionCache() noexcept;
 };
 
 } //end of namespace http
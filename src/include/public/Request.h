@@ -8,6 +8,7 @@
 #include <atomic>
 #include "Data.hpp"
 #include "Type.h"
+#include "RequestExecutor.h"
 
 #if ENABLE_HTTPS
 #include "HttpsHelper.h"
@@ -19,23 +20,139 @@ class ISocket;
 
 class Url;
 
+class BodyStream;
+
 extern void freeSocket(ISocket*) noexcept;
 
 extern void freeUrl(Url*) noexcept;
 
+extern void freeBodyStream(BodyStream*) noexcept;
+
 struct ResponseHeader;
 
+class ResponseParser;
+
+///Idle keep-alive connections kept per scheme://host:port
+struct ConnectionPoolConfig {
+    ///0 disables the reuse, default 6
+    uint32_t maxIdlePerHost = 6;
+    ///an idle connection older than this is closed, default 60s
+    std::chrono::milliseconds idleTimeout{60 * 1000};
+    ///a connection is not reused after this long since it was opened, default 10min
+    std::chrono::milliseconds maxLifetime{10 * 60 * 1000};
+};
+
+///Resolved hosts shared by all the requests of the process
+struct DnsCacheConfig {
+    ///how long the addresses of a host are used, default 60s
+    std::chrono::milliseconds ttl{60 * 1000};
+    ///how long a failed lookup is remembered, 0 disables it, default 5s
+    std::chrono::milliseconds negativeTtl{5 * 1000};
+    ///the least recently used host is dropped beyond it, 0 disables the cache, default 1024
+    uint32_t maxEntries = 1024;
+    ///an expired host is still used while it is resolved again in the background, default true
+    bool isStaleWhileRefresh = true;
+};
+
+///Applied to every new connection of a request before it connects, a pooled connection is only reused with the same ones.
+///0, kInvalid or empty keeps the system default, an option the platform lacks is skipped
+struct SocketOptions {
+    ///TCP_NODELAY, small requests and responses are not held back by nagle, default true
+    bool isNoDelay = true;
+    ///SO_SNDBUF and SO_RCVBUF in bytes, size them to the bandwidth-delay product of the link
+    int32_t sendBufferSize = 0;
+    int32_t receiveBufferSize = 0;
+    ///SO_KEEPALIVE with the idle time before the first probe, the interval between the probes and their count
+    std::chrono::seconds keepAliveIdle{0};
+    std::chrono::seconds keepAliveInterval{0};
+    int32_t keepAliveCount = 0;
+    ///TCP_USER_TIMEOUT, linux only, the connection fails once sent data stays unacknowledged this long
+    std::chrono::milliseconds userTimeout{0};
+    ///IP_TOS or IPV6_TCLASS, the dscp is tos >> 2
+    int32_t tos = kInvalid;
+    ///SO_BINDTODEVICE, linux only
+    std::string interface;
+    ///a numeric ip the connection is sent from, the address family of the other one fails to connect
+    std::string sourceAddress;
+    ///TCP_FASTOPEN_CONNECT, linux only, the first bytes of the request or the ClientHello ride on the syn once the server
+    ///handed out a cookie. Without kernel or server support the connection opens with the usual handshake. It is
+    ///skipped when the host resolves to several addresses, their connects race and only a real handshake can win
+    bool isFastOpen = false;
+};
+
+///The built-in resolver asks the nameservers over udp without blocking the loop threads of the clients
+struct DnsResolverConfig {
+    ///default false, getaddrinfo is used
+    bool isEnabled = false;
+    ///"ip", "ip:port" or "[ipv6]:port", empty reads the nameservers of /etc/resolv.conf, getaddrinfo is used without any
+    std::vector<std::string> nameservers;
+    ///how long a nameserver is waited for before the next one is asked, default 2s
+    std::chrono::milliseconds attemptTimeout{2 * 1000};
+    ///the rounds over all the nameservers, default 2
+    uint32_t attempts = 2;
+};
+
+///a file sent as the request body
+struct BodyFile {
+    ///opened for the request and closed after it, used when fd is -1
+    std::string path;
+    ///an open file, it is not closed and has to stay open until the request finished, default -1
+    int32_t fd = -1;
+    ///the first byte to send
+    uint64_t offset = 0;
+    ///-1 sends up to the end of the file, default -1
+    int64_t length = -1;
+
+    [[nodiscard]] inline bool empty() const noexcept {
+        return fd < 0 && path.empty();
+    }
+};
+
 struct RequestInfo {
     ///default true
     bool isAllowRedirect = true;
+    ///return the connection to the pool once the response is fully read, false sends Connection: close, default true
+    bool isKeepAlive = true;
+    ///Client only, an idempotent request may be written behind the ones still waiting for their responses, default false
+    bool isPipelining = false;
+    ///Client only, Http2 multiplexes the requests to one origin on a single connection, https falls back to http/1.1
+    ///when the server does not select h2, default Http1_1
+    HttpVersion httpVersion = HttpVersion::Http1_1;
+    ///GET and OPTIONS over https only, a new connection that resumes a tls 1.3 session sends the request as early data,
+    ///it is sent again after the handshake when the server rejects it. Early data can be replayed, default false
+    bool isEarlyData = false;
+    ///Client only, GET without a body. Identical requests in flight at the same time, same url, headers and
+    ///settings (redirects, versions, timeouts, socket options), share one request: every handler gets the response.
+    ///A request joins until the response header arrived, canceling it only detaches its handler, default false
+    bool isCoalescing = false;
     ///default V4
     IPVersion ipVersion = IPVersion::Auto;
     std::string url;
     HttpMethodType methodType = HttpMethodType::Unknown;
     std::unordered_map<std::string, std::string> headers;
     DataRefPtr body = nullptr;
+    ///a body produced while it is sent, used when body is empty. Write up to size bytes into buffer and return
+    ///the count, 0 ends the body and a negative value fails the request with BodyReadFailed. It is called on the
+    ///thread sending the request, the next time only once the previous part is written to the socket.
+    ///It can not be sent twice: a stale pooled connection is not retried once it started and a redirect response
+    ///is delivered as it is. Http2, pipelining and coalescing do not apply to it
+    std::function<int64_t(uint8_t* buffer, uint64_t size)> bodyReader = nullptr;
+    ///the length of the body of bodyReader, -1 sends it with Transfer-Encoding: chunked, default -1
+    int64_t bodyLength = -1;
+    ///a file as the body, used when body is empty, before bodyReader. Plain connections send it with sendfile,
+    ///tls reads it into a 64kb buffer a part at a time. A file that can not be read or shrinks while it is sent fails
+    ///the request with BodyReadFailed, as it always does on windows. Redirects, http2, pipelining, coalescing and
+    ///early data do not apply to it
+    BodyFile bodyFile;
     ///default 30s
     std::chrono::milliseconds timeout{60 * 1000};
+    ///deadline of connect and handshake, 0 means only the total timeout applies
+    std::chrono::milliseconds connectTimeout{0};
+    ///the longest wait for the next received bytes, 0 means only the total timeout applies
+    std::chrono::milliseconds readTimeout{0};
+    ///the next resolved address is tried when the previous connect is still pending after it, families alternate, default 250ms
+    std::chrono::milliseconds connectionAttemptDelay{250};
+    SocketOptions socketOptions;
 
     [[nodiscard]] inline uint64_t bodySize() const noexcept {
         return body ? body->length : 0;
@@ -44,6 +161,15 @@ struct RequestInfo {
     [[nodiscard]] inline bool bodyEmpty() const noexcept {
         return !body || body->empty();
     }
+
+    [[nodiscard]] inline bool isBodyFile() const noexcept {
+        return !bodyFile.empty() && bodyEmpty();
+    }
+
+    ///the body is sent from bodyFile or bodyReader while the request goes out
+    [[nodiscard]] inline bool isBodyStreamed() const noexcept {
+        return isBodyFile() || (bodyReader != nullptr && bodyEmpty());
+    }
 };
 
 struct ErrorInfo {
@@ -70,6 +196,16 @@ struct ResponseHeader {
     ResponseHeader() = default;
 };
 
+///How a request went, reported right before onDisconnected
+struct RequestStats {
+    ///the syn of the connection carried data and the server accepted it, see SocketOptions::isFastOpen
+    bool isFastOpen = false;
+    ///waiting for a connection slot of the Client or for a thread of the RequestExecutor
+    std::chrono::milliseconds queueTime{0};
+    ///from the start of the request to its end: resolve, connect, send and receive
+    std::chrono::milliseconds networkTime{0};
+};
+
 struct ResponseHandler {
     ///reqId
     using OnConnectedFunc = std::function<void(std::string_view)>;
@@ -90,6 +226,10 @@ struct ResponseHandler {
     ///reqId, ErrorInfo
     using OnErrorFunc = std::function<void(std::string_view, ErrorInfo)>;
     OnErrorFunc onError = nullptr;
+
+    ///reqId, RequestStats
+    using OnStatsFunc = std::function<void(std::string_view, const RequestStats&)>;
+    OnStatsFunc onStats = nullptr;
 };
 
 class Request {
@@ -97,11 +237,45 @@ public:
     static bool init();
     static void clear();
 
+    ///requests constructed without an executor run on this one, nullptr spawns a thread per request
+    [[maybe_unused]] static void setDefaultExecutor(std::shared_ptr<RequestExecutor> executor) noexcept;
+
+    ///configure the connection pool shared by all the requests, the idle connections over the new limits are closed
+    [[maybe_unused]] static void setConnectionPoolConfig(const ConnectionPoolConfig& config) noexcept;
+
+    ///configure the dns cache shared by all the requests and clients, the hosts over the new limit are dropped
+    [[maybe_unused]] static void setDnsCacheConfig(const DnsCacheConfig& config) noexcept;
+
+    ///host:port always resolves to the addresses, like curl --resolve, empty addresses remove the override
+    [[maybe_unused]] static void setHostOverride(const std::string& host, const std::string& port,
+                                                 const std::vector<std::string>& addresses) noexcept;
+
+    ///forget the resolved hosts, the overrides are kept
+    [[maybe_unused]] static void clearDnsCache() noexcept;
+
+    ///configure the built-in resolver, the hosts missing from the dns cache are resolved by it once it is enabled
+    [[maybe_unused]] static void setDnsResolverConfig(const DnsResolverConfig& config) noexcept;
+
+    ///create the tls context and run HttpsHelper::configContext now instead of in the first https request
+    [[maybe_unused]] static void warmUp() noexcept;
+
+    ///resolve the origin and open count connections into the shared pool ahead of the traffic, blocking,
+    ///return the number of them that are ready. At most maxIdlePerHost of the pool config are kept
+    [[maybe_unused]] static uint32_t preconnect(const std::string& origin, uint32_t count = 1,
+                                                IPVersion ipVersion = IPVersion::Auto) noexcept;
+
 public:
     ///Data copying may result in some performance degradation
     [[maybe_unused]] explicit Request(const RequestInfo&, const ResponseHandler& );
 
     [[maybe_unused]] explicit Request(RequestInfo&&, ResponseHandler&&);
+
+    ///run on the executor instead of a dedicated thread
+    [[maybe_unused]] explicit Request(const RequestInfo&, const ResponseHandler&, std::shared_ptr<RequestExecutor> executor);
+
+    [[maybe_unused]] explicit Request(RequestInfo&&, ResponseHandler&&, std::shared_ptr<RequestExecutor> executor);
+
+    ///wait for the request to finish, including one still queued on the executor
     ~Request();
 
     [[maybe_unused]] void cancel() noexcept {
@@ -113,27 +287,43 @@ public:
     }
 private:
     void config() noexcept;
-    void sendRequest() noexcept;
+    ///isReuse false always opens a new connection, it is the retry of a stale pooled one
+    void sendRequest(bool isReuse = true) noexcept;
+    ///a socket for the family of a resolved address, the connects to the addresses are raced
+    ISocket* createSocket(IPVersion ipVersion) noexcept;
+    ///a pooled connection closed by the server fails before any response byte, retry once on a new one
+    bool retryStaleSocket() noexcept;
+    void recycleSocket(const ResponseParser& parser) noexcept;
     void redirect(const std::string&) noexcept;
     void process() noexcept;
     int64_t getRemainTime() const noexcept;
+    ///the remain time bounded by the timeout of the current phase
+    int64_t getRemainTime(std::chrono::milliseconds phaseTimeout) const noexcept;
     bool send() noexcept;
     bool isReceivable() noexcept;
     void receive() noexcept;
-    bool parseChunk(DataPtr& data, int64_t& chunkSize, bool& isCompleted) noexcept;
     void responseHeader(ResponseHeader&&) noexcept;
     void responseData(DataPtr data) noexcept;
     void handleErrorResponse(ResultCode code, int32_t errorCode) noexcept;
     void disconnected() noexcept;
 private:
     uint8_t redirectCount_ = 0;
+    bool isReusedSocket_ = false;
+    ///plain http through the io_uring of the worker thread
+    bool isUring_ = false;
     std::atomic<bool> isValid_ = true;
-    uint64_t startStamp_ = 0;
+    ///monotonic, ms
+    std::chrono::milliseconds startTime_{0};
     RequestInfo info_;
     ResponseHandler handler_;
+    RequestStats stats_;
     std::unique_ptr<ISocket, decltype(&freeSocket)> socket_;
     std::unique_ptr<Url, decltype(&freeUrl)> url_;
+    std::unique_ptr<BodyStream, decltype(&freeBodyStream)> bodyStream_;
+    std::string poolKey_;
     std::unique_ptr<std::thread> worker_ = nullptr;
+    std::shared_ptr<RequestExecutor> executor_;
+    ExecutorTaskPtr task_;
     std::string reqId_;
 };
 
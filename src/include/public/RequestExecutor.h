@@ -0,0 +1,83 @@
+//
+// Created by Nevermore on 2026/10/17.
+// http-request RequestExecutor
+// Copyright (c) 2024 Nevermore All rights reserved.
+//
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace http {
+
+enum class RejectPolicy : uint8_t {
+    Reject, //!< report ResultCode::Rejected through ResponseHandler::onError.
+    CallerRuns, //!< run the request on the submitting thread.
+    Block, //!< wait until the queue has room.
+    DiscardOldest, //!< reject the oldest queued request to make room.
+};
+
+struct ExecutorConfig {
+    ///worker threads are created on demand up to this count, default 4
+    uint32_t maxThreads = 4;
+    ///requests waiting for a worker, default 1024
+    uint32_t queueDepth = 1024;
+    RejectPolicy rejectPolicy = RejectPolicy::Reject;
+};
+
+struct ExecutorTask {
+    enum class State : uint8_t {
+        Queued,
+        Running,
+        Done,
+    };
+    std::function<void()> run;
+    std::function<void()> reject;
+    std::mutex mutex;
+    std::condition_variable cond;
+    State state = State::Queued;
+};
+
+using ExecutorTaskPtr = std::shared_ptr<ExecutorTask>;
+
+///Bounded worker pool with a submission queue, shared by the requests constructed with it.
+class RequestExecutor {
+public:
+    explicit RequestExecutor(ExecutorConfig config = {});
+    ///the tasks still queued are rejected
+    ~RequestExecutor();
+    RequestExecutor(const RequestExecutor&) = delete;
+    RequestExecutor& operator=(const RequestExecutor&) = delete;
+
+    ///run the task on a worker, task->reject is invoked if the queue is full and the policy rejects it
+    void submit(const ExecutorTaskPtr& task) noexcept;
+
+    ///wait until the task is done
+    static void wait(const ExecutorTaskPtr& task) noexcept;
+
+    [[nodiscard]] size_t queueSize() noexcept;
+
+    [[nodiscard]] size_t threadCount() noexcept;
+
+    ///true on a worker thread of any executor, it lives until its executor is destroyed
+    [[nodiscard]] static bool isWorkerThread() noexcept;
+private:
+    static void execute(const ExecutorTaskPtr& task, bool isReject) noexcept;
+    void work() noexcept;
+private:
+    ExecutorConfig config_;
+    bool isRunning_ = true;
+    uint32_t idleCount_ = 0;
+    std::mutex mutex_;
+    std::condition_variable taskCond_;
+    std::condition_variable spaceCond_;
+    std::deque<ExecutorTaskPtr> tasks_;
+    std::vector<std::thread> workers_;
+};
+
+} //end of namespace http
@@ -32,6 +32,11 @@ enum class HttpMethodType : uint8_t {
     Options = 6,
 };
 
+enum class HttpVersion : uint8_t {
+    Http1_1,
+    Http2, //!< h2 negotiated with ALPN over tls, h2c with prior knowledge over plain http.
+};
+
 enum class HttpStatusCode : uint16_t {
     Unknown,
     /*####### 1xx - Informational #######*/
@@ -148,6 +153,11 @@ enum class ResultCode {
     RedirectError,
     RedirectReachMaxCount,
     ChunkSizeError,
+    Rejected, //!< the executor queue is full.
+    ProtocolError, //!< the server broke the http/2 protocol, errorCode is the http/2 error code.
+    StreamReset, //!< the server reset the http/2 stream, errorCode is the http/2 error code.
+    SetOptionFailed, //!< a SocketOptions value was refused, errorCode is the last error number.
+    BodyReadFailed, //!< the bodyReader or the bodyFile failed, or ended before the length of the body.
 };
 #ifdef __clang__
 #pragma clang diagnostic pop
@@ -48,6 +48,8 @@ struct Time {
     };
     static TimeStamp nowTimeStamp() noexcept;
     static std::chrono::milliseconds nowTime() noexcept;
+    ///monotonic coarse clock for deadlines, immune to wall clock changes
+    static std::chrono::milliseconds steadyTime() noexcept;
 };
 
 } // end of namespace http::util
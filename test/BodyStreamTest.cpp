@@ -0,0 +1,57 @@
+//
+// Created by Nevermore on 2026/10/17.
+// http-request BodyStreamTest
+// Copyright (c) 2024 Nevermore All rights reserved.
+//
+#include <gtest/gtest.h>
+#include "../src/include/BodyStream.h"
+
+using namespace http;
+
+namespace {
+
+///takes every byte at once without sendfile, like a tls socket
+class BufferSocket : public ISocket {
+public:
+    [[nodiscard]] std::tuple<SocketResult, int64_t> send(const std::string_view& data) const noexcept override {
+        sent.append(data);
+        return {SocketResult(), static_cast<int64_t>(data.size())};
+    }
+
+    [[nodiscard]] std::tuple<SocketResult, DataPtr> receive() const noexcept override {
+        return {SocketResult(), nullptr};
+    }
+
+    mutable std::string sent;
+};
+
+} //end of namespace
+
+#if !defined(_WIN32)
+TEST(BodyStream, TruncatedFile) {
+    const std::string content(200 * 1024, 'x');
+    char path[] = "/tmp/http_body_stream_XXXXXX";
+    auto fd = mkstemp(path);
+    ASSERT_GE(fd, 0);
+    ASSERT_EQ(write(fd, content.data(), content.size()), static_cast<ssize_t>(content.size()));
+    RequestInfo info;
+    info.bodyFile.fd = fd;
+    BodyStream stream(info);
+    ASSERT_FALSE(stream.isFailed());
+    BufferSocket socket;
+    auto [result, sendSize] = stream.send(socket);
+    ASSERT_TRUE(result.isSuccess());
+    ASSERT_GT(sendSize, 0);
+
+    ///the rest of the file is gone, the stream fails instead of touching pages past the end
+    ASSERT_EQ(ftruncate(fd, sendSize), 0);
+    while (result.isSuccess()) {
+        std::tie(result, sendSize) = stream.send(socket);
+    }
+    ASSERT_EQ(result.resultCode, ResultCode::BodyReadFailed);
+    ASSERT_EQ(socket.sent, content.substr(0, socket.sent.size()));
+    ASSERT_LT(socket.sent.size(), content.size());
+    ::close(fd);
+    ::unlink(path);
+}
+#endif
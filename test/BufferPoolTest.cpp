@@ -0,0 +1,85 @@
+//
+// Created by Nevermore on 2026/10/17.
+// http-request BufferPoolTest
+// Copyright (c) 2024 Nevermore All rights reserved.
+//
+#include <gtest/gtest.h>
+#include <set>
+#include <thread>
+#include "BufferPool.h"
+#include "Data.hpp"
+
+using namespace http;
+
+TEST(BufferPool, SizeClass) {
+    uint64_t capacity = 0;
+    auto buffer = BufferPool::allocate(100, capacity);
+    ASSERT_NE(buffer, nullptr);
+    ASSERT_EQ(capacity, BufferPool::kMinSize);
+    BufferPool::release(buffer, capacity);
+    buffer = BufferPool::allocate(BufferPool::kMinSize + 1, capacity);
+    ASSERT_EQ(capacity, 2 * BufferPool::kMinSize);
+    BufferPool::release(buffer, capacity);
+    ASSERT_EQ(BufferPool::allocate(BufferPool::kMaxSize + 1, capacity), nullptr);
+    ASSERT_EQ(capacity, 0u);
+}
+
+TEST(BufferPool, Reuse) {
+    uint64_t capacity = 0;
+    auto buffer = BufferPool::allocate(BufferPool::kMinSize, capacity);
+    BufferPool::release(buffer, capacity);
+    ///the last released buffer of the thread is handed out first
+    ASSERT_EQ(BufferPool::allocate(BufferPool::kMinSize, capacity), buffer);
+    BufferPool::release(buffer, capacity);
+}
+
+TEST(BufferPool, Depot) {
+    constexpr size_t kBufferCount = 100;
+    constexpr uint64_t kSize = 32 * 1024;
+    std::vector<uint8_t*> buffers;
+    uint64_t capacity = 0;
+    for (size_t i = 0; i < kBufferCount; i++) {
+        buffers.push_back(BufferPool::allocate(kSize, capacity));
+    }
+    auto depotCount = BufferPool::depotCount();
+    ///released on another thread, its cache overflows into the depot and is flushed there when it exits
+    std::thread([&buffers, capacity] {
+        for (auto buffer : buffers) {
+            BufferPool::release(buffer, capacity);
+        }
+    }).join();
+    ASSERT_EQ(BufferPool::depotCount(), depotCount + kBufferCount);
+    std::set<uint8_t*> released(buffers.begin(), buffers.end());
+    auto buffer = BufferPool::allocate(kSize, capacity);
+    ASSERT_EQ(released.count(buffer), 1u);
+    BufferPool::release(buffer, capacity);
+}
+
+TEST(BufferPool, Data) {
+    auto data = Data::makePooled(1000);
+    ASSERT_TRUE(data->isPooled);
+    ASSERT_EQ(data->capacity, BufferPool::kMinSize);
+    ASSERT_EQ(data->length, 0u);
+    auto rawData = data->rawData;
+    std::fill_n(data->rawData, 4, 'a');
+    data->length = 4;
+    auto moved = std::move(*data);
+    ASSERT_TRUE(moved.isPooled);
+    ASSERT_FALSE(data->isPooled);
+    auto detached = moved.detachData();
+    ASSERT_TRUE(detached->isPooled);
+    ASSERT_EQ(detached->view(), "aaaa");
+    detached.reset();
+    ///the buffer went back to the pool
+    data = Data::makePooled(BufferPool::kMinSize);
+    ASSERT_EQ(data->rawData, rawData);
+    ///outgrowing the buffer moves the bytes to the heap and returns it
+    data->length = 0;
+    data->append(Data(std::string(BufferPool::kMinSize + 1, 'b')));
+    ASSERT_FALSE(data->isPooled);
+    ASSERT_EQ(data->length, BufferPool::kMinSize + 1);
+    ASSERT_EQ(Data::makePooled(BufferPool::kMinSize)->rawData, rawData);
+    auto large = Data::makePooled(BufferPool::kMaxSize + 1);
+    ASSERT_FALSE(large->isPooled);
+    ASSERT_EQ(large->capacity, BufferPool::kMaxSize + 1);
+}
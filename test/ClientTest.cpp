@@ -0,0 +1,1032 @@
+//
+// Created by Nevermore on 2026/10/17.
+// http-request ClientTest
+// Copyright (c) 2024 Nevermore All rights reserved.
+//
+#include <gtest/gtest.h>
+#include <condition_variable>
+#include <future>
+#include "Client.h"
+#include "LocalServer.h"
+#include "LocalHttp2Server.h"
+
+using namespace http;
+using namespace std::chrono_literals;
+
+struct Waiter {
+    std::mutex mutex;
+    std::condition_variable cond;
+    int32_t count = 0;
+
+    void done() {
+        {
+            std::lock_guard lock(mutex);
+            count++;
+        }
+        cond.notify_all();
+    }
+
+    bool wait(int32_t expectCount, std::chrono::milliseconds timeout = 10s) {
+        std::unique_lock lock(mutex);
+        return cond.wait_for(lock, timeout, [&] { return count >= expectCount; });
+    }
+};
+
+TEST(Client, ContentLength) {
+    LocalServer server([](const LocalServer::Request& request) {
+        return std::string("HTTP/1.1 200 OK\r\nContent-Length: 11\r\n\r\nhello world");
+    });
+    Client client;
+    Waiter waiter;
+    std::string body;
+    HttpStatusCode statusCode = HttpStatusCode::Unknown;
+    RequestInfo info;
+    info.url = server.url("/get");
+    info.methodType = HttpMethodType::Get;
+    ResponseHandler handler;
+    handler.onParseHeaderDone = [&](std::string_view, ResponseHeader&& header) {
+        statusCode = header.httpStatusCode;
+    };
+    handler.onData = [&](std::string_view, DataPtr data) {
+        body.append(data->view());
+    };
+    handler.onError = [](std::string_view, ErrorInfo info) {
+        ASSERT_EQ(info.retCode, ResultCode::Success);
+    };
+    handler.onDisconnected = [&](std::string_view) {
+        waiter.done();
+    };
+    client.request(std::move(info), std::move(handler));
+    ASSERT_TRUE(waiter.wait(1));
+    ASSERT_EQ(statusCode, HttpStatusCode::OK);
+    ASSERT_EQ(body, "hello world");
+}
+
+TEST(Client, Chunked) {
+    LocalServer server([](const LocalServer::Request& request) {
+        return std::string("HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n"
+                           "5\r\nhello\r\n1;ext=1\r\n \r\n5\r\nworld\r\n0\r\n\r\n");
+    });
+    Client client;
+    Waiter waiter;
+    std::string body;
+    RequestInfo info;
+    info.url = server.url("/chunked");
+    info.methodType = HttpMethodType::Post;
+    info.body = std::make_shared<Data>("payload");
+    ResponseHandler handler;
+    handler.onData = [&](std::string_view, DataPtr data) {
+        body.append(data->view());
+    };
+    handler.onDisconnected = [&](std::string_view) {
+        waiter.done();
+    };
+    client.request(std::move(info), std::move(handler));
+    ASSERT_TRUE(waiter.wait(1));
+    ASSERT_EQ(body, "hello world");
+}
+
+TEST(Client, LargeBody) {
+    const std::string payload(4 * 1024 * 1024 + 1, 'x');
+    std::vector<bool> tlsModes{false};
+#if ENABLE_HTTPS
+    tlsModes.push_back(true);
+#endif
+    for (auto isTls : tlsModes) {
+        LocalServer server([&payload](const LocalServer::Request& request) {
+            auto isMatch = request.body == payload ? "1" : "0";
+            return std::string("HTTP/1.1 200 OK\r\nContent-Length: 1\r\n\r\n") + isMatch;
+        }, isTls);
+        Client client;
+        Waiter waiter;
+        std::string body;
+        RequestInfo info;
+        info.url = server.url("/upload");
+        info.methodType = HttpMethodType::Post;
+        info.body = std::make_shared<Data>(payload);
+        ResponseHandler handler;
+        handler.onData = [&](std::string_view, DataPtr data) {
+            body.append(data->view());
+        };
+        handler.onError = [](std::string_view, ErrorInfo info) {
+            ASSERT_EQ(info.retCode, ResultCode::Success);
+        };
+        handler.onDisconnected = [&](std::string_view) {
+            waiter.done();
+        };
+        client.request(std::move(info), std::move(handler));
+        ASSERT_TRUE(waiter.wait(1));
+        ASSERT_EQ(body, "1") << isTls;
+    }
+}
+
+TEST(Client, StreamedBody) {
+    constexpr uint64_t kPartSize = 100 * 1000;
+    constexpr int32_t kPartCount = 20;
+    LocalServer server([](const LocalServer::Request& request) {
+        auto isMatch = request.body.size() == kPartSize * kPartCount && request.headers.count("Transfer-Encoding");
+        return std::string("HTTP/1.1 200 OK\r\nContent-Length: 1\r\n\r\n") + (isMatch ? "1" : "0");
+    });
+    Client client;
+    Waiter waiter;
+    std::string body;
+    int32_t partIndex = 0;
+    uint64_t partOffset = 0;
+    uint64_t maxReadSize = 0;
+    RequestInfo info;
+    info.url = server.url("/upload");
+    info.methodType = HttpMethodType::Post;
+    ///the parts of an export generated on demand, none of it is held in full
+    info.bodyReader = [&](uint8_t* buffer, uint64_t size) -> int64_t {
+        maxReadSize = std::max(maxReadSize, size);
+        if (partIndex == kPartCount) {
+            return 0;
+        }
+        auto count = std::min(size, kPartSize - partOffset);
+        std::fill_n(buffer, count, static_cast<uint8_t>('a' + partIndex));
+        partOffset += count;
+        if (partOffset == kPartSize) {
+            partIndex++;
+            partOffset = 0;
+        }
+        return static_cast<int64_t>(count);
+    };
+    ResponseHandler handler;
+    handler.onData = [&](std::string_view, DataPtr data) {
+        body.append(data->view());
+    };
+    handler.onError = [](std::string_view, ErrorInfo info) {
+        ASSERT_EQ(info.retCode, ResultCode::Success);
+    };
+    handler.onDisconnected = [&](std::string_view) {
+        waiter.done();
+    };
+    client.request(std::move(info), std::move(handler));
+    ASSERT_TRUE(waiter.wait(1));
+    ASSERT_EQ(body, "1");
+    ASSERT_LE(maxReadSize, BufferPool::kMaxSize);
+}
+
+TEST(Client, StreamedBodyFailed) {
+    LocalServer server([](const LocalServer::Request& request) {
+        return std::string("HTTP/1.1 200 OK\r\nContent-Length: 2\r\n\r\nok");
+    });
+    Client client;
+    Waiter waiter;
+    ResultCode resultCode = ResultCode::Success;
+    int32_t readCount = 0;
+    RequestInfo info;
+    info.url = server.url("/upload");
+    info.methodType = HttpMethodType::Put;
+    ///it ends before the length it announced
+    info.bodyLength = 1024;
+    info.bodyReader = [&readCount](uint8_t* buffer, uint64_t size) -> int64_t {
+        return readCount++ == 0 ? 10 : 0;
+    };
+    ResponseHandler handler;
+    handler.onError = [&](std::string_view, ErrorInfo info) {
+        resultCode = info.retCode;
+    };
+    handler.onDisconnected = [&](std::string_view) {
+        waiter.done();
+    };
+    client.request(std::move(info), std::move(handler));
+    ASSERT_TRUE(waiter.wait(1));
+    ASSERT_EQ(resultCode, ResultCode::BodyReadFailed);
+}
+
+TEST(Client, FileBody) {
+    std::string content;
+    for (int32_t i = 0; content.size() < 3 * 1024 * 1024; i++) {
+        content += std::to_string(i) + ",";
+    }
+    char path[] = "/tmp/http_file_body_XXXXXX";
+    auto fd = mkstemp(path);
+    ASSERT_GE(fd, 0);
+    ASSERT_EQ(write(fd, content.data(), content.size()), static_cast<ssize_t>(content.size()));
+    ::close(fd);
+    ///not aligned to a page or to the read buffer
+    constexpr uint64_t kOffset = 5001;
+    const auto expectBody = content.substr(kOffset);
+    std::vector<bool> tlsModes{false};
+#if ENABLE_HTTPS
+    tlsModes.push_back(true);
+#endif
+    for (auto isTls : tlsModes) {
+        LocalServer server([&expectBody](const LocalServer::Request& request) {
+            auto isMatch = request.body == expectBody ? "1" : "0";
+            return std::string("HTTP/1.1 200 OK\r\nContent-Length: 1\r\n\r\n") + isMatch;
+        }, isTls);
+        Client client;
+        Waiter waiter;
+        std::string body;
+        RequestInfo info;
+        info.url = server.url("/artifact");
+        info.methodType = HttpMethodType::Put;
+        info.bodyFile.path = path;
+        info.bodyFile.offset = kOffset;
+        ResponseHandler handler;
+        handler.onData = [&](std::string_view, DataPtr data) {
+            body.append(data->view());
+        };
+        handler.onError = [](std::string_view, ErrorInfo info) {
+            ASSERT_EQ(info.retCode, ResultCode::Success);
+        };
+        handler.onDisconnected = [&](std::string_view) {
+            waiter.done();
+        };
+        client.request(std::move(info), std::move(handler));
+        ASSERT_TRUE(waiter.wait(1));
+        ASSERT_EQ(body, "1") << isTls;
+    }
+    ::unlink(path);
+
+    LocalServer server([](const LocalServer::Request& request) {
+        return std::string("HTTP/1.1 200 OK\r\nContent-Length: 2\r\n\r\nok");
+    });
+    Client client;
+    Waiter waiter;
+    ResultCode resultCode = ResultCode::Success;
+    RequestInfo info;
+    info.url = server.url("/artifact");
+    info.methodType = HttpMethodType::Put;
+    info.bodyFile.path = path;
+    ResponseHandler handler;
+    handler.onError = [&](std::string_view, ErrorInfo info) {
+        resultCode = info.retCode;
+    };
+    handler.onDisconnected = [&](std::string_view) {
+        waiter.done();
+    };
+    client.request(std::move(info), std::move(handler));
+    ASSERT_TRUE(waiter.wait(1));
+    ASSERT_EQ(resultCode, ResultCode::BodyReadFailed);
+    ASSERT_EQ(server.requestCount(), 0);
+}
+
+#if ENABLE_HTTPS
+TEST(Client, Tls) {
+    constexpr int32_t kRequestCount = 20;
+    const std::string payload(128 * 1024, 'x');
+    LocalServer server([&](const LocalServer::Request& request) {
+        return "HTTP/1.1 200 OK\r\nContent-Length: " + std::to_string(payload.size()) + "\r\n\r\n" + payload;
+    }, true);
+    Client client;
+    Waiter waiter;
+    std::atomic<int32_t> matchCount = 0;
+    for (int32_t i = 0; i < kRequestCount; i++) {
+        RequestInfo info;
+        info.url = server.url("/tls");
+        info.methodType = HttpMethodType::Get;
+        auto body = std::make_shared<std::string>();
+        ResponseHandler handler;
+        handler.onData = [body](std::string_view, DataPtr data) {
+            body->append(data->view());
+        };
+        handler.onDisconnected = [&, body](std::string_view) {
+            if (*body == payload) {
+                matchCount++;
+            }
+            waiter.done();
+        };
+        client.request(std::move(info), std::move(handler));
+    }
+    ASSERT_TRUE(waiter.wait(kRequestCount));
+    ASSERT_EQ(matchCount, kRequestCount);
+}
+#endif
+
+TEST(Client, Concurrent) {
+    constexpr int32_t kRequestCount = 200;
+    LocalServer server([](const LocalServer::Request& request) {
+        return "HTTP/1.1 200 OK\r\nContent-Length: " + std::to_string(request.path.size()) + "\r\n\r\n" + request.path;
+    });
+    ClientConfig config;
+    config.loopCount = 2;
+    Client client(config);
+    Waiter waiter;
+    std::atomic<int32_t> matchCount = 0;
+    for (int32_t i = 0; i < kRequestCount; i++) {
+        RequestInfo info;
+        auto path = "/item/" + std::to_string(i);
+        info.url = server.url(path);
+        info.methodType = HttpMethodType::Get;
+        ResponseHandler handler;
+        handler.onData = [&, path](std::string_view, DataPtr data) {
+            if (data->view() == path) {
+                matchCount++;
+            }
+        };
+        handler.onDisconnected = [&](std::string_view) {
+            waiter.done();
+        };
+        client.request(std::move(info), std::move(handler));
+    }
+    ASSERT_TRUE(waiter.wait(kRequestCount, 30s));
+    ASSERT_EQ(matchCount, kRequestCount);
+}
+
+TEST(Client, Timeout) {
+    LocalServer server([](const LocalServer::Request& request) {
+        std::this_thread::sleep_for(500ms);
+        return std::string();
+    });
+    Client client;
+    Waiter waiter;
+    ResultCode resultCode = ResultCode::Success;
+    RequestInfo info;
+    info.url = server.url("/slow");
+    info.methodType = HttpMethodType::Get;
+    info.timeout = 100ms;
+    ResponseHandler handler;
+    handler.onError = [&](std::string_view, ErrorInfo error) {
+        resultCode = error.retCode;
+    };
+    handler.onDisconnected = [&](std::string_view) {
+        waiter.done();
+    };
+    client.request(std::move(info), std::move(handler));
+    ASSERT_TRUE(waiter.wait(1));
+    ASSERT_EQ(resultCode, ResultCode::Timeout);
+}
+
+TEST(Client, ReadTimeout) {
+    LocalServer server([](const LocalServer::Request& request) {
+        std::this_thread::sleep_for(500ms);
+        return std::string();
+    });
+    Client client;
+    Waiter waiter;
+    ResultCode resultCode = ResultCode::Success;
+    RequestInfo info;
+    info.url = server.url("/stall");
+    info.methodType = HttpMethodType::Get;
+    info.connectTimeout = 1000ms;
+    info.readTimeout = 100ms;
+    auto startTime = std::chrono::steady_clock::now();
+    ResponseHandler handler;
+    handler.onError = [&](std::string_view, ErrorInfo error) {
+        resultCode = error.retCode;
+    };
+    handler.onDisconnected = [&](std::string_view) {
+        waiter.done();
+    };
+    client.request(std::move(info), std::move(handler));
+    ASSERT_TRUE(waiter.wait(1));
+    ASSERT_EQ(resultCode, ResultCode::Timeout);
+    ASSERT_LT(std::chrono::steady_clock::now() - startTime, 450ms);
+}
+
+TEST(Client, ShardStats) {
+    constexpr int32_t kRequestCount = 40;
+    LocalServer server([](const LocalServer::Request& request) {
+        return std::string("HTTP/1.1 200 OK\r\nContent-Length: 2\r\n\r\nok");
+    });
+    auto runRequests = [&](Client& client) {
+        Waiter waiter;
+        for (int32_t i = 0; i < kRequestCount; i++) {
+            RequestInfo info;
+            info.url = server.url();
+            info.methodType = HttpMethodType::Get;
+            ResponseHandler handler;
+            handler.onDisconnected = [&](std::string_view) {
+                waiter.done();
+            };
+            client.request(std::move(info), std::move(handler));
+        }
+        ASSERT_TRUE(waiter.wait(kRequestCount));
+    };
+
+    ClientConfig config;
+    config.loopCount = 4;
+    config.shardPolicy = ShardPolicy::HostHash;
+    config.cpuAffinity = {0};
+    {
+        Client client(config);
+        runRequests(client);
+        auto stats = client.shardStats();
+        ASSERT_EQ(stats.size(), 4u);
+        uint64_t usedShardCount = 0;
+        for (auto& stat : stats) {
+            ASSERT_EQ(stat.cpu, 0);
+            if (stat.totalCount > 0) {
+                usedShardCount++;
+                ASSERT_EQ(stat.totalCount, static_cast<uint64_t>(kRequestCount));
+                ASSERT_GT(stat.receivedBytes, 0u);
+                ASSERT_GT(stat.sentBytes, 0u);
+            }
+        }
+        ASSERT_EQ(usedShardCount, 1u);
+    }
+
+    config.shardPolicy = ShardPolicy::LeastLoaded;
+    config.cpuAffinity.clear();
+    {
+        Client client(config);
+        runRequests(client);
+        uint64_t totalCount = 0;
+        for (auto& stat : client.shardStats()) {
+            ASSERT_EQ(stat.cpu, kInvalid);
+            totalCount += stat.totalCount;
+        }
+        ASSERT_EQ(totalCount, static_cast<uint64_t>(kRequestCount));
+    }
+}
+
+TEST(Client, KeepAlive) {
+    std::atomic<bool> isClose = false;
+    LocalServer server([&](const LocalServer::Request& request) {
+        return std::string("HTTP/1.1 200 OK\r\nContent-Length: 2\r\n") + (isClose ? "Connection: close\r\n" : "") + "\r\nok";
+    });
+    ClientConfig config;
+    config.loopCount = 2;
+    config.shardPolicy = ShardPolicy::HostHash;
+    config.poolConfig.idleTimeout = 200ms;
+    Client client(config);
+    auto get = [&] {
+        Waiter waiter;
+        std::string body;
+        RequestInfo info;
+        info.url = server.url();
+        info.methodType = HttpMethodType::Get;
+        ResponseHandler handler;
+        handler.onData = [&](std::string_view, DataPtr data) {
+            body.append(data->view());
+        };
+        handler.onError = [](std::string_view, ErrorInfo info) {
+            ASSERT_EQ(info.retCode, ResultCode::Success);
+        };
+        handler.onDisconnected = [&](std::string_view) {
+            waiter.done();
+        };
+        client.request(std::move(info), std::move(handler));
+        EXPECT_TRUE(waiter.wait(1));
+        return body;
+    };
+    ///the origin stays on one loop and its pool hands the connection back every time
+    for (int32_t i = 0; i < 4; i++) {
+        ASSERT_EQ(get(), "ok");
+    }
+    ASSERT_EQ(server.connectionCount(), 1);
+
+    ///an idle connection past the idle timeout is closed
+    std::this_thread::sleep_for(300ms);
+    ASSERT_EQ(get(), "ok");
+    ASSERT_EQ(server.connectionCount(), 2);
+
+    ///Connection: close is never pooled
+    isClose = true;
+    ASSERT_EQ(get(), "ok");
+    ASSERT_EQ(get(), "ok");
+    ASSERT_EQ(server.connectionCount(), 3);
+}
+
+TEST(Client, ShardPools) {
+    LocalServer server([](const LocalServer::Request&) {
+        return std::string("HTTP/1.1 200 OK\r\nContent-Length: 2\r\n\r\nok");
+    });
+    ClientConfig config;
+    config.loopCount = 2;
+    Client client(config);
+    for (int32_t i = 0; i < 6; i++) {
+        Waiter waiter;
+        RequestInfo info;
+        info.url = server.url();
+        info.methodType = HttpMethodType::Get;
+        ResponseHandler handler;
+        handler.onError = [](std::string_view, ErrorInfo info) {
+            ASSERT_EQ(info.retCode, ResultCode::Success);
+        };
+        handler.onDisconnected = [&](std::string_view) {
+            waiter.done();
+        };
+        client.request(std::move(info), std::move(handler));
+        ASSERT_TRUE(waiter.wait(1));
+    }
+    ///the loops take turns and each one reuses the connection it opened, none moves to the other loop
+    ASSERT_EQ(server.connectionCount(), 2);
+    ASSERT_EQ(server.requestCount(), 6);
+}
+
+TEST(Client, Preconnect) {
+    LocalServer server([](const LocalServer::Request&) {
+        return std::string("HTTP/1.1 200 OK\r\nContent-Length: 2\r\n\r\nok");
+    });
+    ClientConfig config;
+    config.loopCount = 2;
+    Client client(config);
+    std::promise<uint32_t> promise;
+    client.preconnect(server.url(), 3, [&](uint32_t readyCount) {
+        promise.set_value(readyCount);
+    });
+    auto future = promise.get_future();
+    ASSERT_EQ(future.wait_for(5s), std::future_status::ready);
+    ASSERT_EQ(future.get(), 3);
+    ///the requests find the connections ready in the pool
+    Waiter waiter;
+    for (int32_t i = 0; i < 3; i++) {
+        RequestInfo info;
+        info.url = server.url();
+        info.methodType = HttpMethodType::Get;
+        ResponseHandler handler;
+        handler.onError = [](std::string_view, ErrorInfo info) {
+            ASSERT_EQ(info.retCode, ResultCode::Success);
+        };
+        handler.onDisconnected = [&](std::string_view) {
+            waiter.done();
+        };
+        client.request(std::move(info), std::move(handler));
+        ASSERT_TRUE(waiter.wait(i + 1));
+    }
+    ASSERT_EQ(server.connectionCount(), 3);
+    ASSERT_EQ(server.requestCount(), 3);
+
+    std::promise<uint32_t> failed;
+    client.preconnect("ftp://127.0.0.1/", 2, [&](uint32_t readyCount) {
+        failed.set_value(readyCount);
+    });
+    auto failedFuture = failed.get_future();
+    ASSERT_EQ(failedFuture.wait_for(5s), std::future_status::ready);
+    ASSERT_EQ(failedFuture.get(), 0);
+}
+
+TEST(Client, Pipelining) {
+    constexpr int32_t kRequestCount = 20;
+    std::atomic<int32_t> servedCount = 0;
+    LocalServer server([&](const LocalServer::Request& request) {
+        ///the server drops the connection once without answering, the requests behind are sent again
+        if (++servedCount == 5) {
+            return std::string();
+        }
+        return "HTTP/1.1 200 OK\r\nContent-Length: " + std::to_string(request.path.size()) + "\r\n\r\n" + request.path;
+    });
+    ClientConfig config;
+    config.maxPipelineDepth = 4;
+    Client client(config);
+    Waiter waiter;
+    std::mutex mutex;
+    std::unordered_map<std::string, std::string> paths;
+    std::unordered_map<std::string, std::string> bodies;
+    for (int32_t i = 0; i < kRequestCount; i++) {
+        RequestInfo info;
+        info.url = server.url("/" + std::to_string(i));
+        info.methodType = HttpMethodType::Get;
+        info.isPipelining = true;
+        ResponseHandler handler;
+        handler.onData = [&](std::string_view reqId, DataPtr data) {
+            std::lock_guard lock(mutex);
+            bodies[std::string(reqId)].append(data->view());
+        };
+        handler.onError = [](std::string_view, ErrorInfo info) {
+            ASSERT_EQ(info.retCode, ResultCode::Success);
+        };
+        handler.onDisconnected = [&](std::string_view) {
+            waiter.done();
+        };
+        std::lock_guard lock(mutex);
+        paths[client.request(std::move(info), std::move(handler))] = "/" + std::to_string(i);
+    }
+    ASSERT_TRUE(waiter.wait(kRequestCount));
+    std::lock_guard lock(mutex);
+    for (auto& [reqId, path] : paths) {
+        ASSERT_EQ(bodies[reqId], path);
+    }
+    ///one connection until the drop, the dropped request is the only one the server read twice
+    ASSERT_EQ(server.connectionCount(), 2);
+    ASSERT_EQ(server.requestCount(), kRequestCount + 1);
+}
+
+TEST(Client, Coalescing) {
+    constexpr int32_t kRequestCount = 10;
+    LocalServer server([](const LocalServer::Request& request) {
+        std::this_thread::sleep_for(100ms);
+        return "HTTP/1.1 200 OK\r\nContent-Length: " + std::to_string(request.path.size()) + "\r\n\r\n" + request.path;
+    });
+    Client client;
+    Waiter waiter;
+    std::mutex mutex;
+    std::unordered_map<std::string, std::string> bodies;
+    std::atomic<int32_t> headerCount = 0;
+    std::atomic<int32_t> connectedCount = 0;
+    auto request = [&](const std::string& path, const std::string& accept) {
+        RequestInfo info;
+        info.url = server.url(path);
+        info.methodType = HttpMethodType::Get;
+        info.isCoalescing = true;
+        info.headers["Accept"] = accept;
+        ResponseHandler handler;
+        handler.onConnected = [&](std::string_view) {
+            connectedCount++;
+        };
+        handler.onParseHeaderDone = [&](std::string_view, ResponseHeader&& header) {
+            EXPECT_EQ(header.httpStatusCode, HttpStatusCode::OK);
+            headerCount++;
+        };
+        handler.onData = [&](std::string_view reqId, DataPtr data) {
+            std::lock_guard lock(mutex);
+            bodies[std::string(reqId)].append(data->view());
+        };
+        handler.onError = [](std::string_view, ErrorInfo info) {
+            ASSERT_EQ(info.retCode, ResultCode::Success);
+        };
+        handler.onDisconnected = [&](std::string_view) {
+            waiter.done();
+        };
+        return client.request(std::move(info), std::move(handler));
+    };
+    std::vector<std::string> reqIds;
+    for (int32_t i = 0; i < kRequestCount; i++) {
+        reqIds.push_back(request("/shared", "text/plain"));
+    }
+    ///another header value is another response
+    auto otherId = request("/shared", "application/json");
+    ///the first request leads, canceling it only detaches its handler
+    client.cancel(reqIds.front());
+    ASSERT_TRUE(waiter.wait(kRequestCount));
+    ASSERT_EQ(server.requestCount(), 2);
+    ASSERT_EQ(headerCount, kRequestCount);
+    ///the canceled one may have seen the connection before it was canceled
+    ASSERT_GE(connectedCount, kRequestCount);
+    ASSERT_LE(connectedCount, kRequestCount + 1);
+    std::lock_guard lock(mutex);
+    ASSERT_EQ(bodies.count(reqIds.front()), 0u);
+    for (size_t i = 1; i < reqIds.size(); i++) {
+        ASSERT_EQ(bodies[reqIds[i]], "/shared");
+    }
+    ASSERT_EQ(bodies[otherId], "/shared");
+}
+
+TEST(Client, CoalescingCancel) {
+    LocalServer server([](const LocalServer::Request& request) {
+        std::this_thread::sleep_for(100ms);
+        return std::string("HTTP/1.1 200 OK\r\nContent-Length: 2\r\n\r\nok");
+    });
+    Client client;
+    std::atomic<int32_t> callbackCount = 0;
+    RequestInfo info;
+    info.url = server.url();
+    info.methodType = HttpMethodType::Get;
+    info.isCoalescing = true;
+    ResponseHandler handler;
+    handler.onDisconnected = [&](std::string_view) {
+        callbackCount++;
+    };
+    auto first = client.request(info, handler);
+    auto second = client.request(info, handler);
+    client.cancel(second);
+    client.cancel(first);
+    std::this_thread::sleep_for(200ms);
+    ASSERT_EQ(callbackCount, 0);
+    ///the abandoned flight is closed, the next request goes out on its own
+    Waiter waiter;
+    handler.onDisconnected = [&](std::string_view) {
+        waiter.done();
+    };
+    client.request(info, handler);
+    ASSERT_TRUE(waiter.wait(1));
+}
+
+TEST(Client, CoalescingSettings) {
+    LocalServer server([](const LocalServer::Request& request) {
+        std::this_thread::sleep_for(300ms);
+        return std::string("HTTP/1.1 200 OK\r\nContent-Length: 2\r\n\r\nok");
+    });
+    Client client;
+    Waiter waiter;
+    std::mutex mutex;
+    std::unordered_map<std::string, ResultCode> results;
+    auto request = [&](std::chrono::milliseconds timeout) {
+        RequestInfo info;
+        info.url = server.url();
+        info.methodType = HttpMethodType::Get;
+        info.isCoalescing = true;
+        info.timeout = timeout;
+        ResponseHandler handler;
+        handler.onError = [&](std::string_view reqId, ErrorInfo info) {
+            std::lock_guard lock(mutex);
+            results[std::string(reqId)] = info.retCode;
+        };
+        handler.onDisconnected = [&](std::string_view reqId) {
+            {
+                std::lock_guard lock(mutex);
+                results.emplace(std::string(reqId), ResultCode::Success);
+            }
+            waiter.done();
+        };
+        return client.request(std::move(info), std::move(handler));
+    };
+    ///a request with a longer timeout does not share the timeout of the first one
+    auto shortId = request(100ms);
+    auto longId = request(5000ms);
+    ASSERT_TRUE(waiter.wait(2));
+    ASSERT_EQ(server.requestCount(), 2);
+    std::lock_guard lock(mutex);
+    ASSERT_EQ(results[shortId], ResultCode::Timeout);
+    ASSERT_EQ(results[longId], ResultCode::Success);
+}
+
+TEST(Client, Http2) {
+    constexpr int32_t kGetCount = 20;
+    constexpr int32_t kPostCount = 4;
+    const std::string largeBody(2 * 1024 * 1024 + 7, 'r');
+    LocalHttp2Server::Config serverConfig;
+    serverConfig.maxConcurrentStreams = 4;
+    LocalHttp2Server server([&](const LocalHttp2Server::Request& request) {
+        LocalHttp2Server::Response response;
+        response.headers.emplace_back("x-method", request.method);
+        if (request.path == "/large") {
+            ///larger than the stream window, the client has to send WINDOW_UPDATE
+            response.body = largeBody;
+        } else if (request.method == "POST") {
+            response.body = std::to_string(request.body.size()) + request.headers.at("content-type");
+        } else {
+            response.body = request.path;
+        }
+        return response;
+    }, serverConfig);
+    Client client;
+    Waiter waiter;
+    std::mutex mutex;
+    std::unordered_map<std::string, std::string> expects;
+    std::unordered_map<std::string, std::string> bodies;
+    auto request = [&](RequestInfo&& info, std::string expect) {
+        info.httpVersion = HttpVersion::Http2;
+        ResponseHandler handler;
+        handler.onParseHeaderDone = [](std::string_view, ResponseHeader&& header) {
+            ASSERT_EQ(header.httpStatusCode, HttpStatusCode::OK);
+            ASSERT_FALSE(header.headers["x-method"].empty());
+        };
+        handler.onData = [&](std::string_view reqId, DataPtr data) {
+            std::lock_guard lock(mutex);
+            bodies[std::string(reqId)].append(data->view());
+        };
+        handler.onError = [](std::string_view, ErrorInfo info) {
+            ASSERT_EQ(info.retCode, ResultCode::Success);
+        };
+        handler.onDisconnected = [&](std::string_view) {
+            waiter.done();
+        };
+        std::lock_guard lock(mutex);
+        expects[client.request(std::move(info), std::move(handler))] = std::move(expect);
+    };
+    for (int32_t i = 0; i < kGetCount; i++) {
+        RequestInfo info;
+        info.url = server.url("/" + std::to_string(i) + "?query=" + std::to_string(i));
+        info.methodType = HttpMethodType::Get;
+        request(std::move(info), "/" + std::to_string(i) + "?query=" + std::to_string(i));
+    }
+    for (int32_t i = 0; i < kPostCount; i++) {
+        RequestInfo info;
+        info.url = server.url("/post");
+        info.methodType = HttpMethodType::Post;
+        info.headers["Content-Type"] = "text/plain";
+        ///larger than the initial window of the server, the body waits for its WINDOW_UPDATE frames
+        info.body = std::make_shared<Data>(std::string(300 * 1024 + i, 'p'));
+        request(std::move(info), std::to_string(300 * 1024 + i) + "text/plain");
+    }
+    RequestInfo info;
+    info.url = server.url("/large");
+    info.methodType = HttpMethodType::Get;
+    request(std::move(info), largeBody);
+    ASSERT_TRUE(waiter.wait(kGetCount + kPostCount + 1));
+    std::lock_guard lock(mutex);
+    for (auto& [reqId, expect] : expects) {
+        ASSERT_EQ(bodies[reqId], expect);
+    }
+    ///all the streams share one connection and respect the announced concurrency
+    ASSERT_EQ(server.connectionCount(), 1);
+    ASSERT_EQ(server.requestCount(), kGetCount + kPostCount + 1);
+    ASSERT_LE(server.maxOpenStreams(), 4);
+}
+
+TEST(Client, Http2GoAway) {
+    constexpr int32_t kRequestCount = 10;
+    LocalHttp2Server::Config serverConfig;
+    serverConfig.goAwayAfter = 3;
+    LocalHttp2Server server([](const LocalHttp2Server::Request& request) {
+        LocalHttp2Server::Response response;
+        response.body = request.path;
+        return response;
+    }, serverConfig);
+    Client client;
+    Waiter waiter;
+    std::mutex mutex;
+    std::unordered_map<std::string, std::string> paths;
+    std::unordered_map<std::string, std::string> bodies;
+    for (int32_t i = 0; i < kRequestCount; i++) {
+        RequestInfo info;
+        info.url = server.url("/" + std::to_string(i));
+        info.methodType = HttpMethodType::Get;
+        info.httpVersion = HttpVersion::Http2;
+        ResponseHandler handler;
+        handler.onData = [&](std::string_view reqId, DataPtr data) {
+            std::lock_guard lock(mutex);
+            bodies[std::string(reqId)].append(data->view());
+        };
+        handler.onError = [](std::string_view, ErrorInfo info) {
+            ASSERT_EQ(info.retCode, ResultCode::Success);
+        };
+        handler.onDisconnected = [&](std::string_view) {
+            waiter.done();
+        };
+        std::lock_guard lock(mutex);
+        paths[client.request(std::move(info), std::move(handler))] = "/" + std::to_string(i);
+    }
+    ASSERT_TRUE(waiter.wait(kRequestCount));
+    std::lock_guard lock(mutex);
+    for (auto& [reqId, path] : paths) {
+        ASSERT_EQ(bodies[reqId], path);
+    }
+    ///the streams the server did not process move to the next connection, none is answered twice
+    ASSERT_EQ(server.connectionCount(), 4);
+    ASSERT_EQ(server.requestCount(), kRequestCount);
+}
+
+#if ENABLE_HTTPS
+TEST(Client, Http2Tls) {
+    LocalHttp2Server::Config serverConfig;
+    serverConfig.isTls = true;
+    LocalHttp2Server server([](const LocalHttp2Server::Request& request) {
+        LocalHttp2Server::Response response;
+        response.body = request.path;
+        return response;
+    }, serverConfig);
+    Client client;
+    for (int32_t i = 0; i < 3; i++) {
+        Waiter waiter;
+        std::string body;
+        RequestInfo info;
+        info.url = server.url("/tls");
+        info.methodType = HttpMethodType::Get;
+        info.httpVersion = HttpVersion::Http2;
+        ResponseHandler handler;
+        handler.onData = [&](std::string_view, DataPtr data) {
+            body.append(data->view());
+        };
+        handler.onError = [](std::string_view, ErrorInfo info) {
+            ASSERT_EQ(info.retCode, ResultCode::Success);
+        };
+        handler.onDisconnected = [&](std::string_view) {
+            waiter.done();
+        };
+        client.request(std::move(info), std::move(handler));
+        ASSERT_TRUE(waiter.wait(1));
+        ASSERT_EQ(body, "/tls");
+    }
+    ///h2 was selected with ALPN and the idle connection is kept for the next requests
+    ASSERT_EQ(server.connectionCount(), 1);
+}
+
+TEST(Client, Http2Fallback) {
+    LocalServer server([](const LocalServer::Request& request) {
+        return "HTTP/1.1 200 OK\r\nContent-Length: " + std::to_string(request.path.size()) + "\r\n\r\n" + request.path;
+    }, true);
+    Client client;
+    for (int32_t i = 0; i < 3; i++) {
+        Waiter waiter;
+        std::string body;
+        RequestInfo info;
+        info.url = server.url("/fallback");
+        info.methodType = HttpMethodType::Get;
+        info.httpVersion = HttpVersion::Http2;
+        ResponseHandler handler;
+        handler.onData = [&](std::string_view, DataPtr data) {
+            body.append(data->view());
+        };
+        handler.onError = [](std::string_view, ErrorInfo info) {
+            ASSERT_EQ(info.retCode, ResultCode::Success);
+        };
+        handler.onDisconnected = [&](std::string_view) {
+            waiter.done();
+        };
+        client.request(std::move(info), std::move(handler));
+        ASSERT_TRUE(waiter.wait(1));
+        ASSERT_EQ(body, "/fallback");
+    }
+    ///the server has no h2, the negotiated connection serves every request over http/1.1
+    ASSERT_EQ(server.connectionCount(), 1);
+    ASSERT_EQ(server.requestCount(), 3);
+}
+
+TEST(Client, Http2AfterHttp1) {
+    LocalHttp2Server::Config serverConfig;
+    serverConfig.isTls = true;
+    LocalHttp2Server server([](const LocalHttp2Server::Request& request) {
+        LocalHttp2Server::Response response;
+        response.body = request.path;
+        return response;
+    }, serverConfig);
+    Client client;
+    ///the preconnected tls socket offers no ALPN and waits in the pool
+    std::promise<uint32_t> promise;
+    client.preconnect(server.url(), 1, [&](uint32_t readyCount) {
+        promise.set_value(readyCount);
+    });
+    auto future = promise.get_future();
+    ASSERT_EQ(future.wait_for(5s), std::future_status::ready);
+    ASSERT_EQ(future.get(), 1);
+
+    Waiter waiter;
+    std::string body;
+    RequestInfo info;
+    info.url = server.url("/h2");
+    info.methodType = HttpMethodType::Get;
+    info.httpVersion = HttpVersion::Http2;
+    ResponseHandler handler;
+    handler.onData = [&](std::string_view, DataPtr data) {
+        body.append(data->view());
+    };
+    handler.onError = [](std::string_view, ErrorInfo info) {
+        ASSERT_EQ(info.retCode, ResultCode::Success);
+    };
+    handler.onDisconnected = [&](std::string_view) {
+        waiter.done();
+    };
+    client.request(std::move(info), std::move(handler));
+    ASSERT_TRUE(waiter.wait(1));
+    ///an idle http/1.1 connection does not demote the origin, h2 is negotiated on a new one
+    ASSERT_EQ(body, "/h2");
+    ASSERT_EQ(server.connectionCount(), 2);
+    ASSERT_EQ(server.requestCount(), 1);
+}
+#endif
+
+#if ENABLE_HTTPS
+TEST(Client, TlsSessionResumption) {
+    LocalServer server([](const LocalServer::Request&) {
+        return std::string("HTTP/1.1 200 OK\r\nConnection: close\r\nContent-Length: 2\r\n\r\nok");
+    }, true);
+    Client client;
+    auto stats = HttpsHelper::sessionStats();
+    for (int32_t i = 0; i < 3; i++) {
+        Waiter waiter;
+        RequestInfo info;
+        info.url = server.url("/resume");
+        info.methodType = HttpMethodType::Get;
+        ResponseHandler handler;
+        handler.onError = [](std::string_view, ErrorInfo info) {
+            ASSERT_EQ(info.retCode, ResultCode::Success);
+        };
+        handler.onDisconnected = [&](std::string_view) {
+            waiter.done();
+        };
+        client.request(std::move(info), std::move(handler));
+        ASSERT_TRUE(waiter.wait(1));
+    }
+    ///every connection after the first resumes the session the server issued before
+    auto current = HttpsHelper::sessionStats();
+    ASSERT_EQ(server.connectionCount(), 3);
+    ASSERT_EQ(current.missCount - stats.missCount, 1);
+    ASSERT_EQ(current.hitCount - stats.hitCount, 2);
+}
+
+static void requestEarlyData(Client& client, const LocalServer& server, int32_t count) {
+    for (int32_t i = 0; i < count; i++) {
+        Waiter waiter;
+        std::string body;
+        RequestInfo info;
+        info.url = server.url("/early");
+        info.methodType = HttpMethodType::Get;
+        info.isEarlyData = true;
+        ResponseHandler handler;
+        handler.onData = [&](std::string_view, DataPtr data) {
+            body.append(data->view());
+        };
+        handler.onError = [](std::string_view, ErrorInfo info) {
+            ASSERT_EQ(info.retCode, ResultCode::Success);
+        };
+        handler.onDisconnected = [&](std::string_view) {
+            waiter.done();
+        };
+        client.request(std::move(info), std::move(handler));
+        ASSERT_TRUE(waiter.wait(1));
+        ASSERT_EQ(body, "/early");
+    }
+}
+
+TEST(Client, TlsEarlyData) {
+    LocalServer server([](const LocalServer::Request& request) {
+        return "HTTP/1.1 200 OK\r\nConnection: close\r\nContent-Length: " + std::to_string(request.path.size()) +
+               "\r\n\r\n" + request.path;
+    }, true);
+    server.setEarlyData(true);
+    Client client;
+    requestEarlyData(client, server, 3);
+    ///the first connection has no ticket yet, the others send the request in the first flight
+    ASSERT_EQ(server.earlyDataCount(), 2);
+    ASSERT_EQ(server.requestCount(), 3);
+}
+
+TEST(Client, TlsEarlyDataRejected) {
+    LocalServer server([](const LocalServer::Request& request) {
+        return "HTTP/1.1 200 OK\r\nConnection: close\r\nContent-Length: " + std::to_string(request.path.size()) +
+               "\r\n\r\n" + request.path;
+    }, true);
+    server.setEarlyData(false);
+    Client client;
+    requestEarlyData(client, server, 3);
+    ///the rejected early data is sent again after the handshake
+    ASSERT_EQ(server.earlyDataCount(), 0);
+    ASSERT_EQ(server.requestCount(), 3);
+}
+#endif
@@ -0,0 +1,134 @@
+//
+// Created by Nevermore on 2026/10/17.
+// http-request ConnectionLimiterTest
+// Copyright (c) 2024 Nevermore All rights reserved.
+//
+#include <gtest/gtest.h>
+#include <condition_variable>
+#include "../src/include/ConnectionLimiter.h"
+#include "Client.h"
+#include "LocalServer.h"
+
+using namespace http;
+using namespace std::chrono_literals;
+
+TEST(ConnectionLimiter, PerOrigin) {
+    ConnectionLimiter limiter(2, 0);
+    std::vector<std::string> started;
+    for (auto id : {"a1", "a2", "a3", "b1"}) {
+        limiter.acquire(id[0] == 'a' ? "a" : "b", id, [&started, id](std::chrono::milliseconds) {
+            started.emplace_back(id);
+        });
+    }
+    ASSERT_EQ(started, (std::vector<std::string>{"a1", "a2", "b1"}));
+    ASSERT_EQ(limiter.waitingCount(), 1u);
+    limiter.release("b1");
+    ASSERT_EQ(started.size(), 3u);
+    limiter.release("a1");
+    ASSERT_EQ(started.back(), "a3");
+    ASSERT_EQ(limiter.waitingCount(), 0u);
+    ASSERT_EQ(limiter.activeCount(), 2u);
+}
+
+TEST(ConnectionLimiter, RoundRobin) {
+    ConnectionLimiter limiter(0, 1);
+    std::vector<std::string> started;
+    auto acquire = [&](const std::string& origin, const std::string& id) {
+        limiter.acquire(origin, id, [&started, id](std::chrono::milliseconds) {
+            started.push_back(id);
+        });
+    };
+    acquire("a", "a1");
+    ///a burst to a arrives before the first request of b and c
+    acquire("a", "a2");
+    acquire("a", "a3");
+    acquire("b", "b1");
+    acquire("c", "c1");
+    acquire("b", "b2");
+    for (const auto& id : {"a1", "a2", "b1", "c1", "a3", "b2"}) {
+        limiter.release(id);
+    }
+    ASSERT_EQ(started, (std::vector<std::string>{"a1", "a2", "b1", "c1", "a3", "b2"}));
+}
+
+TEST(ConnectionLimiter, Cancel) {
+    ConnectionLimiter limiter(1, 0);
+    std::vector<std::string> started;
+    for (auto id : {"1", "2", "3"}) {
+        limiter.acquire("a", id, [&started, id](std::chrono::milliseconds) {
+            started.emplace_back(id);
+        });
+    }
+    ASSERT_TRUE(limiter.cancel("2"));
+    ASSERT_FALSE(limiter.cancel("2"));
+    ///holding a slot, it is released instead
+    ASSERT_FALSE(limiter.cancel("1"));
+    limiter.release("1");
+    ASSERT_EQ(started, (std::vector<std::string>{"1", "3"}));
+    limiter.release("unknown");
+    ASSERT_EQ(limiter.activeCount(), 1u);
+}
+
+TEST(ConnectionLimiter, QueueTime) {
+    ConnectionLimiter limiter(1, 0);
+    std::chrono::milliseconds queueTime{-1};
+    limiter.acquire("a", "1", [](std::chrono::milliseconds time) {
+        ASSERT_EQ(time.count(), 0);
+    });
+    limiter.acquire("a", "2", [&queueTime](std::chrono::milliseconds time) {
+        queueTime = time;
+    });
+    std::this_thread::sleep_for(30ms);
+    limiter.release("1");
+    ASSERT_GE(queueTime.count(), 25);
+}
+
+TEST(ConnectionLimiter, Client) {
+    constexpr int32_t kRequestCount = 12;
+    std::atomic<int32_t> concurrentCount = 0;
+    std::atomic<int32_t> maxConcurrentCount = 0;
+    LocalServer server([&](const LocalServer::Request&) {
+        auto count = ++concurrentCount;
+        auto maxCount = maxConcurrentCount.load();
+        while (count > maxCount && !maxConcurrentCount.compare_exchange_weak(maxCount, count)) {
+        }
+        std::this_thread::sleep_for(20ms);
+        concurrentCount--;
+        return std::string("HTTP/1.1 200 OK\r\nContent-Length: 2\r\n\r\nok");
+    });
+    ClientConfig config;
+    config.loopCount = 2;
+    config.maxConnectionsPerOrigin = 2;
+    Client client(config);
+    std::mutex mutex;
+    std::condition_variable cond;
+    int32_t finishCount = 0;
+    std::atomic<int32_t> queuedCount = 0;
+    for (int32_t i = 0; i < kRequestCount; i++) {
+        RequestInfo info;
+        info.url = server.url();
+        info.methodType = HttpMethodType::Get;
+        ResponseHandler handler;
+        handler.onError = [](std::string_view, ErrorInfo info) {
+            ASSERT_EQ(info.retCode, ResultCode::Success);
+        };
+        handler.onStats = [&](std::string_view, const RequestStats& stats) {
+            if (stats.queueTime.count() > 0) {
+                queuedCount++;
+            }
+            EXPECT_GE(stats.networkTime.count(), 15);
+        };
+        handler.onDisconnected = [&](std::string_view) {
+            std::lock_guard lock(mutex);
+            finishCount++;
+            cond.notify_all();
+        };
+        client.request(std::move(info), std::move(handler));
+    }
+    std::unique_lock lock(mutex);
+    ASSERT_TRUE(cond.wait_for(lock, 5s, [&] { return finishCount == kRequestCount; }));
+    ASSERT_LE(maxConcurrentCount, 2);
+    ASSERT_GE(server.connectionCount(), 1);
+    ASSERT_LE(server.connectionCount(), 2);
+    ASSERT_GT(queuedCount, 0);
+}
@@ -0,0 +1,210 @@
+//
+// Created by Nevermore on 2026/10/17.
+// http-request ConnectorTest
+// Copyright (c) 2024 Nevermore All rights reserved.
+//
+#include <gtest/gtest.h>
+#include <future>
+#include "../src/include/Connector.h"
+#include "../src/include/PlainSocket.h"
+#include "LocalServer.h"
+
+using namespace http;
+using namespace std::chrono_literals;
+
+namespace {
+
+addrinfo* resolve(const std::string& host, uint16_t port) {
+    addrinfo hints{};
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = AI_NUMERICHOST;
+    addrinfo* addressInfo = nullptr;
+    getaddrinfo(host.data(), std::to_string(port).data(), &hints, &addressInfo);
+    return addressInfo;
+}
+
+///the addresses are tried in this order, every node is freed on its own by freeaddrinfo
+AddressInfoPtr chain(std::vector<addrinfo*> addresses) {
+    for (size_t i = 0; i + 1 < addresses.size(); i++) {
+        addresses[i]->ai_next = addresses[i + 1];
+    }
+    return MakeAddressInfoPtr(addresses.front());
+}
+
+uint16_t peerPort(const ISocket& socket) {
+    sockaddr_in address{};
+    socklen_t length = sizeof(address);
+    getpeername(socket.fd(), reinterpret_cast<sockaddr*>(&address), &length);
+    return ntohs(address.sin_port);
+}
+
+ISocket* createSocket(IPVersion ipVersion) {
+    return new PlainSocket(ipVersion);
+}
+
+///A listener whose accept queue is full, the next SYN is dropped and the connect hangs like a black-holed route.
+class StalledListener {
+public:
+    StalledListener() {
+        listenFd_ = ::socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        ::bind(listenFd_, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+        socklen_t length = sizeof(address);
+        getsockname(listenFd_, reinterpret_cast<sockaddr*>(&address), &length);
+        port_ = ntohs(address.sin_port);
+        ::listen(listenFd_, 0);
+        for (int32_t i = 0; i < 4; i++) {
+            auto fd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+            ::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+            clients_.push_back(fd);
+        }
+        std::this_thread::sleep_for(50ms);
+    }
+
+    ~StalledListener() {
+        for (auto fd : clients_) {
+            ::close(fd);
+        }
+        ::close(listenFd_);
+    }
+
+    [[nodiscard]] uint16_t port() const {
+        return port_;
+    }
+
+private:
+    int listenFd_ = -1;
+    uint16_t port_ = 0;
+    std::vector<int> clients_;
+};
+
+///a port nothing listens on, the connect is refused at once
+uint16_t closedPort() {
+    auto fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    ::bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+    socklen_t length = sizeof(address);
+    getsockname(fd, reinterpret_cast<sockaddr*>(&address), &length);
+    ::close(fd);
+    return ntohs(address.sin_port);
+}
+
+}
+
+TEST(Connector, SortAddresses) {
+    auto address = chain({resolve("::1", 1), resolve("::2", 2), resolve("::3", 3),
+                          resolve("127.0.0.1", 4), resolve("127.0.0.2", 5)});
+    auto addresses = Connector::sortAddresses(address.get());
+    std::vector<uint16_t> ports;
+    for (auto current : addresses) {
+        auto port = current->ai_family == AF_INET ? reinterpret_cast<sockaddr_in*>(current->ai_addr)->sin_port :
+                                                    reinterpret_cast<sockaddr_in6*>(current->ai_addr)->sin6_port;
+        ports.push_back(ntohs(port));
+    }
+    ///the families alternate, starting with the family of the first address
+    ASSERT_EQ(ports, std::vector<uint16_t>({1, 4, 2, 5, 3}));
+}
+
+TEST(Connector, StalledAddress) {
+    StalledListener stalled;
+    LocalServer server([](const LocalServer::Request&) {
+        return std::string();
+    });
+    auto start = util::Time::steadyTime();
+    auto [socket, result] = Connector::connect(chain({resolve("127.0.0.1", stalled.port()),
+                                                      resolve("127.0.0.1", server.port())}), 100ms, createSocket, 5000);
+    auto elapsed = util::Time::steadyTime() - start;
+    ASSERT_TRUE(result.isSuccess());
+    ASSERT_EQ(peerPort(*socket), server.port());
+    ///the second address starts after the delay instead of waiting for the timeout
+    ASSERT_GE(elapsed, 100ms);
+    ASSERT_LT(elapsed, 2000ms);
+}
+
+TEST(Connector, RefusedAddress) {
+    LocalServer server([](const LocalServer::Request&) {
+        return std::string();
+    });
+    auto start = util::Time::steadyTime();
+    auto [socket, result] = Connector::connect(chain({resolve("127.0.0.1", closedPort()),
+                                                      resolve("127.0.0.1", server.port())}), 2000ms, createSocket, 5000);
+    ASSERT_TRUE(result.isSuccess());
+    ASSERT_EQ(peerPort(*socket), server.port());
+    ///a failed attempt does not wait for the delay
+    ASSERT_LT(util::Time::steadyTime() - start, 1000ms);
+}
+
+TEST(Connector, AllFailed) {
+    auto [socket, result] = Connector::connect(chain({resolve("127.0.0.1", closedPort()),
+                                                      resolve("127.0.0.1", closedPort())}), 100ms, createSocket, 5000);
+    ASSERT_EQ(socket, nullptr);
+    ASSERT_EQ(result.resultCode, ResultCode::ConnectGenericError);
+}
+
+TEST(Connector, EventLoop) {
+    StalledListener stalled;
+    LocalServer server([](const LocalServer::Request&) {
+        return std::string();
+    });
+    EventLoop loop;
+    ASSERT_TRUE(loop.start());
+    std::unique_ptr<Connector> connector;
+    std::promise<uint16_t> promise;
+    auto start = util::Time::steadyTime();
+    loop.post([&] {
+        connector = std::make_unique<Connector>(loop, chain({resolve("127.0.0.1", stalled.port()),
+                                                             resolve("127.0.0.1", closedPort()),
+                                                             resolve("127.0.0.1", server.port())}), 100ms, createSocket,
+                                                [&](Connector::SocketPtr socket, SocketResult result) {
+            promise.set_value(result.isSuccess() ? peerPort(*socket) : 0);
+        });
+        connector->start();
+    });
+    auto future = promise.get_future();
+    ASSERT_EQ(future.wait_for(5s), std::future_status::ready);
+    ASSERT_EQ(future.get(), server.port());
+    ///one delay for the stalled address, the refused one moves on at once
+    auto elapsed = util::Time::steadyTime() - start;
+    ASSERT_GE(elapsed, 100ms);
+    ASSERT_LT(elapsed, 2000ms);
+    loop.post([&] {
+        connector.reset();
+    });
+    loop.stop();
+}
+
+TEST(Connector, FastOpenRace) {
+    LocalServer server([](const LocalServer::Request&) {
+        return std::string();
+    });
+    server.enableFastOpen();
+    auto createFastOpenSocket = [](IPVersion ipVersion) -> ISocket* {
+        auto socket = new PlainSocket(ipVersion);
+        SocketOptions options;
+        options.isFastOpen = true;
+        socket->setOptions(options);
+        return socket;
+    };
+    ///a lone address keeps fast open, the kernel caches the cookie of 127.0.0.1 when the server hands one out
+    {
+        auto [socket, result] = Connector::connect(chain({resolve("127.0.0.1", server.port())}), 100ms,
+                                                   createFastOpenSocket, 5000);
+        ASSERT_TRUE(result.isSuccess());
+        auto [sendResult, sendSize] = socket->send("GET / HTTP/1.1\r\nHost: 127.0.0.1\r\n\r\n");
+        ASSERT_TRUE(sendResult.isSuccess());
+        std::this_thread::sleep_for(50ms);
+    }
+    StalledListener stalled;
+    auto start = util::Time::steadyTime();
+    auto [socket, result] = Connector::connect(chain({resolve("127.0.0.1", stalled.port()),
+                                                      resolve("127.0.0.1", server.port())}), 100ms,
+                                               createFastOpenSocket, 5000);
+    ASSERT_TRUE(result.isSuccess());
+    ///the stalled address can not win with a deferred syn, the race waits for a real handshake
+    ASSERT_EQ(peerPort(*socket), server.port());
+    ASSERT_LT(util::Time::steadyTime() - start, 2000ms);
+}
@@ -0,0 +1,84 @@
+//
+// Created by Nevermore on 2026/10/17.
+// http-request CoroutineTest
+// Copyright (c) 2024 Nevermore All rights reserved.
+//
+#if ENABLE_COROUTINE
+#include <gtest/gtest.h>
+#include <future>
+#include "Client.h"
+#include "LocalServer.h"
+
+using namespace http;
+using namespace std::chrono_literals;
+
+namespace {
+
+struct Result {
+    HttpStatusCode statusCode = HttpStatusCode::Unknown;
+    ResultCode resultCode = ResultCode::Success;
+    std::string body;
+};
+
+DetachedTask fetch(Client& client, std::string url, std::promise<Result>& promise) {
+    Result result;
+    auto response = co_await client.get(url);
+    if (response.header()) {
+        result.statusCode = response.header()->httpStatusCode;
+    }
+    while (auto chunk = co_await response.nextChunk()) {
+        result.body.append(chunk->view());
+    }
+    result.resultCode = response.error().retCode;
+    promise.set_value(std::move(result));
+}
+
+}
+
+TEST(Coroutine, Chunked) {
+    LocalServer server([](const LocalServer::Request& request) {
+        return std::string("HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n"
+                           "5\r\nhello\r\n1\r\n \r\n5\r\nworld\r\n0\r\n\r\n");
+    });
+    Client client;
+    std::promise<Result> promise;
+    auto future = promise.get_future();
+    fetch(client, server.url("/chunked"), promise);
+    ASSERT_EQ(future.wait_for(10s), std::future_status::ready);
+    auto result = future.get();
+    ASSERT_EQ(result.statusCode, HttpStatusCode::OK);
+    ASSERT_EQ(result.resultCode, ResultCode::Success);
+    ASSERT_EQ(result.body, "hello world");
+}
+
+TEST(Coroutine, Concurrent) {
+    constexpr int32_t kRequestCount = 50;
+    LocalServer server([](const LocalServer::Request& request) {
+        return "HTTP/1.1 200 OK\r\nContent-Length: " + std::to_string(request.path.size()) + "\r\n\r\n" + request.path;
+    });
+    ClientConfig config;
+    config.loopCount = 2;
+    Client client(config);
+    std::vector<std::promise<Result>> promises(kRequestCount);
+    for (int32_t i = 0; i < kRequestCount; i++) {
+        fetch(client, server.url("/item/" + std::to_string(i)), promises[i]);
+    }
+    for (int32_t i = 0; i < kRequestCount; i++) {
+        auto future = promises[i].get_future();
+        ASSERT_EQ(future.wait_for(10s), std::future_status::ready);
+        ASSERT_EQ(future.get().body, "/item/" + std::to_string(i));
+    }
+}
+
+TEST(Coroutine, Error) {
+    Client client;
+    std::promise<Result> promise;
+    auto future = promise.get_future();
+    fetch(client, "ftp://127.0.0.1/", promise);
+    ASSERT_EQ(future.wait_for(10s), std::future_status::ready);
+    auto result = future.get();
+    ASSERT_EQ(result.statusCode, HttpStatusCode::Unknown);
+    ASSERT_EQ(result.resultCode, ResultCode::SchemeNotSupported);
+}
+
+#endif //end if ENABLE_COROUTINE
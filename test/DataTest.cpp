@@ -94,4 +94,29 @@ TEST(Data, reset) {
     data.resetData();
     ASSERT_EQ(data.view(), "");
     ASSERT_EQ(data.length, 0);
-}
\ No newline at end of file
+}
+TEST(Data, slice) {
+    DataRefPtr buffer = std::make_shared<Data>("header body");
+    auto body = Data::slice(buffer, 7, 4);
+    ASSERT_TRUE(body->isSlice());
+    ASSERT_EQ(body->view(), "body");
+    ASSERT_EQ(body->rawData, buffer->rawData + 7);
+    ///a slice of a slice refers to the buffer owning the bytes
+    DataRefPtr shared = std::move(body);
+    auto part = Data::slice(shared, 1, 10);
+    ASSERT_EQ(part->view(), "ody");
+    ASSERT_EQ(part->owner, buffer);
+    shared.reset();
+    buffer.reset();
+    ///the slice keeps the bytes alive
+    ASSERT_EQ(part->view(), "ody");
+    auto moved = std::move(*part);
+    ASSERT_FALSE(part->isSlice());
+    ASSERT_TRUE(moved.isSlice());
+    ///appending copies the bytes out of the shared buffer first
+    moved.append(Data("!"));
+    ASSERT_FALSE(moved.isSlice());
+    ASSERT_EQ(moved.view(), "ody!");
+    ASSERT_TRUE(Data::slice(nullptr, 0, 1)->empty());
+    ASSERT_TRUE(Data::slice(std::make_shared<Data>("a"), 1, 1)->empty());
+}
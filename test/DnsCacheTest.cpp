@@ -0,0 +1,145 @@
+//
+// Created by Nevermore on 2026/10/17.
+// http-request DnsCacheTest
+// Copyright (c) 2024 Nevermore All rights reserved.
+//
+#include <gtest/gtest.h>
+#include <future>
+#include "../src/include/DnsCache.h"
+#include "Client.h"
+#include "LocalServer.h"
+
+using namespace http;
+using namespace std::chrono_literals;
+
+namespace {
+
+std::vector<std::string> addresses(const AddressInfoPtr& address) {
+    std::vector<std::string> result;
+    for (auto current = address.get(); current != nullptr; current = current->ai_next) {
+        char text[INET6_ADDRSTRLEN] = {};
+        uint16_t port = 0;
+        if (current->ai_family == AF_INET) {
+            auto ipv4 = reinterpret_cast<sockaddr_in*>(current->ai_addr);
+            inet_ntop(AF_INET, &ipv4->sin_addr, text, sizeof(text));
+            port = ntohs(ipv4->sin_port);
+        } else {
+            auto ipv6 = reinterpret_cast<sockaddr_in6*>(current->ai_addr);
+            inet_ntop(AF_INET6, &ipv6->sin6_addr, text, sizeof(text));
+            port = ntohs(ipv6->sin6_port);
+        }
+        result.push_back(std::string(text) + "/" + std::to_string(port));
+    }
+    return result;
+}
+
+}
+
+TEST(DnsCache, Resolve) {
+    DnsCache cache;
+    auto [address, errorCode] = cache.resolve("127.0.0.1", "80", IPVersion::Auto);
+    ASSERT_EQ(errorCode, 0);
+    ASSERT_EQ(addresses(address), std::vector<std::string>({"127.0.0.1/80"}));
+    auto [cached, cachedErrorCode] = cache.resolve("127.0.0.1", "80", IPVersion::Auto);
+    ASSERT_EQ(addresses(cached), std::vector<std::string>({"127.0.0.1/80"}));
+    ASSERT_EQ(cache.size(), 1);
+    ///the ip version is part of the key
+    auto [ipv6, ipv6ErrorCode] = cache.resolve("127.0.0.1", "80", IPVersion::V6);
+    ASSERT_EQ(ipv6, nullptr);
+    ASSERT_NE(ipv6ErrorCode, 0);
+    ASSERT_EQ(cache.size(), 2);
+}
+
+TEST(DnsCache, NegativeTtl) {
+    DnsCacheConfig config;
+    config.negativeTtl = 0ms;
+    DnsCache cache(config);
+    auto [address, errorCode] = cache.resolve("127.0.0.1", "not-a-port", IPVersion::V4);
+    ASSERT_EQ(address, nullptr);
+    ASSERT_NE(errorCode, 0);
+    ASSERT_EQ(cache.size(), 0);
+    config.negativeTtl = 1s;
+    cache.setConfig(config);
+    auto [failed, failedErrorCode] = cache.resolve("127.0.0.1", "not-a-port", IPVersion::V4);
+    ASSERT_EQ(failedErrorCode, errorCode);
+    ASSERT_EQ(cache.size(), 1);
+}
+
+TEST(DnsCache, Lru) {
+    DnsCacheConfig config;
+    config.maxEntries = 2;
+    DnsCache cache(config);
+    ASSERT_EQ(std::get<1>(cache.resolve("127.0.0.1", "1", IPVersion::V4)), 0);
+    ASSERT_EQ(std::get<1>(cache.resolve("127.0.0.2", "1", IPVersion::V4)), 0);
+    ASSERT_EQ(std::get<1>(cache.resolve("127.0.0.1", "1", IPVersion::V4)), 0);
+    ASSERT_EQ(std::get<1>(cache.resolve("127.0.0.3", "1", IPVersion::V4)), 0);
+    ASSERT_EQ(cache.size(), 2);
+    config.maxEntries = 1;
+    cache.setConfig(config);
+    ASSERT_EQ(cache.size(), 1);
+    config.maxEntries = 0;
+    cache.setConfig(config);
+    ASSERT_EQ(std::get<1>(cache.resolve("127.0.0.1", "1", IPVersion::V4)), 0);
+    ASSERT_EQ(cache.size(), 0);
+}
+
+TEST(DnsCache, StaleWhileRefresh) {
+    DnsCacheConfig config;
+    config.ttl = 20ms;
+    DnsCache cache(config);
+    ASSERT_EQ(std::get<1>(cache.resolve("127.0.0.1", "80", IPVersion::V4)), 0);
+    std::this_thread::sleep_for(50ms);
+    ///expired, the stale address is handed out and refreshed in the background
+    auto [stale, errorCode] = cache.resolve("127.0.0.1", "80", IPVersion::V4);
+    ASSERT_EQ(addresses(stale), std::vector<std::string>({"127.0.0.1/80"}));
+    ASSERT_EQ(cache.size(), 1);
+    cache.clear();
+    ASSERT_EQ(cache.size(), 0);
+}
+
+TEST(DnsCache, Override) {
+    DnsCache cache;
+    cache.setOverride("dns-override.test", "8080", {"10.0.0.1", "::1", "not-an-address"});
+    ASSERT_EQ(addresses(std::get<0>(cache.resolve("dns-override.test", "8080", IPVersion::Auto))),
+              std::vector<std::string>({"10.0.0.1/8080", "::1/8080"}));
+    ASSERT_EQ(addresses(std::get<0>(cache.resolve("dns-override.test", "8080", IPVersion::V6))),
+              std::vector<std::string>({"::1/8080"}));
+    ///an override is never cached
+    ASSERT_EQ(cache.size(), 0);
+    cache.setOverride("127.0.0.1", "80", {"10.0.0.2"});
+    ASSERT_EQ(addresses(std::get<0>(cache.resolve("127.0.0.1", "80", IPVersion::V4))),
+              std::vector<std::string>({"10.0.0.2/80"}));
+    cache.setOverride("127.0.0.1", "80", {});
+    ASSERT_EQ(addresses(std::get<0>(cache.resolve("127.0.0.1", "80", IPVersion::V4))),
+              std::vector<std::string>({"127.0.0.1/80"}));
+}
+
+TEST(DnsCache, ClientOverride) {
+    LocalServer server([](const LocalServer::Request& request) {
+        return "HTTP/1.1 200 OK\r\nContent-Length: " + std::to_string(request.headers.at("Host").size()) + "\r\n\r\n" +
+               request.headers.at("Host");
+    });
+    auto port = std::to_string(server.port());
+    Request::setHostOverride("dns-override.test", port, {"127.0.0.1"});
+    Client client;
+    std::promise<std::string> promise;
+    std::string body;
+    RequestInfo info;
+    info.url = "http://dns-override.test:" + port + "/";
+    info.methodType = HttpMethodType::Get;
+    ResponseHandler handler;
+    handler.onData = [&](std::string_view, DataPtr data) {
+        body.append(data->view());
+    };
+    handler.onDisconnected = [&](std::string_view) {
+        promise.set_value(body);
+    };
+    handler.onError = [](std::string_view, ErrorInfo info) {
+        ASSERT_EQ(info.retCode, ResultCode::Success);
+    };
+    client.request(std::move(info), std::move(handler));
+    auto future = promise.get_future();
+    ASSERT_EQ(future.wait_for(5s), std::future_status::ready);
+    ASSERT_EQ(future.get(), "dns-override.test");
+    Request::setHostOverride("dns-override.test", port, {});
+}
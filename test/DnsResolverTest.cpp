@@ -0,0 +1,302 @@
+//
+// Created by Nevermore on 2026/10/17.
+// http-request DnsResolverTest
+// Copyright (c) 2024 Nevermore All rights reserved.
+//
+#include <gtest/gtest.h>
+#include <atomic>
+#include <fstream>
+#include <future>
+#include <map>
+#include <thread>
+#include "../src/include/DnsResolver.h"
+#include "Client.h"
+#include "LocalServer.h"
+
+using namespace http;
+using namespace std::chrono_literals;
+
+namespace {
+
+///A nameserver on the loopback answering the A and AAAA queries of its records, other names do not exist.
+///A silent server never answers.
+class StubDnsServer {
+public:
+    struct Record {
+        std::vector<std::string> ipv4;
+        std::vector<std::string> ipv6;
+        uint32_t ttl = 30;
+    };
+
+    explicit StubDnsServer(std::map<std::string, Record> records, bool isSilent = false)
+        : records_(std::move(records))
+        , isSilent_(isSilent) {
+        fd_ = ::socket(AF_INET, SOCK_DGRAM, 0);
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        ::bind(fd_, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+        socklen_t length = sizeof(address);
+        getsockname(fd_, reinterpret_cast<sockaddr*>(&address), &length);
+        port_ = ntohs(address.sin_port);
+        worker_ = std::thread([this] {
+            serve();
+        });
+    }
+
+    ~StubDnsServer() {
+        isRunning_ = false;
+        worker_.join();
+        ::close(fd_);
+    }
+
+    [[nodiscard]] std::string nameserver() const {
+        return "127.0.0.1:" + std::to_string(port_);
+    }
+
+    [[nodiscard]] uint32_t queryCount() const {
+        return queryCount_;
+    }
+
+private:
+    static void append16(std::string& data, uint16_t value) {
+        data.push_back(static_cast<char>(value >> 8));
+        data.push_back(static_cast<char>(value & 0xFF));
+    }
+
+    void serve() {
+        char buffer[512];
+        while (isRunning_) {
+            if (!select(SelectType::Read, fd_, 20).isSuccess()) {
+                continue;
+            }
+            sockaddr_storage peer{};
+            socklen_t peerLength = sizeof(peer);
+            auto size = ::recvfrom(fd_, buffer, sizeof(buffer), 0, reinterpret_cast<sockaddr*>(&peer), &peerLength);
+            if (size < 12) {
+                continue;
+            }
+            queryCount_++;
+            if (isSilent_) {
+                continue;
+            }
+            auto response = answer(std::string(buffer, static_cast<size_t>(size)));
+            ::sendto(fd_, response.data(), response.size(), 0, reinterpret_cast<sockaddr*>(&peer), peerLength);
+        }
+    }
+
+    std::string answer(const std::string& query) {
+        std::string name;
+        size_t pos = 12;
+        while (pos < query.size() && query[pos] != 0) {
+            auto length = static_cast<uint8_t>(query[pos]);
+            name += (name.empty() ? "" : ".") + query.substr(pos + 1, length);
+            pos += 1 + length;
+        }
+        auto type = static_cast<uint16_t>(static_cast<uint8_t>(query[pos + 1]) << 8 | static_cast<uint8_t>(query[pos + 2]));
+        auto question = query.substr(12, pos + 5 - 12);
+        auto it = records_.find(name);
+        std::vector<std::string> addresses;
+        if (it != records_.end()) {
+            addresses = type == 1 ? it->second.ipv4 : it->second.ipv6;
+        }
+        std::string response = query.substr(0, 2);
+        append16(response, static_cast<uint16_t>(0x8180 | (it == records_.end() ? 3 : 0)));
+        append16(response, 1);
+        append16(response, static_cast<uint16_t>(addresses.size()));
+        append16(response, 0);
+        append16(response, 0);
+        response += question;
+        for (const auto& address : addresses) {
+            append16(response, 0xC00C); //the name of the question
+            append16(response, type);
+            append16(response, 1);
+            append16(response, static_cast<uint16_t>(it->second.ttl >> 16));
+            append16(response, static_cast<uint16_t>(it->second.ttl & 0xFFFF));
+            char data[16] = {};
+            auto length = type == 1 ? 4 : 16;
+            inet_pton(type == 1 ? AF_INET : AF_INET6, address.data(), data);
+            append16(response, static_cast<uint16_t>(length));
+            response.append(data, static_cast<size_t>(length));
+        }
+        return response;
+    }
+
+private:
+    std::map<std::string, Record> records_;
+    bool isSilent_ = false;
+    int fd_ = -1;
+    uint16_t port_ = 0;
+    std::atomic<bool> isRunning_ = true;
+    std::atomic<uint32_t> queryCount_ = 0;
+    std::thread worker_;
+};
+
+std::vector<std::string> addresses(const DnsCache::AddressList& list) {
+    std::vector<std::string> result;
+    for (const auto& address : list) {
+        char text[INET6_ADDRSTRLEN] = {};
+        uint16_t port = 0;
+        if (address.storage.ss_family == AF_INET) {
+            auto ipv4 = reinterpret_cast<const sockaddr_in*>(&address.storage);
+            inet_ntop(AF_INET, &ipv4->sin_addr, text, sizeof(text));
+            port = ntohs(ipv4->sin_port);
+        } else {
+            auto ipv6 = reinterpret_cast<const sockaddr_in6*>(&address.storage);
+            inet_ntop(AF_INET6, &ipv6->sin6_addr, text, sizeof(text));
+            port = ntohs(ipv6->sin6_port);
+        }
+        result.push_back(std::string(text) + "/" + std::to_string(port));
+    }
+    return result;
+}
+
+///enable the shared resolver for the scope of a test
+class ResolverScope {
+public:
+    explicit ResolverScope(std::vector<std::string> nameservers,
+                           std::chrono::milliseconds attemptTimeout = 2000ms) {
+        DnsResolverConfig config;
+        config.isEnabled = true;
+        config.nameservers = std::move(nameservers);
+        config.attemptTimeout = attemptTimeout;
+        config.attempts = 1;
+        Request::setDnsResolverConfig(config);
+        Request::clearDnsCache();
+    }
+
+    ~ResolverScope() {
+        Request::setDnsResolverConfig({});
+        Request::clearDnsCache();
+    }
+};
+
+}
+
+TEST(DnsResolver, LoadNameservers) {
+    auto path = testing::TempDir() + "resolv.conf";
+    std::ofstream(path) << "# generated\nsearch example.test\nnameserver 10.0.0.1\n"
+                           "nameserver ::1 ; comment\noptions ndots:1\n";
+    ASSERT_EQ(DnsResolver::loadNameservers(path), std::vector<std::string>({"10.0.0.1", "::1"}));
+    ASSERT_TRUE(DnsResolver::loadNameservers(path + ".missing").empty());
+}
+
+TEST(DnsResolver, Resolve) {
+    StubDnsServer server({{"dual.test", {{"10.0.0.1", "10.0.0.2"}, {"fd00::1"}, 30}}});
+    ResolverScope scope({server.nameserver()});
+    ASSERT_TRUE(DnsResolver::shared().isEnabled());
+    auto result = DnsResolver::shared().resolve("dual.test", "8080", IPVersion::Auto, 5000);
+    ASSERT_EQ(result.errorCode, 0);
+    ///both queries go out together, the AAAA answers are in front
+    ASSERT_EQ(addresses(result.addresses), std::vector<std::string>({"fd00::1/8080", "10.0.0.1/8080", "10.0.0.2/8080"}));
+    ASSERT_EQ(result.ttl, 30s);
+    ASSERT_EQ(server.queryCount(), 2);
+    auto ipv4 = DnsResolver::shared().resolve("dual.test.", "80", IPVersion::V4, 5000);
+    ASSERT_EQ(addresses(ipv4.addresses), std::vector<std::string>({"10.0.0.1/80", "10.0.0.2/80"}));
+    ASSERT_EQ(server.queryCount(), 3);
+}
+
+TEST(DnsResolver, NameError) {
+    StubDnsServer server({});
+    ResolverScope scope({server.nameserver()});
+    auto start = util::Time::steadyTime();
+    auto result = DnsResolver::shared().resolve("missing.test", "80", IPVersion::Auto, 5000);
+    ASSERT_EQ(result.errorCode, EAI_NONAME);
+    ASSERT_TRUE(result.addresses.empty());
+    ASSERT_LT(util::Time::steadyTime() - start, 1000ms);
+}
+
+TEST(DnsResolver, WithoutQuery) {
+    StubDnsServer server({});
+    ResolverScope scope({server.nameserver()});
+    auto result = DnsResolver::shared().resolve("::1", "80", IPVersion::Auto, 5000);
+    ASSERT_EQ(addresses(result.addresses), std::vector<std::string>({"::1/80"}));
+    ASSERT_EQ(DnsResolver::shared().resolve("::1", "80", IPVersion::V4, 5000).errorCode, EAI_NONAME);
+    ASSERT_EQ(DnsResolver::shared().resolve("dual.test", "not-a-port", IPVersion::V4, 5000).errorCode, EAI_SERVICE);
+    ASSERT_EQ(DnsResolver::shared().resolve("bad..name", "80", IPVersion::V4, 5000).errorCode, EAI_NONAME);
+    ASSERT_EQ(server.queryCount(), 0);
+}
+
+TEST(DnsResolver, NextServer) {
+    StubDnsServer silent({}, true);
+    StubDnsServer server({{"next.test", {{"10.0.0.3"}, {}, 30}}});
+    ResolverScope scope({silent.nameserver(), server.nameserver()}, 200ms);
+    auto start = util::Time::steadyTime();
+    auto result = DnsResolver::shared().resolve("next.test", "80", IPVersion::V4, 5000);
+    auto elapsed = util::Time::steadyTime() - start;
+    ASSERT_EQ(addresses(result.addresses), std::vector<std::string>({"10.0.0.3/80"}));
+    ASSERT_EQ(silent.queryCount(), 1);
+    ///the silent server had the attempt timeout to answer
+    ASSERT_GE(elapsed, 200ms);
+    ASSERT_LT(elapsed, 2000ms);
+}
+
+TEST(DnsResolver, Timeout) {
+    StubDnsServer silent({}, true);
+    ResolverScope scope({silent.nameserver()});
+    auto start = util::Time::steadyTime();
+    auto result = DnsResolver::shared().resolve("slow.test", "80", IPVersion::Auto, 100);
+    auto elapsed = util::Time::steadyTime() - start;
+    ASSERT_EQ(result.errorCode, EAI_AGAIN);
+    ///the deadline of the caller wins over the attempt timeout
+    ASSERT_GE(elapsed, 90ms);
+    ASSERT_LT(elapsed, 1000ms);
+}
+
+TEST(DnsResolver, EventLoop) {
+    StubDnsServer server({{"loop.test", {{"10.0.0.4"}, {}, 30}}});
+    ResolverScope scope({server.nameserver()});
+    EventLoop loop;
+    ASSERT_TRUE(loop.start());
+    std::unique_ptr<DnsQuery> query;
+    std::promise<int32_t> promise;
+    loop.post([&] {
+        query = std::make_unique<DnsQuery>(loop, "loop.test", "80", IPVersion::V4,
+                                           [&](AddressInfoPtr address, int32_t errorCode) {
+            promise.set_value(address ? 0 : errorCode);
+        });
+        query->start();
+    });
+    auto future = promise.get_future();
+    ASSERT_EQ(future.wait_for(5s), std::future_status::ready);
+    ASSERT_EQ(future.get(), 0);
+    ///the answer is cached with the ttl of the record
+    auto [address, errorCode, isFound] = DnsCache::shared().find("loop.test", "80", IPVersion::V4);
+    ASSERT_TRUE(isFound);
+    ASSERT_NE(address, nullptr);
+    ASSERT_EQ(server.queryCount(), 1);
+    loop.post([&] {
+        query.reset();
+    });
+    loop.stop();
+}
+
+TEST(DnsResolver, Client) {
+    LocalServer server([](const LocalServer::Request&) {
+        return std::string("HTTP/1.1 200 OK\r\nContent-Length: 2\r\n\r\nok");
+    });
+    StubDnsServer nameserver({{"client.test", {{"127.0.0.1"}, {}, 30}}});
+    ResolverScope scope({nameserver.nameserver()});
+    Client client;
+    std::promise<std::string> promise;
+    std::string body;
+    RequestInfo info;
+    info.url = "http://client.test:" + std::to_string(server.port()) + "/";
+    info.methodType = HttpMethodType::Get;
+    info.ipVersion = IPVersion::V4;
+    ResponseHandler handler;
+    handler.onData = [&](std::string_view, DataPtr data) {
+        body.append(data->view());
+    };
+    handler.onDisconnected = [&](std::string_view) {
+        promise.set_value(body);
+    };
+    handler.onError = [&](std::string_view, ErrorInfo info) {
+        promise.set_value("error " + std::to_string(static_cast<int>(info.retCode)));
+    };
+    client.request(std::move(info), std::move(handler));
+    auto future = promise.get_future();
+    ASSERT_EQ(future.wait_for(5s), std::future_status::ready);
+    ASSERT_EQ(future.get(), "ok");
+    ASSERT_EQ(nameserver.queryCount(), 1);
+}
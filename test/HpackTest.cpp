@@ -0,0 +1,89 @@
+//
+// Created by Nevermore on 2026/10/17.
+// http-request HpackTest
+// Copyright (c) 2024 Nevermore All rights reserved.
+//
+#include <gtest/gtest.h>
+#include "../src/include/Hpack.h"
+
+using namespace http::hpack;
+
+namespace {
+
+std::string fromHex(std::string_view hex) {
+    std::string out;
+    for (size_t i = 0; i + 1 < hex.size(); i += 2) {
+        out.push_back(static_cast<char>(std::stoi(std::string(hex.substr(i, 2)), nullptr, 16)));
+    }
+    return out;
+}
+
+}
+
+///https://www.rfc-editor.org/rfc/rfc7541#appendix-C.4, requests with huffman coding sharing one dynamic table
+TEST(Hpack, DecodeRequests) {
+    Decoder decoder;
+    HeaderList headers;
+    ASSERT_TRUE(decoder.decode(fromHex("828684418cf1e3c2e5f23a6ba0ab90f4ff"), headers));
+    ASSERT_EQ(headers, (HeaderList{{":method", "GET"}, {":scheme", "http"}, {":path", "/"}, {":authority", "www.example.com"}}));
+
+    headers.clear();
+    ASSERT_TRUE(decoder.decode(fromHex("828684be5886a8eb10649cbf"), headers));
+    ASSERT_EQ(headers, (HeaderList{{":method", "GET"}, {":scheme", "http"}, {":path", "/"},
+                                   {":authority", "www.example.com"}, {"cache-control", "no-cache"}}));
+
+    headers.clear();
+    ASSERT_TRUE(decoder.decode(fromHex("828785bf408825a849e95ba97d7f8925a849e95bb8e8b4bf"), headers));
+    ASSERT_EQ(headers, (HeaderList{{":method", "GET"}, {":scheme", "https"}, {":path", "/index.html"},
+                                   {":authority", "www.example.com"}, {"custom-key", "custom-value"}}));
+}
+
+///https://www.rfc-editor.org/rfc/rfc7541#appendix-C.6, responses evicting from a 256 bytes table
+TEST(Hpack, DecodeResponsesWithEviction) {
+    Decoder decoder(256);
+    HeaderList headers;
+    ASSERT_TRUE(decoder.decode(fromHex("488264025885aec3771a4b6196d07abe941054d444a8200595040b8166e082a62d1bff6e919d29ad171863c78f0b97c8e9ae82ae43d3"), headers));
+    ASSERT_EQ(headers, (HeaderList{{":status", "302"}, {"cache-control", "private"},
+                                   {"date", "Mon, 21 Oct 2013 20:13:21 GMT"}, {"location", "https://www.example.com"}}));
+
+    headers.clear();
+    ASSERT_TRUE(decoder.decode(fromHex("4883640effc1c0bf"), headers));
+    ASSERT_EQ(headers, (HeaderList{{":status", "307"}, {"cache-control", "private"},
+                                   {"date", "Mon, 21 Oct 2013 20:13:21 GMT"}, {"location", "https://www.example.com"}}));
+
+    headers.clear();
+    ASSERT_TRUE(decoder.decode(fromHex("88c16196d07abe941054d444a8200595040b8166e084a62d1bffc05a839bd9ab77ad94e7821dd7f2e6c7b335dfdf"
+                                       "cd5b3960d5af27087f3672c1ab270fb5291f9587316065c003ed4ee5b1063d5007"), headers));
+    ASSERT_EQ(headers, (HeaderList{{":status", "200"}, {"cache-control", "private"}, {"date", "Mon, 21 Oct 2013 20:13:22 GMT"},
+                                   {"location", "https://www.example.com"}, {"content-encoding", "gzip"},
+                                   {"set-cookie", "foo=ASDJKHQKBZXOQWEOPIUAXQWEOIU; max-age=3600; version=1"}}));
+}
+
+TEST(Hpack, RoundTrip) {
+    HeaderList headers{{":method", "GET"}, {":path", "/index.html"}, {":authority", "127.0.0.1:8080"},
+                       {"accept-encoding", "gzip, deflate"}, {"x-binary", std::string("\0\xff\r\n", 4)},
+                       {"x-long", std::string(300, 'a')}, {"empty", ""}};
+    std::string block;
+    Encoder().encode(headers, block);
+    Decoder decoder;
+    HeaderList decoded;
+    ASSERT_TRUE(decoder.decode(block, decoded));
+    ASSERT_EQ(decoded, headers);
+}
+
+TEST(Hpack, Invalid) {
+    Decoder decoder;
+    HeaderList headers;
+    ///index 0 and an index past both tables
+    ASSERT_FALSE(decoder.decode(fromHex("80"), headers));
+    ASSERT_FALSE(decoder.decode(fromHex("ff00"), headers));
+    ///a string longer than the block
+    ASSERT_FALSE(decoder.decode(fromHex("400a6b"), headers));
+    ///a table size over the announced one
+    ASSERT_FALSE(decoder.decode(fromHex("3fe21f"), headers));
+
+    std::string out;
+    ///EOS inside the string and padding that is not all ones
+    ASSERT_FALSE(huffmanDecode(fromHex("ffffffff"), out));
+    ASSERT_FALSE(huffmanDecode(fromHex("00"), out));
+}
@@ -0,0 +1,506 @@
+//
+// Created by Nevermore on 2026/10/17.
+// http-request LocalHttp2Server
+// Copyright (c) 2024 Nevermore All rights reserved.
+//
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#if ENABLE_HTTPS
+#include <openssl/ssl.h>
+#include <openssl/x509.h>
+#endif
+#include "../src/include/Hpack.h"
+
+///Minimal blocking HTTP/2 server on the loopback interface for tests.
+///Plain connections speak h2c with prior knowledge, with isTls h2 is selected with ALPN.
+///The responses honor the flow control windows of the client, the requests are answered one after another.
+class LocalHttp2Server {
+public:
+    struct Request {
+        uint32_t streamId = 0;
+        std::string method;
+        std::string path;
+        std::unordered_map<std::string, std::string> headers;
+        std::string body;
+    };
+    struct Response {
+        uint32_t status = 200;
+        std::vector<std::pair<std::string, std::string>> headers;
+        std::string body;
+    };
+    using Responder = std::function<Response(const Request&)>;
+
+    struct Config {
+        bool isTls = false;
+        ///announced SETTINGS_MAX_CONCURRENT_STREAMS, 0 leaves it unlimited
+        uint32_t maxConcurrentStreams = 0;
+        ///send GOAWAY after this many responses on a connection and close it, 0 never does
+        uint32_t goAwayAfter = 0;
+    };
+
+    explicit LocalHttp2Server(Responder responder)
+        : LocalHttp2Server(std::move(responder), Config{}) {
+
+    }
+
+    LocalHttp2Server(Responder responder, Config config)
+        : responder_(std::move(responder))
+        , config_(config) {
+#if ENABLE_HTTPS
+        if (config_.isTls) {
+            initTls();
+        }
+#endif
+        listenFd_ = ::socket(AF_INET, SOCK_STREAM, 0);
+        int value = 1;
+        setsockopt(listenFd_, SOL_SOCKET, SO_REUSEADDR, &value, sizeof(value));
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        address.sin_port = 0;
+        ::bind(listenFd_, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+        socklen_t length = sizeof(address);
+        getsockname(listenFd_, reinterpret_cast<sockaddr*>(&address), &length);
+        port_ = ntohs(address.sin_port);
+        ::listen(listenFd_, 1024);
+        acceptor_ = std::thread([this] {
+            acceptLoop();
+        });
+    }
+
+    ~LocalHttp2Server() {
+        isRunning_ = false;
+        acceptor_.join();
+        {
+            std::lock_guard lock(mutex_);
+            for (auto fd : clients_) {
+                ::shutdown(fd, SHUT_RD);
+            }
+        }
+        for (auto& worker : workers_) {
+            worker.join();
+        }
+        ::close(listenFd_);
+#if ENABLE_HTTPS
+        if (sslContext_) {
+            SSL_CTX_free(sslContext_);
+        }
+#endif
+    }
+
+    [[nodiscard]] std::string url(const std::string& path = "/") const {
+        return (config_.isTls ? "https://127.0.0.1:" : "http://127.0.0.1:") + std::to_string(port_) + path;
+    }
+
+    [[nodiscard]] int32_t connectionCount() const {
+        return connectionCount_;
+    }
+
+    [[nodiscard]] int32_t requestCount() const {
+        return requestCount_;
+    }
+
+    ///the most requests that were open on one connection at the same time
+    [[nodiscard]] int32_t maxOpenStreams() const {
+        return maxOpenStreams_;
+    }
+
+private:
+    struct Frame {
+        uint8_t type = 0;
+        uint8_t flags = 0;
+        uint32_t streamId = 0;
+        std::string payload;
+    };
+
+    struct Connection {
+        int fd = -1;
+#if ENABLE_HTTPS
+        SSL* ssl = nullptr;
+#endif
+        std::string buffer;
+        http::hpack::Decoder decoder;
+        int64_t sendWindow = 65535;
+        int64_t initialWindow = 65535;
+        uint32_t maxFrameSize = 16384;
+        std::map<uint32_t, int64_t> streamWindows;
+        ///the requests still being received
+        std::map<uint32_t, Request> pending;
+        std::deque<Request> ready;
+
+        bool readMore() {
+            char data[16384];
+            ssize_t size;
+#if ENABLE_HTTPS
+            if (ssl) {
+                size = SSL_read(ssl, data, sizeof(data));
+            } else
+#endif
+            {
+                size = ::recv(fd, data, sizeof(data), 0);
+            }
+            if (size <= 0) {
+                return false;
+            }
+            buffer.append(data, static_cast<size_t>(size));
+            return true;
+        }
+
+        void write(const std::string& data) const {
+#if ENABLE_HTTPS
+            if (ssl) {
+                SSL_write(ssl, data.data(), static_cast<int>(data.size()));
+                return;
+            }
+#endif
+            ::send(fd, data.data(), data.size(), MSG_NOSIGNAL);
+        }
+
+        bool readFrame(Frame& frame) {
+            while (buffer.size() < 9) {
+                if (!readMore()) {
+                    return false;
+                }
+            }
+            auto byte = [this](size_t i) {
+                return static_cast<uint32_t>(static_cast<uint8_t>(buffer[i]));
+            };
+            auto length = byte(0) << 16 | byte(1) << 8 | byte(2);
+            frame.type = static_cast<uint8_t>(byte(3));
+            frame.flags = static_cast<uint8_t>(byte(4));
+            frame.streamId = (byte(5) << 24 | byte(6) << 16 | byte(7) << 8 | byte(8)) & 0x7fffffff;
+            while (buffer.size() < 9 + length) {
+                if (!readMore()) {
+                    return false;
+                }
+            }
+            frame.payload = buffer.substr(9, length);
+            buffer.erase(0, 9 + length);
+            return true;
+        }
+    };
+
+    static void appendUint32(std::string& out, uint32_t value) {
+        out.push_back(static_cast<char>(value >> 24));
+        out.push_back(static_cast<char>(value >> 16));
+        out.push_back(static_cast<char>(value >> 8));
+        out.push_back(static_cast<char>(value));
+    }
+
+    static uint32_t readUint32(const std::string& data, size_t pos) {
+        return static_cast<uint32_t>(static_cast<uint8_t>(data[pos])) << 24 |
+               static_cast<uint32_t>(static_cast<uint8_t>(data[pos + 1])) << 16 |
+               static_cast<uint32_t>(static_cast<uint8_t>(data[pos + 2])) << 8 |
+               static_cast<uint32_t>(static_cast<uint8_t>(data[pos + 3]));
+    }
+
+    static std::string makeFrame(uint8_t type, uint8_t flags, uint32_t streamId, const std::string& payload) {
+        std::string out;
+        auto length = static_cast<uint32_t>(payload.size());
+        out.push_back(static_cast<char>(length >> 16));
+        out.push_back(static_cast<char>(length >> 8));
+        out.push_back(static_cast<char>(length));
+        out.push_back(static_cast<char>(type));
+        out.push_back(static_cast<char>(flags));
+        appendUint32(out, streamId);
+        return out + payload;
+    }
+
+#if ENABLE_HTTPS
+    void initTls() {
+        sslContext_ = SSL_CTX_new(TLS_server_method());
+        auto key = EVP_EC_gen("P-256");
+        auto cert = X509_new();
+        X509_set_version(cert, 2);
+        ASN1_INTEGER_set(X509_get_serialNumber(cert), 1);
+        X509_gmtime_adj(X509_getm_notBefore(cert), 0);
+        X509_gmtime_adj(X509_getm_notAfter(cert), 3600);
+        X509_set_pubkey(cert, key);
+        auto name = X509_get_subject_name(cert);
+        X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC, reinterpret_cast<const unsigned char*>("127.0.0.1"), -1, -1, 0);
+        X509_set_issuer_name(cert, name);
+        X509_sign(cert, key, EVP_sha256());
+        SSL_CTX_use_certificate(sslContext_, cert);
+        SSL_CTX_use_PrivateKey(sslContext_, key);
+        X509_free(cert);
+        EVP_PKEY_free(key);
+        SSL_CTX_set_alpn_select_cb(sslContext_, [](SSL*, const unsigned char** out, unsigned char* outLength,
+                                                   const unsigned char* in, unsigned int inLength, void*) {
+            static const unsigned char kH2[] = {2, 'h', '2'};
+            unsigned char* selected = nullptr;
+            if (SSL_select_next_proto(&selected, outLength, kH2, sizeof(kH2), in, inLength) != OPENSSL_NPN_NEGOTIATED) {
+                return SSL_TLSEXT_ERR_NOACK;
+            }
+            *out = selected;
+            return SSL_TLSEXT_ERR_OK;
+        }, nullptr);
+    }
+#endif
+
+    void acceptLoop() {
+        while (isRunning_) {
+            pollfd pfd{listenFd_, POLLIN, 0};
+            if (::poll(&pfd, 1, 20) <= 0) {
+                continue;
+            }
+            auto fd = ::accept(listenFd_, nullptr, nullptr);
+            if (fd < 0) {
+                continue;
+            }
+            connectionCount_++;
+            std::lock_guard lock(mutex_);
+            clients_.push_back(fd);
+            workers_.emplace_back([this, fd] {
+                serve(fd);
+            });
+        }
+    }
+
+    void closeClient(Connection& connection) {
+#if ENABLE_HTTPS
+        if (connection.ssl) {
+            SSL_shutdown(connection.ssl);
+            SSL_free(connection.ssl);
+        }
+#endif
+        std::lock_guard lock(mutex_);
+        clients_.erase(std::remove(clients_.begin(), clients_.end(), connection.fd), clients_.end());
+        ::close(connection.fd);
+    }
+
+    ///false if the connection is closed
+    bool handleFrame(Connection& connection) {
+        Frame frame;
+        if (!connection.readFrame(frame)) {
+            return false;
+        }
+        switch (frame.type) {
+            case 0x0: { //DATA
+                std::string increment;
+                appendUint32(increment, static_cast<uint32_t>(frame.payload.size()));
+                auto it = connection.pending.find(frame.streamId);
+                if (it == connection.pending.end()) {
+                    ///a refused stream, only the connection window is returned
+                    if (!frame.payload.empty()) {
+                        connection.write(makeFrame(0x8, 0, 0, increment));
+                    }
+                    break;
+                }
+                auto& request = it->second;
+                request.body += frame.payload;
+                if (!frame.payload.empty()) {
+                    connection.write(makeFrame(0x8, 0, 0, increment) + makeFrame(0x8, 0, frame.streamId, increment));
+                }
+                if (frame.flags & 0x1) {
+                    connection.ready.push_back(std::move(request));
+                    connection.pending.erase(frame.streamId);
+                }
+                break;
+            }
+            case 0x1: { //HEADERS, the client never sends CONTINUATION for these small blocks
+                http::hpack::HeaderList fields;
+                if (!connection.decoder.decode(frame.payload, fields)) {
+                    return false;
+                }
+                if (config_.maxConcurrentStreams > 0 && connection.streamWindows.size() >= config_.maxConcurrentStreams) {
+                    ///the client may open more before it sees our settings, refused streams are safe to retry
+                    std::string errorCode;
+                    appendUint32(errorCode, 0x7);
+                    connection.write(makeFrame(0x3, 0, frame.streamId, errorCode));
+                    break;
+                }
+                Request request;
+                request.streamId = frame.streamId;
+                for (auto& [name, value] : fields) {
+                    if (name == ":method") {
+                        request.method = value;
+                    } else if (name == ":path") {
+                        request.path = value;
+                    } else {
+                        request.headers[name] = value;
+                    }
+                }
+                connection.streamWindows[frame.streamId] = connection.initialWindow;
+                if (frame.flags & 0x1) {
+                    connection.ready.push_back(std::move(request));
+                } else {
+                    connection.pending[frame.streamId] = std::move(request);
+                }
+                auto openCount = static_cast<int32_t>(connection.streamWindows.size());
+                auto current = maxOpenStreams_.load();
+                while (openCount > current && !maxOpenStreams_.compare_exchange_weak(current, openCount)) {
+                }
+                break;
+            }
+            case 0x3: //RST_STREAM
+                connection.pending.erase(frame.streamId);
+                connection.streamWindows.erase(frame.streamId);
+                break;
+            case 0x4: //SETTINGS
+                if ((frame.flags & 0x1) == 0) {
+                    for (size_t pos = 0; pos + 6 <= frame.payload.size(); pos += 6) {
+                        auto id = static_cast<uint8_t>(frame.payload[pos]) << 8 | static_cast<uint8_t>(frame.payload[pos + 1]);
+                        auto value = readUint32(frame.payload, pos + 2);
+                        if (id == 0x4) {
+                            for (auto& [streamId, window] : connection.streamWindows) {
+                                window += static_cast<int64_t>(value) - connection.initialWindow;
+                            }
+                            connection.initialWindow = value;
+                        }
+                    }
+                    connection.write(makeFrame(0x4, 0x1, 0, {}));
+                }
+                break;
+            case 0x6: //PING
+                if ((frame.flags & 0x1) == 0) {
+                    connection.write(makeFrame(0x6, 0x1, 0, frame.payload));
+                }
+                break;
+            case 0x7: //GOAWAY
+                return false;
+            case 0x8: { //WINDOW_UPDATE
+                auto increment = readUint32(frame.payload, 0) & 0x7fffffff;
+                if (frame.streamId == 0) {
+                    connection.sendWindow += increment;
+                } else if (connection.streamWindows.count(frame.streamId)) {
+                    connection.streamWindows[frame.streamId] += increment;
+                }
+                break;
+            }
+            default:
+                break;
+        }
+        return true;
+    }
+
+    bool respond(Connection& connection, const Request& request) {
+        requestCount_++;
+        auto response = responder_(request);
+        http::hpack::HeaderList fields{{":status", std::to_string(response.status)}};
+        for (auto& header : response.headers) {
+            fields.push_back(header);
+        }
+        fields.emplace_back("content-length", std::to_string(response.body.size()));
+        std::string block;
+        http::hpack::Encoder().encode(fields, block);
+        auto streamId = request.streamId;
+        connection.write(makeFrame(0x1, static_cast<uint8_t>(0x4 | (response.body.empty() ? 0x1 : 0)), streamId, block));
+        size_t offset = 0;
+        while (offset < response.body.size()) {
+            if (connection.streamWindows.count(streamId) == 0) {
+                ///the client reset the stream
+                return true;
+            }
+            auto window = std::min(connection.sendWindow, connection.streamWindows[streamId]);
+            if (window <= 0) {
+                if (!handleFrame(connection)) {
+                    return false;
+                }
+                continue;
+            }
+            auto size = std::min<size_t>({response.body.size() - offset, connection.maxFrameSize, static_cast<size_t>(window)});
+            auto isLast = offset + size == response.body.size();
+            connection.write(makeFrame(0x0, isLast ? 0x1 : 0, streamId, response.body.substr(offset, size)));
+            offset += size;
+            connection.sendWindow -= static_cast<int64_t>(size);
+            connection.streamWindows[streamId] -= static_cast<int64_t>(size);
+        }
+        connection.streamWindows.erase(streamId);
+        return true;
+    }
+
+    void serve(int socket) {
+        Connection connection;
+        connection.fd = socket;
+#if ENABLE_HTTPS
+        if (config_.isTls) {
+            connection.ssl = SSL_new(sslContext_);
+            SSL_set_fd(connection.ssl, socket);
+            if (SSL_accept(connection.ssl) <= 0) {
+                closeClient(connection);
+                return;
+            }
+        }
+#endif
+        constexpr std::string_view kPreface = "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n";
+        while (connection.buffer.size() < kPreface.size()) {
+            if (!connection.readMore()) {
+                closeClient(connection);
+                return;
+            }
+        }
+        if (connection.buffer.compare(0, kPreface.size(), kPreface) != 0) {
+            closeClient(connection);
+            return;
+        }
+        connection.buffer.erase(0, kPreface.size());
+        std::string settings;
+        if (config_.maxConcurrentStreams > 0) {
+            settings.push_back(0);
+            settings.push_back(0x3);
+            appendUint32(settings, config_.maxConcurrentStreams);
+        }
+        connection.write(makeFrame(0x4, 0, 0, settings));
+        uint32_t responseCount = 0;
+        while (true) {
+            while (!connection.ready.empty()) {
+                auto request = std::move(connection.ready.front());
+                connection.ready.pop_front();
+                if (!respond(connection, request)) {
+                    closeClient(connection);
+                    return;
+                }
+                if (config_.goAwayAfter > 0 && ++responseCount == config_.goAwayAfter) {
+                    ///the streams above this one are left for the next connection
+                    std::string payload;
+                    appendUint32(payload, request.streamId);
+                    appendUint32(payload, 0);
+                    connection.write(makeFrame(0x7, 0, 0, payload));
+                    ///wait for the client to close, unread requests would turn our close into a reset
+                    ::shutdown(connection.fd, SHUT_WR);
+                    while (connection.readMore()) {
+                        connection.buffer.clear();
+                    }
+                    closeClient(connection);
+                    return;
+                }
+            }
+            if (!handleFrame(connection)) {
+                closeClient(connection);
+                return;
+            }
+        }
+    }
+
+private:
+    Responder responder_;
+    Config config_;
+#if ENABLE_HTTPS
+    SSL_CTX* sslContext_ = nullptr;
+#endif
+    int listenFd_ = -1;
+    uint16_t port_ = 0;
+    std::atomic<bool> isRunning_ = true;
+    std::atomic<int32_t> connectionCount_ = 0;
+    std::atomic<int32_t> requestCount_ = 0;
+    std::atomic<int32_t> maxOpenStreams_ = 0;
+    std::thread acceptor_;
+    std::mutex mutex_;
+    std::vector<int> clients_;
+    std::vector<std::thread> workers_;
+};
@@ -0,0 +1,361 @@
+//
+// Created by Nevermore on 2026/10/17.
+// http-request LocalServer
+// Copyright (c) 2024 Nevermore All rights reserved.
+//
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#if ENABLE_HTTPS
+#include <openssl/ssl.h>
+#include <openssl/x509.h>
+#endif
+
+///Minimal blocking HTTP/1.1 server on the loopback interface for tests, keep-alive is supported.
+///With isTls it serves https with a self-signed certificate generated at startup.
+class LocalServer {
+public:
+    struct Request {
+        std::string method;
+        std::string path;
+        std::unordered_map<std::string, std::string> headers;
+        std::string body;
+    };
+    ///return the raw response, an empty string closes the connection
+    using Responder = std::function<std::string(const Request&)>;
+
+    explicit LocalServer(Responder responder, bool isTls = false)
+        : responder_(std::move(responder))
+        , isTls_(isTls) {
+#if ENABLE_HTTPS
+        if (isTls_) {
+            initTls();
+        }
+#endif
+        listenFd_ = ::socket(AF_INET, SOCK_STREAM, 0);
+        int value = 1;
+        setsockopt(listenFd_, SOL_SOCKET, SO_REUSEADDR, &value, sizeof(value));
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        address.sin_port = 0;
+        ::bind(listenFd_, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+        socklen_t length = sizeof(address);
+        getsockname(listenFd_, reinterpret_cast<sockaddr*>(&address), &length);
+        port_ = ntohs(address.sin_port);
+        ::listen(listenFd_, 1024);
+        acceptor_ = std::thread([this] {
+            acceptLoop();
+        });
+    }
+
+    ~LocalServer() {
+        isRunning_ = false;
+        acceptor_.join();
+        {
+            std::lock_guard lock(mutex_);
+            for (auto fd : clients_) {
+                ::shutdown(fd, SHUT_RD);
+            }
+        }
+        for (auto& worker : workers_) {
+            worker.join();
+        }
+        ::close(listenFd_);
+#if ENABLE_HTTPS
+        if (sslContext_) {
+            SSL_CTX_free(sslContext_);
+        }
+#endif
+    }
+
+    [[nodiscard]] uint16_t port() const {
+        return port_;
+    }
+
+    [[nodiscard]] std::string url(const std::string& path = "/") const {
+        return (isTls_ ? "https://127.0.0.1:" : "http://127.0.0.1:") + std::to_string(port_) + path;
+    }
+
+    ///accept data in the syn, false if the kernel refuses it
+    bool enableFastOpen() {
+        int value = 16;
+        return setsockopt(listenFd_, IPPROTO_TCP, TCP_FASTOPEN, &value, sizeof(value)) == 0;
+    }
+
+    [[nodiscard]] int32_t connectionCount() const {
+        return connectionCount_;
+    }
+
+    [[nodiscard]] int32_t requestCount() const {
+        return requestCount_;
+    }
+
+#if ENABLE_HTTPS
+    ///issue tickets that allow tls 1.3 early data, a rejecting server still lets the handshake succeed, call it before any request
+    void setEarlyData(bool isAccepted) {
+        SSL_CTX_set_max_early_data(sslContext_, 16 * 1024);
+        isEarlyDataAccepted_ = isAccepted;
+    }
+
+    ///the connections whose request arrived as early data
+    [[nodiscard]] int32_t earlyDataCount() const {
+        return earlyDataCount_;
+    }
+#endif
+
+    ///close the kept-alive connections as an idle server would, return once they are closed
+    void closeConnections() {
+        {
+            std::lock_guard lock(mutex_);
+            for (auto fd : clients_) {
+                ::shutdown(fd, SHUT_RD);
+            }
+        }
+        while (true) {
+            {
+                std::lock_guard lock(mutex_);
+                if (clients_.empty()) {
+                    return;
+                }
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+private:
+    struct Connection {
+        int fd = -1;
+#if ENABLE_HTTPS
+        SSL* ssl = nullptr;
+#endif
+
+        ssize_t read(char* data, size_t size) const {
+#if ENABLE_HTTPS
+            if (ssl) {
+                return SSL_read(ssl, data, static_cast<int>(size));
+            }
+#endif
+            return ::recv(fd, data, size, 0);
+        }
+
+        void write(const std::string& data) const {
+#if ENABLE_HTTPS
+            if (ssl) {
+                SSL_write(ssl, data.data(), static_cast<int>(data.size()));
+                return;
+            }
+#endif
+            ::send(fd, data.data(), data.size(), MSG_NOSIGNAL);
+        }
+    };
+
+#if ENABLE_HTTPS
+    void initTls() {
+        sslContext_ = SSL_CTX_new(TLS_server_method());
+        auto key = EVP_EC_gen("P-256");
+        auto cert = X509_new();
+        X509_set_version(cert, 2);
+        ASN1_INTEGER_set(X509_get_serialNumber(cert), 1);
+        X509_gmtime_adj(X509_getm_notBefore(cert), 0);
+        X509_gmtime_adj(X509_getm_notAfter(cert), 3600);
+        X509_set_pubkey(cert, key);
+        auto name = X509_get_subject_name(cert);
+        X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC, reinterpret_cast<const unsigned char*>("127.0.0.1"), -1, -1, 0);
+        X509_set_issuer_name(cert, name);
+        X509_sign(cert, key, EVP_sha256());
+        SSL_CTX_use_certificate(sslContext_, cert);
+        SSL_CTX_use_PrivateKey(sslContext_, key);
+        X509_free(cert);
+        EVP_PKEY_free(key);
+    }
+#endif
+
+#if ENABLE_HTTPS
+    static bool readEarlyData(SSL* ssl, std::string& buffer) {
+        char data[4096];
+        while (true) {
+            size_t size = 0;
+            auto ret = SSL_read_early_data(ssl, data, sizeof(data), &size);
+            if (ret == SSL_READ_EARLY_DATA_ERROR) {
+                return false;
+            }
+            buffer.append(data, size);
+            if (ret == SSL_READ_EARLY_DATA_FINISH) {
+                return true;
+            }
+        }
+    }
+#endif
+
+    void acceptLoop() {
+        while (isRunning_) {
+            pollfd pfd{listenFd_, POLLIN, 0};
+            if (::poll(&pfd, 1, 20) <= 0) {
+                continue;
+            }
+            auto fd = ::accept(listenFd_, nullptr, nullptr);
+            if (fd < 0) {
+                continue;
+            }
+            connectionCount_++;
+            std::lock_guard lock(mutex_);
+            clients_.push_back(fd);
+            workers_.emplace_back([this, fd] {
+                serve(fd);
+            });
+        }
+    }
+
+    static bool readMore(const Connection& connection, std::string& buffer) {
+        char data[4096];
+        auto size = connection.read(data, sizeof(data));
+        if (size <= 0) {
+            return false;
+        }
+        buffer.append(data, static_cast<size_t>(size));
+        return true;
+    }
+
+    static bool readBody(const Connection& fd, std::string& buffer, Request& request) {
+        if (request.headers.count("Content-Length")) {
+            auto length = std::stoul(request.headers["Content-Length"]);
+            while (buffer.size() < length) {
+                if (!readMore(fd, buffer)) {
+                    return false;
+                }
+            }
+            request.body = buffer.substr(0, length);
+            buffer.erase(0, length);
+        } else if (request.headers["Transfer-Encoding"] == "chunked") {
+            while (true) {
+                size_t pos;
+                while ((pos = buffer.find("\r\n")) == std::string::npos) {
+                    if (!readMore(fd, buffer)) {
+                        return false;
+                    }
+                }
+                auto size = std::stoul(buffer.substr(0, pos), nullptr, 16);
+                buffer.erase(0, pos + 2);
+                while (buffer.size() < size + 2) {
+                    if (!readMore(fd, buffer)) {
+                        return false;
+                    }
+                }
+                request.body += buffer.substr(0, size);
+                buffer.erase(0, size + 2);
+                if (size == 0) {
+                    break;
+                }
+            }
+        }
+        return true;
+    }
+
+    void closeClient(const Connection& connection) {
+#if ENABLE_HTTPS
+        if (connection.ssl) {
+            SSL_shutdown(connection.ssl);
+            SSL_free(connection.ssl);
+        }
+#endif
+        std::lock_guard lock(mutex_);
+        clients_.erase(std::remove(clients_.begin(), clients_.end(), connection.fd), clients_.end());
+        ::close(connection.fd);
+    }
+
+    void serve(int socket) {
+        Connection fd{socket};
+        std::string buffer;
+#if ENABLE_HTTPS
+        if (isTls_) {
+            fd.ssl = SSL_new(sslContext_);
+            SSL_set_fd(fd.ssl, socket);
+            if (isEarlyDataAccepted_ && !readEarlyData(fd.ssl, buffer)) {
+                closeClient(fd);
+                return;
+            }
+            if (SSL_accept(fd.ssl) <= 0) {
+                closeClient(fd);
+                return;
+            }
+            if (SSL_get_early_data_status(fd.ssl) == SSL_EARLY_DATA_ACCEPTED) {
+                earlyDataCount_++;
+            }
+        }
+#endif
+        while (true) {
+            size_t headerEnd;
+            while (true) {
+                ///the CRLF a client may leave after a body is not part of the next request
+                while (buffer.compare(0, 2, "\r\n") == 0) {
+                    buffer.erase(0, 2);
+                }
+                if ((headerEnd = buffer.find("\r\n\r\n")) != std::string::npos) {
+                    break;
+                }
+                if (!readMore(fd, buffer)) {
+                    closeClient(fd);
+                    return;
+                }
+            }
+            Request request;
+            auto header = buffer.substr(0, headerEnd);
+            buffer.erase(0, headerEnd + 4);
+            auto lineEnd = header.find("\r\n");
+            auto requestLine = header.substr(0, lineEnd);
+            request.method = requestLine.substr(0, requestLine.find(' '));
+            request.path = requestLine.substr(request.method.size() + 1, requestLine.rfind(' ') - request.method.size() - 1);
+            while (lineEnd != std::string::npos) {
+                auto next = header.find("\r\n", lineEnd + 2);
+                auto line = header.substr(lineEnd + 2, next == std::string::npos ? std::string::npos : next - lineEnd - 2);
+                if (auto colon = line.find(": "); colon != std::string::npos) {
+                    request.headers[line.substr(0, colon)] = line.substr(colon + 2);
+                }
+                lineEnd = next;
+            }
+            if (!readBody(fd, buffer, request)) {
+                closeClient(fd);
+                return;
+            }
+            requestCount_++;
+            auto response = responder_(request);
+            if (response.empty()) {
+                closeClient(fd);
+                return;
+            }
+            fd.write(response);
+        }
+    }
+
+private:
+    Responder responder_;
+    bool isTls_ = false;
+#if ENABLE_HTTPS
+    SSL_CTX* sslContext_ = nullptr;
+    std::atomic<bool> isEarlyDataAccepted_ = false;
+    std::atomic<int32_t> earlyDataCount_ = 0;
+#endif
+    int listenFd_ = -1;
+    uint16_t port_ = 0;
+    std::atomic<bool> isRunning_ = true;
+    std::atomic<int32_t> connectionCount_ = 0;
+    std::atomic<int32_t> requestCount_ = 0;
+    std::thread acceptor_;
+    std::mutex mutex_;
+    std::vector<int> clients_;
+    std::vector<std::thread> workers_;
+};
@@ -9,8 +9,10 @@
 #include "Data.hpp"
 #include "Request.h"
 #include "Type.h"
+#include "LocalServer.h"
 
 using namespace http;
+using namespace std::chrono_literals;
 
 TEST(Request, Get) {
     Request::init();
@@ -213,4 +215,270 @@ TEST(Request, Options) {
     std::unique_lock lock(mutex);
     cond.wait(lock, [&]{ return isFinished; });
     Request::clear();
-}
\ No newline at end of file
+}
+
+TEST(Request, LocalChunked) {
+    LocalServer server([](const LocalServer::Request& request) {
+        return std::string("HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n"
+                           "5\r\nhello\r\n6\r\n world\r\n0\r\n\r\n");
+    });
+    std::condition_variable cond;
+    std::mutex mutex;
+    bool isFinished = false;
+    std::string body;
+    RequestInfo info;
+    info.url = server.url("/chunked");
+    info.methodType = HttpMethodType::Get;
+    ResponseHandler handler;
+    handler.onData = [&](std::string_view reqId, DataPtr data) {
+        body.append(data->view());
+    };
+    handler.onError = [](std::string_view reqId, ErrorInfo info) {
+        ASSERT_EQ(info.retCode, ResultCode::Success);
+    };
+    handler.onDisconnected = [&](std::string_view reqId) {
+        {
+            std::lock_guard lock(mutex);
+            isFinished = true;
+        }
+        cond.notify_all();
+    };
+    Request request(std::move(info), std::move(handler));
+    std::unique_lock lock(mutex);
+    cond.wait(lock, [&]{ return isFinished; });
+    ASSERT_EQ(body, "hello world");
+}
+
+TEST(Request, LocalReadTimeout) {
+    LocalServer server([](const LocalServer::Request& request) {
+        std::this_thread::sleep_for(500ms);
+        return std::string();
+    });
+    std::condition_variable cond;
+    std::mutex mutex;
+    bool isFinished = false;
+    ResultCode resultCode = ResultCode::Success;
+    RequestInfo info;
+    info.url = server.url("/stall");
+    info.methodType = HttpMethodType::Get;
+    info.readTimeout = 100ms;
+    auto startTime = std::chrono::steady_clock::now();
+    ResponseHandler handler;
+    handler.onError = [&](std::string_view reqId, ErrorInfo info) {
+        resultCode = info.retCode;
+    };
+    handler.onDisconnected = [&](std::string_view reqId) {
+        {
+            std::lock_guard lock(mutex);
+            isFinished = true;
+        }
+        cond.notify_all();
+    };
+    Request request(std::move(info), std::move(handler));
+    std::unique_lock lock(mutex);
+    cond.wait(lock, [&]{ return isFinished; });
+    ASSERT_EQ(resultCode, ResultCode::Timeout);
+    ASSERT_LT(std::chrono::steady_clock::now() - startTime, 450ms);
+}
+
+TEST(Request, LocalStreamedBody) {
+    LocalServer server([](const LocalServer::Request& request) {
+        auto isChunked = request.headers.count("Transfer-Encoding") ? "chunked:" : "length:";
+        auto body = isChunked + std::to_string(request.body.size());
+        return "HTTP/1.1 200 OK\r\nContent-Length: " + std::to_string(body.size()) + "\r\n\r\n" + body;
+    });
+    constexpr uint64_t kBodySize = 1024 * 1024 + 7;
+    for (int64_t bodyLength : {static_cast<int64_t>(kBodySize), int64_t(-1)}) {
+        std::condition_variable cond;
+        std::mutex mutex;
+        bool isFinished = false;
+        std::string body;
+        uint64_t producedSize = 0;
+        RequestInfo info;
+        info.url = server.url("/upload");
+        info.methodType = HttpMethodType::Post;
+        info.bodyLength = bodyLength;
+        info.bodyReader = [&producedSize](uint8_t* buffer, uint64_t size) {
+            auto count = std::min(size, kBodySize - producedSize);
+            std::fill_n(buffer, count, 'x');
+            producedSize += count;
+            return static_cast<int64_t>(count);
+        };
+        ResponseHandler handler;
+        handler.onData = [&](std::string_view, DataPtr data) {
+            body.append(data->view());
+        };
+        handler.onError = [](std::string_view, ErrorInfo info) {
+            ASSERT_EQ(info.retCode, ResultCode::Success);
+        };
+        handler.onDisconnected = [&](std::string_view) {
+            {
+                std::lock_guard lock(mutex);
+                isFinished = true;
+            }
+            cond.notify_all();
+        };
+        Request request(std::move(info), std::move(handler));
+        std::unique_lock lock(mutex);
+        cond.wait(lock, [&]{ return isFinished; });
+        ASSERT_EQ(body, (bodyLength < 0 ? "chunked:" : "length:") + std::to_string(kBodySize));
+    }
+}
+
+TEST(Request, LocalFileBody) {
+    LocalServer server([](const LocalServer::Request& request) {
+        return "HTTP/1.1 200 OK\r\nContent-Length: " + std::to_string(request.body.size()) + "\r\n\r\n" + request.body;
+    });
+    const std::string content = "skipped|the part of the file that is sent|skipped";
+    char path[] = "/tmp/http_file_body_XXXXXX";
+    auto fd = mkstemp(path);
+    ASSERT_GE(fd, 0);
+    ::unlink(path);
+    ASSERT_EQ(write(fd, content.data(), content.size()), static_cast<ssize_t>(content.size()));
+    std::condition_variable cond;
+    std::mutex mutex;
+    bool isFinished = false;
+    std::string body;
+    RequestInfo info;
+    info.url = server.url("/upload");
+    info.methodType = HttpMethodType::Post;
+    info.bodyFile.fd = fd;
+    info.bodyFile.offset = 8;
+    info.bodyFile.length = 33;
+    ResponseHandler handler;
+    handler.onData = [&](std::string_view, DataPtr data) {
+        body.append(data->view());
+    };
+    handler.onError = [](std::string_view, ErrorInfo info) {
+        ASSERT_EQ(info.retCode, ResultCode::Success);
+    };
+    handler.onDisconnected = [&](std::string_view) {
+        {
+            std::lock_guard lock(mutex);
+            isFinished = true;
+        }
+        cond.notify_all();
+    };
+    {
+        Request request(std::move(info), std::move(handler));
+        std::unique_lock lock(mutex);
+        cond.wait(lock, [&]{ return isFinished; });
+    }
+    ASSERT_EQ(body, "the part of the file that is sent");
+    ///the file is not closed and its position did not move
+    ASSERT_EQ(lseek(fd, 0, SEEK_CUR), static_cast<off_t>(content.size()));
+    ::close(fd);
+}
+
+TEST(Request, LocalKeepAlive) {
+    LocalServer server([](const LocalServer::Request& request) {
+        return "HTTP/1.1 200 OK\r\nContent-Length: " + std::to_string(request.body.size()) + "\r\n\r\n" + request.body;
+    });
+    auto post = [&](const std::string& payload) {
+        std::condition_variable cond;
+        std::mutex mutex;
+        bool isFinished = false;
+        std::string body;
+        RequestInfo info;
+        info.url = server.url("/echo");
+        info.methodType = HttpMethodType::Post;
+        info.body = std::make_shared<Data>(payload.size(), reinterpret_cast<const uint8_t*>(payload.data()));
+        ResponseHandler handler;
+        handler.onData = [&](std::string_view reqId, DataPtr data) {
+            body.append(data->view());
+        };
+        handler.onError = [](std::string_view reqId, ErrorInfo info) {
+            ASSERT_EQ(info.retCode, ResultCode::Success);
+        };
+        handler.onDisconnected = [&](std::string_view reqId) {
+            {
+                std::lock_guard lock(mutex);
+                isFinished = true;
+            }
+            cond.notify_all();
+        };
+        Request request(std::move(info), std::move(handler));
+        std::unique_lock lock(mutex);
+        cond.wait(lock, [&]{ return isFinished; });
+        return body;
+    };
+    ASSERT_EQ(post("first"), "first");
+    ASSERT_EQ(post("second"), "second");
+    ASSERT_EQ(post("third"), "third");
+    ASSERT_EQ(server.connectionCount(), 1);
+    ASSERT_EQ(server.requestCount(), 3);
+
+    ///the pooled connection fails the health check once the server closed it
+    server.closeConnections();
+    ASSERT_EQ(post("fourth"), "fourth");
+    ASSERT_EQ(server.connectionCount(), 2);
+}
+
+TEST(Request, LocalPreconnect) {
+    LocalServer server([](const LocalServer::Request&) {
+        return std::string("HTTP/1.1 200 OK\r\nContent-Length: 2\r\n\r\nok");
+    });
+    Request::warmUp();
+    ASSERT_EQ(Request::preconnect("ftp://127.0.0.1/"), 0);
+    ASSERT_EQ(Request::preconnect(server.url(), 2), 2);
+    std::condition_variable cond;
+    std::mutex mutex;
+    bool isFinished = false;
+    RequestInfo info;
+    info.url = server.url();
+    info.methodType = HttpMethodType::Get;
+    ResponseHandler handler;
+    handler.onError = [](std::string_view reqId, ErrorInfo info) {
+        ASSERT_EQ(info.retCode, ResultCode::Success);
+    };
+    handler.onDisconnected = [&](std::string_view reqId) {
+        {
+            std::lock_guard lock(mutex);
+            isFinished = true;
+        }
+        cond.notify_all();
+    };
+    {
+        Request request(std::move(info), std::move(handler));
+        std::unique_lock lock(mutex);
+        cond.wait(lock, [&]{ return isFinished; });
+    }
+    ///the request took a preconnected connection
+    ASSERT_EQ(server.connectionCount(), 2);
+    ASSERT_EQ(server.requestCount(), 1);
+}
+
+#if ENABLE_HTTPS
+TEST(Request, LocalTls) {
+    const std::string payload(256 * 1024, 'x');
+    LocalServer server([&](const LocalServer::Request& request) {
+        return "HTTP/1.1 200 OK\r\nContent-Length: " + std::to_string(payload.size()) + "\r\n\r\n" + payload;
+    }, true);
+    std::condition_variable cond;
+    std::mutex mutex;
+    bool isFinished = false;
+    std::string body;
+    RequestInfo info;
+    info.url = server.url("/tls");
+    info.methodType = HttpMethodType::Get;
+    info.timeout = 5000ms;
+    ResponseHandler handler;
+    handler.onData = [&](std::string_view reqId, DataPtr data) {
+        body.append(data->view());
+    };
+    handler.onError = [](std::string_view reqId, ErrorInfo info) {
+        ASSERT_EQ(info.retCode, ResultCode::Success);
+    };
+    handler.onDisconnected = [&](std::string_view reqId) {
+        {
+            std::lock_guard lock(mutex);
+            isFinished = true;
+        }
+        cond.notify_all();
+    };
+    Request request(std::move(info), std::move(handler));
+    std::unique_lock lock(mutex);
+    cond.wait(lock, [&]{ return isFinished; });
+    ASSERT_TRUE(body == payload);
+}
+#endif
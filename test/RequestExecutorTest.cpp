@@ -0,0 +1,132 @@
+//
+// Created by Nevermore on 2026/10/17.
+// http-request RequestExecutorTest
+// Copyright (c) 2024 Nevermore All rights reserved.
+//
+#include <gtest/gtest.h>
+#include <condition_variable>
+#include "Request.h"
+#include "LocalServer.h"
+
+using namespace http;
+using namespace std::chrono_literals;
+
+TEST(RequestExecutor, Bounded) {
+    constexpr int32_t kRequestCount = 20;
+    LocalServer server([](const LocalServer::Request& request) {
+        return std::string("HTTP/1.1 200 OK\r\nContent-Length: 2\r\n\r\nok");
+    });
+    ExecutorConfig config;
+    config.maxThreads = 2;
+    auto executor = std::make_shared<RequestExecutor>(config);
+    std::atomic<int32_t> finishCount = 0;
+    {
+        std::vector<std::unique_ptr<Request>> requests;
+        for (int32_t i = 0; i < kRequestCount; i++) {
+            RequestInfo info;
+            info.url = server.url();
+            info.methodType = HttpMethodType::Get;
+            ResponseHandler handler;
+            handler.onError = [](std::string_view, ErrorInfo info) {
+                ASSERT_EQ(info.retCode, ResultCode::Success);
+            };
+            handler.onDisconnected = [&](std::string_view) {
+                finishCount++;
+            };
+            requests.push_back(std::make_unique<Request>(std::move(info), std::move(handler), executor));
+        }
+        ASSERT_LE(executor->threadCount(), 2u);
+    }
+    ASSERT_EQ(finishCount, kRequestCount);
+}
+
+TEST(RequestExecutor, Reject) {
+    LocalServer server([](const LocalServer::Request& request) {
+        std::this_thread::sleep_for(200ms);
+        return std::string("HTTP/1.1 200 OK\r\nContent-Length: 2\r\n\r\nok");
+    });
+    ExecutorConfig config;
+    config.maxThreads = 1;
+    config.queueDepth = 1;
+    config.rejectPolicy = RejectPolicy::Reject;
+    auto executor = std::make_shared<RequestExecutor>(config);
+    std::atomic<int32_t> rejectCount = 0;
+    std::atomic<int32_t> successCount = 0;
+    auto makeHandler = [&] {
+        ResponseHandler handler;
+        handler.onData = [&](std::string_view, DataPtr) {
+            successCount++;
+        };
+        handler.onError = [&](std::string_view, ErrorInfo info) {
+            if (info.retCode == ResultCode::Rejected) {
+                rejectCount++;
+            }
+        };
+        return handler;
+    };
+    RequestInfo info;
+    info.url = server.url();
+    info.methodType = HttpMethodType::Get;
+    {
+        Request first(info, makeHandler(), executor);
+        while (executor->queueSize() > 0) {
+            std::this_thread::sleep_for(1ms);
+        }
+        Request second(info, makeHandler(), executor);
+        Request third(info, makeHandler(), executor);
+        ASSERT_EQ(rejectCount, 1);
+    }
+    ASSERT_EQ(successCount, 2);
+}
+
+TEST(RequestExecutor, CancelQueued) {
+    LocalServer server([](const LocalServer::Request& request) {
+        std::this_thread::sleep_for(100ms);
+        return std::string("HTTP/1.1 200 OK\r\nContent-Length: 2\r\n\r\nok");
+    });
+    ExecutorConfig config;
+    config.maxThreads = 1;
+    auto executor = std::make_shared<RequestExecutor>(config);
+    std::atomic<int32_t> callbackCount = 0;
+    ResponseHandler handler;
+    handler.onDisconnected = [&](std::string_view) {
+        callbackCount++;
+    };
+    RequestInfo info;
+    info.url = server.url();
+    info.methodType = HttpMethodType::Get;
+    auto first = std::make_unique<Request>(info, handler, executor);
+    auto second = std::make_unique<Request>(info, handler, executor);
+    second->cancel();
+    second.reset();
+    first.reset();
+    ASSERT_EQ(callbackCount, 1);
+}
+
+TEST(RequestExecutor, QueueTime) {
+    LocalServer server([](const LocalServer::Request& request) {
+        std::this_thread::sleep_for(50ms);
+        return std::string("HTTP/1.1 200 OK\r\nContent-Length: 2\r\n\r\nok");
+    });
+    ExecutorConfig config;
+    config.maxThreads = 1;
+    auto executor = std::make_shared<RequestExecutor>(config);
+    std::vector<RequestStats> stats(2);
+    RequestInfo info;
+    info.url = server.url();
+    info.methodType = HttpMethodType::Get;
+    {
+        std::vector<std::unique_ptr<Request>> requests;
+        for (auto& requestStats : stats) {
+            ResponseHandler handler;
+            handler.onStats = [&requestStats](std::string_view, const RequestStats& value) {
+                requestStats = value;
+            };
+            requests.push_back(std::make_unique<Request>(info, handler, executor));
+        }
+    }
+    ASSERT_GE(stats[0].networkTime.count(), 40);
+    ///the second one waited for the thread of the first one
+    ASSERT_GE(stats[1].queueTime.count(), 40);
+    ASSERT_GE(stats[1].networkTime.count(), 40);
+}
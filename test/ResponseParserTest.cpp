@@ -0,0 +1,81 @@
+//
+// Created by Nevermore on 2026/10/17.
+// http-request ResponseParserTest
+// Copyright (c) 2024 Nevermore All rights reserved.
+//
+#include <gtest/gtest.h>
+#include "../src/include/ResponseParser.h"
+
+using namespace http;
+
+namespace {
+
+DataPtr makeData(std::string_view str) {
+    return std::make_unique<Data>(static_cast<uint64_t>(str.size()), reinterpret_cast<const uint8_t*>(str.data()));
+}
+
+} //end of namespace
+
+TEST(ResponseParser, SliceBody) {
+    ResponseParser parser;
+    std::vector<DataPtr> chunks;
+    parser.setDataCallback([&chunks](DataPtr data) {
+        chunks.push_back(std::move(data));
+    });
+    auto data = makeData("HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n4\r\nabcd\r\n3\r\nefg\r\n");
+    auto begin = data->rawData;
+    auto end = data->rawData + data->length;
+    ASSERT_EQ(parser.parse(std::move(data)), ParseState::Body);
+    ASSERT_EQ(chunks.size(), 2u);
+    ASSERT_EQ(chunks[0]->view(), "abcd");
+    ASSERT_EQ(chunks[1]->view(), "efg");
+    ///the chunks point into the received buffer
+    for (const auto& chunk : chunks) {
+        ASSERT_TRUE(chunk->isSlice());
+        ASSERT_TRUE(chunk->rawData >= begin && chunk->rawData + chunk->length <= end);
+    }
+    ASSERT_EQ(parser.parse(makeData("0\r\n\r\nHTTP/1.1")), ParseState::Completed);
+    ASSERT_EQ(parser.takeRemain()->view(), "HTTP/1.1");
+}
+
+TEST(ResponseParser, SplitRead) {
+    const std::string response = "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n"
+                                 "5\r\nhello\r\n1;ext=1\r\n \r\n6\r\nworld!\r\n0\r\nTrailer: x\r\n\r\n";
+    ///every split of the response into two reads gives the same body
+    for (size_t i = 1; i < response.size(); i++) {
+        ResponseParser parser;
+        std::string body;
+        int32_t headerCount = 0;
+        parser.setHeaderCallback([&headerCount](ResponseHeader&&) {
+            headerCount++;
+        });
+        parser.setDataCallback([&body](DataPtr data) {
+            body.append(data->view());
+        });
+        auto view = std::string_view(response);
+        parser.parse(makeData(view.substr(0, i)));
+        ASSERT_EQ(parser.parse(makeData(view.substr(i))), ParseState::Completed) << i;
+        ASSERT_EQ(headerCount, 1);
+        ASSERT_EQ(body, "hello world!") << i;
+        ASSERT_EQ(parser.takeRemain(), nullptr);
+    }
+}
+
+TEST(ResponseParser, ContentLength) {
+    const std::string response = "HTTP/1.1 200 OK\r\nContent-Length: 10\r\n\r\n0123456789HTTP/1.1 204";
+    ///the start of the next response always comes in the second read
+    for (size_t i = 1; i < response.find("HTTP/1.1 204"); i++) {
+        ResponseParser parser;
+        std::string body;
+        parser.setDataCallback([&body](DataPtr data) {
+            body.append(data->view());
+        });
+        auto view = std::string_view(response);
+        parser.parse(makeData(view.substr(0, i)));
+        ASSERT_EQ(parser.parse(makeData(view.substr(i))), ParseState::Completed) << i;
+        ASSERT_EQ(body, "0123456789") << i;
+        auto remain = parser.takeRemain();
+        ASSERT_NE(remain, nullptr) << i;
+        ASSERT_EQ(remain->view(), "HTTP/1.1 204") << i;
+    }
+}
@@ -0,0 +1,219 @@
+//
+// Created by Nevermore on 2026/10/17.
+// http-request SocketOptionsTest
+// Copyright (c) 2024 Nevermore All rights reserved.
+//
+#include <gtest/gtest.h>
+#include <fstream>
+#include <future>
+#include "../src/include/ConnectionPool.h"
+#include "../src/include/PlainSocket.h"
+#include "Client.h"
+#include "LocalServer.h"
+
+using namespace http;
+using namespace std::chrono_literals;
+
+namespace {
+
+AddressInfoPtr resolve(uint16_t port) {
+    addrinfo hints{};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = AI_NUMERICHOST;
+    addrinfo* addressInfo = nullptr;
+    getaddrinfo("127.0.0.1", std::to_string(port).data(), &hints, &addressInfo);
+    return MakeAddressInfoPtr(addressInfo);
+}
+
+///fast open of the clients and of the servers is enabled
+bool isFastOpenEnabled() {
+    std::ifstream file("/proc/sys/net/ipv4/tcp_fastopen");
+    int32_t value = 0;
+    return (file >> value) && (value & 3) == 3;
+}
+
+int32_t getOption(const ISocket& socket, int level, int name) {
+    int32_t value = 0;
+    socklen_t length = sizeof(value);
+    getsockopt(socket.fd(), level, name, &value, &length);
+    return value;
+}
+
+}
+
+TEST(SocketOptions, Apply) {
+    LocalServer server([](const LocalServer::Request&) {
+        return std::string();
+    });
+    SocketOptions options;
+    options.receiveBufferSize = 256 * 1024;
+    options.keepAliveIdle = 30s;
+    options.keepAliveInterval = 5s;
+    options.keepAliveCount = 3;
+    options.userTimeout = 10s;
+    options.tos = 0x10;
+    options.sourceAddress = "127.0.0.2";
+    PlainSocket socket(IPVersion::V4);
+    socket.setOptions(options);
+    ASSERT_TRUE(socket.connect(resolve(server.port()), 1000).isSuccess());
+    ASSERT_EQ(getOption(socket, IPPROTO_TCP, TCP_NODELAY), 1);
+    ///linux doubles the buffer size for its bookkeeping
+    ASSERT_GE(getOption(socket, SOL_SOCKET, SO_RCVBUF), options.receiveBufferSize);
+    ASSERT_EQ(getOption(socket, SOL_SOCKET, SO_KEEPALIVE), 1);
+#if defined(__linux__)
+    ASSERT_EQ(getOption(socket, IPPROTO_TCP, TCP_KEEPIDLE), 30);
+    ASSERT_EQ(getOption(socket, IPPROTO_TCP, TCP_KEEPINTVL), 5);
+    ASSERT_EQ(getOption(socket, IPPROTO_TCP, TCP_KEEPCNT), 3);
+    ASSERT_EQ(getOption(socket, IPPROTO_TCP, TCP_USER_TIMEOUT), 10000);
+#endif
+    ASSERT_EQ(getOption(socket, IPPROTO_IP, IP_TOS), 0x10);
+    sockaddr_in address{};
+    socklen_t length = sizeof(address);
+    getsockname(socket.fd(), reinterpret_cast<sockaddr*>(&address), &length);
+    char text[INET_ADDRSTRLEN] = {};
+    inet_ntop(AF_INET, &address.sin_addr, text, sizeof(text));
+    ASSERT_STREQ(text, "127.0.0.2");
+}
+
+TEST(SocketOptions, Default) {
+    LocalServer server([](const LocalServer::Request&) {
+        return std::string();
+    });
+    SocketOptions options;
+    options.isNoDelay = false;
+    PlainSocket socket(IPVersion::V4);
+    socket.setOptions(options);
+    ASSERT_TRUE(socket.connect(resolve(server.port()), 1000).isSuccess());
+    ASSERT_EQ(getOption(socket, IPPROTO_TCP, TCP_NODELAY), 0);
+    ASSERT_EQ(getOption(socket, SOL_SOCKET, SO_KEEPALIVE), 0);
+}
+
+TEST(SocketOptions, Refused) {
+    LocalServer server([](const LocalServer::Request&) {
+        return std::string();
+    });
+    SocketOptions options;
+    options.sourceAddress = "::1";
+    PlainSocket socket(IPVersion::V4);
+    socket.setOptions(options);
+    auto result = socket.connect(resolve(server.port()), 1000);
+    ASSERT_EQ(result.resultCode, ResultCode::SetOptionFailed);
+    ASSERT_EQ(result.errorCode, EAFNOSUPPORT);
+}
+
+TEST(SocketOptions, Client) {
+    LocalServer server([](const LocalServer::Request&) {
+        return std::string("HTTP/1.1 200 OK\r\nContent-Length: 2\r\n\r\nok");
+    });
+    Client client;
+    auto request = [&](const std::string& sourceAddress) {
+        std::promise<ResultCode> promise;
+        auto result = ResultCode::Success;
+        RequestInfo info;
+        info.url = server.url();
+        info.methodType = HttpMethodType::Get;
+        info.isKeepAlive = false;
+        info.socketOptions.sourceAddress = sourceAddress;
+        ResponseHandler handler;
+        handler.onError = [&](std::string_view, ErrorInfo info) {
+            result = info.retCode;
+        };
+        handler.onDisconnected = [&](std::string_view) {
+            promise.set_value(result);
+        };
+        client.request(std::move(info), std::move(handler));
+        auto future = promise.get_future();
+        EXPECT_EQ(future.wait_for(5s), std::future_status::ready);
+        return future.get();
+    };
+    ASSERT_EQ(request("127.0.0.3"), ResultCode::Success);
+    ///a source address that is not local fails the connect
+    ASSERT_EQ(request("192.0.2.1"), ResultCode::SetOptionFailed);
+}
+
+TEST(SocketOptions, PoolKey) {
+    LocalServer server([](const LocalServer::Request&) {
+        return std::string("HTTP/1.1 200 OK\r\nContent-Length: 2\r\n\r\nok");
+    });
+    Client client;
+    auto request = [&](const std::string& sourceAddress) {
+        std::promise<ResultCode> promise;
+        auto result = ResultCode::Success;
+        RequestInfo info;
+        info.url = server.url();
+        info.methodType = HttpMethodType::Get;
+        info.socketOptions.sourceAddress = sourceAddress;
+        ResponseHandler handler;
+        handler.onError = [&](std::string_view, ErrorInfo info) {
+            result = info.retCode;
+        };
+        handler.onDisconnected = [&](std::string_view) {
+            promise.set_value(result);
+        };
+        client.request(std::move(info), std::move(handler));
+        auto future = promise.get_future();
+        EXPECT_EQ(future.wait_for(5s), std::future_status::ready);
+        return future.get();
+    };
+    ASSERT_EQ(request("127.0.0.2"), ResultCode::Success);
+    ASSERT_EQ(request("127.0.0.3"), ResultCode::Success);
+    ASSERT_EQ(request("127.0.0.2"), ResultCode::Success);
+    ASSERT_EQ(request(""), ResultCode::Success);
+    ///a pooled connection only serves the requests that ask for its source address
+    ASSERT_EQ(server.connectionCount(), 3);
+    ASSERT_EQ(server.requestCount(), 4);
+
+    Url url("http://127.0.0.1:80/");
+    SocketOptions options;
+    ASSERT_EQ(ConnectionPool::makeKey(url, IPVersion::Auto, options), "http://127.0.0.1:80");
+    options.isFastOpen = true;
+    ASSERT_EQ(ConnectionPool::makeKey(url, IPVersion::Auto, options), "http://127.0.0.1:80");
+    options.interface = "lo";
+    options.tos = 0x10;
+    ASSERT_EQ(ConnectionPool::makeKey(url, IPVersion::V4, options), "http://127.0.0.1:80#v4#if=lo#tos=16");
+}
+
+TEST(SocketOptions, FastOpen) {
+    LocalServer server([](const LocalServer::Request&) {
+        return std::string("HTTP/1.1 200 OK\r\nContent-Length: 2\r\n\r\nok");
+    });
+    auto isServerEnabled = isFastOpenEnabled() && server.enableFastOpen();
+    Client client;
+    auto request = [&] {
+        std::promise<RequestStats> promise;
+        auto result = ResultCode::Success;
+        RequestStats stats;
+        RequestInfo info;
+        info.url = server.url();
+        info.methodType = HttpMethodType::Get;
+        info.isKeepAlive = false;
+        info.socketOptions.isFastOpen = true;
+        ResponseHandler handler;
+        handler.onError = [&](std::string_view, ErrorInfo info) {
+            result = info.retCode;
+        };
+        handler.onStats = [&](std::string_view, const RequestStats& requestStats) {
+            stats = requestStats;
+        };
+        handler.onDisconnected = [&](std::string_view) {
+            promise.set_value(stats);
+        };
+        client.request(std::move(info), std::move(handler));
+        auto future = promise.get_future();
+        EXPECT_EQ(future.wait_for(5s), std::future_status::ready);
+        auto requestStats = future.get();
+        EXPECT_EQ(result, ResultCode::Success);
+        return requestStats;
+    };
+    ///the first connection to the server asks for a cookie, the kernel keeps it for the later ones
+    auto stats = request();
+    if (!isServerEnabled) {
+        ///the connections fall back to the usual handshake
+        ASSERT_FALSE(stats.isFastOpen);
+        ASSERT_FALSE(request().isFastOpen);
+        GTEST_SKIP() << "fast open is not enabled by net.ipv4.tcp_fastopen";
+    }
+    ASSERT_TRUE(request().isFastOpen);
+    ASSERT_EQ(server.connectionCount(), 2);
+}
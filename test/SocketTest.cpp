@@ -0,0 +1,103 @@
+//
+// Created by Nevermore on 2026/10/17.
+// http-request SocketTest
+// Copyright (c) 2024 Nevermore All rights reserved.
+//
+#include <gtest/gtest.h>
+#include <sys/resource.h>
+#include <thread>
+#include "../src/include/PlainSocket.h"
+#include "LocalServer.h"
+
+using namespace http;
+
+TEST(Socket, SkipBuffers) {
+    std::vector<DataView> buffers{"header", "", "body"};
+    ASSERT_EQ(skipBuffers(buffers, 0), (std::vector<DataView>{"header", "body"}));
+    ASSERT_EQ(skipBuffers(buffers, 4), (std::vector<DataView>{"er", "body"}));
+    ASSERT_EQ(skipBuffers(buffers, 6), (std::vector<DataView>{"body"}));
+    ASSERT_EQ(skipBuffers(buffers, 8), (std::vector<DataView>{"dy"}));
+    ASSERT_TRUE(skipBuffers(buffers, 10).empty());
+}
+
+TEST(Socket, SendBuffers) {
+    LocalServer server([](const LocalServer::Request& request) {
+        auto size = std::to_string(request.body.size());
+        return "HTTP/1.1 200 OK\r\nContent-Length: " + std::to_string(size.size()) + "\r\n\r\n" + size;
+    });
+    addrinfo hints{};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* result = nullptr;
+    ASSERT_EQ(getaddrinfo("127.0.0.1", std::to_string(server.port()).c_str(), &hints, &result), 0);
+    auto address = MakeAddressInfoPtr(result);
+    PlainSocket socket;
+    ASSERT_TRUE(socket.connect(address, 1000).isSuccess());
+    const std::string body(1024 * 1024, 'x');
+    const std::string header = "POST / HTTP/1.1\r\nHost: 127.0.0.1\r\nContent-Length: " +
+                               std::to_string(body.size()) + "\r\n\r\n";
+    auto buffers = skipBuffers({header, body}, 0);
+    int32_t sendCount = 0;
+    while (!buffers.empty()) {
+        ASSERT_TRUE(socket.canSend(1000).isSuccess());
+        auto [sendResult, sendSize] = socket.sendBuffers(buffers);
+        ASSERT_TRUE(sendResult.isSuccess() || sendResult.resultCode == ResultCode::Retry);
+        if (sendCount++ == 0) {
+            ///the header and the start of the body left in one call
+            ASSERT_GT(sendSize, static_cast<int64_t>(header.size()));
+        }
+        buffers = skipBuffers(buffers, static_cast<uint64_t>(sendSize));
+    }
+    std::string response;
+    auto expectEnd = "\r\n\r\n" + std::to_string(body.size());
+    while (response.find(expectEnd) == std::string::npos) {
+        ASSERT_TRUE(socket.canReceive(1000).isSuccess());
+        auto [receiveResult, data] = socket.receive();
+        ASSERT_TRUE(receiveResult.isSuccess());
+        response.append(data->view());
+    }
+}
+
+TEST(Socket, IsAliveHighFd) {
+    rlimit limit{};
+    ASSERT_EQ(getrlimit(RLIMIT_NOFILE, &limit), 0);
+    if (limit.rlim_max < FD_SETSIZE + 64) {
+        GTEST_SKIP() << "the fd limit is below FD_SETSIZE";
+    }
+    auto originLimit = limit;
+    limit.rlim_cur = std::max<rlim_t>(limit.rlim_cur, FD_SETSIZE + 64);
+    ASSERT_EQ(setrlimit(RLIMIT_NOFILE, &limit), 0);
+    ///take the low fds so the socket lands above FD_SETSIZE
+    std::vector<int> fillers;
+    while (fillers.empty() || (fillers.back() >= 0 && fillers.back() < FD_SETSIZE - 1)) {
+        fillers.push_back(::dup(STDIN_FILENO));
+    }
+    ASSERT_GE(fillers.back(), 0);
+    LocalServer server([](const LocalServer::Request&) {
+        return std::string("HTTP/1.1 200 OK\r\nContent-Length: 2\r\n\r\nok");
+    });
+    addrinfo hints{};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* result = nullptr;
+    ASSERT_EQ(getaddrinfo("127.0.0.1", std::to_string(server.port()).c_str(), &hints, &result), 0);
+    auto address = MakeAddressInfoPtr(result);
+    {
+        PlainSocket socket;
+        ASSERT_GE(socket.fd(), FD_SETSIZE);
+        ASSERT_TRUE(socket.connect(address, 1000).isSuccess());
+        ASSERT_TRUE(socket.isAlive());
+        const std::string request = "GET / HTTP/1.1\r\nHost: 127.0.0.1\r\n\r\n";
+        auto [sendResult, sendSize] = socket.send(request);
+        ASSERT_TRUE(sendResult.isSuccess());
+        ///an unread response means the connection can not be reused
+        for (int32_t i = 0; i < 100 && socket.isAlive(); i++) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        ASSERT_FALSE(socket.isAlive());
+    }
+    for (auto fd : fillers) {
+        ::close(fd);
+    }
+    setrlimit(RLIMIT_NOFILE, &originLimit);
+}
@@ -0,0 +1,91 @@
+//
+// Created by Nevermore on 2026/10/17.
+// http-request TimerWheelTest
+// Copyright (c) 2024 Nevermore All rights reserved.
+//
+#include <gtest/gtest.h>
+#include <random>
+#include "../src/include/TimerWheel.h"
+
+using namespace http;
+
+TEST(TimerWheel, Order) {
+    TimerWheel wheel(1000);
+    std::vector<int64_t> fired;
+    int64_t now = 1000;
+    for (int64_t delay : {0, 5, 1, 70, 64, 4100, 300000}) {
+        wheel.add(1000 + delay, [&, delay] {
+            ASSERT_GE(now, 1000 + delay);
+            fired.push_back(delay);
+        });
+    }
+    ASSERT_EQ(wheel.size(), 7u);
+    while (wheel.size() > 0) {
+        now += 7;
+        wheel.advance(now);
+    }
+    ASSERT_EQ(fired, (std::vector<int64_t>{0, 1, 5, 64, 70, 4100, 300000}));
+    ASSERT_EQ(wheel.size(), 0u);
+    ASSERT_EQ(wheel.advance(now), kInvalid);
+}
+
+TEST(TimerWheel, Cancel) {
+    TimerWheel wheel(0);
+    int32_t count = 0;
+    auto first = wheel.add(10, [&] { count++; });
+    uint64_t second = 0;
+    ///a timer cancels the next one in the same slot
+    wheel.add(20, [&] {
+        count++;
+        ASSERT_TRUE(wheel.cancel(second));
+    });
+    second = wheel.add(20, [&] { count += 100; });
+    ASSERT_TRUE(wheel.cancel(first));
+    ASSERT_FALSE(wheel.cancel(first));
+    ASSERT_EQ(wheel.advance(15), 5);
+    wheel.advance(100);
+    ASSERT_EQ(count, 1);
+    ASSERT_EQ(wheel.size(), 0u);
+}
+
+TEST(TimerWheel, Random) {
+    TimerWheel wheel(123);
+    std::mt19937 random(42);
+    std::uniform_int_distribution<int64_t> distribution(0, 20000);
+    int64_t now = 123;
+    int32_t firedCount = 0;
+    for (int32_t i = 0; i < 2000; i++) {
+        auto expireTime = now + distribution(random);
+        wheel.add(expireTime, [&, expireTime] {
+            ASSERT_GE(now, expireTime);
+            ///jumps of at most 50ms, so a timer never fires later than that
+            ASSERT_LT(now - expireTime, 50);
+            firedCount++;
+        });
+        if (i % 10 == 0) {
+            now += distribution(random) % 50;
+            wheel.advance(now);
+        }
+    }
+    while (wheel.size() > 0) {
+        now += 49;
+        wheel.advance(now);
+    }
+    ASSERT_EQ(firedCount, 2000);
+}
+
+TEST(TimerWheel, AddInTask) {
+    TimerWheel wheel(0);
+    int64_t now = 0;
+    int32_t count = 0;
+    std::function<void()> task = [&] {
+        if (++count < 5) {
+            wheel.add(now, TimerWheel::Task(task));
+        }
+    };
+    wheel.add(1, TimerWheel::Task(task));
+    for (now = 1; now < 10; now++) {
+        wheel.advance(now);
+    }
+    ASSERT_EQ(count, 5);
+}
@@ -0,0 +1,283 @@
+//
+// Created by Nevermore on 2026/10/17.
+// http-request UringSocketTest
+// Copyright (c) 2024 Nevermore All rights reserved.
+//
+#if ENABLE_IO_URING
+#include <gtest/gtest.h>
+#include <csignal>
+#include <sys/ptrace.h>
+#include <sys/wait.h>
+#include "../src/include/PlainSocket.h"
+#include "../src/include/UringSocket.h"
+#include "LocalServer.h"
+
+using namespace http;
+using namespace std::chrono_literals;
+
+namespace {
+
+AddressInfoPtr resolve(const LocalServer& server) {
+    addrinfo hints{};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* addressInfo = nullptr;
+    getaddrinfo("127.0.0.1", std::to_string(server.port()).data(), &hints, &addressInfo);
+    return MakeAddressInfoPtr(addressInfo);
+}
+
+///the syscalls of a process that connects a socket of type T, then stops and has messageCount messages written to
+///its peer and received by the socket. Only the syscalls after the stop are counted, -1 if it can not be traced
+template<typename T>
+int64_t countReceiveSyscalls(int32_t messageCount) {
+    auto pid = fork();
+    if (pid == 0) {
+        ptrace(PTRACE_TRACEME, 0, nullptr, nullptr);
+        auto listenFd = ::socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        ::bind(listenFd, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+        socklen_t length = sizeof(address);
+        getsockname(listenFd, reinterpret_cast<sockaddr*>(&address), &length);
+        ::listen(listenFd, 1);
+        addrinfo hints{};
+        hints.ai_family = AF_INET;
+        hints.ai_socktype = SOCK_STREAM;
+        addrinfo* addressInfo = nullptr;
+        getaddrinfo("127.0.0.1", std::to_string(ntohs(address.sin_port)).data(), &hints, &addressInfo);
+        if constexpr (std::is_same_v<T, UringSocket>) {
+            if (!UringSocket::isSupported()) {
+                _exit(1);
+            }
+        }
+        T socket;
+        if (!socket.connect(MakeAddressInfoPtr(addressInfo), 1000).isSuccess()) {
+            _exit(1);
+        }
+        auto peerFd = ::accept(listenFd, nullptr, nullptr);
+        const std::string message(1024, 'x');
+        raise(SIGSTOP);
+        for (int32_t i = 0; i < messageCount; i++) {
+            [[maybe_unused]] auto res = ::write(peerFd, message.data(), message.size());
+            if (!socket.canReceive(1000).isSuccess() || !std::get<0>(socket.receive()).isSuccess()) {
+                _exit(1);
+            }
+        }
+        _exit(0);
+    }
+    int status = 0;
+    waitpid(pid, &status, 0);
+    if (!WIFSTOPPED(status) || ptrace(PTRACE_SETOPTIONS, pid, nullptr, PTRACE_O_TRACESYSGOOD | PTRACE_O_EXITKILL) < 0) {
+        kill(pid, SIGKILL);
+        waitpid(pid, &status, 0);
+        return kInvalid;
+    }
+    ///every syscall stops once on entry and once on exit
+    int64_t stopCount = 0;
+    while (ptrace(PTRACE_SYSCALL, pid, nullptr, nullptr) == 0 && waitpid(pid, &status, 0) == pid && !WIFEXITED(status)) {
+        if (WIFSTOPPED(status) && WSTOPSIG(status) == (SIGTRAP | 0x80)) {
+            stopCount++;
+        }
+    }
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0 ? stopCount / 2 : kInvalid;
+}
+
+std::string receiveAll(UringSocket& socket, size_t expectSize) {
+    std::string body;
+    while (body.size() < expectSize) {
+        if (!socket.canReceive(5000).isSuccess()) {
+            break;
+        }
+        auto [result, data] = socket.receive();
+        if (!result.isSuccess()) {
+            break;
+        }
+        body.append(data->view());
+    }
+    return body;
+}
+
+}
+
+TEST(UringSocket, SendReceive) {
+    if (!UringSocket::isSupported()) {
+        GTEST_SKIP() << "io_uring is not available";
+    }
+    const std::string payload(64 * 1024, 'x');
+    const std::string expectResponse = "HTTP/1.1 200 OK\r\nContent-Length: " + std::to_string(payload.size()) + "\r\n\r\n" + payload;
+    LocalServer server([&](const LocalServer::Request& request) {
+        return expectResponse;
+    });
+    auto address = resolve(server);
+    for (int32_t i = 0; i < 3; i++) {
+        UringSocket socket;
+        ASSERT_TRUE(socket.connect(address, 1000).isSuccess());
+        std::string request = "GET / HTTP/1.1\r\nHost: 127.0.0.1\r\n\r\n";
+        ASSERT_TRUE(socket.canSend(1000).isSuccess());
+        auto [sendResult, sendSize] = socket.send(request);
+        ASSERT_TRUE(sendResult.isSuccess());
+        ASSERT_EQ(sendSize, static_cast<int64_t>(request.size()));
+        ASSERT_TRUE(receiveAll(socket, expectResponse.size()) == expectResponse);
+    }
+}
+
+TEST(UringSocket, SendBuffers) {
+    if (!UringSocket::isSupported()) {
+        GTEST_SKIP() << "io_uring is not available";
+    }
+    const std::string body(256 * 1024, 'x');
+    LocalServer server([&](const LocalServer::Request& request) {
+        return std::string("HTTP/1.1 200 OK\r\nContent-Length: 1\r\n\r\n") + (request.body == body ? "1" : "0");
+    });
+    auto address = resolve(server);
+    UringSocket socket;
+    ASSERT_TRUE(socket.connect(address, 1000).isSuccess());
+    const std::string header = "POST / HTTP/1.1\r\nHost: 127.0.0.1\r\nContent-Length: " +
+                               std::to_string(body.size()) + "\r\n\r\n";
+    auto buffers = skipBuffers({header, body}, 0);
+    while (!buffers.empty()) {
+        ASSERT_TRUE(socket.canSend(1000).isSuccess());
+        auto [sendResult, sendSize] = socket.sendBuffers(buffers);
+        ASSERT_TRUE(sendResult.isSuccess());
+        buffers = skipBuffers(buffers, static_cast<uint64_t>(sendSize));
+    }
+    const std::string expectResponse = "HTTP/1.1 200 OK\r\nContent-Length: 1\r\n\r\n1";
+    ASSERT_EQ(receiveAll(socket, expectResponse.size()), expectResponse);
+}
+
+TEST(UringSocket, ReceiveTimeout) {
+    if (!UringSocket::isSupported()) {
+        GTEST_SKIP() << "io_uring is not available";
+    }
+    LocalServer server([](const LocalServer::Request& request) {
+        std::this_thread::sleep_for(300ms);
+        return std::string();
+    });
+    UringSocket socket;
+    ASSERT_TRUE(socket.connect(resolve(server), 1000).isSuccess());
+    auto [sendResult, sendSize] = socket.send("GET / HTTP/1.1\r\n\r\n");
+    ASSERT_TRUE(sendResult.isSuccess());
+    ASSERT_EQ(socket.canReceive(50).resultCode, ResultCode::Timeout);
+    ///the armed receive reports the close of the server
+    ASSERT_TRUE(socket.canReceive(5000).isSuccess());
+    auto [result, data] = socket.receive();
+    ASSERT_EQ(result.resultCode, ResultCode::Disconnected);
+}
+
+TEST(UringSocket, ConnectRefused) {
+    if (!UringSocket::isSupported()) {
+        GTEST_SKIP() << "io_uring is not available";
+    }
+    AddressInfoPtr address(nullptr, freeaddrinfo);
+    {
+        LocalServer server([](const LocalServer::Request& request) {
+            return std::string();
+        });
+        address = resolve(server);
+    }
+    UringSocket socket;
+    auto result = socket.connect(address, 1000);
+    ASSERT_EQ(result.resultCode, ResultCode::ConnectGenericError);
+    ASSERT_EQ(result.errorCode, ECONNREFUSED);
+}
+
+TEST(UringSocket, SendTimeout) {
+    if (!UringSocket::isSupported()) {
+        GTEST_SKIP() << "io_uring is not available";
+    }
+    ///a listener that never accepts, the connection is queued and nobody reads it
+    auto listenFd = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    ::bind(listenFd, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+    socklen_t length = sizeof(address);
+    getsockname(listenFd, reinterpret_cast<sockaddr*>(&address), &length);
+    ::listen(listenFd, 1);
+    addrinfo hints{};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* addressInfo = nullptr;
+    getaddrinfo("127.0.0.1", std::to_string(ntohs(address.sin_port)).data(), &hints, &addressInfo);
+    {
+        UringSocket socket;
+        ASSERT_TRUE(socket.connect(MakeAddressInfoPtr(addressInfo), 1000).isSuccess());
+        auto payload = std::make_unique<std::string>(1024 * 1024, 'x');
+        SocketResult result;
+        for (int32_t i = 0; i < 256 && result.resultCode != ResultCode::Timeout; i++) {
+            ASSERT_TRUE(socket.canSend(50).isSuccess());
+            std::tie(result, std::ignore) = socket.sendBuffers({"header", *payload});
+            ASSERT_TRUE(result.isSuccess() || result.resultCode == ResultCode::Timeout);
+        }
+        ///the canceled send has completed, its message and the payload are no longer in use
+        ASSERT_EQ(result.resultCode, ResultCode::Timeout);
+        payload.reset();
+    }
+    ::close(listenFd);
+
+    ///the ring of the thread keeps working
+    LocalServer server([](const LocalServer::Request& request) {
+        return std::string("HTTP/1.1 200 OK\r\nContent-Length: 2\r\n\r\nok");
+    });
+    UringSocket socket;
+    ASSERT_TRUE(socket.connect(resolve(server), 1000).isSuccess());
+    auto [sendResult, sendSize] = socket.send("GET / HTTP/1.1\r\nHost: 127.0.0.1\r\n\r\n");
+    ASSERT_TRUE(sendResult.isSuccess());
+    auto response = receiveAll(socket, 40);
+    ASSERT_NE(response.find("ok"), std::string::npos);
+}
+
+TEST(UringSocket, HeldBuffers) {
+    if (!UringSocket::isSupported()) {
+        GTEST_SKIP() << "io_uring is not available";
+    }
+    ///more than the buffer ring holds, every received buffer is kept until the end
+    const std::string payload(8 * 1024 * 1024, 'x');
+    const std::string expectResponse = "HTTP/1.1 200 OK\r\nContent-Length: " + std::to_string(payload.size()) + "\r\n\r\n" + payload;
+    LocalServer server([&](const LocalServer::Request& request) {
+        return expectResponse;
+    });
+    UringSocket socket;
+    ASSERT_TRUE(socket.connect(resolve(server), 1000).isSuccess());
+    auto [sendResult, sendSize] = socket.send("GET / HTTP/1.1\r\nHost: 127.0.0.1\r\n\r\n");
+    ASSERT_TRUE(sendResult.isSuccess());
+    std::vector<DataPtr> received;
+    size_t receivedSize = 0;
+    while (receivedSize < expectResponse.size()) {
+        ASSERT_TRUE(socket.canReceive(5000).isSuccess());
+        auto [result, data] = socket.receive();
+        ASSERT_TRUE(result.isSuccess());
+        receivedSize += data->length;
+        received.push_back(std::move(data));
+    }
+    std::string response;
+    for (auto& data : received) {
+        response.append(data->view());
+    }
+    ASSERT_TRUE(response == expectResponse);
+    ///the ring gets its buffers back once they are released
+    received.clear();
+    socket.close();
+    UringSocket nextSocket;
+    ASSERT_TRUE(nextSocket.connect(resolve(server), 1000).isSuccess());
+    std::tie(sendResult, sendSize) = nextSocket.send("GET / HTTP/1.1\r\nHost: 127.0.0.1\r\n\r\n");
+    ASSERT_TRUE(sendResult.isSuccess());
+    ASSERT_TRUE(receiveAll(nextSocket, expectResponse.size()) == expectResponse);
+}
+
+TEST(UringSocket, FewerSyscalls) {
+    ///the ring is per thread and can not be used by a forked child, the child checks the support itself
+    constexpr int32_t kMessageCount = 200;
+    auto plainCount = countReceiveSyscalls<PlainSocket>(kMessageCount);
+    auto uringCount = countReceiveSyscalls<UringSocket>(kMessageCount);
+    if (plainCount < 0 || uringCount < 0) {
+        GTEST_SKIP() << "io_uring or ptrace is not available";
+    }
+    std::cout << "syscalls per message, socket: " << static_cast<double>(plainCount) / kMessageCount
+              << ", io_uring: " << static_cast<double>(uringCount) / kMessageCount << std::endl;
+    ///select and recv against one io_uring_enter, the write of the peer is counted for both
+    ASSERT_LT(uringCount, plainCount);
+}
+
+#endif //end if ENABLE_IO_URING